@@ -0,0 +1,481 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QPointF>
+#include <QtMath>
+#include <cmath>
+
+#include "arcfitter.h"
+#include "gcodeline.h"
+
+namespace
+{
+// fewest moves worth an arc
+const int _minMoves = 3;
+// most moves in one arc, bounds the work per move and the lines held back
+const int _maxMoves = 64;
+// spread of the extrusion per mm allowed within an arc
+const double _extrusionTolerance = 0.05;
+
+/**
+ * @brief Text of the number of \p word in \p command
+ */
+QByteArray text(const QByteArray &command, const GCodeLine::Word *word)
+{
+    return command.mid(word->begin, word->end - word->begin);
+}
+
+/**
+ * @brief True if \p words has a word without a number, a word given twice, a subcode or a line number
+ */
+bool isUnusual(const GCodeLine &words)
+{
+    if (words.subcode() != -1 || words.hasRepeatedWords() || words.lineNumber() != -1 || words.checksum() != -1) {
+        return true;
+    }
+    for (int i = 0; i < words.wordCount(); i++) {
+        if (!words.word(i).hasValue) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief \p value with 3 decimals, without a sign for zero
+ */
+QByteArray number(double value)
+{
+    const double rounded = std::round(value * 1000) / 1000;
+    return QByteArray::number(rounded == 0 ? 0.0 : rounded, 'f', 3);
+}
+
+/**
+ * @brief A G1 move that may become part of an arc
+ */
+struct Move {
+    ArcFitter::Line line;   //!< @param line: the move as read
+    double x;               //!< @param x: X at its end
+    double y;               //!< @param y: Y at its end
+    QByteArray xText;       //!< @param xText: X at its end as written in the job
+    QByteArray yText;       //!< @param yText: Y at its end as written in the job
+    double length;          //!< @param length: XY length
+    double e;               //!< @param e: extruded, 0 for a travel move
+    QByteArray eText;       //!< @param eText: E word of the move as written
+    int eDecimals;          //!< @param eDecimals: decimals of eText
+    bool hasF;              //!< @param hasF: the move sets the feedrate
+    double f;               //!< @param f: feedrate it sets
+    QByteArray fText;       //!< @param fText: F word of the move as written
+};
+
+/**
+ * @brief A circle through the points of a run
+ */
+struct Arc {
+    double x;               //!< @param x: X of the center
+    double y;               //!< @param y: Y of the center
+    bool counterClockwise;  //!< @param counterClockwise: direction from start to end
+};
+}
+
+/**
+ * @brief The ArcFitterPrivate class
+ */
+class ArcFitterPrivate
+{
+public:
+    double tolerance = 0.05;    //!< @param tolerance: largest distance of a move from its arc
+    double maxRadius = 1000;    //!< @param maxRadius: largest radius of an arc
+    qint64 arcs = 0;            //!< @param arcs: arcs written
+    qint64 replaced = 0;        //!< @param replaced: moves replaced by arcs
+
+    // modal state after the last line passed in
+    double x = 0;               //!< @param x: X position
+    double y = 0;               //!< @param y: Y position
+    QByteArray xText;           //!< @param xText: X position as written in the job
+    QByteArray yText;           //!< @param yText: Y position as written in the job
+    bool knownX = false;        //!< @param knownX: X is known
+    bool knownY = false;        //!< @param knownY: Y is known
+    double e = 0;               //!< @param e: absolute E position
+    bool knownE = false;        //!< @param knownE: e is known
+    double feedrate = -1;       //!< @param feedrate: last F, -1 if unknown
+    bool relative = false;      //!< @param relative: G91 is active
+    bool relativeE = false;     //!< @param relativeE: M83 is active
+    bool inches = false;        //!< @param inches: G20 is active
+
+    double startX = 0;          //!< @param startX: X where the run starts
+    double startY = 0;          //!< @param startY: Y where the run starts
+    QVector<Move> run;          //!< @param run: moves held back
+
+    /**
+     * @brief Make \p move of \p line if it can be part of an arc
+     */
+    bool toMove(const GCodeLine &words, const ArcFitter::Line &line, Move &move) const
+    {
+        if (words.letter() != 'G' || words.code() != 1 || isUnusual(words) || relative || inches) {
+            return false;
+        }
+        for (int i = 0; i < words.wordCount(); i++) {
+            const char letter = words.word(i).letter;
+            if (letter != 'X' && letter != 'Y' && letter != 'E' && letter != 'F') {
+                return false;
+            }
+        }
+        const GCodeLine::Word *wordX = words.find('X');
+        const GCodeLine::Word *wordY = words.find('Y');
+        const GCodeLine::Word *wordE = words.find('E');
+        const GCodeLine::Word *wordF = words.find('F');
+        if ((!wordX && !wordY) || !knownX || !knownY) {
+            return false;
+        }
+        move.line = line;
+        move.x = wordX ? wordX->value : x;
+        move.y = wordY ? wordY->value : y;
+        move.xText = wordX ? text(line.command, wordX) : xText;
+        move.yText = wordY ? text(line.command, wordY) : yText;
+        move.length = std::hypot(move.x - x, move.y - y);
+        if (move.length < 1e-6) {
+            return false;
+        }
+        move.e = 0;
+        move.eDecimals = 0;
+        if (wordE) {
+            if (!relativeE && !knownE) {
+                return false;
+            }
+            move.e = relativeE ? wordE->value : wordE->value - e;
+            move.eText = text(line.command, wordE);
+            move.eDecimals = wordE->decimals;
+            if (move.e < 0) {
+                // retracting while moving, leave it alone
+                return false;
+            }
+        }
+        move.hasF = wordF;
+        if (move.hasF) {
+            move.f = wordF->value;
+            move.fText = text(line.command, wordF);
+        }
+        return true;
+    }
+
+    /**
+     * @brief True if \p move moves like the run, extruding at the same rate and feedrate
+     */
+    bool compatible(const Move &move) const
+    {
+        const Move &first = run.first();
+        if ((move.e > 0) != (first.e > 0)) {
+            return false;
+        }
+        if (move.e > 0) {
+            const double rate = first.e / first.length;
+            if (std::abs(move.e / move.length - rate) > rate * _extrusionTolerance) {
+                return false;
+            }
+        }
+        // words of move are not tracked yet, feedrate is the one before it
+        return !move.hasF || move.f == feedrate;
+    }
+
+    /**
+     * @brief Fit a circle to the run, and \p next if given
+     * @return False if a move strays from the circle by more than tolerance
+     */
+    bool fit(const Move *next, Arc &arc) const
+    {
+        QVector<QPointF> points;
+        points.reserve(run.size() + 2);
+        points.append(QPointF(startX, startY));
+        for (const Move &move : run) {
+            points.append(QPointF(move.x, move.y));
+        }
+        if (next) {
+            points.append(QPointF(next->x, next->y));
+        }
+
+        // circle through the ends and the middle
+        const QPointF a = points.first();
+        const QPointF b = points.at(points.size() / 2);
+        const QPointF c = points.last();
+        const double det = 2 * (a.x() * (b.y() - c.y()) + b.x() * (c.y() - a.y()) + c.x() * (a.y() - b.y()));
+        if (std::abs(det) < 1e-9) {
+            return false;
+        }
+        const double a2 = a.x() * a.x() + a.y() * a.y();
+        const double b2 = b.x() * b.x() + b.y() * b.y();
+        const double c2 = c.x() * c.x() + c.y() * c.y();
+        arc.x = (a2 * (b.y() - c.y()) + b2 * (c.y() - a.y()) + c2 * (a.y() - b.y())) / det;
+        arc.y = (a2 * (c.x() - b.x()) + b2 * (a.x() - c.x()) + c2 * (b.x() - a.x())) / det;
+        const double radius = std::hypot(a.x() - arc.x, a.y() - arc.y);
+        if (radius > maxRadius) {
+            return false;
+        }
+
+        // every point and the middle of every move on the circle, turning one way by less than a turn
+        int direction = 0;
+        double sweep = 0;
+        for (int i = 1; i < points.size(); i++) {
+            const QPointF p = points.at(i - 1) - QPointF(arc.x, arc.y);
+            const QPointF q = points.at(i) - QPointF(arc.x, arc.y);
+            const QPointF middle = (p + q) / 2;
+            if (std::abs(std::hypot(q.x(), q.y()) - radius) > tolerance
+                    || std::abs(std::hypot(middle.x(), middle.y()) - radius) > tolerance) {
+                return false;
+            }
+            const double angle = std::atan2(p.x() * q.y() - p.y() * q.x(), p.x() * q.x() + p.y() * q.y());
+            const int turn = angle > 0 ? 1 : -1;
+            if (angle == 0 || (direction && turn != direction)) {
+                return false;
+            }
+            direction = turn;
+            sweep += std::abs(angle);
+        }
+        arc.counterClockwise = direction > 0;
+        return sweep < 2 * M_PI - 1e-3;
+    }
+
+    /**
+     * @brief Write the run as an arc, or as it is if it is too short
+     */
+    void writeRun(QVector<ArcFitter::Line> &output)
+    {
+        Arc arc;
+        if (run.size() < _minMoves || !fit(nullptr, arc)) {
+            for (const Move &move : run) {
+                output.append(move.line);
+            }
+            run.clear();
+            return;
+        }
+
+        const Move &first = run.first();
+        const Move &last = run.last();
+        QByteArray command = arc.counterClockwise ? QByteArray("G3") : QByteArray("G2");
+        command += " X" + last.xText + " Y" + last.yText;
+        command += " I" + number(arc.x - startX) + " J" + number(arc.y - startY);
+        if (first.e > 0) {
+            if (relativeE) {
+                // the sum of the moves, rounded to what they were written with
+                double e = 0;
+                int decimals = 0;
+                for (const Move &move : run) {
+                    e += move.e;
+                    decimals = qMax(decimals, move.eDecimals);
+                }
+                command += " E" + QByteArray::number(e, 'f', decimals);
+            } else {
+                command += " E" + last.eText;
+            }
+        }
+        if (first.hasF) {
+            command += " F" + first.fText;
+        }
+        output.append({command, last.line.offset, last.line.fileOffset});
+        arcs++;
+        replaced += run.size();
+        run.clear();
+    }
+
+    /**
+     * @brief Apply \p words of \p command to the modal state
+     */
+    void track(const GCodeLine &words, const QByteArray &command)
+    {
+        const GCodeLine::Word *wordX = words.find('X');
+        const GCodeLine::Word *wordY = words.find('Y');
+        const GCodeLine::Word *wordE = words.find('E');
+        const GCodeLine::Word *wordF = words.find('F');
+        if (words.letter() == 'G') {
+            switch (words.code()) {
+            case 0:
+            case 1:
+            case 2:
+            case 3:
+                if (wordX) {
+                    x = relative ? x + wordX->value : wordX->value;
+                    xText = text(command, wordX);
+                    // a relative move leaves no text to copy
+                    knownX = !relative;
+                }
+                if (wordY) {
+                    y = relative ? y + wordY->value : wordY->value;
+                    yText = text(command, wordY);
+                    knownY = !relative;
+                }
+                if (wordE) {
+                    e = relative || relativeE ? e + wordE->value : wordE->value;
+                    knownE = knownE || !(relative || relativeE);
+                }
+                if (wordF) {
+                    feedrate = wordF->value;
+                }
+                break;
+            case 4:
+                break;
+            case 20:
+                inches = true;
+                break;
+            case 21:
+                inches = false;
+                break;
+            case 90:
+                relative = false;
+                break;
+            case 91:
+                relative = true;
+                break;
+            case 92:
+                if (wordX) {
+                    x = wordX->value;
+                    xText = text(command, wordX);
+                    knownX = true;
+                }
+                if (wordY) {
+                    y = wordY->value;
+                    yText = text(command, wordY);
+                    knownY = true;
+                }
+                if (wordE) {
+                    e = wordE->value;
+                    knownE = true;
+                }
+                if (!wordX && !wordY && !wordE) {
+                    knownX = knownY = knownE = false;
+                }
+                break;
+            default:
+                // homing, probing and the like, the position is not known anymore
+                knownX = knownY = false;
+                break;
+            }
+        } else if (words.letter() == 'M') {
+            if (words.code() == 82) {
+                relativeE = false;
+            } else if (words.code() == 83) {
+                relativeE = true;
+            }
+        } else if (words.letter() == 'T') {
+            // tool offsets move the head
+            knownX = knownY = false;
+        }
+    }
+};
+
+ArcFitter::ArcFitter() :
+    d(new ArcFitterPrivate)
+{
+}
+
+ArcFitter::~ArcFitter()
+{
+    delete d;
+}
+
+void ArcFitter::setTolerance(double mm)
+{
+    d->tolerance = qMax(0.0, mm);
+}
+
+double ArcFitter::tolerance() const
+{
+    return d->tolerance;
+}
+
+void ArcFitter::setMaxRadius(double mm)
+{
+    d->maxRadius = qMax(0.0, mm);
+}
+
+double ArcFitter::maxRadius() const
+{
+    return d->maxRadius;
+}
+
+void ArcFitter::addLine(const ArcFitter::Line &line, QVector<ArcFitter::Line> &output)
+{
+    GCodeLine words;
+    Move move;
+    const bool parsed = words.parse(line.command);
+    if (!parsed || !d->toMove(words, line, move)) {
+        flush(output);
+        output.append(line);
+        if (parsed) {
+            d->track(words, line.command);
+        } else if (!line.command.isEmpty()) {
+            // nothing is known about what it does
+            d->knownX = d->knownY = false;
+        }
+        return;
+    }
+
+    if (!d->run.isEmpty()) {
+        Arc arc;
+        if (d->run.size() >= _maxMoves || !d->compatible(move) || !d->fit(&move, arc)) {
+            d->writeRun(output);
+        }
+    }
+    if (d->run.isEmpty()) {
+        d->startX = d->x;
+        d->startY = d->y;
+    }
+    d->run.append(move);
+    d->track(words, line.command);
+}
+
+QString ArcFitter::name() const
+{
+    return QStringLiteral("arc fitting");
+}
+
+void ArcFitter::process(QVector<Line> &lines)
+{
+    QVector<Line> output;
+    output.reserve(lines.size());
+    for (const Line &line : lines) {
+        addLine(line, output);
+    }
+    lines.swap(output);
+}
+
+void ArcFitter::flush(QVector<ArcFitter::Line> &output)
+{
+    if (!d->run.isEmpty()) {
+        d->writeRun(output);
+    }
+}
+
+bool ArcFitter::isEmpty() const
+{
+    return d->run.isEmpty();
+}
+
+qint64 ArcFitter::arcs() const
+{
+    return d->arcs;
+}
+
+qint64 ArcFitter::replacedMoves() const
+{
+    return d->replaced;
+}
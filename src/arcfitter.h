@@ -0,0 +1,117 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "gcodepipeline.h"
+
+class ArcFitterPrivate;
+/**
+ * @brief The ArcFitter class
+ * Replaces runs of G1 moves that follow a circular arc by a single G2 or G3.
+ *
+ * Slicers write curves as many short G1 segments, each one a line the host
+ * has to send and the firmware has to plan. Lines are passed in job order to
+ * addLine(). Consecutive absolute XY moves, extruding at the same rate or not
+ * extruding at all, are held back while they stay within tolerance() of one
+ * circle. Once a move doesn't fit, the held moves are written as one arc if
+ * there are enough of them, or as they were otherwise.
+ *
+ * The arc ends on the exact end point of the last move, copied from its text,
+ * and extrudes exactly what the moves did. Any other command ends the run and
+ * passes through unchanged.
+ *
+ * In a streamed print it runs as a GCodePipeline stage.
+ */
+class ATCORE_EXPORT ArcFitter : public GCodeFilter
+{
+public:
+    ArcFitter();
+    ~ArcFitter() override;
+
+    /**
+     * @brief Name of the stage in a GCodePipeline
+     */
+    QString name() const override;
+
+    /**
+     * @brief Fit a batch of lines, as a GCodePipeline stage
+     * @param lines: next lines of the job, replaced by the lines done with
+     */
+    void process(QVector<Line> &lines) override;
+
+    /**
+     * @brief Largest distance of a move from the arc replacing it
+     * @param mm: tolerance in mm, 0.05 by default
+     */
+    void setTolerance(double mm);
+
+    /**
+     * @brief Largest distance of a move from the arc replacing it in mm
+     */
+    double tolerance() const;
+
+    /**
+     * @brief Largest radius of an arc, flatter runs are left as they are
+     * @param mm: radius in mm, 1000 by default
+     */
+    void setMaxRadius(double mm);
+
+    /**
+     * @brief Largest radius of an arc in mm
+     */
+    double maxRadius() const;
+
+    /**
+     * @brief Fit the next line of the job
+     * @param line: next line
+     * @param output: lines done with are appended to it, in job order
+     */
+    void addLine(const Line &line, QVector<Line> &output);
+
+    /**
+     * @brief Write the moves held back, at the end of the job
+     * @param output: lines are appended to it
+     */
+    void flush(QVector<Line> &output) override;
+
+    /**
+     * @brief True if no move is held back
+     */
+    bool isEmpty() const;
+
+    /**
+     * @brief Number of arcs written
+     */
+    qint64 arcs() const;
+
+    /**
+     * @brief Number of G1 moves replaced by arcs
+     */
+    qint64 replacedMoves() const;
+
+private:
+    ArcFitter(const ArcFitter &) = delete;
+    ArcFitter &operator=(const ArcFitter &) = delete;
+    ArcFitterPrivate *d;
+};
@@ -27,20 +27,176 @@
 #include <QSerialPortInfo>
 #include <QPluginLoader>
 #include <QCoreApplication>
+#include <QElapsedTimer>
 #include <QLoggingCategory>
 #include <QTime>
 #include <QTimer>
 #include <QThread>
+#include <QQueue>
 
 #include "atcore.h"
 #include "atcore_version.h"
 #include "seriallayer.h"
 #include "gcodecommands.h"
+#include "gcodebuilder.h"
 #include "printthread.h"
+#include "retransmitbuffer.h"
+#include "latencyhistogram.h"
+#include "gcodeindex.h"
+#include "printjournal.h"
+#include "printtimeestimator.h"
 #include "atcore_default_folders.h"
 
 Q_LOGGING_CATEGORY(ATCORE_PLUGIN, "org.kde.atelier.core.plugin")
 Q_LOGGING_CATEGORY(ATCORE_CORE, "org.kde.atelier.core")
+
+namespace
+{
+/**
+ * @brief Free command slots reported by Marlin ADVANCED_OK
+ * @param message: message from the printer ("ok N<line> P<planner> B<buffer>")
+ * @return free slots in the command buffer or -1 if \p message is not an ADVANCED_OK reply
+ */
+int advancedOkFreeSlots(const QByteArray &message)
+{
+    if (!message.startsWith("ok ") || !message.contains(" P")) {
+        return -1;
+    }
+    int i = message.indexOf(" B");
+    if (i == -1) {
+        return -1;
+    }
+    int freeSlots = -1;
+    for (i += 2; i < message.size() && message.at(i) >= '0' && message.at(i) <= '9'; ++i) {
+        freeSlots = qMax(freeSlots, 0) * 10 + (message.at(i) - '0');
+    }
+    return freeSlots;
+}
+
+/**
+ * @brief Line requested by a "Resend: <line>" (Marlin, Repetier) or "rs <line>" (older Repetier) reply
+ * @param message: message from the printer
+ * @return the requested line or -1 if \p message is not a resend request
+ */
+int resendRequestLine(const QByteArray &message)
+{
+    int i = 0;
+    if (message.startsWith("Resend:")) {
+        i = 7;
+    } else if (message.startsWith("rs ")) {
+        i = 3;
+    } else {
+        return -1;
+    }
+    while (i < message.size() && (message.at(i) == ' ' || message.at(i) == 'N')) {
+        ++i;
+    }
+    int line = -1;
+    for (; i < message.size() && message.at(i) >= '0' && message.at(i) <= '9'; ++i) {
+        line = qMax(line, 0) * 10 + (message.at(i) - '0');
+    }
+    return line;
+}
+
+/**
+ * @brief Check for a line number or checksum error reply
+ * @param message: message from the printer
+ */
+bool isLineError(const QByteArray &message)
+{
+    if (!message.startsWith("Error:")) {
+        return false;
+    }
+    const QByteArray error = message.toLower();
+    return error.contains("checksum") || error.contains("line number") || error.contains("expected line");
+}
+
+/**
+ * @brief Class of \p command for the latency histograms
+ * @param command: command as queued, an "N<line> " prefix is skipped
+ */
+AtCore::COMMAND_CLASS commandClass(const QByteArray &command)
+{
+    int i = 0;
+    const int size = command.size();
+    while (i < size && command.at(i) == ' ') {
+        i++;
+    }
+    if (i < size && command.at(i) == 'N') {
+        while (i < size && command.at(i) != ' ') {
+            i++;
+        }
+        while (i < size && command.at(i) == ' ') {
+            i++;
+        }
+    }
+    if (i >= size) {
+        return AtCore::OTHER;
+    }
+
+    const char letter = char(command.at(i) & ~0x20);
+    int number = -1;
+    for (i++; i < size && command.at(i) >= '0' && command.at(i) <= '9'; i++) {
+        number = qMax(number, 0) * 10 + (command.at(i) - '0');
+    }
+    if (number == -1) {
+        return AtCore::OTHER;
+    }
+
+    if (letter == 'G') {
+        return number <= 1 ? AtCore::MOVE : AtCore::GCODE;
+    }
+    if (letter == 'M') {
+        if (number == 105) {
+            return AtCore::TEMPERATURE;
+        }
+        if ((number >= 20 && number <= 30) || number == 32 || number == 928) {
+            return AtCore::SDCARD;
+        }
+        return AtCore::MCODE;
+    }
+    return AtCore::OTHER;
+}
+
+/**
+ * @brief A command sent and not yet acknowledged
+ */
+struct InFlightCommand {
+    int size;                           //!< @param size: bytes written
+    AtCore::COMMAND_CLASS commandClass; //!< @param commandClass: class for the latency histograms
+    qint64 sent;                        //!< @param sent: AtCorePrivate::clock time it was sent, in ns
+    qint64 jobOffset;                   //!< @param jobOffset: byte offset after it in the print job, -1 if not from a job
+    QByteArray jobCommand;              //!< @param jobCommand: the job command for the PrintJournal
+    int line;                           //!< @param line: its line number, -1 if not numbered
+};
+
+/**
+ * @brief A framed line waiting to be sent before the queued commands
+ */
+struct PendingFrame {
+    QByteArray frame;                   //!< @param frame: the framed line
+    int line = -1;                      //!< @param line: its line number, -1 if it isn't a line sent again
+    qint64 jobOffset = -1;              //!< @param jobOffset: byte offset after it in the print job, -1 if not from a job
+    QByteArray jobCommand;              //!< @param jobCommand: the job command for the PrintJournal
+};
+
+/**
+ * @brief Start the journal of a host-streamed print
+ * @param fileName: the gcode file being printed
+ * @param state: state the print starts from
+ * @return the running journal or nullptr if it can't be written
+ */
+PrintJournal *startJournal(const QString &fileName, const PrintJournal::State &state)
+{
+    PrintJournal *journal = new PrintJournal(fileName);
+    if (!journal->start(state)) {
+        delete journal;
+        return nullptr;
+    }
+    return journal;
+}
+}
+
 /**
  * @brief The AtCorePrivate struct
  */
@@ -53,9 +209,34 @@ struct AtCorePrivate {
     QByteArray lastMessage;             //!< @param lastMessage: lastMessage from the printer
     int extruderCount = 1;              //!< @param extruderCount: extruder count
     Temperature temperature;            //!< @param temperature: Temperature object
-    QStringList commandQueue;           //!< @param commandQueue: the list of commands to send to the printer
-    bool ready = false;                 //!< @param ready: True if printer is ready for a command
+    QList<QByteArray> commandQueue;     //!< @param commandQueue: the list of commands to send to the printer
+    QSharedPointer<PrintJob> job;       //!< @param job: commands read ahead by the PrintThread, sent after the commandQueue
+    QQueue<InFlightCommand> inFlight;   //!< @param inFlight: commands sent and not yet acknowledged
+    int inFlightBytes = 0;              //!< @param inFlightBytes: bytes sent and not yet acknowledged
+    int firmwareFreeSlots = -1;         //!< @param firmwareFreeSlots: free command slots from ADVANCED_OK, -1 if unknown
+    bool streamingWindow = false;       //!< @param streamingWindow: True to keep several commands in flight
+    RetransmitBuffer retransmit;        //!< @param retransmit: line numbers, checksums and the lines kept for resends
+    QList<PendingFrame> pendingFrames;  //!< @param pendingFrames: framed lines to send before the commandQueue
+    bool lineNumbering = false;         //!< @param lineNumbering: True to send commands with line numbers and checksums
+    int lastResend = -1;                //!< @param lastResend: line of the last resend request served
+    int staleResends = 0;               //!< @param staleResends: repeated requests for lastResend still expected
+    int lineErrors = 0;                 //!< @param lineErrors: line number and checksum errors reported by the firmware
+    int retransmits = 0;                //!< @param retransmits: lines sent again on resend requests
+    QElapsedTimer clock;                //!< @param clock: monotonic clock for command latencies
+    LatencyHistogram latency[AtCore::OTHER + 1]; //!< @param latency: send to acknowledge latency per COMMAND_CLASS
+    PrintJournal *journal = nullptr;    //!< @param journal: journal of the running print, nullptr if none
+    PrintTimeEstimator *estimator = nullptr; //!< @param estimator: print time estimator with the printer's limits
+    GCodeBuilder builder;               //!< @param builder: writes the commands AtCore sends itself
+    bool printJournal = true;           //!< @param printJournal: True to journal host-streamed prints
+    int progressInterval = 250;         //!< @param progressInterval: longest time between two progress updates in ms
+    float progressStep = 0.1f;          //!< @param progressStep: progress change published right away, in percent
+    bool arcFitting = false;            //!< @param arcFitting: True to fit arcs to streamed prints
+    float arcTolerance = 0.05f;         //!< @param arcTolerance: largest distance of a move from its arc in mm
+    bool minifyCommands = false;        //!< @param minifyCommands: True to minify streamed prints
+    QList<std::function<GCodeFilter *()>> printFilters; //!< @param printFilters: make the stages of each streamed print
     QTimer *tempTimer = nullptr;        //!< @param tempTimer: timer connected to the checkTemperature function
+    bool temperatureQueued = false;     //!< @param temperatureQueued: True while an M105 of checkTemperature is in the commandQueue
+    bool temperatureAutoReport = false; //!< @param temperatureAutoReport: True once M155 asked the firmware to report temperatures
     float percentage;                   //!< @param percentage: print job percent
     QByteArray posString;               //!< @param posString: stored string from last M114 return
     AtCore::STATES printerState;        //!< @param printerState: State of the Printer
@@ -73,8 +254,13 @@ AtCore::AtCore(QObject *parent) :
     d(new AtCorePrivate)
 {
     qRegisterMetaType<AtCore::STATES>("AtCore::STATES");
+    qRegisterMetaType<QVector<GCodePipeline::StageStats>>("QVector<GCodePipeline::StageStats>");
     setState(AtCore::DISCONNECTED);
 
+    d->clock.start();
+
+    d->estimator = new PrintTimeEstimator(this);
+
     d->tempTimer = new QTimer(this);
     d->tempTimer->setInterval(5000);
     d->tempTimer->setSingleShot(false);
@@ -178,13 +364,24 @@ void AtCore::findFirmware(const QByteArray &message)
     }
     qCDebug(ATCORE_CORE) << "Firmware Name:" << fwName;
 
-    if (message.contains("EXTRUDER_COUNT:")) {
-        //this code is broken if more then 9 extruders are detected. since only one char is returned
-        d->extruderCount = message.at(message.indexOf("EXTRUDER_COUNT:") + 15) - '0';
+    const int countAt = message.indexOf("EXTRUDER_COUNT:");
+    if (countAt != -1) {
+        int count = 0;
+        for (int i = countAt + 15; i < message.size() && message.at(i) >= '0' && message.at(i) <= '9'; i++) {
+            count = count * 10 + (message.at(i) - '0');
+        }
+        if (count > 0) {
+            d->extruderCount = count;
+        }
     }
+    d->temperature.setExtruderCount(d->extruderCount);
     qCDebug(ATCORE_CORE) << "Extruder Count:" << QString::number(extruderCount());
 
     loadFirmwarePlugin(fwName);
+    if (firmwarePluginLoaded()) {
+        //the plugin may need capabilities from the firmware string
+        firmwarePlugin()->checkCommand(message);
+    }
 }
 
 void AtCore::loadFirmwarePlugin(const QString &fwName)
@@ -206,11 +403,22 @@ void AtCore::loadFirmwarePlugin(const QString &fwName)
             qCDebug(ATCORE_PLUGIN) << "Connected to" << firmwarePlugin()->name();
             firmwarePlugin()->init(this);
             disconnect(serial(), &SerialLayer::receivedCommand, this, &AtCore::findFirmware);
-            connect(serial(), &SerialLayer::receivedCommand, this, &AtCore::newMessage);
-            connect(firmwarePlugin(), &IFirmware::readyForCommand, this, &AtCore::processQueue);
-            d->ready = true; // ready on new firmware load
+            connect(serial(), &SerialLayer::receivedCommand, this, &AtCore::newMessage, Qt::UniqueConnection);
+            connect(firmwarePlugin(), &IFirmware::readyForCommand, this, &AtCore::commandAcknowledged, Qt::UniqueConnection);
+            // ready on new firmware load
+            d->inFlight.clear();
+            d->inFlightBytes = 0;
+            d->firmwareFreeSlots = -1;
+            d->pendingFrames.clear();
+            d->lineErrors = 0;
+            d->retransmits = 0;
+            d->temperatureQueued = false;
+            d->temperatureAutoReport = false;
+            if (d->lineNumbering) {
+                resetLineNumber();
+            }
             if (firmwarePlugin()->name() != QStringLiteral("Grbl")) {
-                connect(d->tempTimer, &QTimer::timeout, this, &AtCore::checkTemperature);
+                connect(d->tempTimer, &QTimer::timeout, this, &AtCore::checkTemperature, Qt::UniqueConnection);
                 d->tempTimer->start();
             }
             setState(IDLE);
@@ -220,10 +428,14 @@ void AtCore::loadFirmwarePlugin(const QString &fwName)
     }
 }
 
-bool AtCore::initSerial(const QString &port, int baud)
+bool AtCore::initSerial(const QString &port, int baud, bool ioThread)
 {
     d->serial = new SerialLayer(port, baud);
     if (serialInitialized() && d->serial->isWritable()) {
+        if (ioThread) {
+            d->serial->startIoThread();
+            connect(serial(), &SerialLayer::commandQueueDrained, this, &AtCore::processQueue);
+        }
         setState(AtCore::CONNECTING);
         connect(serial(), &SerialLayer::receivedCommand, this, &AtCore::findFirmware);
         return true;
@@ -302,13 +514,32 @@ void AtCore::setSerialTimerInterval(const quint16 &newTime)
 void AtCore::newMessage(const QByteArray &message)
 {
     d->lastMessage = message;
+    const int freeSlots = advancedOkFreeSlots(message);
+    if (freeSlots != -1 && freeSlots != d->firmwareFreeSlots) {
+        d->firmwareFreeSlots = freeSlots;
+        updateWriteCoalescing();
+    }
+    if (isLineError(message)) {
+        d->lineErrors++;
+    }
+    const int resendLine = resendRequestLine(message);
+    if (resendLine != -1) {
+        resendFrom(resendLine);
+    }
     if (message.startsWith(QString::fromLatin1("X:").toLocal8Bit())) {
         d->posString = message;
         d->posString.resize(d->posString.indexOf('E'));
         d->posString.replace(':', "");
     }
 
-    //Check if have temperature info and decode it
+    if (message.startsWith("Cap:AUTOREPORT_TEMP:1") && !d->temperatureAutoReport) {
+        //the firmware reports on its own, no M105 in the command stream anymore
+        d->temperatureAutoReport = true;
+        disconnect(d->tempTimer, &QTimer::timeout, this, &AtCore::checkTemperature);
+        queueCommand(d->builder.begin('M', 155).word('S', uint(qMax(d->tempTimer->interval() / 1000, 1))).command());
+    }
+
+    //Check if have temperature info and decode it, reports may come unsolicited
     if (d->lastMessage.contains("T:") || d->lastMessage.contains("B:")) {
         temperature().decodeTemp(message);
     }
@@ -317,12 +548,12 @@ void AtCore::newMessage(const QByteArray &message)
 
 void AtCore::setRelativePosition()
 {
-    pushCommand(GCode::toCommand(GCode::G91));
+    queueCommand(GCodeBuilder::G91);
 }
 
 void AtCore::setAbsolutePosition()
 {
-    pushCommand(GCode::toCommand(GCode::G90));
+    queueCommand(GCodeBuilder::G90);
 }
 
 float AtCore::percentagePrinted() const
@@ -340,18 +571,102 @@ void AtCore::print(const QString &fileName, bool sdPrint)
     if (sdPrint) {
         pushCommand(GCode::toCommand(GCode::M23, fileName));
         d->sdCardFileName = fileName;
-        pushCommand(GCode::toCommand(GCode::M24));
+        queueCommand(GCodeBuilder::M24);
         setState(AtCore::BUSY);
         d->sdCardPrinting = true;
         connect(d->tempTimer, &QTimer::timeout, this, &AtCore::sdCardPrintStatus);
         return;
     }
+    delete d->journal;
+    d->journal = d->printJournal ? startJournal(fileName, PrintJournal::State()) : nullptr;
+    startPrintThread(fileName, 0);
+}
+
+bool AtCore::resumePrint(const QString &fileName)
+{
+    PrintJournal::State journal;
+    if (state() == AtCore::CONNECTING || d->sdCardPrinting || !PrintJournal::read(fileName, journal)) {
+        return false;
+    }
+    qCDebug(ATCORE_CORE) << "Resuming" << fileName << "at byte" << journal.offset;
+    setState(AtCore::STARTPRINT);
+
+    //heat while the nozzle rests on the print, then lift it clear and home X and Y only
+    if (journal.bedTemp > 0) {
+        setBedTemp(uint(journal.bedTemp));
+    }
+    if (journal.extruderTemp > 0) {
+        setExtruderTemp(uint(journal.extruderTemp), uint(journal.tool));
+    }
+    //M109 waits for the active tool
+    GCodeBuilder &builder = d->builder;
+    if (journal.tool != 0) {
+        queueCommand(builder.begin('T', journal.tool).command());
+    }
+    if (journal.bedTemp > 0) {
+        setBedTemp(uint(journal.bedTemp), true);
+    }
+    if (journal.extruderTemp > 0) {
+        setExtruderTemp(uint(journal.extruderTemp), uint(journal.tool), true);
+    }
+    queueCommand(builder.begin(GCode::G92).word('Z', double(journal.z)).command());
+    queueCommand(GCodeBuilder::G91);
+    queueCommand(builder.begin(GCode::G1).word('Z', 2).word('F', 600).command());
+    queueCommand(GCodeBuilder::G90);
+    home(AtCore::X | AtCore::Y);
+
+    //restore the modal state of the job
+    queueCommand(builder.begin(GCode::G1).word('X', double(journal.x)).word('Y', double(journal.y)).word('F', 3000).command());
+    queueCommand(builder.begin(GCode::G1).word('Z', double(journal.z)).word('F', 600).command());
+    queueCommand(builder.begin(journal.relativeE ? GCode::M83 : GCode::M82).command());
+    queueCommand(builder.begin(GCode::G92).word('E', double(journal.e), 5).command());
+    if (journal.relative) {
+        queueCommand(GCodeBuilder::G91);
+    }
+    setFanSpeed(uint(journal.fanSpeed));
+    if (journal.feedrate > 0) {
+        queueCommand(builder.begin(GCode::G1).word('F', double(journal.feedrate), 0).command());
+    }
+
+    delete d->journal;
+    d->journal = d->printJournal ? startJournal(fileName, journal) : nullptr;
+    startPrintThread(fileName, journal.offset);
+    return true;
+}
+
+bool AtCore::canResumePrint(const QString &fileName) const
+{
+    PrintJournal::State journal;
+    return PrintJournal::read(fileName, journal);
+}
+
+void AtCore::startPrintThread(const QString &fileName, qint64 offset)
+{
     //START A THREAD AND CONNECT TO IT
     QThread *thread = new QThread();
     PrintThread *printThread = new PrintThread(this, fileName);
+    printThread->seek(offset);
+    printThread->setProgressRate(d->progressInterval, d->progressStep);
+    for (const auto &create : d->printFilters) {
+        printThread->addFilter(create());
+    }
+    if (d->arcFitting && firmwarePluginLoaded() && firmwarePlugin()->supportsArcs()) {
+        printThread->setArcFitting(d->arcTolerance);
+    }
+    if (d->minifyCommands) {
+        printThread->setMinifying(firmwarePluginLoaded() && firmwarePlugin()->supportsCompactWords());
+    }
     printThread->moveToThread(thread);
 
+    d->job = printThread->job();
+    updateWriteCoalescing();
+    connect(printThread, &PrintThread::commandsQueued, this, &AtCore::processQueue, Qt::QueuedConnection);
+    connect(this, &AtCore::printJobDrained, printThread, &PrintThread::processJob, Qt::QueuedConnection);
     connect(printThread, &PrintThread::printProgressChanged, this, &AtCore::printProgressChanged, Qt::QueuedConnection);
+    connect(printThread, &PrintThread::printLayerChanged, this, &AtCore::printLayerChanged, Qt::QueuedConnection);
+    connect(printThread, &PrintThread::printTimeRemainingChanged, this, &AtCore::printTimeRemainingChanged, Qt::QueuedConnection);
+    connect(printThread, &PrintThread::printMinified, this, &AtCore::printMinified, Qt::QueuedConnection);
+    connect(printThread, &PrintThread::printPipelineStats, this, &AtCore::printPipelineStats, Qt::QueuedConnection);
     connect(thread, &QThread::started, printThread, &PrintThread::start);
     connect(printThread, &PrintThread::finished, thread, &QThread::quit);
     connect(thread, &QThread::finished, printThread, &PrintThread::deleteLater);
@@ -360,14 +675,104 @@ void AtCore::print(const QString &fileName, bool sdPrint)
     }
 }
 
+bool AtCore::indexJob(const QString &fileName, GCodeIndex &index) const
+{
+    return index.open(fileName);
+}
+
+bool AtCore::analyzeJob(const QString &fileName, GCodeAnalyzer::Analysis &analysis) const
+{
+    return GCodeAnalyzer::analyze(fileName, analysis);
+}
+
 void AtCore::pushCommand(const QString &comm)
 {
-    d->commandQueue.append(comm);
-    if (d->ready) {
-        processQueue();
+    queueCommand(comm.toLocal8Bit());
+}
+
+void AtCore::pushCommand(const GCodeBuilder &command)
+{
+    queueCommand(command.command());
+}
+
+void AtCore::queueCommand(const QByteArray &command)
+{
+    d->commandQueue.append(command);
+    processQueue();
+}
+
+bool AtCore::printJournal() const
+{
+    return d->printJournal;
+}
+
+void AtCore::setPrintJournal(bool enabled)
+{
+    d->printJournal = enabled;
+}
+
+int AtCore::progressInterval() const
+{
+    return d->progressInterval;
+}
+
+void AtCore::setProgressInterval(int msecs)
+{
+    d->progressInterval = qMax(0, msecs);
+}
+
+float AtCore::progressStep() const
+{
+    return d->progressStep;
+}
+
+void AtCore::setProgressStep(float percent)
+{
+    d->progressStep = qMax(0.0f, percent);
+}
+
+bool AtCore::arcFitting() const
+{
+    return d->arcFitting;
+}
+
+void AtCore::setArcFitting(bool enabled)
+{
+    d->arcFitting = enabled;
+}
+
+float AtCore::arcTolerance() const
+{
+    return d->arcTolerance;
+}
+
+void AtCore::setArcTolerance(float mm)
+{
+    d->arcTolerance = qMax(0.0f, mm);
+}
+
+bool AtCore::minifyCommands() const
+{
+    return d->minifyCommands;
+}
+
+void AtCore::setMinifyCommands(bool enabled)
+{
+    d->minifyCommands = enabled;
+}
+
+void AtCore::addPrintFilter(const std::function<GCodeFilter *()> &create)
+{
+    if (create) {
+        d->printFilters.append(create);
     }
 }
 
+void AtCore::clearPrintFilters()
+{
+    d->printFilters.clear();
+}
+
 void AtCore::closeConnection()
 {
     if (serialInitialized()) {
@@ -377,7 +782,7 @@ void AtCore::closeConnection()
             setState(AtCore::STOP);
         }
         if (firmwarePluginLoaded()) {
-            disconnect(firmwarePlugin(), &IFirmware::readyForCommand, this, &AtCore::processQueue);
+            disconnect(firmwarePlugin(), &IFirmware::readyForCommand, this, &AtCore::commandAcknowledged);
             disconnect(serial(), &SerialLayer::receivedCommand, this, &AtCore::newMessage);
             if (firmwarePlugin()->name() != QStringLiteral("Grbl")) {
                 disconnect(d->tempTimer, &QTimer::timeout, this, &AtCore::checkTemperature);
@@ -388,6 +793,9 @@ void AtCore::closeConnection()
         QString msg = d->pluginLoader.unload() ? QStringLiteral("success") : QStringLiteral("FAIL");
         qCDebug(ATCORE_PLUGIN) << QStringLiteral("Firmware plugin %1 unload: %2").arg(name, msg);
         serial()->close();
+        d->inFlight.clear();
+        d->inFlightBytes = 0;
+        d->pendingFrames.clear();
         clearSdCardFileList();
         setState(AtCore::DISCONNECTED);
     }
@@ -408,6 +816,18 @@ void AtCore::setState(AtCore::STATES state)
             d->sdCardPrinting = false;
             disconnect(d->tempTimer, &QTimer::timeout, this, &AtCore::sdCardPrintStatus);
         }
+        if ((state == AtCore::FINISHEDPRINT || state == AtCore::STOP) && serialInitialized()) {
+            serial()->setWriteCoalescing(false);
+        }
+        if ((state == AtCore::FINISHEDPRINT || state == AtCore::STOP) && d->journal) {
+            //the job ended on purpose, nothing to resume
+            d->journal->finish();
+            delete d->journal;
+            d->journal = nullptr;
+        }
+        if (state == AtCore::FINISHEDPRINT || state == AtCore::STOP) {
+            d->job.clear();
+        }
         emit(stateChanged(d->printerState));
     }
 }
@@ -416,6 +836,7 @@ void AtCore::stop()
 {
     setState(AtCore::STOP);
     d->commandQueue.clear();
+    d->temperatureQueued = false;
     if (d->sdCardPrinting) {
         stopSdPrint();
     }
@@ -427,18 +848,24 @@ void AtCore::stop()
 void AtCore::emergencyStop()
 {
     d->commandQueue.clear();
+    d->temperatureQueued = false;
+    //the firmware drops whatever it has buffered
+    d->inFlight.clear();
+    d->inFlightBytes = 0;
+    d->pendingFrames.clear();
     if (AtCore::state() == AtCore::BUSY) {
         if (!d->sdCardPrinting) {
             //Stop our running print thread
             setState(AtCore::STOP);
         }
     }
-    serial()->pushCommand(GCode::toCommand(GCode::M112).toLocal8Bit());
+    serial()->setWriteCoalescing(false);
+    serial()->pushCommand(GCodeBuilder::M112);
 }
 
 void AtCore::stopSdPrint()
 {
-    pushCommand(GCode::toCommand(GCode::M25));
+    queueCommand(GCodeBuilder::M25);
     d->sdCardFileName = QString();
     pushCommand(GCode::toCommand(GCode::M23, d->sdCardFileName));
     AtCore::setState(AtCore::FINISHEDPRINT);
@@ -449,7 +876,7 @@ void AtCore::requestFirmware()
 {
     if (serialInitialized()) {
         qCDebug(ATCORE_CORE) << "Sending " << GCode::description(GCode::M115);
-        serial()->pushCommand(GCode::toCommand(GCode::M115).toLocal8Bit());
+        serial()->pushCommand(GCodeBuilder::M115);
     } else {
         qCDebug(ATCORE_CORE) << "There is no open device to send commands";
     }
@@ -508,9 +935,9 @@ void AtCore::detectFirmware()
 void AtCore::pause(const QString &pauseActions)
 {
     if (d->sdCardPrinting) {
-        pushCommand(GCode::toCommand(GCode::M25));
+        queueCommand(GCodeBuilder::M25);
     }
-    pushCommand(GCode::toCommand(GCode::M114));
+    queueCommand(GCodeBuilder::M114);
     if (!pauseActions.isEmpty()) {
         QStringList temp = pauseActions.split(QChar::fromLatin1(','));
         for (int i = 0; i < temp.length(); i++) {
@@ -523,71 +950,69 @@ void AtCore::pause(const QString &pauseActions)
 void AtCore::resume()
 {
     if (d->sdCardPrinting) {
-        pushCommand(GCode::toCommand(GCode::M24));
+        queueCommand(GCodeBuilder::M24);
     } else {
-        pushCommand(GCode::toCommand(GCode::G0, QString::fromLatin1(d->posString)));
+        queueCommand(d->builder.begin(GCode::G0).text(d->posString).command());
     }
     setState(AtCore::BUSY);
+    //the print job waits for the queue
+    processQueue();
 }
 
 /*~~~~~Control Slots ~~~~~~~~*/
 
 void AtCore::home()
 {
-    pushCommand(GCode::toCommand(GCode::G28));
+    queueCommand(GCodeBuilder::G28);
 }
 
 void AtCore::home(uchar axis)
 {
-    QString args;
+    GCodeBuilder &builder = d->builder.begin(GCode::G28);
 
     if (axis & AtCore::X) {
-        args.append(QStringLiteral("X0 "));
+        builder.word('X', 0);
     }
 
     if (axis & AtCore::Y) {
-        args.append(QStringLiteral("Y0 "));
+        builder.word('Y', 0);
     }
 
     if (axis & AtCore::Z) {
-        args.append(QStringLiteral("Z0"));
+        builder.word('Z', 0);
     }
-    pushCommand(GCode::toCommand(GCode::G28, args));
+    queueCommand(builder.command());
 }
 
 void AtCore::setExtruderTemp(uint temp, uint extruder, bool andWait)
 {
     if (andWait) {
-        pushCommand(GCode::toCommand(GCode::M109, QString::number(temp), QString::number(extruder)));
+        queueCommand(d->builder.begin(GCode::M109).word('S', temp).command());
     } else {
-        pushCommand(GCode::toCommand(GCode::M104, QString::number(extruder), QString::number(temp)));
+        queueCommand(d->builder.begin(GCode::M104).word('P', extruder).word('S', temp).command());
     }
-    temperature().setExtruderTargetTemperature(temp);
+    temperature().setExtruderTargetTemperature(temp, int(extruder));
 }
 
 void AtCore::setBedTemp(uint temp, bool andWait)
 {
-    if (andWait) {
-        pushCommand(GCode::toCommand(GCode::M190, QString::number(temp)));
-    } else {
-        pushCommand(GCode::toCommand(GCode::M140, QString::number(temp)));
-    }
+    queueCommand(d->builder.begin(andWait ? GCode::M190 : GCode::M140).word('S', temp).command());
     temperature().setBedTargetTemperature(temp);
 }
 
 void AtCore::setFanSpeed(uint speed, uint fanNumber)
 {
-    pushCommand(GCode::toCommand(GCode::M106, QString::number(fanNumber), QString::number(speed)));
+    queueCommand(d->builder.begin(GCode::M106).word('P', fanNumber).word('S', speed).command());
 }
 
 void AtCore::setPrinterSpeed(uint speed)
 {
-    pushCommand(GCode::toCommand(GCode::M220, QString::number(speed)));
+    queueCommand(d->builder.begin(GCode::M220).word('S', speed).command());
 }
 
 void AtCore::setFlowRate(uint speed)
 {
-    pushCommand(GCode::toCommand(GCode::M221, QString::number(speed)));
+    queueCommand(d->builder.begin(GCode::M221).word('S', speed).command());
 }
 
 void AtCore::move(AtCore::AXES axis, int arg)
@@ -614,7 +1039,7 @@ void AtCore::move(AtCore::AXES axis, int arg)
 
 void AtCore::move(QLatin1Char axis, int arg)
 {
-    pushCommand(GCode::toCommand(GCode::G1, QStringLiteral("%1 %2").arg(axis).arg(QString::number(arg))));
+    queueCommand(d->builder.begin(GCode::G1).word(axis.latin1(), arg).command());
 }
 
 int AtCore::extruderCount() const
@@ -622,11 +1047,14 @@ int AtCore::extruderCount() const
     return d->extruderCount;
 }
 
-void AtCore::processQueue()
+bool AtCore::temperatureAutoReport() const
 {
-    d->ready = true;
+    return d->temperatureAutoReport;
+}
 
-    if (d->commandQueue.isEmpty()) {
+void AtCore::processQueue()
+{
+    if (d->commandQueue.isEmpty() && d->pendingFrames.isEmpty() && (!d->job || d->job->commands.isEmpty())) {
         return;
     }
 
@@ -635,22 +1063,281 @@ void AtCore::processQueue()
         return;
     }
 
-    QString text = d->commandQueue.takeAt(0);
+    if (!firmwarePluginLoaded()) {
+        //commands wait for the firmware to be known
+        return;
+    }
 
-    if (firmwarePluginLoaded()) {
-        serial()->pushCommand(firmwarePlugin()->translate(text));
+    // resends and M110 go first, they are framed already
+    while (!d->pendingFrames.isEmpty()) {
+        if (!canSendCommand(d->pendingFrames.first().frame.size() + 2)) {
+            return;
+        }
+        const PendingFrame pending = d->pendingFrames.takeFirst();
+        sendCommand(pending.frame, commandClass(pending.frame), false, pending.jobOffset, pending.jobCommand, pending.line);
+    }
+
+    while (!d->commandQueue.isEmpty()) {
+        if (!sendQueuedCommand(d->commandQueue.first())) {
+            return;
+        }
+        if (d->temperatureQueued && d->commandQueue.first() == GCodeBuilder::M105) {
+            d->temperatureQueued = false;
+        }
+        d->commandQueue.removeFirst();
+    }
+
+    //the print job only streams while printing, user commands go first
+    if (!d->job || (state() != AtCore::BUSY && state() != AtCore::STARTPRINT)) {
+        return;
+    }
+    PrintJob &job = *d->job;
+    while (const PrintJobCommand *next = job.commands.front()) {
+        if (!sendQueuedCommand(next->command, next->offset)) {
+            break;
+        }
+        job.sentOffset = next->offset;
+        job.sentFileOffset = next->fileOffset;
+        PrintJobCommand sent;
+        job.commands.pop(sent);
+    }
+    if (job.commands.size() < job.lowWater && !job.wakePending.exchange(true)) {
+        emit printJobDrained(QPrivateSignal());
+    }
+}
+
+bool AtCore::sendQueuedCommand(const QByteArray &comm, qint64 jobOffset)
+{
+    QByteArray command = firmwarePlugin()->translate(comm);
+    const bool binary = firmwarePlugin()->isBinary(command);
+    // SerialLayer terminates each ASCII command with "\n\r"
+    int size = command.size() + (binary ? 0 : 2);
+    if (d->lineNumbering && !binary) {
+        // "N<line> " and "*<checksum>", the checksum has at most 3 digits
+        size += QByteArray::number(d->retransmit.nextLineNumber()).size() + 6;
+    }
+    //each numbered line of a multi-line translation is pushed on its own
+    const int commands = d->lineNumbering && !binary ? command.count('\n') + 1 : 1;
+    if (!canSendCommand(size, commands)) {
+        return false;
+    }
+    const AtCore::COMMAND_CLASS kind = commandClass(comm);
+    QByteArray jobCommand;
+    if (jobOffset != -1 && d->journal) {
+        //the journal reads the command as the job wrote it
+        jobCommand = binary ? comm : command;
+    }
+    int line = -1;
+    if (d->lineNumbering && !binary) {
+        //some plugins translate to several lines, each one needs its own number
+        const QList<QByteArray> lines = command.split('\n');
+        for (int i = 0; i < lines.size() - 1; i++) {
+            sendCommand(d->retransmit.frame(lines.at(i).trimmed()), kind);
+        }
+        line = d->retransmit.nextLineNumber();
+        command = d->retransmit.frame(lines.last().trimmed());
+    }
+    sendCommand(command, kind, binary, jobOffset, jobCommand, line);
+    return true;
+}
+
+void AtCore::sendCommand(const QByteArray &command, AtCore::COMMAND_CLASS commandClass, bool binary, qint64 jobOffset, const QByteArray &jobCommand, int line)
+{
+    const int size = command.size() + (binary ? 0 : 2);
+    if (binary) {
+        serial()->pushCommand(command, QByteArray());
     } else {
-        serial()->pushCommand(text.toLocal8Bit());
+        serial()->pushCommand(command);
+    }
+    d->inFlight.enqueue({size, commandClass, d->clock.nsecsElapsed(), jobOffset, jobCommand, line});
+    d->inFlightBytes += size;
+}
+
+void AtCore::commandAcknowledged()
+{
+    if (!d->inFlight.isEmpty()) {
+        const InFlightCommand command = d->inFlight.dequeue();
+        d->inFlightBytes -= command.size;
+        d->latency[command.commandClass].record(quint64(d->clock.nsecsElapsed() - command.sent) / 1000);
+        if (command.jobOffset != -1 && d->journal) {
+            d->journal->acknowledged(command.jobCommand, command.jobOffset);
+        }
+    }
+    processQueue();
+}
+
+bool AtCore::canSendCommand(int size, int commands) const
+{
+    //a full I/O thread queue holds everything back until it drained
+    if (!serial()->canPushCommand(commands)) {
+        return false;
+    }
+
+    if (d->inFlight.isEmpty()) {
+        return true;
+    }
+
+    const int bufferSize = firmwarePlugin()->bufferSize();
+    if (!d->streamingWindow || bufferSize <= 0) {
+        //one command at a time
+        return false;
+    }
+
+    if (d->firmwareFreeSlots != -1 && d->inFlight.size() >= d->firmwareFreeSlots) {
+        return false;
+    }
+    return d->inFlightBytes + size <= bufferSize;
+}
+
+bool AtCore::streamingWindow() const
+{
+    return d->streamingWindow;
+}
+
+void AtCore::setStreamingWindow(bool enabled)
+{
+    d->streamingWindow = enabled;
+    updateWriteCoalescing();
+    processQueue();
+}
+
+int AtCore::commandWindow() const
+{
+    if (!d->streamingWindow || !firmwarePluginLoaded() || firmwarePlugin()->bufferSize() <= 0) {
+        return 1;
+    }
+    if (d->firmwareFreeSlots > 0) {
+        return d->firmwareFreeSlots;
+    }
+    //Assume short moves, dense gcode is where the window matters.
+    return qMax(1, firmwarePlugin()->bufferSize() / 16);
+}
+
+bool AtCore::lineNumbering() const
+{
+    return d->lineNumbering;
+}
+
+void AtCore::setLineNumbering(bool enabled)
+{
+    if (d->lineNumbering == enabled) {
+        return;
+    }
+    d->lineNumbering = enabled;
+    d->pendingFrames.clear();
+    if (enabled && firmwarePluginLoaded()) {
+        resetLineNumber();
+    }
+}
+
+const LatencyHistogram &AtCore::commandLatency(AtCore::COMMAND_CLASS commandClass) const
+{
+    return d->latency[commandClass];
+}
+
+PrintTimeEstimator &AtCore::printTimeEstimator() const
+{
+    return *d->estimator;
+}
+
+void AtCore::resetCommandLatency()
+{
+    for (auto &histogram : d->latency) {
+        histogram.reset();
+    }
+}
+
+int AtCore::lineErrors() const
+{
+    return d->lineErrors;
+}
+
+int AtCore::retransmits() const
+{
+    return d->retransmits;
+}
+
+void AtCore::updateWriteCoalescing()
+{
+    if (!serialInitialized()) {
+        return;
+    }
+    //a print streaming several commands goes in as few USB packets as possible,
+    //one at a time each command would wait for the flush deadline
+    const bool coalesce = d->job && commandWindow() > 1;
+    if (serial()->writeCoalescing() != coalesce) {
+        serial()->setWriteCoalescing(coalesce);
+    }
+}
+
+void AtCore::resetLineNumber()
+{
+    d->lastResend = -1;
+    d->staleResends = 0;
+    PendingFrame reset;
+    reset.frame = d->retransmit.reset(0);
+    d->pendingFrames.append(reset);
+    processQueue();
+}
+
+void AtCore::resendFrom(int line)
+{
+    if (!d->lineNumbering) {
+        return;
+    }
+
+    if (line == d->lastResend && d->staleResends > 0) {
+        //Lines sent after a bad one are dropped too and each asks for the same resend.
+        d->staleResends--;
+        return;
+    }
+
+    QList<QByteArray> lines;
+    if (!d->retransmit.resend(line, lines)) {
+        qCDebug(ATCORE_CORE) << "Can't resend line" << line << ", it is no longer kept.";
+        return;
+    }
+    qCDebug(ATCORE_CORE) << "Resending" << lines.size() << "lines from" << line;
+    d->lastResend = line;
+    d->staleResends = qMax(0, d->inFlight.size() - 1);
+    d->retransmits += lines.size();
+
+    QList<PendingFrame> frames;
+    for (int i = 0; i < lines.size(); i++) {
+        PendingFrame frame;
+        frame.frame = lines.at(i);
+        frame.line = line + i;
+        frames.append(frame);
+    }
+    //the firmware dropped the lines from the bad one on, the "ok"s it sends for them
+    //acknowledge nothing, the print job commands they carry go with the lines sent again
+    const auto moveJob = [&frames, line](int frameLine, qint64 &jobOffset, QByteArray &jobCommand) {
+        const int i = frameLine - line;
+        if (frameLine == -1 || jobOffset == -1 || i < 0 || i >= frames.size()) {
+            return;
+        }
+        frames[i].jobOffset = jobOffset;
+        frames[i].jobCommand = jobCommand;
+        jobOffset = -1;
+        jobCommand.clear();
+    };
+    for (InFlightCommand &command : d->inFlight) {
+        moveJob(command.line, command.jobOffset, command.jobCommand);
+    }
+    //lines of an earlier resend not sent yet
+    for (PendingFrame &pending : d->pendingFrames) {
+        moveJob(pending.line, pending.jobOffset, pending.jobCommand);
     }
-    d->ready = false;
+    d->pendingFrames = frames;
 }
 
 void AtCore::checkTemperature()
 {
-    if (d->commandQueue.contains(GCode::toCommand(GCode::M105))) {
+    if (d->temperatureQueued || d->temperatureAutoReport) {
         return;
     }
-    pushCommand(GCode::toCommand(GCode::M105));
+    d->temperatureQueued = true;
+    queueCommand(GCodeBuilder::M105);
 }
 
 void AtCore::showMessage(const QString &message)
@@ -755,5 +1442,5 @@ void AtCore::setReadingSdCardList(bool readingList)
 
 void AtCore::sdCardPrintStatus()
 {
-    pushCommand(GCode::toCommand(GCode::M27));
+    queueCommand(GCodeBuilder::M27);
 }
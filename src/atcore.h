@@ -28,13 +28,20 @@
 #include <QObject>
 #include <QList>
 #include <QSerialPortInfo>
+#include <functional>
 
+#include "gcodeanalyzer.h"
+#include "gcodebuilder.h"
+#include "gcodepipeline.h"
 #include "ifirmware.h"
 #include "temperature.h"
 #include "atcore_export.h"
 
 class SerialLayer;
 class IFirmware;
+class GCodeIndex;
+class LatencyHistogram;
+class PrintTimeEstimator;
 class QTime;
 
 struct AtCorePrivate;
@@ -61,6 +68,14 @@ class ATCORE_EXPORT AtCore : public QObject
     Q_PROPERTY(AtCore::STATES state READ state WRITE setState NOTIFY stateChanged)
     Q_PROPERTY(bool sdMount READ isSdMounted WRITE setSdMounted NOTIFY sdMountChanged)
     Q_PROPERTY(QStringList sdFileList READ sdFileList NOTIFY sdCardFileListChanged)
+    Q_PROPERTY(bool streamingWindow READ streamingWindow WRITE setStreamingWindow)
+    Q_PROPERTY(bool lineNumbering READ lineNumbering WRITE setLineNumbering)
+    Q_PROPERTY(bool printJournal READ printJournal WRITE setPrintJournal)
+    Q_PROPERTY(int progressInterval READ progressInterval WRITE setProgressInterval)
+    Q_PROPERTY(float progressStep READ progressStep WRITE setProgressStep)
+    Q_PROPERTY(bool arcFitting READ arcFitting WRITE setArcFitting)
+    Q_PROPERTY(float arcTolerance READ arcTolerance WRITE setArcTolerance)
+    Q_PROPERTY(bool minifyCommands READ minifyCommands WRITE setMinifyCommands)
 
     //Add friends as Sd Card support is extended to more plugins.
     friend class RepetierPlugin;
@@ -104,6 +119,18 @@ public:
         IMPERIAL    //!< Imperial Units (Feet)
     };
     Q_ENUM(UNITS)
+    /**
+     * @brief The COMMAND_CLASS enum - Classes of commands for latency statistics
+     */
+    enum COMMAND_CLASS {
+        MOVE,           //!< G0 and G1 moves
+        GCODE,          //!< Other G commands
+        TEMPERATURE,    //!< M105 temperature reports
+        SDCARD,         //!< Sd card commands: M20 - M30, M32 and M928
+        MCODE,          //!< Other M commands
+        OTHER           //!< Anything else
+    };
+    Q_ENUM(COMMAND_CLASS)
     /**
      * @brief AtCore create a new instance of AtCore
      * @param parent: parent of the object
@@ -133,10 +160,11 @@ public:
      * @brief Initialize a connection to \p port at a speed of \p baud <br />
      * @param port: the port to initialize
      * @param baud: the baud of the port
+     * @param ioThread: True to read and write the port on its own thread, see SerialLayer::startIoThread()
      * @return True is connection was successful
      * @sa serialPorts(),serial(),closeConnection()
      */
-    Q_INVOKABLE bool initSerial(const QString &port, int baud);
+    Q_INVOKABLE bool initSerial(const QString &port, int baud, bool ioThread = false);
 
     /**
      * @brief Returns a list of valid baud speeds
@@ -195,6 +223,15 @@ public:
      */
     int extruderCount() const;
 
+    /**
+     * @brief Temperatures are reported by the firmware
+     *
+     * Firmwares advertising "Cap:AUTOREPORT_TEMP:1" in their M115 reply are
+     * asked to report temperatures with M155 instead of being polled with M105.
+     * @return True if M155 was sent, false while polling
+     */
+    bool temperatureAutoReport() const;
+
     /**
      * @brief Return printed percentage
      * @sa printProgressChanged()
@@ -235,6 +272,139 @@ public:
      */
     bool isSdMounted() const;
 
+    /**
+     * @brief Check if commands are streamed with a sliding window
+     * @return True if more than one command may be in flight
+     * @sa setStreamingWindow(),commandWindow()
+     */
+    bool streamingWindow() const;
+
+    /**
+     * @brief Number of commands a print job should keep queued ahead of the firmware
+     * @return 1 unless the streaming window is enabled and supported by the firmware plugin
+     * @sa streamingWindow(),IFirmware::bufferSize()
+     */
+    int commandWindow() const;
+
+    /**
+     * @brief Check if commands are sent with line numbers and checksums
+     * @return True if line numbering is enabled
+     * @sa setLineNumbering(),lineErrors(),retransmits()
+     */
+    bool lineNumbering() const;
+
+    /**
+     * @brief Check if host-streamed prints keep a journal to resume from
+     * @return True if print journals are enabled, the default
+     * @sa setPrintJournal(),resumePrint()
+     */
+    bool printJournal() const;
+
+    /**
+     * @brief Check if \p fileName has a journal to resume from
+     * @param fileName: gcode file that was printed
+     * @sa resumePrint()
+     */
+    bool canResumePrint(const QString &fileName) const;
+
+    /**
+     * @brief Longest time between two printProgressChanged() during a print
+     * @return time in ms, 250 by default
+     * @sa setProgressInterval(),progressStep()
+     */
+    int progressInterval() const;
+
+    /**
+     * @brief Progress change published by printProgressChanged() without waiting for progressInterval()
+     * @return step in percent, 0.1 by default
+     * @sa setProgressStep()
+     */
+    float progressStep() const;
+
+    /**
+     * @brief Check if streamed prints replace runs of G1 moves along an arc by G2 and G3
+     * @return True if arc fitting is enabled, false by default
+     * @sa setArcFitting(),arcTolerance()
+     */
+    bool arcFitting() const;
+
+    /**
+     * @brief Largest distance of a G1 move from the arc replacing it
+     * @return tolerance in mm, 0.05 by default
+     * @sa setArcTolerance()
+     */
+    float arcTolerance() const;
+
+    /**
+     * @brief Check if streamed prints are sent with as few bytes as possible
+     * @return True if minifying is enabled, false by default
+     * @sa setMinifyCommands()
+     */
+    bool minifyCommands() const;
+
+    /**
+     * @brief Run streamed prints through a stage of your own before they are sent
+     *
+     * \p create is called for every print() to make a fresh stage, which the print
+     * thread deletes when the job ends. Stages run on the thread reading the job,
+     * in the order they were added and before arc fitting and minifying.
+     * printPipelineStats() reports what each stage cost at the end of the job.
+     * Takes effect on the next print().
+     * @param create: returns a new stage
+     * @sa clearPrintFilters()
+     */
+    void addPrintFilter(const std::function<GCodeFilter *()> &create);
+
+    /**
+     * @brief Remove the stages added with addPrintFilter()
+     * Takes effect on the next print().
+     */
+    void clearPrintFilters();
+
+    /**
+     * @brief Line number and checksum errors reported by the firmware since the plugin was loaded
+     * @sa lineNumbering()
+     */
+    int lineErrors() const;
+
+    /**
+     * @brief Time from sending a command to its "ok", for one class of commands
+     *
+     * Every acknowledged command is recorded, reading the histogram is lock-free
+     * and can happen from any thread.
+     * @param commandClass: class of the commands
+     * @return latency histogram in microseconds
+     * @sa resetCommandLatency()
+     */
+    const LatencyHistogram &commandLatency(AtCore::COMMAND_CLASS commandClass) const;
+
+    /**
+     * @brief Print time estimator of this printer
+     *
+     * Set the printer's motion limits on it, print() estimates with them. It can also
+     * estimate a file before printing it, see PrintTimeEstimator::start().
+     */
+    PrintTimeEstimator &printTimeEstimator() const;
+
+    /**
+     * @brief Read what a job does before printing it
+     *
+     * The bounds, filament, layers, feedrates, tools and temperatures of the job,
+     * to reject a job the printer can't take before streaming starts. The file
+     * is parsed on all cores, this blocks until done.
+     * @param fileName: the gcode file, not compressed
+     * @param analysis: filled with what the job does
+     * @return False if the file can't be read
+     * @sa GCodeAnalyzer
+     */
+    bool analyzeJob(const QString &fileName, GCodeAnalyzer::Analysis &analysis) const;
+
+    /**
+     * @brief Lines sent again on "Resend" requests since the plugin was loaded
+     * @sa lineNumbering()
+     */
+    int retransmits() const;
+
 signals:
 
     /**
@@ -244,6 +414,41 @@ signals:
      */
     void printProgressChanged(const float &newProgress);
 
+    /**
+     * @brief The print job reached a new layer
+     * @param layer: layer being printed, from 0
+     * @param layerCount: number of layers in the job
+     */
+    void printLayerChanged(int layer, int layerCount);
+
+    /**
+     * @brief The estimated time left of the print job changed
+     * @param seconds: time left, from a kinematic simulation of the job
+     * @sa printTimeEstimator()
+     */
+    void printTimeRemainingChanged(int seconds);
+
+    /**
+     * @brief A minified print ended
+     * @param savedBytes: bytes not sent thanks to minifying
+     * @param jobBytes: bytes of the job's commands before minifying
+     * @sa setMinifyCommands()
+     */
+    void printMinified(qint64 savedBytes, qint64 jobBytes);
+
+    /**
+     * @brief A print that went through filter stages ended
+     * @param stages: lines in, lines out and time spent of each stage, in order
+     * @sa addPrintFilter()
+     */
+    void printPipelineStats(const QVector<GCodePipeline::StageStats> &stages);
+
+    /**
+     * @brief The lookahead queue of the print job ran low
+     * Connected to PrintThread::processJob
+     */
+    void printJobDrained(QPrivateSignal);
+
     /**
      * @brief New message was received from the printer
      * @param message: Message that was received
@@ -288,13 +493,34 @@ public slots:
      */
     void pushCommand(const QString &comm);
 
+    /**
+     * @brief Push a command built with a GCodeBuilder into the command queue
+     *
+     * The command is queued as bytes, without a conversion to QString and back.
+     * @param command : builder holding the command
+     */
+    void pushCommand(const GCodeBuilder &command);
+
     /**
      * @brief Public Interface for printing a file
+     * gzip, bzip2 and zstd compressed files are decompressed while printing.
      * @param fileName: the gcode file to print.
      * @param sdPrint: set true to print fileName from Sd card
      */
     void print(const QString &fileName, bool sdPrint = false);
 
+    /**
+     * @brief Index a gcode file, loading its sidecar index or building and caching it
+     *
+     * print() does this by itself on the print thread, calling it earlier saves the time
+     * at the start of the print. This blocks until done.
+     * @param fileName: the gcode file to index.
+     * @param index: filled with the line offsets and layers of the file
+     * @return False if the file can't be read
+     * @sa GCodeIndex
+     */
+    bool indexJob(const QString &fileName, GCodeIndex &index) const;
+
     /**
      * @brief Stop the Printer by empting the queue and aborting the print job (if running)
      * @sa emergencyStop(),pause(),resume()
@@ -442,6 +668,105 @@ public slots:
      */
     void sdCardPrintStatus();
 
+    /**
+     * @brief Keep several commands in flight instead of waiting for an "ok" after each one
+     *
+     * The window is limited by IFirmware::bufferSize() and, on firmwares reporting
+     * ADVANCED_OK ("ok N P B"), by the free command slots they report.
+     * Firmware plugins without a buffer size keep sending one command at a time.
+     * @param enabled: True to enable the streaming window
+     * @sa streamingWindow()
+     */
+    void setStreamingWindow(bool enabled);
+
+    /**
+     * @brief Send commands as "N<line> <command>*<checksum>"
+     *
+     * Numbering restarts with an M110 when enabled and on each firmware plugin load.
+     * The last lines sent are kept and sent again when the firmware asks with "Resend: <line>".
+     * @param enabled: True to enable line numbers and checksums
+     * @sa lineNumbering()
+     */
+    void setLineNumbering(bool enabled);
+
+    /**
+     * @brief Keep a journal of host-streamed prints
+     *
+     * The journal, next to the gcode file, records the last line the firmware acknowledged
+     * and the position, temperatures and fan at that point. It is deleted when the print
+     * finishes or is stopped, so one left behind means the host or the printer went down.
+     * Takes effect on the next print().
+     * @param enabled: True to journal prints
+     * @sa PrintJournal,resumePrint()
+     */
+    void setPrintJournal(bool enabled);
+
+    /**
+     * @brief Continue a print that was cut short, from its journal
+     *
+     * Heats the bed and the extruder back to their last targets, lifts Z, homes X and Y,
+     * restores position, E, modes, fan and feedrate and streams the rest of the file.
+     * @param fileName: the gcode file that was printed
+     * @return False if there is no journal for this version of the file
+     * @sa canResumePrint(),setPrintJournal()
+     */
+    bool resumePrint(const QString &fileName);
+
+    /**
+     * @brief Set the longest time between two printProgressChanged() during a print
+     *
+     * Progress is published when this time has passed or it moved by progressStep(),
+     * whichever comes first, so listeners are not woken for every line. Takes effect on the next print().
+     * @param msecs: time in ms
+     * @sa progressInterval(),setProgressStep()
+     */
+    void setProgressInterval(int msecs);
+
+    /**
+     * @brief Set the progress change published without waiting for progressInterval()
+     * Takes effect on the next print().
+     * @param percent: step in percent
+     * @sa progressStep(),setProgressInterval()
+     */
+    void setProgressStep(float percent);
+
+    /**
+     * @brief Replace runs of G1 moves along an arc by G2 and G3 in streamed prints
+     *
+     * Fewer lines go over the serial link and through the firmware planner on curved
+     * perimeters. Only used with firmwares supporting arcs, see IFirmware::supportsArcs().
+     * Takes effect on the next print().
+     * @param enabled: True to fit arcs
+     * @sa arcFitting(),setArcTolerance()
+     */
+    void setArcFitting(bool enabled);
+
+    /**
+     * @brief Set the largest distance of a G1 move from the arc replacing it
+     * Takes effect on the next print().
+     * @param mm: tolerance in mm
+     * @sa arcTolerance(),setArcFitting()
+     */
+    void setArcTolerance(float mm);
+
+    /**
+     * @brief Send streamed prints with as few bytes as possible
+     *
+     * Repeated feedrates, axis words repeating the position and needless zeros are
+     * dropped from moves, and the spaces between words for firmwares that read them
+     * without, see IFirmware::supportsCompactWords(). printMinified() reports the
+     * bytes saved at the end of the job. Takes effect on the next print().
+     * @param enabled: True to minify
+     * @sa minifyCommands()
+     */
+    void setMinifyCommands(bool enabled);
+
+    /**
+     * @brief Forget the latencies recorded for all command classes
+     * @sa commandLatency()
+     */
+    void resetCommandLatency();
+
 private slots:
     /**
      * @brief processQueue send commands from the queue.
@@ -449,7 +774,13 @@ private slots:
     void processQueue();
 
     /**
-     * @brief Send M105 to the printer if one is not in the Queue
+     * @brief The firmware acknowledged the oldest command in flight
+     * Connect to IFirmware::readyForCommand
+     */
+    void commandAcknowledged();
+
+    /**
+     * @brief Send M105 to the printer if one is not in the Queue and the firmware doesn't report temperatures
      */
     void checkTemperature();
 
@@ -487,6 +818,62 @@ private:
      */
     bool serialInitialized() const;
 
+    /**
+     * @brief Check if a command of \p size bytes fits in the streaming window
+     * @param size: bytes that will be written for the command
+     * @param commands: number of lines the command is pushed as
+     * @return True if the command can be sent now
+     */
+    bool canSendCommand(int size, int commands = 1) const;
+
+    /**
+     * @brief Write \p command and count it as in flight
+     * @param command: translated, and framed if needed, command
+     * @param commandClass: class of \p command for commandLatency()
+     * @param binary: True if \p command is a binary frame, written without terminator
+     * @param jobOffset: byte offset after the command in the print job, -1 if not from a job
+     * @param jobCommand: the job command for the print journal
+     * @param line: line number of \p command, -1 if not numbered
+     */
+    void sendCommand(const QByteArray &command, AtCore::COMMAND_CLASS commandClass, bool binary = false, qint64 jobOffset = -1, const QByteArray &jobCommand = QByteArray(), int line = -1);
+
+    /**
+     * @brief Translate, frame and send a queued command if it fits in the streaming window
+     * @param comm: the command
+     * @param jobOffset: byte offset after the command in the print job, -1 if not from a job
+     * @return False if the command has to wait
+     */
+    bool sendQueuedCommand(const QByteArray &comm, qint64 jobOffset = -1);
+
+    /**
+     * @brief Append a command to the command queue and send what fits
+     * @param command: the command as sent, before translation by the firmware plugin
+     */
+    void queueCommand(const QByteArray &command);
+
+    /**
+     * @brief Stream a file from a PrintThread
+     * @param fileName: the gcode file to print
+     * @param offset: byte offset to start at
+     */
+    void startPrintThread(const QString &fileName, qint64 offset);
+
+    /**
+     * @brief Coalesce writes while a print streams more than one command at a time
+     */
+    void updateWriteCoalescing();
+
+    /**
+     * @brief Restart line numbering with an M110
+     */
+    void resetLineNumber();
+
+    /**
+     * @brief Queue the lines the firmware asked for again
+     * @param line: first line to resend
+     */
+    void resendFrom(int line);
+
     /**
      * @brief send firmware request to the printer
      */
@@ -0,0 +1,347 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QLoggingCategory>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "gcodeanalyzer.h"
+#include "gcodechunkparser.h"
+#include "gcodedecompressor.h"
+#include "gcodereader.h"
+
+Q_LOGGING_CATEGORY(GCODE_ANALYZER, "org.kde.atelier.core.gcodeAnalyzer")
+
+namespace
+{
+const double _pi = 3.14159265358979323846;
+// moves this close are at the same height
+const double _layerEpsilon = 1e-4;
+// tools beyond this are a broken file, not a printer
+const int _maxTool = 255;
+
+typedef GCodeChunkParser::Record Record;
+typedef GCodeChunkParser::Word Word;
+
+/**
+ * @brief True for the commands the analysis follows
+ */
+bool isAnalyzed(char letter, int code)
+{
+    switch (letter) {
+    case 'G':
+        return (code >= 0 && code <= 3) || code == 20 || code == 21 || code == 28 || (code >= 90 && code <= 92);
+    case 'M':
+        return code == 82 || code == 83 || code == 104 || code == 109 || code == 140 || code == 190;
+    case 'T':
+        return code >= 0 && code <= _maxTool;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Insert \p value in the sorted \p values if it isn't there
+ */
+void insertSorted(QVector<double> &values, double value)
+{
+    const auto it = std::lower_bound(values.begin(), values.end(), value);
+    if (it == values.end() || *it != value) {
+        values.insert(it, value);
+    }
+}
+
+/**
+ * @brief Follows the modal state of a job over its parsed commands, in order
+ */
+class Tracker
+{
+public:
+    explicit Tracker(GCodeAnalyzer::Analysis &analysis) : _analysis(analysis)
+    {
+        const double infinity = std::numeric_limits<double>::infinity();
+        for (int axis = 0; axis < 3; axis++) {
+            _minimum[axis] = _printMinimum[axis] = infinity;
+            _maximum[axis] = _printMaximum[axis] = -infinity;
+        }
+    }
+
+    void process(const Record &record)
+    {
+        if (record.letter == 'G') {
+            processG(record);
+        } else if (record.letter == 'M') {
+            processM(record);
+        } else {
+            _tool = record.code;
+        }
+    }
+
+    /**
+     * @brief Write the bounds and tools into the analysis
+     */
+    void finish()
+    {
+        for (int axis = 0; axis < 3; axis++) {
+            const bool reached = _minimum[axis] <= _maximum[axis];
+            _analysis.minimum[axis] = reached ? _minimum[axis] : 0;
+            _analysis.maximum[axis] = reached ? _maximum[axis] : 0;
+            const bool printed = _printMinimum[axis] <= _printMaximum[axis];
+            _analysis.printMinimum[axis] = printed ? _printMinimum[axis] : 0;
+            _analysis.printMaximum[axis] = printed ? _printMaximum[axis] : 0;
+        }
+        _analysis.tools.clear();
+        for (int tool = 0; tool < _analysis.filament.size(); tool++) {
+            if (_analysis.filament.at(tool) > 0) {
+                _analysis.tools.append(tool);
+            }
+        }
+    }
+
+private:
+    void processG(const Record &record)
+    {
+        switch (record.code) {
+        case 0:
+        case 1:
+        case 2:
+        case 3:
+            move(record);
+            break;
+        case 20:
+            _scale = 25.4;
+            break;
+        case 21:
+            _scale = 1;
+            break;
+        case 28: {
+            const bool all = !record.has(GCodeChunkParser::WordX) && !record.has(GCodeChunkParser::WordY) && !record.has(GCodeChunkParser::WordZ);
+            for (int axis = 0; axis < 3; axis++) {
+                if (all || record.has(Word(axis))) {
+                    _position[axis] = 0;
+                    _known[axis] = true;
+                }
+            }
+            break;
+        }
+        case 90:
+            _relative = false;
+            break;
+        case 91:
+            _relative = true;
+            break;
+        case 92:
+            for (int axis = 0; axis < 4; axis++) {
+                if (record.has(Word(axis))) {
+                    _position[axis] = record.value[axis] * _scale;
+                    _known[axis] = true;
+                }
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    void processM(const Record &record)
+    {
+        switch (record.code) {
+        case 82:
+            _relativeE = false;
+            break;
+        case 83:
+            _relativeE = true;
+            break;
+        case 104:
+        case 109:
+            if (record.has(GCodeChunkParser::WordS) && record.value[GCodeChunkParser::WordS] > 0) {
+                insertSorted(_analysis.extruderTemperatures, record.value[GCodeChunkParser::WordS]);
+            }
+            break;
+        case 140:
+        case 190:
+            if (record.has(GCodeChunkParser::WordS) && record.value[GCodeChunkParser::WordS] > 0) {
+                insertSorted(_analysis.bedTemperatures, record.value[GCodeChunkParser::WordS]);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    void move(const Record &record)
+    {
+        if (record.has(GCodeChunkParser::WordF) && record.value[GCodeChunkParser::WordF] > 0) {
+            const double feedrate = record.value[GCodeChunkParser::WordF] * _scale;
+            if (_analysis.maximumFeedrate == 0) {
+                _analysis.minimumFeedrate = _analysis.maximumFeedrate = feedrate;
+            } else {
+                _analysis.minimumFeedrate = qMin(_analysis.minimumFeedrate, feedrate);
+                _analysis.maximumFeedrate = qMax(_analysis.maximumFeedrate, feedrate);
+            }
+        }
+
+        double start[3];
+        bool moved = false;
+        for (int axis = 0; axis < 3; axis++) {
+            start[axis] = _position[axis];
+            if (!record.has(Word(axis))) {
+                continue;
+            }
+            const double value = record.value[axis] * _scale;
+            if (_relative) {
+                // relative to a position never set, the place stays unknown
+                _position[axis] += value;
+                moved = moved || value != 0;
+            } else {
+                moved = moved || !_known[axis] || value != _position[axis];
+                _position[axis] = value;
+                _known[axis] = true;
+            }
+        }
+
+        double extruded = 0;
+        if (record.has(GCodeChunkParser::WordE)) {
+            const double value = record.value[GCodeChunkParser::WordE] * _scale;
+            extruded = _relative || _relativeE ? value : value - _position[3];
+            _position[3] += extruded;
+            addFilament(extruded);
+        }
+
+        include(_position, _minimum, _maximum);
+        const bool printing = extruded > 0 && moved;
+        if (printing) {
+            include(start, _printMinimum, _printMaximum);
+            include(_position, _printMinimum, _printMaximum);
+        }
+        if ((record.code == 2 || record.code == 3) && _known[0] && _known[1]) {
+            includeArc(record, start, printing);
+        }
+        if (printing && _known[2] && (_analysis.layerHeights.isEmpty() || _position[2] > _analysis.layerHeights.last() + _layerEpsilon)) {
+            _analysis.layerHeights.append(_position[2]);
+        }
+    }
+
+    void addFilament(double extruded)
+    {
+        if (_analysis.filament.size() <= _tool) {
+            _analysis.filament.resize(_tool + 1);
+        }
+        _analysis.filament[_tool] += extruded;
+    }
+
+    /**
+     * @brief Grow \p minimum and \p maximum to \p position, for the known axes
+     */
+    void include(const double *position, double *minimum, double *maximum) const
+    {
+        for (int axis = 0; axis < 3; axis++) {
+            if (_known[axis]) {
+                minimum[axis] = qMin(minimum[axis], position[axis]);
+                maximum[axis] = qMax(maximum[axis], position[axis]);
+            }
+        }
+    }
+
+    /**
+     * @brief Include the X and Y extremes an I J arc passes through
+     */
+    void includeArc(const Record &record, const double *start, bool printing)
+    {
+        if (!record.has(GCodeChunkParser::WordI) && !record.has(GCodeChunkParser::WordJ)) {
+            return;
+        }
+        const double centerX = start[0] + (record.has(GCodeChunkParser::WordI) ? record.value[GCodeChunkParser::WordI] * _scale : 0);
+        const double centerY = start[1] + (record.has(GCodeChunkParser::WordJ) ? record.value[GCodeChunkParser::WordJ] * _scale : 0);
+        const double radius = std::hypot(start[0] - centerX, start[1] - centerY);
+        const double from = std::atan2(start[1] - centerY, start[0] - centerX);
+        const double to = std::atan2(_position[1] - centerY, _position[0] - centerX);
+        const bool clockwise = record.code == 2;
+        double sweep = clockwise ? from - to : to - from;
+        while (sweep <= 1e-9) {
+            sweep += 2 * _pi;
+        }
+        for (int quadrant = 0; quadrant < 4; quadrant++) {
+            const double angle = quadrant * _pi / 2;
+            const double along = std::fmod((clockwise ? from - angle : angle - from) + 4 * _pi, 2 * _pi);
+            if (along > sweep) {
+                continue;
+            }
+            const double point[3] = {centerX + radius * std::cos(angle), centerY + radius * std::sin(angle), _position[2]};
+            include(point, _minimum, _maximum);
+            if (printing) {
+                include(point, _printMinimum, _printMaximum);
+            }
+        }
+    }
+
+    GCodeAnalyzer::Analysis &_analysis;
+    double _position[4] = {0, 0, 0, 0};
+    bool _known[4] = {false, false, false, false};
+    double _minimum[3];
+    double _maximum[3];
+    double _printMinimum[3];
+    double _printMaximum[3];
+    double _scale = 1;
+    bool _relative = false;
+    bool _relativeE = false;
+    int _tool = 0;
+};
+}
+
+bool GCodeAnalyzer::Analysis::fitsIn(const double volumeMinimum[3], const double volumeMaximum[3]) const
+{
+    for (int axis = 0; axis < 3; axis++) {
+        if (minimum[axis] < volumeMinimum[axis] || maximum[axis] > volumeMaximum[axis]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool GCodeAnalyzer::analyze(const QString &fileName, GCodeAnalyzer::Analysis &analysis)
+{
+    analysis = Analysis();
+    if (GCodeDecompressor::format(fileName) != GCodeDecompressor::NONE) {
+        // chunks are parsed from the memory map
+        qCDebug(GCODE_ANALYZER) << "Can't analyze compressed" << fileName;
+        return false;
+    }
+    GCodeReader reader(fileName);
+    if (!reader.open()) {
+        return false;
+    }
+
+    GCodeChunkParser parser(reader.data(), reader.size(), isAnalyzed);
+    Tracker tracker(analysis);
+    parser.run([&](const GCodeChunkParser::Chunk &chunk) {
+        for (const auto &record : chunk.records) {
+            tracker.process(record);
+        }
+        analysis.lineCount += chunk.lines.size();
+    });
+    tracker.finish();
+    qCDebug(GCODE_ANALYZER) << fileName << analysis.lineCount << "lines," << analysis.layerCount() << "layers," << parser.chunkCount() << "chunks";
+    return true;
+}
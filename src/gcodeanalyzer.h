@@ -0,0 +1,82 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QString>
+#include <QVector>
+
+#include "atcore_export.h"
+
+/**
+ * @brief The GCodeAnalyzer class
+ * Reads what a G-code file does before it is printed.
+ *
+ * The file is parsed in chunks on all cores, the modal state of the job is
+ * followed over the parsed chunks in file order. Positions are in mm, G20
+ * inches are converted.
+ */
+class ATCORE_EXPORT GCodeAnalyzer
+{
+public:
+    /**
+     * @brief What a job does
+     */
+    struct Analysis {
+        qint64 lineCount = 0;                   //!< @param lineCount: lines in the file
+        double minimum[3] = {0, 0, 0};          //!< @param minimum: X, Y and Z the moves reach, 0 for an axis never positioned
+        double maximum[3] = {0, 0, 0};          //!< @param maximum: X, Y and Z the moves reach, 0 for an axis never positioned
+        double printMinimum[3] = {0, 0, 0};     //!< @param printMinimum: X, Y and Z the extruding moves reach
+        double printMaximum[3] = {0, 0, 0};     //!< @param printMaximum: X, Y and Z the extruding moves reach
+        QVector<double> filament;               //!< @param filament: mm of filament each tool pushes, by tool number
+        QVector<int> tools;                     //!< @param tools: tools that extrude, in increasing order
+        QVector<double> layerHeights;           //!< @param layerHeights: Z of each layer, a layer starts where extruding goes higher
+        double minimumFeedrate = 0;             //!< @param minimumFeedrate: lowest F of the moves in mm/min, 0 if none
+        double maximumFeedrate = 0;             //!< @param maximumFeedrate: highest F of the moves in mm/min, 0 if none
+        QVector<double> extruderTemperatures;   //!< @param extruderTemperatures: M104 and M109 targets, in increasing order
+        QVector<double> bedTemperatures;        //!< @param bedTemperatures: M140 and M190 targets, in increasing order
+
+        /**
+         * @brief Number of layers
+         */
+        int layerCount() const
+        {
+            return layerHeights.size();
+        }
+
+        /**
+         * @brief True if every move stays inside a build volume
+         * @param volumeMinimum: lowest X, Y and Z the printer reaches
+         * @param volumeMaximum: highest X, Y and Z the printer reaches
+         */
+        bool fitsIn(const double volumeMinimum[3], const double volumeMaximum[3]) const;
+    };
+
+    /**
+     * @brief Analyse \p fileName, blocking until done
+     * @param fileName: G-code file, not compressed
+     * @param analysis: filled with what the job does
+     * @return False if the file can't be read or is compressed
+     */
+    static bool analyze(const QString &fileName, Analysis &analysis);
+};
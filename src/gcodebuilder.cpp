@@ -0,0 +1,211 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <algorithm>
+#include <cmath>
+
+#include "gcodebuilder.h"
+
+namespace
+{
+// room for a command without text, reserved once
+const int _capacity = 96;
+
+// scales for the decimals kept, exact as doubles
+const qint64 _scales[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+const int _maxDecimals = 9;
+
+// fixed point values below this fit a qint64
+const double _maxScaled = 9e18;
+
+/**
+ * @brief Write \p value backwards, ending at \p end
+ * @return First character written
+ */
+char *writeDigits(char *end, quint64 value)
+{
+    do {
+        *--end = char('0' + value % 10);
+        value /= 10;
+    } while (value);
+    return end;
+}
+
+/**
+ * @brief Write \p value into \p out
+ * @return Characters written
+ */
+int formatInteger(char *out, qint64 value)
+{
+    char digits[24];
+    char *end = digits + sizeof(digits);
+    const quint64 magnitude = value < 0 ? 0 - quint64(value) : quint64(value);
+    char *begin = writeDigits(end, magnitude);
+    if (value < 0) {
+        *--begin = '-';
+    }
+    const int count = int(end - begin);
+    std::copy(begin, end, out);
+    return count;
+}
+}
+
+const QByteArray GCodeBuilder::G28 = QByteArrayLiteral("G28");
+const QByteArray GCodeBuilder::G90 = QByteArrayLiteral("G90");
+const QByteArray GCodeBuilder::G91 = QByteArrayLiteral("G91");
+const QByteArray GCodeBuilder::M24 = QByteArrayLiteral("M24");
+const QByteArray GCodeBuilder::M25 = QByteArrayLiteral("M25");
+const QByteArray GCodeBuilder::M27 = QByteArrayLiteral("M27");
+const QByteArray GCodeBuilder::M105 = QByteArrayLiteral("M105");
+const QByteArray GCodeBuilder::M112 = QByteArrayLiteral("M112");
+const QByteArray GCodeBuilder::M114 = QByteArrayLiteral("M114");
+const QByteArray GCodeBuilder::M115 = QByteArrayLiteral("M115");
+
+GCodeBuilder::GCodeBuilder()
+{
+    _command.reserve(_capacity);
+}
+
+GCodeBuilder &GCodeBuilder::begin(GCode::GCommands gcode)
+{
+    return begin('G', int(gcode));
+}
+
+GCodeBuilder &GCodeBuilder::begin(GCode::MCommands mcode)
+{
+    return begin('M', int(mcode));
+}
+
+GCodeBuilder &GCodeBuilder::begin(char letter, int code)
+{
+    clear();
+    char digits[24];
+    digits[0] = letter;
+    _command.append(digits, 1 + formatInteger(digits + 1, code));
+    return *this;
+}
+
+GCodeBuilder &GCodeBuilder::word(char letter)
+{
+    append(letter, nullptr, 0);
+    return *this;
+}
+
+GCodeBuilder &GCodeBuilder::word(char letter, int value)
+{
+    return word(letter, qint64(value));
+}
+
+GCodeBuilder &GCodeBuilder::word(char letter, uint value)
+{
+    return word(letter, qint64(value));
+}
+
+GCodeBuilder &GCodeBuilder::word(char letter, qint64 value)
+{
+    char digits[24];
+    append(letter, digits, formatInteger(digits, value));
+    return *this;
+}
+
+GCodeBuilder &GCodeBuilder::word(char letter, double value, int decimals)
+{
+    char digits[32];
+    append(letter, digits, formatNumber(digits, value, decimals));
+    return *this;
+}
+
+GCodeBuilder &GCodeBuilder::text(const QByteArray &text)
+{
+    _command.append(' ');
+    _command.append(text);
+    return *this;
+}
+
+const QByteArray &GCodeBuilder::command() const
+{
+    return _command;
+}
+
+int GCodeBuilder::formatNumber(char *out, double value, int decimals)
+{
+    decimals = qBound(0, decimals, _maxDecimals);
+    const double scaled = value * double(_scales[decimals]);
+    if (!(std::fabs(scaled) < _maxScaled)) {
+        // out of fixed point range or not a number, not something a printer takes
+        const QByteArray text = QByteArray::number(value, 'g', 15).left(31);
+        std::copy(text.constData(), text.constData() + text.size(), out);
+        return text.size();
+    }
+
+    const qint64 fixed = qRound64(scaled);
+    const quint64 magnitude = fixed < 0 ? 0 - quint64(fixed) : quint64(fixed);
+    const quint64 scale = quint64(_scales[decimals]);
+    quint64 integer = magnitude / scale;
+    quint64 fraction = magnitude % scale;
+    int fractionDigits = decimals;
+    while (fractionDigits > 0 && fraction % 10 == 0) {
+        fraction /= 10;
+        fractionDigits--;
+    }
+
+    char digits[32];
+    char *end = digits + sizeof(digits);
+    char *begin = end;
+    for (int i = 0; i < fractionDigits; i++) {
+        *--begin = char('0' + fraction % 10);
+        fraction /= 10;
+    }
+    if (fractionDigits) {
+        *--begin = '.';
+    }
+    begin = writeDigits(begin, integer);
+    // a value rounding to zero is written "0", never "-0"
+    if (fixed < 0) {
+        *--begin = '-';
+    }
+    std::copy(begin, end, out);
+    return int(end - begin);
+}
+
+void GCodeBuilder::clear()
+{
+    if (_command.isDetached()) {
+        _command.resize(0);
+    } else {
+        // a copy of the last command is queued, leave it to it
+        _command = QByteArray();
+        _command.reserve(_capacity);
+    }
+}
+
+void GCodeBuilder::append(char letter, const char *digits, int count)
+{
+    _command.append(' ');
+    _command.append(letter);
+    if (count) {
+        _command.append(digits, count);
+    }
+}
@@ -0,0 +1,135 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QByteArray>
+
+#include "atcore_export.h"
+#include "gcodecommands.h"
+
+/**
+ * @brief The GCodeBuilder class
+ * Writes G and M commands with typed arguments into a reused byte buffer.
+ *
+ * begin() starts a command for any GCode::GCommands or GCode::MCommands value,
+ * word() appends an argument, command() returns the line as it is sent. The
+ * buffer keeps its capacity between commands, building allocates nothing
+ * unless a copy of the last command is still held somewhere.
+ *
+ * Numbers are written in fixed point with integer arithmetic, without a
+ * trailing ".0" or zeros: 200.0 is "200", 1.50 is "1.5".
+ *
+ * Commands sent without arguments often are pre-rendered constants, like M105.
+ */
+class ATCORE_EXPORT GCodeBuilder
+{
+public:
+    GCodeBuilder();
+
+    /**
+     * @brief Start a G command, dropping the one built before
+     * @param gcode: the command, written as "G" and its number
+     */
+    GCodeBuilder &begin(GCode::GCommands gcode);
+
+    /**
+     * @brief Start an M command, dropping the one built before
+     * @param mcode: the command, written as "M" and its number
+     */
+    GCodeBuilder &begin(GCode::MCommands mcode);
+
+    /**
+     * @brief Start a command given by its letter and number, like T1
+     * @param letter: upper case letter of the command
+     * @param code: number of the command
+     */
+    GCodeBuilder &begin(char letter, int code);
+
+    /**
+     * @brief Append a word without a number, like X for G28 X
+     * @param letter: upper case letter of the word
+     */
+    GCodeBuilder &word(char letter);
+
+    /**
+     * @brief Append a word with an integer
+     * @param letter: upper case letter of the word
+     * @param value: its number
+     */
+    GCodeBuilder &word(char letter, int value);
+    GCodeBuilder &word(char letter, uint value);
+    GCodeBuilder &word(char letter, qint64 value);
+
+    /**
+     * @brief Append a word with a number
+     * @param letter: upper case letter of the word
+     * @param value: its number
+     * @param decimals: digits kept after the decimal point, at most 9
+     */
+    GCodeBuilder &word(char letter, double value, int decimals = 3);
+
+    /**
+     * @brief Append a text argument, like the file name of M23 or the message of M117
+     * @param text: the text, written after a space
+     */
+    GCodeBuilder &text(const QByteArray &text);
+
+    /**
+     * @brief The command built since the last begin()
+     */
+    const QByteArray &command() const;
+
+    /**
+     * @brief Write \p value in fixed point
+     * @param out: at least 32 characters
+     * @param value: the number, finite and below 1e15 in magnitude for exact digits
+     * @param decimals: digits kept after the decimal point, trailing zeros are dropped
+     * @return Characters written
+     */
+    static int formatNumber(char *out, double value, int decimals);
+
+    static const QByteArray G28;    //!< @param G28: "G28", home all axes
+    static const QByteArray G90;    //!< @param G90: "G90", absolute positioning
+    static const QByteArray G91;    //!< @param G91: "G91", relative positioning
+    static const QByteArray M24;    //!< @param M24: "M24", start or resume the SD print
+    static const QByteArray M25;    //!< @param M25: "M25", pause the SD print
+    static const QByteArray M27;    //!< @param M27: "M27", SD print status
+    static const QByteArray M105;   //!< @param M105: "M105", temperatures
+    static const QByteArray M112;   //!< @param M112: "M112", emergency stop
+    static const QByteArray M114;   //!< @param M114: "M114", position
+    static const QByteArray M115;   //!< @param M115: "M115", firmware and capabilities
+
+private:
+    /**
+     * @brief Empty the buffer, keeping its capacity if no copy shares it
+     */
+    void clear();
+
+    /**
+     * @brief Append ' ', \p letter and \p count characters of \p digits
+     */
+    void append(char letter, const char *digits, int count);
+
+    QByteArray _command;            //!< @param _command: the command being built
+};
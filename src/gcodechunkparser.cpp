@@ -0,0 +1,194 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QMutex>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <cstring>
+
+#include "gcodechunkparser.h"
+#include "gcodeline.h"
+
+namespace
+{
+// Chunks are parsed in parallel, a few of them at a time
+const qint64 _chunkSize = 2 << 20;
+
+int wordIndex(char letter)
+{
+    switch (letter) {
+    case 'X': return GCodeChunkParser::WordX;
+    case 'Y': return GCodeChunkParser::WordY;
+    case 'Z': return GCodeChunkParser::WordZ;
+    case 'E': return GCodeChunkParser::WordE;
+    case 'F': return GCodeChunkParser::WordF;
+    case 'I': return GCodeChunkParser::WordI;
+    case 'J': return GCodeChunkParser::WordJ;
+    case 'P': return GCodeChunkParser::WordP;
+    case 'R': return GCodeChunkParser::WordR;
+    case 'S': return GCodeChunkParser::WordS;
+    case 'T': return GCodeChunkParser::WordT;
+    default: return -1;
+    }
+}
+
+/**
+ * @brief Parses one chunk on a thread pool
+ */
+class ParseTask : public QRunnable
+{
+public:
+    ParseTask(const char *data, GCodeChunkParser::Chunk &chunk, GCodeChunkParser::Filter filter, QMutex &mutex, QWaitCondition &parsed) :
+        _data(data), _chunk(chunk), _filter(filter), _mutex(mutex), _parsed(parsed)
+    {
+    }
+
+    void run() override
+    {
+        GCodeChunkParser::parse(_data, _chunk, _filter);
+        QMutexLocker lock(&_mutex);
+        _chunk.ready = true;
+        _parsed.wakeAll();
+    }
+
+private:
+    const char *_data;
+    GCodeChunkParser::Chunk &_chunk;
+    GCodeChunkParser::Filter _filter;
+    QMutex &_mutex;
+    QWaitCondition &_parsed;
+};
+}
+
+GCodeChunkParser::GCodeChunkParser(const char *data, qint64 size, Filter filter) :
+    _data(data),
+    _filter(filter)
+{
+    const auto parts = split(data, size, _chunkSize);
+    _chunks.resize(parts.size());
+    for (int i = 0; i < parts.size(); i++) {
+        _chunks[i].begin = parts.at(i).first;
+        _chunks[i].end = parts.at(i).second;
+    }
+}
+
+QVector<QPair<qint64, qint64>> GCodeChunkParser::split(const char *data, qint64 size, qint64 chunkSize)
+{
+    QVector<QPair<qint64, qint64>> parts;
+    chunkSize = qMax(chunkSize, qint64(1));
+    for (qint64 begin = 0; begin < size;) {
+        qint64 end = size;
+        if (size - begin > chunkSize) {
+            const char *newLine = static_cast<const char *>(std::memchr(data + begin + chunkSize, '\n', size_t(size - begin - chunkSize)));
+            end = newLine ? newLine - data + 1 : size;
+        }
+        parts.append(qMakePair(begin, end));
+        begin = end;
+    }
+    return parts;
+}
+
+int GCodeChunkParser::chunkCount() const
+{
+    return _chunks.size();
+}
+
+bool GCodeChunkParser::run(const std::function<void(const Chunk &)> &merge, const std::atomic<bool> *cancel)
+{
+    // parse a few chunks ahead of the merge, it runs in file order
+    QThreadPool pool;
+    QMutex mutex;
+    QWaitCondition parsed;
+    const int window = qMax(1, QThread::idealThreadCount()) + 1;
+    int queued = 0;
+    for (; queued < _chunks.size() && queued < window; queued++) {
+        pool.start(new ParseTask(_data, _chunks[queued], _filter, mutex, parsed));
+    }
+
+    for (int i = 0; i < _chunks.size(); i++) {
+        if (cancel && *cancel) {
+            // the tasks still running use the mutex
+            pool.waitForDone();
+            return false;
+        }
+        Chunk &chunk = _chunks[i];
+        {
+            QMutexLocker lock(&mutex);
+            while (!chunk.ready) {
+                parsed.wait(&mutex);
+            }
+        }
+        merge(chunk);
+        chunk.lines = QVector<quint32>();
+        chunk.records = QVector<Record>();
+        if (queued < _chunks.size()) {
+            pool.start(new ParseTask(_data, _chunks[queued], _filter, mutex, parsed));
+            queued++;
+        }
+    }
+    pool.waitForDone();
+    return true;
+}
+
+void GCodeChunkParser::parse(const char *data, Chunk &chunk, Filter filter)
+{
+    const char *p = data + chunk.begin;
+    const char *chunkEnd = data + chunk.end;
+    int line = 0;
+    GCodeLine command;
+    while (p < chunkEnd) {
+        const char *newLine = static_cast<const char *>(std::memchr(p, '\n', size_t(chunkEnd - p)));
+        const char *end = newLine ? newLine : chunkEnd;
+        chunk.lines.append(quint32(p - data - chunk.begin));
+
+        while (p < end && (*p == ' ' || *p == '\t')) {
+            p++;
+        }
+        // only the commands that matter are parsed in full
+        const char letter = p < end ? char(*p & ~0x20) : 0;
+        const char *q = p + 1;
+        double number = 0;
+        if (letter >= 'A' && letter <= 'Z' && GCodeLine::parseNumber(q, end, number) && filter(letter, int(number))
+                && command.parse(p, end)) {
+            Record record;
+            record.line = line;
+            record.letter = letter;
+            record.code = short(command.code());
+            record.words = 0;
+            for (int i = 0; i < command.wordCount(); i++) {
+                const GCodeLine::Word &word = command.word(i);
+                const int index = wordIndex(word.letter);
+                if (index != -1 && word.hasValue) {
+                    record.words |= quint16(1 << index);
+                    record.value[index] = word.value;
+                }
+            }
+            chunk.records.append(record);
+        }
+
+        line++;
+        p = newLine ? newLine + 1 : chunkEnd;
+    }
+}
@@ -0,0 +1,132 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QPair>
+#include <QVector>
+#include <atomic>
+#include <functional>
+
+#include "atcore_export.h"
+
+/**
+ * @brief The GCodeChunkParser class
+ * Parses a G-code file held in memory in chunks on all cores.
+ *
+ * The file is split at line ends into chunks of a few MB. Each chunk is split
+ * in lines and the commands a Filter keeps are parsed into Records, on a
+ * thread pool. The chunks are handed back in file order to a single thread,
+ * which follows the modal state of the job. Only a few chunks are parsed ahead
+ * of it, the memory used doesn't grow with the file.
+ */
+class ATCORE_EXPORT GCodeChunkParser
+{
+public:
+    /**
+     * @brief Words kept for a command
+     */
+    enum Word { WordX, WordY, WordZ, WordE, WordF, WordI, WordJ, WordP, WordR, WordS, WordT, WordCount };
+
+    /**
+     * @brief A parsed command
+     */
+    struct Record {
+        int line;                   //!< @param line: line in the chunk
+        char letter;                //!< @param letter: command letter, 'G', 'M' or 'T'
+        short code;                 //!< @param code: command number
+        quint16 words;              //!< @param words: one bit per Word seen
+        double value[WordCount];    //!< @param value: value of each Word seen
+
+        bool has(Word word) const
+        {
+            return words & (1 << word);
+        }
+    };
+
+    /**
+     * @brief A part of the file, parsed on its own
+     */
+    struct Chunk {
+        qint64 begin = 0;           //!< @param begin: offset of the first line
+        qint64 end = 0;             //!< @param end: offset after the last line
+        QVector<quint32> lines;     //!< @param lines: offset of each line from begin
+        QVector<Record> records;    //!< @param records: commands of the chunk the filter kept
+        bool ready = false;         //!< @param ready: parsing is done, guarded by the parser's mutex
+    };
+
+    /**
+     * @brief Commands to parse, the others are only counted as lines
+     * @param letter: upper case command letter
+     * @param code: command number
+     */
+    typedef bool (*Filter)(char letter, int code);
+
+    /**
+     * @brief Split \p data at line ends
+     * @param data: the file
+     * @param size: bytes in \p data
+     * @param filter: commands to parse
+     */
+    GCodeChunkParser(const char *data, qint64 size, Filter filter);
+
+    /**
+     * @brief Number of chunks the file was split in
+     */
+    int chunkCount() const;
+
+    /**
+     * @brief Parse every chunk, calling \p merge on each in file order
+     *
+     * \p merge runs in the calling thread while the next chunks are parsed.
+     * A chunk's lines and records are freed once it returns.
+     * @param merge: called with each parsed chunk
+     * @param cancel: stops the run before the next chunk once set, may be nullptr
+     * @return False if \p cancel stopped the run
+     */
+    bool run(const std::function<void(const Chunk &)> &merge, const std::atomic<bool> *cancel = nullptr);
+
+    /**
+     * @brief Split \p data at line ends into parts of at least \p chunkSize bytes
+     *
+     * Only the last part may be smaller. GCodeIndex splits files the same way.
+     * @param data: the file
+     * @param size: bytes in \p data
+     * @param chunkSize: bytes of a part before it is cut at the next line end
+     * @return offset of the first line and offset after the last line of each part, in file order
+     */
+    static QVector<QPair<qint64, qint64>> split(const char *data, qint64 size, qint64 chunkSize);
+
+    /**
+     * @brief Split \p chunk in lines and parse the commands \p filter keeps
+     * @param data: the file
+     * @param chunk: the chunk, begin and end set
+     * @param filter: commands to parse
+     */
+    static void parse(const char *data, Chunk &chunk, Filter filter);
+
+private:
+    const char *_data;              //!< @param _data: the file
+    Filter _filter;                 //!< @param _filter: commands to parse
+    QVector<Chunk> _chunks;         //!< @param _chunks: the file split at line ends
+};
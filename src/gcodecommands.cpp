@@ -25,540 +25,447 @@
 */
 #include <QObject>
 #include <QMetaEnum>
+#include <algorithm>
 
 #include "gcodecommands.h"
 
 const QString GCode::commandRequiresArgument = QObject::tr("%1%2: requires an argument");
 const QString GCode::commandNotSupported = QObject::tr("Not implemented or not supported!");
 
-QString GCode::description(GCommands gcode)
+namespace
 {
-    switch (gcode) {
-    case G0://Teacup - Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware - MakerBot
-        return QObject::tr("G0: Rapid linear move");
-    case G1://Teacup - Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("G1: Linear move");
-    case G2://Sprinter - Marlin - Repetier - Smoothie
-        return QObject::tr("G2: Controlled Arc Move clockwise");
-    case G3://Sprinter - Marlin - Repetier - Smoothie
-        return QObject::tr("G3: Controlled Arc Move counterclockwise");
-    case G4://Teacup - Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware - MakerBot
-        return QObject::tr("G4: Dwell");
-    case G10://Marlin - Repetier > 0.92 - Smoothie
-        return QObject::tr("G10: Retract");
-    case G11://Marlin - Repetier > 0.92 - Smoothie
-        return QObject::tr("G11: Unretract");
-    case G20://Teacup - Sprinter - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("G20: Set units to inches");
-    case G21://Teacup - Sprinter - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("G21: Set units to millimeters");
-    case G28://Teacup - Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware - MakerBot
-        return QObject::tr("G28: Move to Origin Home");
-    case G29://Marlin - Repetier 0.91.7
-        return QObject::tr("G29: Detailed Z-Probe");
-    case G30:// Marlin - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("G30: Single Z-Probe");
-    case G31://Repetier 0.91.7 - Smoothie - RepRap Firmware - Marlin
-        return QObject::tr("G31: Set or report current probe status / Dock Z Probe sled for Marlin");
-    case G32://Repetier 0.92.8 - Smoothie - RepRap Firmware - Marlin
-        return QObject::tr("G32: Probe Z and calculate Z plane(Bed Leveling)/ UnDoc Z Probe sled for Marlin");
-    case G33://Repetier 0.92.8
-        return QObject::tr("G33: Measure/List/Adjust Distortion Matrix");
-    case G90://Teacup - Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware - MakerBot
-        return QObject::tr("G90: Set to absolute positioning");
-    case G91://Teacup - Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware - MakerBot
-        return QObject::tr("G91: Set to relative positioning");
-    case G92://Teacup - Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware - MakerBot
-        return QObject::tr("G92: Set position");
-    case G100://Repetier 0.92
-        return QObject::tr("G100: Calibrate floor or rod radius");
-    case G130://MakerBot
-        return QObject::tr("G130: Set digital potentiometer value");
-    case G131://Repetier 0.91
-        return QObject::tr("G131: Recase Move offset");
-    case G132://Repetier 0.91
-        return QObject::tr("G132: Calibrate endstops offsets");
-    case G133://Repetier 0.91
-        return QObject::tr("G133: Measure steps to top");
-    case G161://Teacup - MakerBot
-        return QObject::tr("G161: Home axis to minimum");
-    case G162://Teacup - MakerBot
-        return QObject::tr("G162: Home axis to maximum");
-    default:
-        return commandNotSupported;
-    }
+enum {
+    Teacup = GCode::Teacup,
+    Sprinter = GCode::Sprinter,
+    Marlin = GCode::Marlin,
+    Repetier = GCode::Repetier,
+    Smoothie = GCode::Smoothie,
+    RepRapFirmware = GCode::RepRapFirmware,
+    MakerBot = GCode::MakerBot
+};
+
+/**
+ * @brief How toCommand() writes the arguments after the prefix
+ */
+enum Format : quint8 {
+    Unsupported,    // toCommand() returns commandNotSupported
+    NoArgument,     // the prefix alone
+    Fixed,          // the prefix is the whole command
+    Words,          // " value1" upper cased, words like "X10 Y20"
+    Text,           // " value1" as given, a file name or a message
+    OptionalP,      // " Pvalue1"
+    SValue,         // " Svalue1"
+    ToolAndS,       // " Svalue1", or " Pvalue1 Svalue2" for another tool or fan
+    SdPosition      // " Svalue1" in bytes, or " P" for a value1 in %
+};
+
+/**
+ * @brief A row of the command tables
+ */
+struct Command {
+    short code;                 //!< @param code: command number, the tables are sorted by it
+    const char *prefix;         //!< @param prefix: the command as sent without arguments
+    Format format;              //!< @param format: how arguments are written
+    quint8 required;            //!< @param required: arguments toCommand() needs
+    quint8 arity;               //!< @param arity: arguments toCommand() takes
+    quint8 firmwares;           //!< @param firmwares: GCode::Firmware flags of the firmwares supporting it
+    const char *description;    //!< @param description: untranslated description
+};
+
+// Firmwares as the RepRap wiki lists them, with versions where they matter
+constexpr Command _gCommands[] = {
+    {0, "G0", Words, 0, 1, Teacup | Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware | MakerBot, QT_TRANSLATE_NOOP("QObject", "G0: Rapid linear move")},
+    {1, "G1", Words, 0, 1, Teacup | Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "G1: Linear move")},
+    {2, "G2", Unsupported, 0, 0, Sprinter | Marlin | Repetier | Smoothie, QT_TRANSLATE_NOOP("QObject", "G2: Controlled Arc Move clockwise")},
+    {3, "G3", Unsupported, 0, 0, Sprinter | Marlin | Repetier | Smoothie, QT_TRANSLATE_NOOP("QObject", "G3: Controlled Arc Move counterclockwise")},
+    {4, "G4", Unsupported, 0, 0, Teacup | Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware | MakerBot, QT_TRANSLATE_NOOP("QObject", "G4: Dwell")},
+    {10, "G10", Unsupported, 0, 0, Marlin | Repetier | Smoothie, QT_TRANSLATE_NOOP("QObject", "G10: Retract")}, // Marlin - Repetier > 0.92 - Smoothie
+    {11, "G11", Unsupported, 0, 0, Marlin | Repetier | Smoothie, QT_TRANSLATE_NOOP("QObject", "G11: Unretract")}, // Marlin - Repetier > 0.92 - Smoothie
+    {20, "G20", NoArgument, 0, 0, Teacup | Sprinter | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "G20: Set units to inches")},
+    {21, "G21", NoArgument, 0, 0, Teacup | Sprinter | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "G21: Set units to millimeters")},
+    {28, "G28", Words, 0, 1, Teacup | Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware | MakerBot, QT_TRANSLATE_NOOP("QObject", "G28: Move to Origin Home")},
+    {29, "G29", Unsupported, 0, 0, Marlin | Repetier, QT_TRANSLATE_NOOP("QObject", "G29: Detailed Z-Probe")}, // Marlin - Repetier 0.91.7
+    {30, "G30", Unsupported, 0, 0, Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "G30: Single Z-Probe")},
+    {31, "G31", Unsupported, 0, 0, Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "G31: Set or report current probe status / Dock Z Probe sled for Marlin")}, // Repetier 0.91.7 - Smoothie - RepRap Firmware - Marlin
+    {32, "G32 S1", Fixed, 0, 0, Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "G32: Probe Z and calculate Z plane(Bed Leveling)/ UnDoc Z Probe sled for Marlin")}, // Repetier 0.92.8 - Smoothie - RepRap Firmware - Marlin
+    {33, "G33", Unsupported, 0, 0, Repetier, QT_TRANSLATE_NOOP("QObject", "G33: Measure/List/Adjust Distortion Matrix")}, // Repetier 0.92.8
+    {90, "G90", NoArgument, 0, 0, Teacup | Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware | MakerBot, QT_TRANSLATE_NOOP("QObject", "G90: Set to absolute positioning")},
+    {91, "G91", NoArgument, 0, 0, Teacup | Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware | MakerBot, QT_TRANSLATE_NOOP("QObject", "G91: Set to relative positioning")},
+    {92, "G92", Unsupported, 0, 0, Teacup | Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware | MakerBot, QT_TRANSLATE_NOOP("QObject", "G92: Set position")},
+    {100, "G100", Unsupported, 0, 0, Repetier, QT_TRANSLATE_NOOP("QObject", "G100: Calibrate floor or rod radius")}, // Repetier 0.92
+    {130, "G130", Unsupported, 0, 0, MakerBot, QT_TRANSLATE_NOOP("QObject", "G130: Set digital potentiometer value")},
+    {131, "G131", Unsupported, 0, 0, Repetier, QT_TRANSLATE_NOOP("QObject", "G131: Recase Move offset")}, // Repetier 0.91
+    {132, "G132", Unsupported, 0, 0, Repetier, QT_TRANSLATE_NOOP("QObject", "G132: Calibrate endstops offsets")}, // Repetier 0.91
+    {133, "G133", Unsupported, 0, 0, Repetier, QT_TRANSLATE_NOOP("QObject", "G133: Measure steps to top")}, // Repetier 0.91
+    {161, "G161", Unsupported, 0, 0, Teacup | MakerBot, QT_TRANSLATE_NOOP("QObject", "G161: Home axis to minimum")},
+    {162, "G162", Unsupported, 0, 0, Teacup | MakerBot, QT_TRANSLATE_NOOP("QObject", "G162: Home axis to maximum")},
+};
+
+constexpr Command _mCommands[] = {
+    {0, "M0", Unsupported, 0, 0, Teacup | Marlin | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M0: Stop or unconditional stop")},
+    {1, "M1", Unsupported, 0, 0, Marlin | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M1: Sleep or unconditional stop")},
+    {2, "M2", Unsupported, 0, 0, Teacup | MakerBot, QT_TRANSLATE_NOOP("QObject", "M2: Program End")},
+    {6, "M6", Unsupported, 0, 0, Teacup, QT_TRANSLATE_NOOP("QObject", "M6: Tool Change")},
+    {17, "M17", Unsupported, 0, 0, Teacup | Marlin | Smoothie, QT_TRANSLATE_NOOP("QObject", "M17: Enable/power all steppers motors")},
+    {18, "M18", Unsupported, 0, 0, Teacup | Marlin | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M18: Disable all steppers motors")}, // Teacup - Marlin(M84) - Smoothie -RepRap Firmware
+    {20, "M20", NoArgument, 0, 0, Teacup | Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M20: List SDCard")},
+    {21, "M21", OptionalP, 0, 1, Teacup | Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M21: Initialize SDCard")},
+    {22, "M22", OptionalP, 0, 1, Teacup | Sprinter | Marlin | Repetier | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M22: Release SDCard")},
+    {23, "M23", Text, 1, 1, Teacup | Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M23: Select SD file")},
+    {24, "M24", NoArgument, 0, 0, Teacup | Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M24: Start/resume SD print")},
+    {25, "M25", NoArgument, 0, 0, Teacup | Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M25: Pause SD print")},
+    {26, "M26", SdPosition, 1, 1, Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M26: Set SD position")}, // Sprinter - Marlin - Repetier - Smoothie(abort) - RepRap Firmware
+    {27, "M27", NoArgument, 0, 0, Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M27: Report SD print status")},
+    {28, "M28", Text, 1, 1, Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M28: Begin write to SD card")},
+    {29, "M29", Text, 1, 1, Sprinter | Marlin | Repetier | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M29: Stop writing to SD card")},
+    {30, "M30", Text, 1, 1, Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M30: Delete a file on the SD card")},
+    {31, "M31", Unsupported, 0, 0, Marlin, QT_TRANSLATE_NOOP("QObject", "M31: Output time since last M109 or SD card start to serial")},
+    {32, "M32", Unsupported, 0, 0, Marlin | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M32: Select file and start SD print")},
+    {33, "M33", Unsupported, 0, 0, Marlin, QT_TRANSLATE_NOOP("QObject", "M33: Get the long name for an SD card file or folder")},
+    {34, "M34", Unsupported, 0, 0, Marlin, QT_TRANSLATE_NOOP("QObject", "M34: Set SD file sorting options")},
+    {36, "M36", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M36: Return file information")},
+    {42, "M42", Unsupported, 0, 0, Sprinter | Marlin | Repetier | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M42: Switch I/O pin")},
+    {48, "M48", Unsupported, 0, 0, Marlin, QT_TRANSLATE_NOOP("QObject", "M48: Measure Z-Probe repeatability")},
+    {70, "M70", Unsupported, 0, 0, MakerBot, QT_TRANSLATE_NOOP("QObject", "M70: Display message")},
+    {72, "M72", Unsupported, 0, 0, MakerBot, QT_TRANSLATE_NOOP("QObject", "M72: Play a tone or song")},
+    {73, "M73", Unsupported, 0, 0, MakerBot, QT_TRANSLATE_NOOP("QObject", "M73: Set build percentage")},
+    {80, "M80", Unsupported, 0, 0, Teacup | Sprinter | Marlin | Repetier | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M80: ATX Power On")}, // Teacup(automatic) - Sprinter - Marlin - Repetier - RepRap Firmware
+    {81, "M81", Unsupported, 0, 0, Teacup | Sprinter | Marlin | Repetier | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M81: ATX Power Off")}, // Teacup(automatic) - Sprinter - Marlin - Repetier  - RepRap Firmware
+    {82, "M82", Unsupported, 0, 0, Teacup | Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M82: Set extruder to absolute mode")},
+    {83, "M83", Unsupported, 0, 0, Teacup | Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M83: Set extruder to relative mode")},
+    {84, "M84", SValue, 0, 1, Teacup | Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M84: Stop idle hold")},
+    {85, "M85", Unsupported, 0, 0, Sprinter | Marlin | Repetier, QT_TRANSLATE_NOOP("QObject", "M85: Set Inactivity shutdown timer")},
+    {92, "M92", Unsupported, 0, 0, Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M92: Set axis steps per unit")},
+    {93, "M93", Unsupported, 0, 0, Sprinter, QT_TRANSLATE_NOOP("QObject", "M93: Send axis steps per unit")},
+    {99, "M99", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M99: Return from Macro/Subprogram")},
+    {101, "M101", Unsupported, 0, 0, Teacup, QT_TRANSLATE_NOOP("QObject", "M101: Turn extruder 1 on Forward, Undo Retraction")},
+    {103, "M103", Unsupported, 0, 0, Teacup, QT_TRANSLATE_NOOP("QObject", "M103: Turn all extruders off - Extruder Retraction")},
+    {104, "M104", ToolAndS, 1, 2, Teacup | Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware | MakerBot, QT_TRANSLATE_NOOP("QObject", "M104: Set Extruder Temperature")},
+    {105, "M105", NoArgument, 0, 0, Teacup | Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware | MakerBot, QT_TRANSLATE_NOOP("QObject", "M105: Get Extruder Temperature")},
+    {106, "M106", ToolAndS, 0, 2, Teacup | Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M106: Fan On")},
+    {107, "M107", NoArgument, 0, 0, Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M107: Fan Off")},
+    {108, "M108", Unsupported, 0, 0, Marlin, QT_TRANSLATE_NOOP("QObject", "M108: Cancel Heating")},
+    {109, "M109", SValue, 1, 1, Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware | MakerBot, QT_TRANSLATE_NOOP("QObject", "M109: Set Extruder Temperature and Wait")},
+    {110, "M110", Unsupported, 0, 0, Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M110: Set Current Line Number")},
+    {111, "M111", Unsupported, 0, 0, Teacup | Marlin | Repetier | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M111: Set Debug Level")},
+    {112, "M112", NoArgument, 0, 0, Teacup | Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M112: Emergency Stop")},
+    {114, "M114", NoArgument, 0, 0, Teacup | Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware | MakerBot, QT_TRANSLATE_NOOP("QObject", "M114: Get Current Position")},
+    {115, "M115", NoArgument, 0, 0, Teacup | Sprinter | Marlin | Repetier | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M115: Get Firmware Version and Capabilities")},
+    {116, "M116", NoArgument, 0, 0, Teacup | Repetier | RepRapFirmware | MakerBot, QT_TRANSLATE_NOOP("QObject", "M116: Wait")},
+    {117, "M117", Text, 1, 1, Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M117: Display Message")},
+    {119, "M119", NoArgument, 0, 0, Teacup | Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M119: Get Endstop Status")},
+    {120, "M120", Unsupported, 0, 0, Marlin | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M120: Push for Smoothie and RepRap Firmware / Enable Endstop detection for Marlin")},
+    {121, "M121", Unsupported, 0, 0, Marlin | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M121: Pop for Smoothie and RepRap Firmware / Disable Endstop detection for Marlin")},
+    {122, "M122", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M122: Diagnose")},
+    {126, "M126", Unsupported, 0, 0, Marlin | MakerBot, QT_TRANSLATE_NOOP("QObject", "M126: Open valve")},
+    {127, "M127", Unsupported, 0, 0, Marlin | MakerBot, QT_TRANSLATE_NOOP("QObject", "M127: Close valve")},
+    {130, "M130", Unsupported, 0, 0, Teacup, QT_TRANSLATE_NOOP("QObject", "M130: Set PID P value")},
+    {131, "M131", Unsupported, 0, 0, Teacup, QT_TRANSLATE_NOOP("QObject", "M131: Set PID I value")},
+    {132, "M132", Unsupported, 0, 0, Teacup | MakerBot, QT_TRANSLATE_NOOP("QObject", "M132: Set PID D value")},
+    {133, "M133", Unsupported, 0, 0, Teacup | MakerBot, QT_TRANSLATE_NOOP("QObject", "M133: Set PID I limit value")},
+    {134, "M134", Unsupported, 0, 0, Teacup | MakerBot, QT_TRANSLATE_NOOP("QObject", "M134: Write PID values to EEPROM")},
+    {135, "M135", Unsupported, 0, 0, RepRapFirmware | MakerBot, QT_TRANSLATE_NOOP("QObject", "M135: Set PID sample interval")},
+    {140, "M140", SValue, 1, 1, Teacup | Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware | MakerBot, QT_TRANSLATE_NOOP("QObject", "M140: Set Bed Temperature - Fast")},
+    {141, "M141", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M141: Set Chamber Temperature - Fast")},
+    {143, "M143", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M143: Maximum hot-end temperature")},
+    {144, "M144", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M144: Stand by your bed")},
+    {150, "M150", Unsupported, 0, 0, Marlin, QT_TRANSLATE_NOOP("QObject", "M150: Set display color")},
+    {163, "M163", Unsupported, 0, 0, Repetier, QT_TRANSLATE_NOOP("QObject", "M163: Set weight of mixed material")}, // Repetier > 0.92
+    {164, "M164", Unsupported, 0, 0, Repetier, QT_TRANSLATE_NOOP("QObject", "M164: Store weights")}, // Repetier > 0.92
+    {190, "M190", SValue, 1, 1, Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M190: Wait for bed temperature to reach target temp")},
+    {200, "M200", Unsupported, 0, 0, Marlin | Repetier | Smoothie, QT_TRANSLATE_NOOP("QObject", "M200: Set filament diameter")},
+    {201, "M201", Unsupported, 0, 0, Sprinter | Marlin | Repetier | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M201: Set max printing acceleration")},
+    {202, "M202", Unsupported, 0, 0, Marlin | Repetier, QT_TRANSLATE_NOOP("QObject", "M202: Set max travel acceleration")},
+    {203, "M203", Unsupported, 0, 0, Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M203: Set maximum feedrate")},
+    {204, "M204", Unsupported, 0, 0, Sprinter | Marlin | Repetier | Smoothie, QT_TRANSLATE_NOOP("QObject", "M204: Set default acceleration")},
+    {205, "M205", Unsupported, 0, 0, Sprinter | Marlin | Repetier | Smoothie, QT_TRANSLATE_NOOP("QObject", "M205: Advanced settings")},
+    {206, "M206", Unsupported, 0, 0, Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M206: Offset axes for Sprinter, Marlin, Smoothie, RepRap Firmware / Set eeprom value for Repetier")},
+    {207, "M207", Unsupported, 0, 0, Marlin | Smoothie, QT_TRANSLATE_NOOP("QObject", "M207: Set retract length")},
+    {208, "M208", Unsupported, 0, 0, Marlin | Smoothie, QT_TRANSLATE_NOOP("QObject", "M208: Set unretract length")},
+    {209, "M209", Unsupported, 0, 0, Marlin | Repetier, QT_TRANSLATE_NOOP("QObject", "M209: Enable automatic retract")},
+    {212, "M212", Unsupported, 0, 0, Marlin, QT_TRANSLATE_NOOP("QObject", "M212: Set Bed Level Sensor Offset")},
+    {218, "M218", Unsupported, 0, 0, Marlin, QT_TRANSLATE_NOOP("QObject", "M218: Set Hotend Offset")},
+    {220, "M220", SValue, 1, 1, Teacup | Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M220: Set speed factor override percentage")},
+    {221, "M221", SValue, 1, 1, Teacup | Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M221: Set extrude factor override percentage")},
+    {226, "M226", Unsupported, 0, 0, Marlin | Repetier, QT_TRANSLATE_NOOP("QObject", "M226: Wait for pin state")},
+    {231, "M231", Unsupported, 0, 0, Repetier, QT_TRANSLATE_NOOP("QObject", "M231: Set OPS parameter")},
+    {232, "M232", Unsupported, 0, 0, Repetier, QT_TRANSLATE_NOOP("QObject", "M232: Read and reset max. advance values")},
+    {240, "M240", Unsupported, 0, 0, Marlin, QT_TRANSLATE_NOOP("QObject", "M240: Trigger camera")},
+    {250, "M250", Unsupported, 0, 0, Marlin, QT_TRANSLATE_NOOP("QObject", "M250: Set LCD contrast")},
+    {251, "M251", Unsupported, 0, 0, Repetier, QT_TRANSLATE_NOOP("QObject", "M251: Measure Z steps from homing stop (Delta printers)")},
+    {280, "M280", Unsupported, 0, 0, Marlin, QT_TRANSLATE_NOOP("QObject", "M280: Set servo position")},
+    {300, "M300", Unsupported, 0, 0, Marlin | Repetier | RepRapFirmware | MakerBot, QT_TRANSLATE_NOOP("QObject", "M300: Play beep sound")},
+    {301, "M301", Unsupported, 0, 0, Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M301: Set PID parameters")},
+    {302, "M302", Unsupported, 0, 0, Marlin | Repetier | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M302: Allow cold extrudes ")}, // Marlin - Repetier > 0.92 - RepRap Firmware
+    {303, "M303", Unsupported, 0, 0, Sprinter | Marlin | Repetier | Smoothie, QT_TRANSLATE_NOOP("QObject", "M303: Run PID tuning")},
+    {304, "M304", Unsupported, 0, 0, Marlin | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M304: Set PID parameters - Bed")},
+    {305, "M305", Unsupported, 0, 0, Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M305: Set thermistor and ADC parameters")},
+    {306, "M306", Unsupported, 0, 0, Smoothie, QT_TRANSLATE_NOOP("QObject", "M306: set home offset calculated from toolhead position")},
+    {320, "M320", Unsupported, 0, 0, Repetier, QT_TRANSLATE_NOOP("QObject", "M320: Activate autolevel (Repetier)")},
+    {321, "M321", Unsupported, 0, 0, Repetier, QT_TRANSLATE_NOOP("QObject", "M321: Deactivate autolevel (Repetier)")},
+    {322, "M322", Unsupported, 0, 0, Repetier, QT_TRANSLATE_NOOP("QObject", "M322: Reset autolevel matrix (Repetier)")},
+    {323, "M323", Unsupported, 0, 0, Repetier, QT_TRANSLATE_NOOP("QObject", "M323: Distortion correction on/off (Repetier)")},
+    {340, "M340", Unsupported, 0, 0, Repetier, QT_TRANSLATE_NOOP("QObject", "M340: Control the servos")},
+    {350, "M350", Unsupported, 0, 0, Marlin | Repetier | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M350: Set microstepping mode")},
+    {351, "M351", Unsupported, 0, 0, Marlin, QT_TRANSLATE_NOOP("QObject", "M351: Toggle MS1 MS2 pins directly")},
+    {355, "M355", Unsupported, 0, 0, Repetier, QT_TRANSLATE_NOOP("QObject", "M355: Turn case lights on/off")}, // Repetier > 0.92.2
+    {360, "M360", Unsupported, 0, 0, Repetier, QT_TRANSLATE_NOOP("QObject", "M360: Report firmware configuration")}, // Repetier > 9.92.2
+    {361, "M361", Unsupported, 0, 0, Smoothie, QT_TRANSLATE_NOOP("QObject", "M361: Move to Theta 90 degree position")},
+    {362, "M362", Unsupported, 0, 0, Smoothie, QT_TRANSLATE_NOOP("QObject", "M362: Move to Psi 0 degree position")},
+    {363, "M363", Unsupported, 0, 0, Smoothie, QT_TRANSLATE_NOOP("QObject", "M363: Move to Psi 90 degree position")},
+    {364, "M364", Unsupported, 0, 0, Smoothie, QT_TRANSLATE_NOOP("QObject", "M364: Move to Psi + Theta 90 degree position")},
+    {365, "M365", Unsupported, 0, 0, Smoothie, QT_TRANSLATE_NOOP("QObject", "M365: SCARA scaling factor")},
+    {366, "M366", Unsupported, 0, 0, Smoothie, QT_TRANSLATE_NOOP("QObject", "M366: SCARA convert trim")},
+    {370, "M370", Unsupported, 0, 0, Smoothie, QT_TRANSLATE_NOOP("QObject", "M370: Morgan manual bed level - clear map")},
+    {371, "M371", Unsupported, 0, 0, Smoothie, QT_TRANSLATE_NOOP("QObject", "M371: Move to next calibration position")},
+    {372, "M372", Unsupported, 0, 0, Smoothie, QT_TRANSLATE_NOOP("QObject", "M372: Record calibration value, and move to next position")},
+    {373, "M373", Unsupported, 0, 0, Smoothie, QT_TRANSLATE_NOOP("QObject", "M373: End bed level calibration mode")},
+    {374, "M374", Unsupported, 0, 0, Smoothie, QT_TRANSLATE_NOOP("QObject", "M374: Save calibration grid")},
+    {375, "M375", Unsupported, 0, 0, Smoothie, QT_TRANSLATE_NOOP("QObject", "M375: Display matrix / Load Matrix")},
+    {380, "M380", Unsupported, 0, 0, Marlin, QT_TRANSLATE_NOOP("QObject", "M380: Activate solenoid")},
+    {381, "M381", Unsupported, 0, 0, Marlin, QT_TRANSLATE_NOOP("QObject", "M381: Disable all solenoids")},
+    {400, "M400", Unsupported, 0, 0, Sprinter | Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M400: Wait for current moves to finish")},
+    {401, "M401", Unsupported, 0, 0, Marlin, QT_TRANSLATE_NOOP("QObject", "M401: Lower z-probe")},
+    {402, "M402", Unsupported, 0, 0, Marlin, QT_TRANSLATE_NOOP("QObject", "M402: Raise z-probe")},
+    {404, "M404", Unsupported, 0, 0, Marlin | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M404: Filament width and nozzle diameter")},
+    {405, "M405", Unsupported, 0, 0, Marlin, QT_TRANSLATE_NOOP("QObject", "M405: Filament Sensor on")},
+    {406, "M406", Unsupported, 0, 0, Marlin, QT_TRANSLATE_NOOP("QObject", "M406: Filament Sensor off")},
+    {407, "M407", Unsupported, 0, 0, Marlin | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M407: Display filament diameter")},
+    {408, "M408", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M408: Report JSON-style response")},
+    {420, "M420", Unsupported, 0, 0, Marlin, QT_TRANSLATE_NOOP("QObject", "M420: Enable/Disable Mesh Leveling (Marlin)")},
+    {450, "M450", Unsupported, 0, 0, Repetier, QT_TRANSLATE_NOOP("QObject", "M450: Report Printer Mode")},
+    {451, "M451", Unsupported, 0, 0, Repetier, QT_TRANSLATE_NOOP("QObject", "M451: Select FFF Printer Mode")},
+    {452, "M452", Unsupported, 0, 0, Repetier, QT_TRANSLATE_NOOP("QObject", "M452: Select Laser Printer Mode")},
+    {453, "M453", Unsupported, 0, 0, Repetier, QT_TRANSLATE_NOOP("QObject", "M453: Select CNC Printer Mode")},
+    {460, "M460", Unsupported, 0, 0, Repetier, QT_TRANSLATE_NOOP("QObject", "M460: Define temperature range for thermistor controlled fan")},
+    {500, "M500", Unsupported, 0, 0, Sprinter | Marlin | Repetier | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M500: Store parameters in EEPROM")},
+    {501, "M501", Unsupported, 0, 0, Sprinter | Marlin | Repetier | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M501: Read parameters from EEPROM")},
+    {502, "M502", Unsupported, 0, 0, Sprinter | Marlin | Repetier | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M502: Revert to the default 'factory settings'.")},
+    {503, "M503", Unsupported, 0, 0, Sprinter | Marlin | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M503: Print settings ")},
+    {540, "M540", Unsupported, 0, 0, Marlin, QT_TRANSLATE_NOOP("QObject", "M540: Enable/Disable 'Stop SD Print on Endstop Hit'")},
+    {550, "M550", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M550: Set Name")},
+    {551, "M551", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M551: Set Password")},
+    {552, "M552", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M552: Set IP address")},
+    {553, "M553", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M553: Set Netmask")},
+    {554, "M554", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M554: Set Gateway")},
+    {555, "M555", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M555: Set compatibility")},
+    {556, "M556", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M556: Axis compensation")},
+    {557, "M557", Unsupported, 0, 0, Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M557: Set Z probe point")},
+    {558, "M558", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M558: Set Z probe type")},
+    {559, "M559", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M559: Upload configuration file")},
+    {560, "M560", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M560: Upload web page file")},
+    {561, "M561", Unsupported, 0, 0, Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M561: Set Identity Transform")},
+    {562, "M562", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M562: Reset temperature fault")},
+    {563, "M563", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M563: Define or remove a tool")},
+    {564, "M564", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M564: Limit axes")},
+    {565, "M565", Unsupported, 0, 0, Smoothie, QT_TRANSLATE_NOOP("QObject", "M565: Set Z probe offset")},
+    {566, "M566", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M566: Set allowable instantaneous speed change")},
+    {567, "M567", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M567: Set tool mix ratio")},
+    {568, "M568", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M568: Turn off/on tool mix ratio")},
+    {569, "M569", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M569: Set axis direction and enable values")},
+    {570, "M570", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M570: Set heater timeout")},
+    {571, "M571", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M571: Set output on extrude")},
+    {573, "M573", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M573: Report heater PWM")},
+    {574, "M574", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M574: Set endstop configuration")},
+    {575, "M575", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M575: Set serial comms parameters")},
+    {577, "M577", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M577: Wait until endstop is triggered")},
+    {578, "M578", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M578: Fire inkjet bits")},
+    {579, "M579", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M579: Scale Cartesian axes")},
+    {580, "M580", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M580: Select Roland")},
+    {600, "M600", Unsupported, 0, 0, Marlin, QT_TRANSLATE_NOOP("QObject", "M600: Filament change pause")},
+    {605, "M605", Unsupported, 0, 0, Marlin, QT_TRANSLATE_NOOP("QObject", "M605: Set dual x-carriage movement mode")},
+    {665, "M665", Unsupported, 0, 0, Marlin | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M665: Set delta configuration")},
+    {666, "M666", Unsupported, 0, 0, Marlin | Repetier | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M666: Set delta endstop adjustment")},
+    {667, "M667", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M667: Select CoreXY mode")},
+    {851, "M851", Unsupported, 0, 0, Marlin, QT_TRANSLATE_NOOP("QObject", "M851: Set Z-Probe Offset")},
+    {906, "M906", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M906: Set motor currents")},
+    {907, "M907", Unsupported, 0, 0, Marlin | Repetier | Smoothie, QT_TRANSLATE_NOOP("QObject", "M907: Set digital trimpot motor")},
+    {908, "M908", Unsupported, 0, 0, Marlin | Repetier, QT_TRANSLATE_NOOP("QObject", "M908: Control digital trimpot directly")}, // Marlin - Repetier > 0.92
+    {911, "M911", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M911: Set power monitor threshold voltages")},
+    {912, "M912", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M912: Set electronics temperature monitor adjustment")},
+    {913, "M913", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M913: Set motor percentage of normal current")},
+    {928, "M928", Unsupported, 0, 0, Marlin, QT_TRANSLATE_NOOP("QObject", "M928: Start SD logging")},
+    {997, "M997", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M997: Perform in-application firmware update")},
+    {998, "M998", Unsupported, 0, 0, RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M998: Request resend of line")},
+    {999, "M999", Unsupported, 0, 0, Marlin | Smoothie | RepRapFirmware, QT_TRANSLATE_NOOP("QObject", "M999: Restart after being stopped by error")},
+};
+
+const int _gCount = int(sizeof(_gCommands) / sizeof(*_gCommands));
+const int _mCount = int(sizeof(_mCommands) / sizeof(*_mCommands));
+
+// codes go up to M999, so a code is its own collision free slot
+const int _slots = 1000;
+
+/**
+ * @brief Number written in \p prefix after its letter
+ */
+constexpr int prefixCode(const char *prefix, int code = 0)
+{
+    return *prefix >= '0' && *prefix <= '9' ? prefixCode(prefix + 1, code * 10 + (*prefix - '0')) : code;
 }
 
-QString GCode::toCommand(GCommands gcode, const QString &value1)
+/**
+ * @brief True if \p table is sorted by code, each prefix matches its code and arguments fit the arity
+ */
+constexpr bool isWellFormed(const Command *table, int size)
 {
-    QString code = QStringLiteral("G%1").arg(QString::number(gcode));
-    switch (gcode) {
-    case G90:
-    case G91:
-        return code;
+    return size == 0
+           || (table[0].code >= 0 && table[0].code < _slots
+               && prefixCode(table[0].prefix + 1) == table[0].code
+               && table[0].required <= table[0].arity
+               && (size == 1 || table[0].code < table[1].code)
+               && isWellFormed(table + 1, size - 1));
+}
 
-    case G32:
-        return code.append(QStringLiteral(" S1"));
-    case G0:
-    case G1:
-    case G28:
-        code = value1.isEmpty() ? code : code.append(QStringLiteral(" %1").arg(value1.toUpper()));
-        return code;
+static_assert(isWellFormed(_gCommands, _gCount), "G command table is not sorted or has a wrong prefix");
+static_assert(isWellFormed(_mCommands, _mCount), "M command table is not sorted or has a wrong prefix");
 
-    default:
-        return commandNotSupported;
+/**
+ * @brief Row of each code, -1 for codes without one
+ */
+struct SlotIndex {
+    short row[_slots];
+
+    SlotIndex(const Command *table, int size)
+    {
+        std::fill(row, row + _slots, short(-1));
+        for (int i = 0; i < size; i++) {
+            row[table[i].code] = short(i);
+        }
     }
+
+    const Command *find(const Command *table, int code) const
+    {
+        return code >= 0 && code < _slots && row[code] != -1 ? &table[row[code]] : nullptr;
+    }
+};
+
+const Command *findG(int code)
+{
+    static const SlotIndex index(_gCommands, _gCount);
+    return index.find(_gCommands, code);
 }
 
-QString GCode::description(MCommands gcode)
+const Command *findM(int code)
 {
-    switch (gcode) {
-    case M0://Marlin - Teacup - RepRap Firmware
-        return QObject::tr("M0: Stop or unconditional stop");
-    case M1://Marlin - RepRap Firmware
-        return QObject::tr("M1: Sleep or unconditional stop");
-    case M2://Teacup - Maker Bot
-        return QObject::tr("M2: Program End");
-    case M6://Teacup
-        return QObject::tr("M6: Tool Change");
-    case M17://Teacup - Marlin - Smoothie
-        return QObject::tr("M17: Enable/power all steppers motors");
-    case M18://Teacup - Marlin(M84) - Smoothie -RepRap Firmware
-        return QObject::tr("M18: Disable all steppers motors");
-    case M20://Teacup - Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("M20: List SDCard");
-    case M21://Teacup - Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("M21: Initialize SDCard");
-    case M22://Teacup - Sprinter - Marlin - Repetier - RepRap Firmware
-        return QObject::tr("M22: Release SDCard");
-    case M23://Teacup - Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("M23: Select SD file");
-    case M24://Teacup - Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("M24: Start/resume SD print");
-    case M25://Teacup - Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("M25: Pause SD print");
-    case M26://Sprinter - Marlin - Repetier - Smoothie(abort) - RepRap Firmware
-        return QObject::tr("M26: Set SD position");
-    case M27://Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("M27: Report SD print status");
-    case M28://Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("M28: Begin write to SD card");
-    case M29:// Sprinter - Marlin - Repetier - RepRap Firmware
-        return QObject::tr("M29: Stop writing to SD card");
-    case M30://Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("M30: Delete a file on the SD card");
-    case M31://Marlin
-        return QObject::tr("M31: Output time since last M109 or SD card start to serial");
-    case M32://Marlin - Smoothie - RepRap Firmware
-        return QObject::tr("M32: Select file and start SD print");
-    case M33://Marlin
-        return QObject::tr("M33: Get the long name for an SD card file or folder");
-    case M34://Marlin
-        return QObject::tr("M34: Set SD file sorting options");
-    case M36://RepRap Firmware
-        return QObject::tr("M36: Return file information");
-    case M42://Sprinter - Marlin - Repetier - RepRap Firmware
-        return QObject::tr("M42: Switch I/O pin");
-    case M48://Marlin
-        return QObject::tr("M48: Measure Z-Probe repeatability");
-    case M70://MakerBot
-        return QObject::tr("M70: Display message");
-    case M72://MakerBot
-        return QObject::tr("M72: Play a tone or song");
-    case M73://MakerBot
-        return QObject::tr("M73: Set build percentage");
-    case M80://Teacup(automatic) - Sprinter - Marlin - Repetier - RepRap Firmware
-        return QObject::tr("M80: ATX Power On");
-    case M81://Teacup(automatic) - Sprinter - Marlin - Repetier  - RepRap Firmware
-        return QObject::tr("M81: ATX Power Off");
-    case M82://Teacup - Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("M82: Set extruder to absolute mode");
-    case M83://Teacup - Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("M83: Set extruder to relative mode");
-    case M84://Teacup - Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("M84: Stop idle hold");
-    case M85://Sprinter - Marlin - Repetier
-        return QObject::tr("M85: Set Inactivity shutdown timer");
-    case M92:// Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("M92: Set axis steps per unit");
-    case M93:// Sprinter
-        return QObject::tr("M93: Send axis steps per unit");
-    case M98: //RepRap Firmware
-        return QObject::tr("M98: Call Macro/Subprogram");
-    case M99://RepRap Firmware
-        return QObject::tr("M99: Return from Macro/Subprogram");
-    case M101://Teacup
-        return QObject::tr("M101: Turn extruder 1 on Forward, Undo Retraction");
-    case M103://Teacup
-        return QObject::tr("M103: Turn all extruders off - Extruder Retraction");
-    case M104://Teacup - Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware - MakerBot
-        return QObject::tr("M104: Set Extruder Temperature");
-    case M105://Teacup - Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware - MakerBot
-        return QObject::tr("M105: Get Extruder Temperature");
-    case M106://Teacup - Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("M106: Fan On");
-    case M107:// Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("M107: Fan Off");
-    case M108://Marlin
-        return QObject::tr("M108: Cancel Heating");
-    case M109:// Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware - MakerBot
-        return QObject::tr("M109: Set Extruder Temperature and Wait");
-    case M110:// Marlin - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("M110: Set Current Line Number");
-    case M111://Teacup -  Marlin - Repetier - RepRap Firmware
-        return QObject::tr("M111: Set Debug Level");
-    case M112://Teacup - Marlin - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("M112: Emergency Stop");
-    case M114://Teacup - Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware - MakerBot
-        return QObject::tr("M114: Get Current Position");
-    case M115://Teacup - Sprinter - Marlin - Repetier - RepRap Firmware
-        return QObject::tr("M115: Get Firmware Version and Capabilities");
-    case M116://Teacup - Repetier - RepRap Firmware - MakerBot
-        return QObject::tr("M116: Wait");
-    case M117:// Marlin - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("M117: Display Message");
-    case M119://Teacup - Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("M119: Get Endstop Status");
-    case M120://Marlin - Smoothie - RepRap Firmware
-        return QObject::tr("M120: Push for Smoothie and RepRap Firmware / Enable Endstop detection for Marlin");
-    case M121://Marlin - Smoothie - RepRap Firmware
-        return QObject::tr("M121: Pop for Smoothie and RepRap Firmware / Disable Endstop detection for Marlin");
-    case M122://RepRap Firmware
-        return QObject::tr("M122: Diagnose");
-    case M126://Marlin - MakerBot
-        return QObject::tr("M126: Open valve");
-    case M127://Marlin - MakerBot
-        return QObject::tr("M127: Close valve");
-    case M130://Teacup
-        return QObject::tr("M130: Set PID P value");
-    case M131://Teacup
-        return QObject::tr("M131: Set PID I value");
-    case M132://Teacup - MakerBot
-        return QObject::tr("M132: Set PID D value");
-    case M133://Teacup - MakerBot
-        return QObject::tr("M133: Set PID I limit value");
-    case M134://Teacup - MakerBot
-        return QObject::tr("M134: Write PID values to EEPROM");
-    case M135://RepRap Firmware - MakerBot
-        return QObject::tr("M135: Set PID sample interval");
-    case M140://Teacup - Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware - MakerBot
-        return QObject::tr("M140: Set Bed Temperature - Fast");
-    case M141://RepRap Firmware
-        return QObject::tr("M141: Set Chamber Temperature - Fast");
-    case M143://RepRap Firmware
-        return QObject::tr("M143: Maximum hot-end temperature");
-    case M144://RepRap Firmware
-        return QObject::tr("M144: Stand by your bed");
-    case M150://Marlin
-        return QObject::tr("M150: Set display color");
-    case M163://Repetier > 0.92
-        return QObject::tr("M163: Set weight of mixed material");
-    case M164://Repetier > 0.92
-        return QObject::tr("M164: Store weights");
-    case M190://Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("M190: Wait for bed temperature to reach target temp");
-    case M200://Marlin - Repetier - Smoothie
-        return QObject::tr("M200: Set filament diameter");
-    case M201://Sprinter - Marlin - Repetier - RepRap Firmware
-        return QObject::tr("M201: Set max printing acceleration");
-    case M202://Marlin - Repetier
-        return QObject::tr("M202: Set max travel acceleration");
-    case M203://Marlin - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("M203: Set maximum feedrate");
-    case M204://Sprinter - Marlin - Repetier - Smoothie
-        return QObject::tr("M204: Set default acceleration");
-    case M205://Sprinter - Marlin - Repetier - Smoothie
-        return QObject::tr("M205: Advanced settings");
-    case M206://Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("M206: Offset axes for Sprinter, Marlin, Smoothie, RepRap Firmware / Set eeprom value for Repetier");
-    case M207://Marlin - Smoothie
-        return QObject::tr("M207: Set retract length");
-    case M208://Marlin - Smoothie
-        return QObject::tr("M208: Set unretract length");
-    case M209://Marlin - Repetier
-        return QObject::tr("M209: Enable automatic retract");
-    case M212://Marlin
-        return QObject::tr("M212: Set Bed Level Sensor Offset");
-    case M218://Marlin
-        return QObject::tr("M218: Set Hotend Offset");
-    case M220://Teacup - Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("M220: Set speed factor override percentage");
-    case M221://Teacup - Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("M221: Set extrude factor override percentage");
-    case M226://Marlin - Repetier
-        return QObject::tr("M226: Wait for pin state");
-    case M231://Repetier
-        return QObject::tr("M231: Set OPS parameter");
-    case M232://Repetier
-        return QObject::tr("M232: Read and reset max. advance values");
-    case M240://Marlin
-        return QObject::tr("M240: Trigger camera");
-    case M250://Marlin
-        return QObject::tr("M250: Set LCD contrast");
-    case M251://Repetier
-        return QObject::tr("M251: Measure Z steps from homing stop (Delta printers)");
-    case M280://Marlin
-        return QObject::tr("M280: Set servo position");
-    case M300://Marlin - Repetier - RepRap Firmware - MakerBot
-        return QObject::tr("M300: Play beep sound");
-    case M301://Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("M301: Set PID parameters");
-    case M302://Marlin - Repetier > 0.92 - RepRap Firmware
-        return QObject::tr("M302: Allow cold extrudes ");
-    case M303://Sprinter - Marlin - Repetier - Smoothie
-        return QObject::tr("M303: Run PID tuning");
-    case M304://Marlin - RepRap Firmware
-        return QObject::tr("M304: Set PID parameters - Bed");
-    case M305:// Smoothie - RepRap Firmware
-        return QObject::tr("M305: Set thermistor and ADC parameters");
-    case M306:// Smoothie
-        return QObject::tr("M306: set home offset calculated from toolhead position");
-    case M320://Repeier
-        return QObject::tr("M320: Activate autolevel (Repetier)");
-    case M321://Repetier
-        return QObject::tr("M321: Deactivate autolevel (Repetier)");
-    case M322://Repetier
-        return QObject::tr("M322: Reset autolevel matrix (Repetier)");
-    case M323://Repetier
-        return QObject::tr("M323: Distortion correction on/off (Repetier)");
-    case M340://Repetier
-        return QObject::tr("M340: Control the servos");
-    case M350://Marlin - Repetier - RepRap Firmware
-        return QObject::tr("M350: Set microstepping mode");
-    case M351://Marlin
-        return QObject::tr("M351: Toggle MS1 MS2 pins directly");
-    case M355://Repetier > 0.92.2
-        return QObject::tr("M355: Turn case lights on/off");
-    case M360://Repetier > 9.92.2
-        return QObject::tr("M360: Report firmware configuration");
-    case M361://Smoothie
-        return QObject::tr("M361: Move to Theta 90 degree position");
-    case M362://Smoothie
-        return QObject::tr("M362: Move to Psi 0 degree position");
-    case M363://Smoothie
-        return QObject::tr("M363: Move to Psi 90 degree position");
-    case M364://Smoothie
-        return QObject::tr("M364: Move to Psi + Theta 90 degree position");
-    case M365://Smoothie
-        return QObject::tr("M365: SCARA scaling factor");
-    case M366://Smoothie
-        return QObject::tr("M366: SCARA convert trim");
-    case M370://Smoothie
-        return QObject::tr("M370: Morgan manual bed level - clear map");
-    case M371://Smoothie
-        return QObject::tr("M371: Move to next calibration position");
-    case M372://Smoothie
-        return QObject::tr("M372: Record calibration value, and move to next position");
-    case M373://Smoothie
-        return QObject::tr("M373: End bed level calibration mode");
-    case M374://Smoothie
-        return QObject::tr("M374: Save calibration grid");
-    case M375://Smoothie
-        return QObject::tr("M375: Display matrix / Load Matrix");
-    case M380://Marlin
-        return QObject::tr("M380: Activate solenoid");
-    case M381://Marlin
-        return QObject::tr("M381: Disable all solenoids");
-    case M400://Sprinter - Marlin - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("M400: Wait for current moves to finish");
-    case M401://Marlin
-        return QObject::tr("M401: Lower z-probe");
-    case M402://Marlin
-        return QObject::tr("M402: Raise z-probe");
-    case M404://Marlin - RepRap Firmware
-        return QObject::tr("M404: Filament width and nozzle diameter");
-    case M405://Marlin
-        return QObject::tr("M405: Filament Sensor on");
-    case M406://Marlin
-        return QObject::tr("M406: Filament Sensor off");
-    case M407://Marlin - RepRap Firmware
-        return QObject::tr("M407: Display filament diameter");
-    case M408://RepRap Firmware
-        return QObject::tr("M408: Report JSON-style response");
-    case M420:
-        return QObject::tr("M420: Enable/Disable Mesh Leveling (Marlin)");
-    case M450://Repetier
-        return QObject::tr("M450: Report Printer Mode");
-    case M451://Repetier
-        return QObject::tr("M451: Select FFF Printer Mode");
-    case M452://Repetier
-        return QObject::tr("M452: Select Laser Printer Mode");
-    case M453://Repetier
-        return QObject::tr("M453: Select CNC Printer Mode");
-    case M460://Repetier
-        return QObject::tr("M460: Define temperature range for thermistor controlled fan");
-    case M500://Sprinter - Marlin - Repetier - RepRap Firmware
-        return QObject::tr("M500: Store parameters in EEPROM");
-    case M501://Sprinter - Marlin - Repetier - RepRap Firmware
-        return QObject::tr("M501: Read parameters from EEPROM");
-    case M502://Sprinter - Marlin - Repetier - RepRap Firmware
-        return QObject::tr("M502: Revert to the default 'factory settings'.");
-    case M503://Sprinter - Marlin - RepRap Firmware
-        return QObject::tr("M503: Print settings ");
-    case M540://Marlin
-        return QObject::tr("M540: Enable/Disable 'Stop SD Print on Endstop Hit'");
-    case M550://RepRap Firmware
-        return QObject::tr("M550: Set Name");
-    case M551://RepRap Firmware
-        return QObject::tr("M551: Set Password");
-    case M552://RepRap Firmware
-        return QObject::tr("M552: Set IP address");
-    case M553://RepRap Firmware
-        return QObject::tr("M553: Set Netmask");
-    case M554://RepRap Firmware
-        return QObject::tr("M554: Set Gateway");
-    case M555://RepRap Firmware
-        return QObject::tr("M555: Set compatibility");
-    case M556://RepRap Firmware
-        return QObject::tr("M556: Axis compensation");
-    case M557://Smoothie - RepRap Firmware
-        return QObject::tr("M557: Set Z probe point");
-    case M558://RepRap Firmware
-        return QObject::tr("M558: Set Z probe type");
-    case M559://RepRap Firmware
-        return QObject::tr("M559: Upload configuration file");
-    case M560://RepRap Firmware
-        return QObject::tr("M560: Upload web page file");
-    case M561://Smoothie - RepRap Firmware
-        return QObject::tr("M561: Set Identity Transform");
-    case M562://RepRap Firmware
-        return QObject::tr("M562: Reset temperature fault");
-    case M563://RepRap Firmware
-        return QObject::tr("M563: Define or remove a tool");
-    case M564://RepRap Firmware
-        return QObject::tr("M564: Limit axes");
-    case M565://Smoothie
-        return QObject::tr("M565: Set Z probe offset");
-    case M566://RepRap Firmware
-        return QObject::tr("M566: Set allowable instantaneous speed change");
-    case M567://RepRap Firmware
-        return QObject::tr("M567: Set tool mix ratio");
-    case M568://RepRap Firmware
-        return QObject::tr("M568: Turn off/on tool mix ratio");
-    case M569://RepRap Firmware
-        return QObject::tr("M569: Set axis direction and enable values");
-    case M570://RepRap Firmware
-        return QObject::tr("M570: Set heater timeout");
-    case M571://RepRap Firmware
-        return QObject::tr("M571: Set output on extrude");
-    case M573://RepRap Firmware
-        return QObject::tr("M573: Report heater PWM");
-    case M574://RepRap Firmware
-        return QObject::tr("M574: Set endstop configuration");
-    case M575://RepRap Firmware
-        return QObject::tr("M575: Set serial comms parameters");
-    case M577://RepRap Firmware
-        return QObject::tr("M577: Wait until endstop is triggered");
-    case M578://RepRap Firmware
-        return QObject::tr("M578: Fire inkjet bits");
-    case M579://RepRap Firmware
-        return QObject::tr("M579: Scale Cartesian axes");
-    case M580://RepRap Firmware
-        return QObject::tr("M580: Select Roland");
-    case M600://Marlin
-        return QObject::tr("M600: Filament change pause");
-    case M605://Marlin
-        return QObject::tr("M605: Set dual x-carriage movement mode");
-    case M665://Marlin - Smoothie - RepRap Firmware
-        return QObject::tr("M665: Set delta configuration");
-    case M666://Marlin - Repetier - Smoothie - RepRap Firmware
-        return QObject::tr("M666: Set delta endstop adjustment");
-    case M667://RepRap Firmware
-        return QObject::tr("M667: Select CoreXY mode");
-    case M851://Marlin
-        return QObject::tr("M851: Set Z-Probe Offset");
-    case M906://RepRap Firmware
-        return QObject::tr("M906: Set motor currents");
-    case M907://Marlin - Repetier - Smoothie
-        return QObject::tr("M907: Set digital trimpot motor");
-    case M908://Marlin - Repetier > 0.92
-        return QObject::tr("M908: Control digital trimpot directly");
-    case M911://RepRap Firmware
-        return QObject::tr("M911: Set power monitor threshold voltages");
-    case M912://RepRap Firmware
-        return QObject::tr("M912: Set electronics temperature monitor adjustment");
-    case M913://RepRap Firmware
-        return QObject::tr("M913: Set motor percentage of normal current");
-    case M928://Marlin
-        return QObject::tr("M928: Start SD logging");
-    case M997://RepRap Firmware
-        return QObject::tr("M997: Perform in-application firmware update");
-    case M998://RepRap Firmware
-        return QObject::tr("M998: Request resend of line");
-    case M999://Marlin - Smoothie - RepRap Firmware
-        return QObject::tr("M999: Restart after being stopped by error");
-    default:
-        return commandNotSupported;
+    static const SlotIndex index(_mCommands, _mCount);
+    return index.find(_mCommands, code);
+}
+
+/**
+ * @brief Code of \p command if it starts with \p letter followed by a number
+ * @return -1 if it doesn't
+ */
+int parseCode(const QString &command, char letter)
+{
+    const QChar *p = command.constData();
+    const QChar *end = p + command.size();
+    while (p < end && p->isSpace()) {
+        p++;
     }
+    if (p == end || p->toUpper() != QLatin1Char(letter)) {
+        return -1;
+    }
+    p++;
+    int code = 0;
+    int digits = 0;
+    for (; p < end && p->unicode() >= '0' && p->unicode() <= '9' && digits < 4; p++, digits++) {
+        code = code * 10 + (p->unicode() - '0');
+    }
+    // subcodes are other commands
+    if (!digits || (p < end && !p->isSpace())) {
+        return -1;
+    }
+    return code;
 }
 
-QString GCode::toCommand(MCommands gcode, const QString &value1, const QString &value2)
+/**
+ * @brief Write \p command with its arguments
+ */
+QString format(const Command *command, char letter, const QString &value1, const QString &value2)
 {
-    QString code = QStringLiteral("M%1").arg(QString::number(gcode));
-    switch (gcode) {
-    case M20:
-    case M24:
-    case M25:
-    case M27:
-    case M105:
-    case M107:
-    case M112:
-    case M114:
-    case M115:
-    case M116:
-    case M119:
+    if (!command || command->format == Unsupported) {
+        return GCode::commandNotSupported;
+    }
+    if (command->required && value1.isEmpty()) {
+        return GCode::commandRequiresArgument.arg(QString(QLatin1Char(letter)), QString::number(command->code));
+    }
+    QString code = QLatin1String(command->prefix);
+    switch (command->format) {
+    case Words:
+        return value1.isEmpty() ? code : code + QLatin1Char(' ') + value1.toUpper();
+    case Text:
+        return code + QLatin1Char(' ') + value1;
+    case OptionalP:
+        return value1.isEmpty() ? code : code + QLatin1String(" P") + value1;
+    case SValue:
+        return value1.isEmpty() ? code : code + QLatin1String(" S") + value1;
+    case ToolAndS:
+        if (value1.isEmpty()) {
+            return code;
+        }
+        return value2.isEmpty() ? code + QLatin1String(" S") + value1 : code + QLatin1String(" P") + value1 + QLatin1String(" S") + value2;
+    /// For M26 values that end with %. AtCore will send the percentage verison of the command (optional in firmwares)
+    /// For all values not ending in % it will start on that byte. This is the standard Sd resume supported by all reprap based firmware.
+    case SdPosition:
+        if (value1.endsWith(QLatin1Char('%'))) {
+            return code + QLatin1String(" P") + QString::number(value1.leftRef(value1.size() - 1).toDouble() / 100);
+        }
+        return code + QLatin1String(" S") + value1;
+    default:
         return code;
+    }
+}
+}
 
-    case M21:
-    case M22:
-        code = value1.isEmpty() ? code : code.append(QStringLiteral(" P%1").arg(value1));
-        return code;
+QString GCode::description(GCommands gcode)
+{
+    const Command *command = findG(gcode);
+    return command ? QObject::tr(command->description) : commandNotSupported;
+}
 
-    case M23:
-    case M28:
-    case M29:
-    case M30:
-    case M117:
-        code = value1.isEmpty() ? GCode::commandRequiresArgument.arg(QStringLiteral("M"), QString::number(gcode)) : code.append(QStringLiteral(" %1").arg(value1));
-        return code;
+QString GCode::description(MCommands gcode)
+{
+    const Command *command = findM(gcode);
+    return command ? QObject::tr(command->description) : commandNotSupported;
+}
 
-    case M109:
-    case M140:
-    case M190:
-    case M220:
-    case M221:
-        code = value1.isEmpty() ? GCode::commandRequiresArgument.arg(QStringLiteral("M"), QString::number(gcode)) : code.append(QStringLiteral(" S%1").arg(value1));
-        return code;
+QString GCode::toCommand(GCommands gcode, const QString &value1)
+{
+    return format(findG(gcode), 'G', value1, QString());
+}
 
-    case M84:
-        code = value1.isEmpty() ? code : code.append(QStringLiteral(" S%1").arg(value1));
-        return code;
+QString GCode::toCommand(MCommands gcode, const QString &value1, const QString &value2)
+{
+    return format(findM(gcode), 'M', value1, value2);
+}
 
-    case M104:
-        code = value2.isEmpty() ? code.append(QStringLiteral(" S%1").arg(value1)) : code.append(QStringLiteral(" P%1 S%2").arg(value1).arg(value2));
-        code = value1.isEmpty() ? GCode::commandRequiresArgument.arg(QStringLiteral("M"), QString::number(gcode)) : code ;
-        return code;
+GCode::Firmwares GCode::firmwares(GCommands gcode)
+{
+    const Command *command = findG(gcode);
+    return command ? Firmwares(command->firmwares) : Firmwares();
+}
 
-    case M106:
-        code = value2.isEmpty() ? code.append(QStringLiteral(" S%1").arg(value1)) : code.append(QStringLiteral(" P%1 S%2").arg(value1).arg(value2));
-        code = value1.isEmpty() ? QStringLiteral("M106") : code ;
-        return code;
+GCode::Firmwares GCode::firmwares(MCommands gcode)
+{
+    const Command *command = findM(gcode);
+    return command ? Firmwares(command->firmwares) : Firmwares();
+}
 
-    /// For M26 values that end with %. AtCore will send the percentage verison of the command (optional in firmwares)
-    /// For all values not ending in % it will start on that byte. This is the standard Sd resume supported by all reprap based firmware.
-    case M26: {
-        if (!value1.isEmpty()) {
-            if (value1.endsWith(QStringLiteral("%"))) {
-                QString temp = value1;
-                temp.replace(QStringLiteral("%"), QStringLiteral(""));
-                return code.append(QStringLiteral(" P%1").arg(temp.toDouble() / 100));
-            }
-            return code.append(QStringLiteral(" S%1").arg(value1));
-        }
-        return GCode::commandRequiresArgument.arg(QStringLiteral("M"), QString::number(gcode));
+bool GCode::fromCommand(const QString &command, GCommands &gcode)
+{
+    const Command *row = findG(parseCode(command, 'G'));
+    if (row) {
+        gcode = GCommands(row->code);
     }
+    return row;
+}
 
-    default:
-        return commandNotSupported;
+bool GCode::fromCommand(const QString &command, MCommands &mcode)
+{
+    const Command *row = findM(parseCode(command, 'M'));
+    if (row) {
+        mcode = MCommands(row->code);
     }
+    return row;
 }
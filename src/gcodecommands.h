@@ -32,6 +32,7 @@
 /**
  * @brief The GCode class
  * Provides Descriptions and Commands strings for G and M Commands
+ * from tables of the commands built at compile time
  */
 class ATCORE_EXPORT GCode
 {
@@ -109,6 +110,21 @@ public:
     };
     Q_ENUM(MCommands);
 
+    /**
+     * @brief Firmwares a command is known to work with
+     */
+    enum Firmware {
+        Teacup = 0x01,
+        Sprinter = 0x02,
+        Marlin = 0x04,
+        Repetier = 0x08,
+        Smoothie = 0x10,
+        RepRapFirmware = 0x20,
+        MakerBot = 0x40
+    };
+    Q_DECLARE_FLAGS(Firmwares, Firmware)
+    Q_FLAG(Firmwares)
+
     /**
      * @brief Return Description of command \p gcode
      * @param gcode: Command to describe
@@ -138,7 +154,39 @@ public:
      * @return Command String to send to printer
      */
     static QString toCommand(MCommands gcode, const QString &value1 = QString(), const QString &value2 = QString());
+
+    /**
+     * @brief Firmwares supporting command \p gcode
+     * @param gcode: Command to look up
+     * @return flags of the firmwares, none if it isn't known
+     */
+    static Firmwares firmwares(GCommands gcode);
+
+    /**
+     * @brief Firmwares supporting command \p gcode
+     * @param gcode: Command to look up
+     * @return flags of the firmwares, none if it isn't known
+     */
+    static Firmwares firmwares(MCommands gcode);
+
+    /**
+     * @brief Find the GCode::GCommands of a command
+     * @param command: Command String like "G28 X", its first word is looked up
+     * @param gcode: set to the command found
+     * @return False if \p command doesn't start with a known G command
+     */
+    static bool fromCommand(const QString &command, GCommands &gcode);
+
+    /**
+     * @brief Find the GCode::MCommands of a command
+     * @param command: Command String like "M104 S200", its first word is looked up
+     * @param mcode: set to the command found
+     * @return False if \p command doesn't start with a known M command
+     */
+    static bool fromCommand(const QString &command, MCommands &mcode);
 protected:
     static const QString commandRequiresArgument;
     static const QString commandNotSupported;
 };
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(GCode::Firmwares)
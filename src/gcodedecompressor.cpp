@@ -0,0 +1,506 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QFile>
+#include <QLoggingCategory>
+#include <QMutex>
+#include <QQueue>
+#include <QThread>
+#include <QWaitCondition>
+#include <cstring>
+
+#if defined(HAVE_ZLIB)
+#include <zlib.h>
+#endif
+#if defined(HAVE_BZIP2)
+#include <bzlib.h>
+#endif
+#if defined(HAVE_ZSTD)
+#include <zstd.h>
+#endif
+
+#include "gcodedecompressor.h"
+
+Q_LOGGING_CATEGORY(GCODE_DECOMPRESSOR, "org.kde.atelier.core.gcodeDecompressor")
+
+namespace
+{
+// compressed bytes read at once
+const int _inputSize = 64 * 1024;
+// decompressed bytes handed out at once
+const int _blockSize = 256 * 1024;
+// blocks decoded ahead of the reader, a few seconds of the fastest serial link
+const int _blocksAhead = 16;
+
+/**
+ * @brief Decodes one format, a stream after the other
+ */
+class Decoder
+{
+public:
+    virtual ~Decoder()
+    {
+    }
+
+    /**
+     * @brief Decode from \p in to \p out as far as both allow, advancing both
+     * @return False on corrupt data
+     */
+    virtual bool decode(const char *&in, const char *inEnd, char *&out, char *outEnd) = 0;
+
+    /**
+     * @brief True between two streams, where the file may end
+     */
+    virtual bool atBoundary() const = 0;
+};
+
+#if defined(HAVE_ZLIB)
+/**
+ * @brief Decodes gzip and zlib, concatenated members included
+ */
+class GzipDecoder : public Decoder
+{
+public:
+    GzipDecoder()
+    {
+        std::memset(&_stream, 0, sizeof(_stream));
+        // 32: detect the gzip or zlib header
+        _ok = inflateInit2(&_stream, MAX_WBITS + 32) == Z_OK;
+    }
+
+    ~GzipDecoder() override
+    {
+        if (_ok) {
+            inflateEnd(&_stream);
+        }
+    }
+
+    bool decode(const char *&in, const char *inEnd, char *&out, char *outEnd) override
+    {
+        if (!_ok) {
+            return false;
+        }
+        if (_boundary) {
+            if (in == inEnd) {
+                return true;
+            }
+            inflateReset(&_stream);
+            _boundary = false;
+        }
+        _stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in));
+        _stream.avail_in = uInt(inEnd - in);
+        _stream.next_out = reinterpret_cast<Bytef *>(out);
+        _stream.avail_out = uInt(outEnd - out);
+        const int result = inflate(&_stream, Z_NO_FLUSH);
+        in = reinterpret_cast<const char *>(_stream.next_in);
+        out = reinterpret_cast<char *>(_stream.next_out);
+        if (result == Z_STREAM_END) {
+            _boundary = true;
+            return true;
+        }
+        // Z_BUF_ERROR only means no progress was possible
+        return result == Z_OK || result == Z_BUF_ERROR;
+    }
+
+    bool atBoundary() const override
+    {
+        return _boundary;
+    }
+
+private:
+    z_stream _stream;
+    bool _ok = false;
+    bool _boundary = true;
+};
+#endif
+
+#if defined(HAVE_BZIP2)
+/**
+ * @brief Decodes bzip2, concatenated streams from parallel compressors included
+ */
+class Bzip2Decoder : public Decoder
+{
+public:
+    ~Bzip2Decoder() override
+    {
+        if (_started) {
+            BZ2_bzDecompressEnd(&_stream);
+        }
+    }
+
+    bool decode(const char *&in, const char *inEnd, char *&out, char *outEnd) override
+    {
+        if (_boundary) {
+            if (in == inEnd) {
+                return true;
+            }
+            if (_started) {
+                BZ2_bzDecompressEnd(&_stream);
+            }
+            std::memset(&_stream, 0, sizeof(_stream));
+            _started = BZ2_bzDecompressInit(&_stream, 0, 0) == BZ_OK;
+            if (!_started) {
+                return false;
+            }
+            _boundary = false;
+        }
+        _stream.next_in = const_cast<char *>(in);
+        _stream.avail_in = uint(inEnd - in);
+        _stream.next_out = out;
+        _stream.avail_out = uint(outEnd - out);
+        const int result = BZ2_bzDecompress(&_stream);
+        in = _stream.next_in;
+        out = _stream.next_out;
+        if (result == BZ_STREAM_END) {
+            _boundary = true;
+            return true;
+        }
+        return result == BZ_OK;
+    }
+
+    bool atBoundary() const override
+    {
+        return _boundary;
+    }
+
+private:
+    bz_stream _stream;
+    bool _started = false;
+    bool _boundary = true;
+};
+#endif
+
+#if defined(HAVE_ZSTD)
+/**
+ * @brief Decodes Zstandard, any number of frames
+ */
+class ZstdDecoder : public Decoder
+{
+public:
+    ZstdDecoder() : _stream(ZSTD_createDStream())
+    {
+        if (_stream) {
+            ZSTD_initDStream(_stream);
+        }
+    }
+
+    ~ZstdDecoder() override
+    {
+        ZSTD_freeDStream(_stream);
+    }
+
+    bool decode(const char *&in, const char *inEnd, char *&out, char *outEnd) override
+    {
+        if (!_stream) {
+            return false;
+        }
+        if (_boundary && in == inEnd) {
+            return true;
+        }
+        ZSTD_inBuffer input = {in, size_t(inEnd - in), 0};
+        ZSTD_outBuffer output = {out, size_t(outEnd - out), 0};
+        const size_t result = ZSTD_decompressStream(_stream, &output, &input);
+        if (ZSTD_isError(result)) {
+            qCDebug(GCODE_DECOMPRESSOR) << ZSTD_getErrorName(result);
+            return false;
+        }
+        in += input.pos;
+        out += output.pos;
+        // 0: a frame was decoded and flushed completely
+        _boundary = result == 0;
+        return true;
+    }
+
+    bool atBoundary() const override
+    {
+        return _boundary;
+    }
+
+private:
+    ZSTD_DStream *_stream;
+    bool _boundary = true;
+};
+#endif
+
+/**
+ * @brief A Decoder for \p format, nullptr if it's not supported
+ */
+Decoder *createDecoder(GCodeDecompressor::FORMAT format)
+{
+    switch (format) {
+#if defined(HAVE_ZLIB)
+    case GCodeDecompressor::GZIP:
+        return new GzipDecoder;
+#endif
+#if defined(HAVE_BZIP2)
+    case GCodeDecompressor::BZIP2:
+        return new Bzip2Decoder;
+#endif
+#if defined(HAVE_ZSTD)
+    case GCodeDecompressor::ZSTD:
+        return new ZstdDecoder;
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+/**
+ * @brief A decompressed block
+ */
+struct Block {
+    QByteArray data;            //!< @param data: decompressed bytes
+    qint64 compressedOffset;    //!< @param compressedOffset: compressed bytes consumed up to its end
+};
+}
+
+class DecompressorThread;
+/**
+ * @brief The GCodeDecompressorPrivate class
+ */
+class GCodeDecompressorPrivate
+{
+public:
+    QFile file;                         //!< @param file: the compressed file
+    GCodeDecompressor::FORMAT format = GCodeDecompressor::NONE; //!< @param format: compression of file
+    qint64 compressedSize = 0;          //!< @param compressedSize: size of file
+    DecompressorThread *worker = nullptr; //!< @param worker: thread decoding file
+
+    QMutex mutex;                       //!< @param mutex: guards the members below
+    QWaitCondition ready;               //!< @param ready: a block was queued or the worker ended
+    QWaitCondition taken;               //!< @param taken: the reader took a block or is stopping
+    QQueue<Block> blocks;               //!< @param blocks: blocks decoded ahead
+    bool ended = false;                 //!< @param ended: the worker queued its last block
+    bool error = false;                 //!< @param error: the worker ended on corrupt data
+    bool stopping = false;              //!< @param stopping: the worker quits without decoding the rest
+
+    /**
+     * @brief Queue \p block for the reader, waits while enough are queued
+     * @return False if the reader is stopping
+     */
+    bool push(const Block &block)
+    {
+        QMutexLocker lock(&mutex);
+        while (blocks.size() >= _blocksAhead && !stopping) {
+            taken.wait(&mutex);
+        }
+        if (stopping) {
+            return false;
+        }
+        blocks.enqueue(block);
+        ready.wakeOne();
+        return true;
+    }
+
+    /**
+     * @brief Decode the whole file into blocks
+     * @return False on corrupt or truncated data
+     */
+    bool decodeFile()
+    {
+        QScopedPointer<Decoder> decoder(createDecoder(format));
+        if (!decoder) {
+            return false;
+        }
+        QByteArray input(_inputSize, Qt::Uninitialized);
+        const char *in = input.constData();
+        const char *inEnd = in;
+        bool eof = false;
+        QByteArray output(_blockSize, Qt::Uninitialized);
+        char *out = output.data();
+        for (;;) {
+            if (in == inEnd && !eof) {
+                const qint64 read = file.read(input.data(), input.size());
+                if (read < 0) {
+                    qCDebug(GCODE_DECOMPRESSOR) << "Can't read" << file.fileName() << file.errorString();
+                    return false;
+                }
+                eof = read == 0;
+                in = input.constData();
+                inEnd = in + read;
+            }
+
+            const char *inBefore = in;
+            char *outBefore = out;
+            if (!decoder->decode(in, inEnd, out, output.data() + output.size())) {
+                qCDebug(GCODE_DECOMPRESSOR) << file.fileName() << "is corrupt";
+                return false;
+            }
+            const bool stalled = in == inBefore && out == outBefore;
+            if (stalled && in != inEnd) {
+                qCDebug(GCODE_DECOMPRESSOR) << file.fileName() << "is corrupt";
+                return false;
+            }
+
+            const bool last = eof && stalled;
+            if (out == output.data() + output.size() || (last && out != output.data())) {
+                output.resize(int(out - output.data()));
+                if (!push({output, file.pos() - (inEnd - in)})) {
+                    return true;
+                }
+                output = QByteArray(_blockSize, Qt::Uninitialized);
+                out = output.data();
+            }
+            if (last) {
+                if (!decoder->atBoundary()) {
+                    qCDebug(GCODE_DECOMPRESSOR) << file.fileName() << "is truncated";
+                    return false;
+                }
+                return true;
+            }
+        }
+    }
+};
+
+/**
+ * @brief Decodes the file of a GCodeDecompressor
+ */
+class DecompressorThread : public QThread
+{
+public:
+    explicit DecompressorThread(GCodeDecompressorPrivate *decompressor) : d(decompressor)
+    {
+    }
+
+protected:
+    void run() override
+    {
+        const bool ok = d->decodeFile();
+        QMutexLocker lock(&d->mutex);
+        d->error = !ok;
+        d->ended = true;
+        d->ready.wakeAll();
+    }
+
+private:
+    GCodeDecompressorPrivate *d;
+};
+
+GCodeDecompressor::GCodeDecompressor(const QString &fileName) :
+    d(new GCodeDecompressorPrivate)
+{
+    d->file.setFileName(fileName);
+}
+
+GCodeDecompressor::~GCodeDecompressor()
+{
+    if (d->worker) {
+        {
+            QMutexLocker lock(&d->mutex);
+            d->stopping = true;
+            d->taken.wakeAll();
+        }
+        d->worker->wait();
+        delete d->worker;
+    }
+    delete d;
+}
+
+GCodeDecompressor::FORMAT GCodeDecompressor::format(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return NONE;
+    }
+    const QByteArray magic = file.read(4);
+    if (magic.startsWith("\x1f\x8b")) {
+        return GZIP;
+    }
+    if (magic.startsWith("BZh")) {
+        return BZIP2;
+    }
+    if (magic == QByteArray("\x28\xb5\x2f\xfd", 4)) {
+        return ZSTD;
+    }
+    return NONE;
+}
+
+bool GCodeDecompressor::isSupported(GCodeDecompressor::FORMAT format)
+{
+    switch (format) {
+#if defined(HAVE_ZLIB)
+    case GZIP:
+        return true;
+#endif
+#if defined(HAVE_BZIP2)
+    case BZIP2:
+        return true;
+#endif
+#if defined(HAVE_ZSTD)
+    case ZSTD:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+bool GCodeDecompressor::open()
+{
+    if (d->worker) {
+        return true;
+    }
+    d->format = format(d->file.fileName());
+    if (!isSupported(d->format)) {
+        qCDebug(GCODE_DECOMPRESSOR) << "Can't decompress" << d->file.fileName() << ", format" << d->format << "is not supported";
+        return false;
+    }
+    if (!d->file.open(QIODevice::ReadOnly)) {
+        qCDebug(GCODE_DECOMPRESSOR) << "Can't open" << d->file.fileName() << d->file.errorString();
+        return false;
+    }
+    d->compressedSize = d->file.size();
+    d->worker = new DecompressorThread(d);
+    d->worker->start();
+    return true;
+}
+
+qint64 GCodeDecompressor::compressedSize() const
+{
+    return d->compressedSize;
+}
+
+bool GCodeDecompressor::read(QByteArray &block, qint64 &compressedOffset)
+{
+    if (!d->worker) {
+        return false;
+    }
+    QMutexLocker lock(&d->mutex);
+    while (d->blocks.isEmpty() && !d->ended) {
+        d->ready.wait(&d->mutex);
+    }
+    if (d->blocks.isEmpty()) {
+        return false;
+    }
+    const Block next = d->blocks.dequeue();
+    d->taken.wakeOne();
+    block = next.data;
+    compressedOffset = next.compressedOffset;
+    return true;
+}
+
+bool GCodeDecompressor::hasError() const
+{
+    QMutexLocker lock(&d->mutex);
+    return d->error;
+}
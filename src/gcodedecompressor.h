@@ -0,0 +1,106 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+#include "atcore_export.h"
+
+class GCodeDecompressorPrivate;
+/**
+ * @brief The GCodeDecompressor class
+ * Decompresses a gzip, bzip2 or zstd G-code file on a thread of its own.
+ *
+ * The worker decodes the file into blocks and keeps a few of them ready, so a
+ * print streaming from read() never waits on decompression. Each block carries
+ * the compressed bytes consumed so far, for progress of a job of unknown size.
+ * Formats are told apart by their magic bytes, not the file name. Each format
+ * needs its library at build time, see isSupported().
+ */
+class ATCORE_EXPORT GCodeDecompressor
+{
+public:
+    /**
+     * @brief Compression of a file
+     */
+    enum FORMAT {
+        NONE = 0,   /*!< Not compressed */
+        GZIP,       /*!< gzip or zlib, with zlib */
+        BZIP2,      /*!< bzip2, with libbz2 */
+        ZSTD,       /*!< Zstandard, with libzstd */
+    };
+
+    /**
+     * @brief Compression of \p fileName from its first bytes
+     * @param fileName: file to check
+     * @return NONE for plain files and files that can't be read
+     */
+    static FORMAT format(const QString &fileName);
+
+    /**
+     * @brief True if AtCore was built with the library for \p format
+     */
+    static bool isSupported(FORMAT format);
+
+    /**
+     * @brief Create a new GCodeDecompressor, call open() before reading
+     * @param fileName: compressed file
+     */
+    explicit GCodeDecompressor(const QString &fileName);
+
+    /**
+     * @brief Stop the worker
+     */
+    ~GCodeDecompressor();
+
+    /**
+     * @brief Start decompressing
+     * @return False if the file can't be read or its format is not supported
+     */
+    bool open();
+
+    /**
+     * @brief Size of the compressed file in bytes
+     */
+    qint64 compressedSize() const;
+
+    /**
+     * @brief Take the next decompressed block, waits for the worker if none is ready
+     * @param block: set to the next block
+     * @param compressedOffset: set to the compressed bytes consumed for it and all blocks before
+     * @return False at the end of the file or if it is corrupt
+     */
+    bool read(QByteArray &block, qint64 &compressedOffset);
+
+    /**
+     * @brief True if decompression stopped on corrupt or truncated data
+     */
+    bool hasError() const;
+
+private:
+    GCodeDecompressor(const GCodeDecompressor &) = delete;
+    GCodeDecompressor &operator=(const GCodeDecompressor &) = delete;
+    GCodeDecompressorPrivate *d;
+};
@@ -0,0 +1,683 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QDataStream>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "gcodeindex.h"
+#include "gcodechunkparser.h"
+#include "gcodereader.h"
+#include "gcodedecompressor.h"
+#include "gcodeline.h"
+
+Q_LOGGING_CATEGORY(GCODE_INDEX, "org.kde.atelier.core.gcodeIndex")
+
+namespace
+{
+const quint32 _magic = 0x41544958; // "ATIX"
+const quint16 _version = 1;
+// Chunks scanned in parallel are at least this big
+const qint64 _minChunkSize = 1 << 20;
+// Bytes of a layer in the sidecar: offset, line, z and extruded, floats are written as doubles
+const qint64 _layerRecordSize = 32;
+
+/**
+ * @brief What the index needs to know about the machine
+ */
+struct MachineState {
+    bool relative = false;      //!< @param relative: G91
+    bool relativeE = false;     //!< @param relativeE: M83
+    double z = 0;               //!< @param z: Z position
+    double e = 0;               //!< @param e: E position
+    double extruded = 0;        //!< @param extruded: filament extruded so far
+    double layerZ = -std::numeric_limits<double>::max(); //!< @param layerZ: height of the current layer
+};
+
+/**
+ * @brief Extrusion at a point of a chunk scanned without knowing its start
+ * The real value is the extrusion at the start of the chunk plus extruded,
+ * minus the E position at the start if minusEntryE is set.
+ */
+struct Extrusion {
+    double extruded = 0;
+    bool minusEntryE = false;
+};
+
+/**
+ * @brief An extruding move that may start a layer
+ */
+struct LayerCandidate {
+    qint64 offset;
+    qint64 line;
+    double z;
+    bool entryZ;                //!< @param entryZ: the move is at the Z the chunk started at
+    Extrusion before;
+    bool extrusionUnknown;      //!< @param extrusionUnknown: extrudes if eThreshold is above the E position the chunk started at
+    double eThreshold;
+};
+
+/**
+ * @brief Offset and extrusion of a line
+ */
+struct LinePoint {
+    qint64 offset;
+    qint64 line;
+    Extrusion before;
+};
+
+/**
+ * @brief A part of the file, scanned on its own
+ */
+struct Chunk {
+    qint64 begin = 0;           //!< @param begin: offset of the first line
+    qint64 end = 0;             //!< @param end: offset after the last line
+    qint64 firstLine = 0;       //!< @param firstLine: number of the first line
+    qint64 lines = 0;           //!< @param lines: lines in the chunk
+
+    bool rerun = false;         //!< @param rerun: the scan depends on something it couldn't track
+    bool usesRelative = false;  //!< @param usesRelative: a move relied on G90/G91 before the chunk set it
+    bool usesRelativeE = false; //!< @param usesRelativeE: a move relied on M82/M83 before the chunk set it
+    bool relativeKnown = false; //!< @param relativeKnown: relative holds the mode at the end of the chunk
+    bool relative = false;
+    bool relativeEKnown = false;//!< @param relativeEKnown: relativeE holds the mode at the end of the chunk
+    bool relativeE = false;
+    bool zKnown = false;        //!< @param zKnown: z is the Z at the end, otherwise Z didn't change
+    double z = 0;
+    bool eKnown = false;        //!< @param eKnown: e is the E at the end, otherwise it is added to the E at the start
+    double e = 0;
+    Extrusion extruded;         //!< @param extruded: extrusion at the end of the chunk
+
+    QVector<LinePoint> strideLines;
+    QVector<LinePoint> layerComments;
+    QVector<LayerCandidate> candidates;
+};
+
+/**
+ * @brief Value of the \p letter word of a command without comment
+ * @return False if there is no such word
+ */
+bool wordValue(const char *p, const char *end, char letter, double &value)
+{
+    // skip the command word
+    while (p < end && *p != ' ' && *p != '\t') {
+        p++;
+    }
+    while (p < end) {
+        if ((*p & ~0x20) == letter && (*(p - 1) == ' ' || *(p - 1) == '\t')) {
+            p++;
+            if (!GCodeLine::parseNumber(p, end, value)) {
+                value = 0;
+            }
+            return true;
+        }
+        p++;
+    }
+    return false;
+}
+
+/**
+ * @brief True if the command has any word after the command word
+ */
+bool hasArguments(const char *p, const char *end)
+{
+    while (p < end && *p != ' ' && *p != '\t') {
+        p++;
+    }
+    for (; p < end; p++) {
+        if (*p != ' ' && *p != '\t' && *p != '\r') {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Count the lines of \p chunk
+ */
+void countLines(const char *data, Chunk &chunk)
+{
+    const char *p = data + chunk.begin;
+    const char *end = data + chunk.end;
+    qint64 lines = 0;
+    while (p < end) {
+        const char *newLine = static_cast<const char *>(std::memchr(p, '\n', size_t(end - p)));
+        lines++;
+        if (!newLine) {
+            break;
+        }
+        p = newLine + 1;
+    }
+    chunk.lines = lines;
+}
+
+/**
+ * @brief Scan \p chunk for line offsets, layer changes and extrusion
+ * @param entry: machine state at the start of the chunk, nullptr if it isn't known yet
+ */
+void scanChunk(const char *data, Chunk &chunk, int stride, const MachineState *entry)
+{
+    chunk.rerun = false;
+    chunk.usesRelative = false;
+    chunk.usesRelativeE = false;
+    chunk.strideLines.clear();
+    chunk.layerComments.clear();
+    chunk.candidates.clear();
+
+    // without an entry state absolute modes are assumed, the fixup checks that
+    bool relativeKnown = entry;
+    bool relative = entry ? entry->relative : false;
+    bool relativeEKnown = entry;
+    bool relativeE = entry ? entry->relativeE : false;
+    bool zEntry = !entry;
+    double z = entry ? entry->z : 0;
+    bool eEntry = !entry;
+    double e = entry ? entry->e : 0;
+    Extrusion extruded;
+    double layerZ = entry ? entry->layerZ : -std::numeric_limits<double>::max();
+    bool entryZCandidate = false;
+
+    const char *p = data + chunk.begin;
+    const char *chunkEnd = data + chunk.end;
+    qint64 line = chunk.firstLine;
+    while (p < chunkEnd) {
+        const char *newLine = static_cast<const char *>(std::memchr(p, '\n', size_t(chunkEnd - p)));
+        const char *end = newLine ? newLine : chunkEnd;
+        const qint64 offset = p - data;
+        if (line % stride == 0) {
+            chunk.strideLines.append({offset, line, extruded});
+        }
+
+        while (p < end && (*p == ' ' || *p == '\t')) {
+            p++;
+        }
+        if (p < end && *p == ';') {
+            if (end - p > 7 && std::memcmp(p + 1, "LAYER:", 6) == 0) {
+                chunk.layerComments.append({offset, line, extruded});
+            }
+        } else if (p + 1 < end) {
+            const char *comment = static_cast<const char *>(std::memchr(p, ';', size_t(end - p)));
+            if (comment) {
+                end = comment;
+            }
+            const char letter = char(*p & ~0x20);
+            const char *q = p + 1;
+            double number = 0;
+            if ((letter == 'G' || letter == 'M') && GCodeLine::parseNumber(q, end, number)) {
+                const int code = int(number);
+                double value = 0;
+                if (letter == 'M' && (code == 82 || code == 83)) {
+                    relativeE = code == 83;
+                    relativeEKnown = true;
+                } else if (letter == 'G' && (code == 90 || code == 91)) {
+                    relative = code == 91;
+                    relativeKnown = true;
+                } else if (letter == 'G' && code == 92) {
+                    if (wordValue(p, end, 'Z', value)) {
+                        z = value;
+                        zEntry = false;
+                    }
+                    if (wordValue(p, end, 'E', value)) {
+                        e = value;
+                        eEntry = false;
+                    }
+                } else if (letter == 'G' && code == 28) {
+                    if (!hasArguments(p, end) || wordValue(p, end, 'Z', value)) {
+                        z = 0;
+                        zEntry = false;
+                    }
+                } else if (letter == 'G' && code >= 0 && code <= 3) {
+                    if (wordValue(p, end, 'Z', value)) {
+                        chunk.usesRelative |= !relativeKnown;
+                        if (!relative) {
+                            z = value;
+                            zEntry = false;
+                        } else if (zEntry) {
+                            // relative to a Z we don't know
+                            chunk.rerun = true;
+                        } else {
+                            z += value;
+                        }
+                    }
+                    if (wordValue(p, end, 'E', value)) {
+                        chunk.usesRelative |= !relativeKnown;
+                        chunk.usesRelativeE |= !relativeEKnown;
+                        double delta = value;
+                        bool unknown = false;
+                        double threshold = 0;
+                        if (relative || relativeE) {
+                            e += value;
+                        } else if (eEntry) {
+                            // extrudes if value is above the E the chunk started at
+                            unknown = true;
+                            threshold = value - e;
+                            delta = value - e;
+                            e = value;
+                            eEntry = false;
+                        } else {
+                            delta = value - e;
+                            e = value;
+                        }
+
+                        if (unknown || delta > 0) {
+                            if (zEntry) {
+                                if (!entryZCandidate || unknown) {
+                                    chunk.candidates.append({offset, line, 0, true, extruded, unknown, threshold});
+                                    entryZCandidate = !unknown;
+                                }
+                            } else if (z > layerZ) {
+                                chunk.candidates.append({offset, line, z, false, extruded, unknown, threshold});
+                                if (!unknown) {
+                                    layerZ = z;
+                                }
+                            }
+                        }
+                        extruded.extruded += delta;
+                        extruded.minusEntryE |= unknown;
+                    }
+                }
+            }
+        }
+
+        line++;
+        p = newLine ? newLine + 1 : chunkEnd;
+    }
+
+    chunk.relativeKnown = relativeKnown;
+    chunk.relative = relative;
+    chunk.relativeEKnown = relativeEKnown;
+    chunk.relativeE = relativeE;
+    chunk.zKnown = !zEntry;
+    chunk.z = z;
+    chunk.eKnown = !eEntry;
+    chunk.e = e;
+    chunk.extruded = extruded;
+}
+
+/**
+ * @brief Runs one pass over one chunk on a thread pool
+ */
+class ChunkTask : public QRunnable
+{
+public:
+    ChunkTask(const char *data, Chunk &chunk, int stride, bool count) :
+        _data(data), _chunk(chunk), _stride(stride), _count(count)
+    {
+    }
+
+    void run() override
+    {
+        if (_count) {
+            countLines(_data, _chunk);
+        } else {
+            scanChunk(_data, _chunk, _stride, nullptr);
+        }
+    }
+
+private:
+    const char *_data;
+    Chunk &_chunk;
+    int _stride;
+    bool _count;
+};
+
+/**
+ * @brief Real extrusion of a point of a chunk starting at \p state
+ */
+double resolve(const MachineState &state, const Extrusion &extrusion)
+{
+    return state.extruded + extrusion.extruded - (extrusion.minusEntryE ? state.e : 0);
+}
+
+/**
+ * @brief Read a QVector written with operator<<, without trusting its count
+ * @param itemSize: bytes of an item in the stream
+ * @return False if the count is larger than what is left of the stream
+ */
+template <typename T>
+bool readVector(QDataStream &in, QVector<T> &vector, qint64 itemSize)
+{
+    quint32 count = 0;
+    in >> count;
+    if (in.status() != QDataStream::Ok || count > quint64(in.device()->bytesAvailable() / itemSize)) {
+        return false;
+    }
+    vector.resize(int(count));
+    for (T &item : vector) {
+        in >> item;
+    }
+    return true;
+}
+}
+
+/**
+ * @brief The GCodeIndexPrivate class
+ */
+class GCodeIndexPrivate
+{
+public:
+    QString fileName;                       //!< @param fileName: indexed file
+    bool valid = false;                     //!< @param valid: the index matches fileName
+    qint64 fileSize = 0;                    //!< @param fileSize: size of the file when indexed
+    qint64 modified = 0;                    //!< @param modified: modification time of the file when indexed, ms since epoch
+    int stride = 1024;                      //!< @param stride: lines between two strideOffsets
+    qint64 lineCount = 0;                   //!< @param lineCount: lines in the file
+    double totalExtruded = 0;               //!< @param totalExtruded: filament extruded by the file
+    QVector<qint64> strideOffsets;          //!< @param strideOffsets: offset of every stride line
+    QVector<double> strideExtruded;         //!< @param strideExtruded: extrusion before every stride line
+    QVector<GCodeIndex::Layer> layers;      //!< @param layers: layer changes
+};
+
+GCodeIndex::GCodeIndex() :
+    d(new GCodeIndexPrivate)
+{
+}
+
+GCodeIndex::~GCodeIndex()
+{
+    delete d;
+}
+
+QString GCodeIndex::sidecarFileName(const QString &fileName)
+{
+    return fileName + QStringLiteral(".atindex");
+}
+
+bool GCodeIndex::open(const QString &fileName, int stride)
+{
+    if (load(fileName) && d->stride == stride) {
+        return true;
+    }
+    if (!build(fileName, stride)) {
+        return false;
+    }
+    if (!save()) {
+        qCDebug(GCODE_INDEX) << "Can't cache the index of" << fileName;
+    }
+    return true;
+}
+
+bool GCodeIndex::build(const QString &fileName, int stride)
+{
+    d->valid = false;
+    d->fileName = fileName;
+    d->stride = qMax(stride, 1);
+    d->strideOffsets.clear();
+    d->strideExtruded.clear();
+    d->layers.clear();
+
+    if (GCodeDecompressor::format(fileName) != GCodeDecompressor::NONE) {
+        // offsets in a compressed file can't be seeked to
+        qCDebug(GCODE_INDEX) << "Can't index compressed" << fileName;
+        return false;
+    }
+    GCodeReader reader(fileName);
+    if (!reader.open()) {
+        return false;
+    }
+    d->fileSize = reader.size();
+    d->modified = QFileInfo(fileName).lastModified().toMSecsSinceEpoch();
+    const char *data = reader.data();
+
+    // split at line ends, every chunk is kept for the fixup so there are at most a few per thread
+    const qint64 size = reader.size();
+    const int threads = qMax(1, QThread::idealThreadCount());
+    const qint64 maxChunks = qint64(threads) * 4;
+    const auto parts = GCodeChunkParser::split(data, size, qMax(_minChunkSize, (size + maxChunks - 1) / maxChunks));
+    QVector<Chunk> chunks(parts.size());
+    for (int i = 0; i < parts.size(); i++) {
+        chunks[i].begin = parts.at(i).first;
+        chunks[i].end = parts.at(i).second;
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+    // pass 1: where each chunk's lines start
+    for (auto &chunk : chunks) {
+        pool.start(new ChunkTask(data, chunk, d->stride, true));
+    }
+    pool.waitForDone();
+    qint64 line = 0;
+    for (auto &chunk : chunks) {
+        chunk.firstLine = line;
+        line += chunk.lines;
+    }
+    d->lineCount = line;
+
+    // pass 2: scan with a symbolic start
+    for (auto &chunk : chunks) {
+        pool.start(new ChunkTask(data, chunk, d->stride, false));
+    }
+    pool.waitForDone();
+
+    bool layerComments = false;
+    for (const auto &chunk : chunks) {
+        layerComments |= !chunk.layerComments.isEmpty();
+    }
+
+    // fixup, in file order
+    MachineState state;
+    int rescans = 0;
+    for (auto &chunk : chunks) {
+        if (chunk.rerun || (chunk.usesRelative && state.relative) || (chunk.usesRelativeE && state.relativeE)) {
+            scanChunk(data, chunk, d->stride, &state);
+            rescans++;
+        }
+
+        for (const auto &point : chunk.strideLines) {
+            d->strideOffsets.append(point.offset);
+            d->strideExtruded.append(resolve(state, point.before));
+        }
+
+        if (layerComments) {
+            for (const auto &point : chunk.layerComments) {
+                GCodeIndex::Layer layer;
+                layer.offset = point.offset;
+                layer.line = point.line;
+                layer.extruded = resolve(state, point.before);
+                d->layers.append(layer);
+            }
+        } else {
+            for (const auto &candidate : chunk.candidates) {
+                const double z = candidate.entryZ ? state.z : candidate.z;
+                const bool extrudes = !candidate.extrusionUnknown || candidate.eThreshold > state.e;
+                if (extrudes && z > state.layerZ) {
+                    GCodeIndex::Layer layer;
+                    layer.offset = candidate.offset;
+                    layer.line = candidate.line;
+                    layer.z = float(z);
+                    layer.extruded = resolve(state, candidate.before);
+                    d->layers.append(layer);
+                    state.layerZ = z;
+                }
+            }
+        }
+
+        state.relative = chunk.relativeKnown ? chunk.relative : state.relative;
+        state.relativeE = chunk.relativeEKnown ? chunk.relativeE : state.relativeE;
+        state.z = chunk.zKnown ? chunk.z : state.z;
+        state.extruded = resolve(state, chunk.extruded);
+        state.e = chunk.eKnown ? chunk.e : state.e + chunk.e;
+    }
+    d->totalExtruded = state.extruded;
+    d->valid = true;
+    qCDebug(GCODE_INDEX) << "Indexed" << fileName << d->lineCount << "lines," << d->layers.size() << "layers,"
+                         << chunks.size() << "chunks," << rescans << "scanned again";
+    return true;
+}
+
+bool GCodeIndex::load(const QString &fileName)
+{
+    d->valid = false;
+    QFile file(sidecarFileName(fileName));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_4);
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    in >> magic >> version;
+    if (magic != _magic || version != _version) {
+        return false;
+    }
+
+    const QFileInfo info(fileName);
+    qint64 fileSize = 0;
+    qint64 modified = 0;
+    in >> fileSize >> modified;
+    if (fileSize != info.size() || modified != info.lastModified().toMSecsSinceEpoch()) {
+        qCDebug(GCODE_INDEX) << "Index of" << fileName << "is outdated";
+        return false;
+    }
+
+    // counts larger than what is left of the sidecar are not allocated
+    qint32 stride = 0;
+    qint32 layerCount = 0;
+    in >> stride >> d->lineCount >> d->totalExtruded;
+    if (!readVector(in, d->strideOffsets, sizeof(qint64)) || !readVector(in, d->strideExtruded, sizeof(double))) {
+        qCDebug(GCODE_INDEX) << "Index of" << fileName << "is damaged";
+        return false;
+    }
+    in >> layerCount;
+    if (in.status() != QDataStream::Ok || layerCount < 0 || layerCount > d->lineCount
+            || layerCount > file.bytesAvailable() / _layerRecordSize) {
+        qCDebug(GCODE_INDEX) << "Index of" << fileName << "is damaged";
+        return false;
+    }
+    d->layers.resize(layerCount);
+    for (auto &layer : d->layers) {
+        in >> layer.offset >> layer.line >> layer.z >> layer.extruded;
+    }
+    if (in.status() != QDataStream::Ok || stride <= 0 || d->strideOffsets.size() != d->strideExtruded.size()) {
+        return false;
+    }
+
+    d->fileName = fileName;
+    d->fileSize = fileSize;
+    d->modified = modified;
+    d->stride = stride;
+    d->valid = true;
+    return true;
+}
+
+bool GCodeIndex::save() const
+{
+    if (!d->valid) {
+        return false;
+    }
+    QSaveFile file(sidecarFileName(d->fileName));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_4);
+    out << _magic << _version << d->fileSize << d->modified;
+    out << qint32(d->stride) << d->lineCount << d->totalExtruded << d->strideOffsets << d->strideExtruded;
+    out << qint32(d->layers.size());
+    for (const auto &layer : d->layers) {
+        out << layer.offset << layer.line << layer.z << layer.extruded;
+    }
+    return file.commit();
+}
+
+bool GCodeIndex::isValid() const
+{
+    return d->valid;
+}
+
+qint64 GCodeIndex::fileSize() const
+{
+    return d->fileSize;
+}
+
+qint64 GCodeIndex::lineCount() const
+{
+    return d->lineCount;
+}
+
+int GCodeIndex::stride() const
+{
+    return d->stride;
+}
+
+double GCodeIndex::totalExtruded() const
+{
+    return d->totalExtruded;
+}
+
+const QVector<GCodeIndex::Layer> &GCodeIndex::layers() const
+{
+    return d->layers;
+}
+
+int GCodeIndex::layerAt(qint64 offset) const
+{
+    auto layer = std::upper_bound(d->layers.constBegin(), d->layers.constEnd(), offset,
+    [](qint64 value, const GCodeIndex::Layer & layer) {
+        return value < layer.offset;
+    });
+    return int(layer - d->layers.constBegin()) - 1;
+}
+
+double GCodeIndex::extrudedBefore(qint64 line) const
+{
+    if (d->strideExtruded.isEmpty()) {
+        return 0;
+    }
+    const qint64 index = qBound(qint64(0), line / d->stride, qint64(d->strideExtruded.size() - 1));
+    return d->strideExtruded.at(int(index));
+}
+
+bool GCodeIndex::seekToLine(GCodeReader &reader, qint64 line) const
+{
+    if (!d->valid || line < 0 || line >= d->lineCount) {
+        return false;
+    }
+    if (!reader.seek(d->strideOffsets.at(int(line / d->stride)))) {
+        return false;
+    }
+    const char *data = nullptr;
+    int size = 0;
+    for (qint64 i = line % d->stride; i > 0; i--) {
+        reader.readLine(data, size);
+    }
+    return true;
+}
+
+bool GCodeIndex::seekToLayer(GCodeReader &reader, int layer) const
+{
+    if (!d->valid || layer < 0 || layer >= d->layers.size()) {
+        return false;
+    }
+    return reader.seek(d->layers.at(layer).offset);
+}
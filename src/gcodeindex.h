@@ -0,0 +1,164 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QString>
+#include <QVector>
+
+#include "atcore_export.h"
+
+class GCodeReader;
+class GCodeIndexPrivate;
+/**
+ * @brief The GCodeIndex class
+ * Compact index of a G-code file: line offsets, layers and extrusion.
+ *
+ * The byte offset of every stride() line and of every layer change is kept
+ * together with the filament extruded up to that point. Layers come from
+ * slicer ";LAYER:" comments when the file has them, otherwise from the first
+ * extruding move above the previous layer.
+ *
+ * build() scans the file in parallel chunks. The state a chunk starts with
+ * (Z, E and the G90/G91, M82/M83 modes) is only known once the chunks before
+ * it are done, so chunks are scanned with a symbolic start and fixed up in
+ * order afterwards. The rare chunks whose meaning depends on an unknown start
+ * mode are scanned again once it is known.
+ *
+ * The index is cached in a sidecar file next to the job, see open().
+ */
+class ATCORE_EXPORT GCodeIndex
+{
+public:
+    /**
+     * @brief A layer change
+     */
+    struct Layer {
+        qint64 offset = 0;      //!< @param offset: byte offset of the line starting the layer
+        qint64 line = 0;        //!< @param line: number of that line, from 0
+        float z = 0;            //!< @param z: height of the layer, 0 for ";LAYER:" comments
+        double extruded = 0;    //!< @param extruded: filament extruded before the layer in mm
+    };
+
+    GCodeIndex();
+    ~GCodeIndex();
+
+    /**
+     * @brief Load the cached index of \p fileName or build and cache it
+     * @param fileName: G-code file
+     * @param stride: keep the offset of every \p stride line when building
+     * @return False if the file can't be read
+     */
+    bool open(const QString &fileName, int stride = 1024);
+
+    /**
+     * @brief Scan \p fileName
+     * @param fileName: G-code file
+     * @param stride: keep the offset of every \p stride line
+     * @return False if the file can't be read
+     */
+    bool build(const QString &fileName, int stride = 1024);
+
+    /**
+     * @brief Load the sidecar index of \p fileName
+     * @param fileName: G-code file
+     * @return False if there is no sidecar or it doesn't match the file's size and time
+     */
+    bool load(const QString &fileName);
+
+    /**
+     * @brief Write the index to the sidecar of the indexed file
+     * @return False if the sidecar can't be written
+     */
+    bool save() const;
+
+    /**
+     * @brief Sidecar file used for \p fileName
+     */
+    static QString sidecarFileName(const QString &fileName);
+
+    /**
+     * @brief True once build() or load() succeeded
+     */
+    bool isValid() const;
+
+    /**
+     * @brief Size of the indexed file in bytes
+     */
+    qint64 fileSize() const;
+
+    /**
+     * @brief Number of lines in the indexed file
+     */
+    qint64 lineCount() const;
+
+    /**
+     * @brief Distance in lines between two kept line offsets
+     */
+    int stride() const;
+
+    /**
+     * @brief Filament extruded by the whole file in mm
+     */
+    double totalExtruded() const;
+
+    /**
+     * @brief The layer changes, in file order
+     */
+    const QVector<Layer> &layers() const;
+
+    /**
+     * @brief Layer holding the line at byte \p offset
+     * @return index in layers(), -1 before the first layer
+     */
+    int layerAt(qint64 offset) const;
+
+    /**
+     * @brief Filament extruded before the kept line at or before \p line
+     * @param line: line number, from 0
+     */
+    double extrudedBefore(qint64 line) const;
+
+    /**
+     * @brief Move \p reader to the start of \p line
+     *
+     * Jumps to the closest kept offset and reads at most stride() lines.
+     * @param reader: reader of the indexed file
+     * @param line: line number, from 0
+     * @return False if \p line is not in the file
+     */
+    bool seekToLine(GCodeReader &reader, qint64 line) const;
+
+    /**
+     * @brief Move \p reader to the start of \p layer
+     * @param reader: reader of the indexed file
+     * @param layer: index in layers()
+     * @return False if there is no such layer
+     */
+    bool seekToLayer(GCodeReader &reader, int layer) const;
+
+private:
+    GCodeIndex(const GCodeIndex &) = delete;
+    GCodeIndex &operator=(const GCodeIndex &) = delete;
+    GCodeIndexPrivate *d;
+};
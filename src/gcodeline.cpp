@@ -0,0 +1,291 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <cmath>
+
+#include "gcodeline.h"
+
+namespace
+{
+// digits kept exactly in a 64 bit mantissa
+const int _maxDigits = 19;
+
+// powers of ten exact as doubles
+const double _powers[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+const int _maxPower = 22;
+
+bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/**
+ * @brief Upper case letter of \p c, 0 if it is not a letter
+ */
+char letterOf(char c)
+{
+    const char letter = char(c & ~0x20);
+    return letter >= 'A' && letter <= 'Z' ? letter : 0;
+}
+
+/**
+ * @brief True for the commands whose argument is text rather than words
+ */
+bool takesText(char letter, int code)
+{
+    if (letter != 'M') {
+        return false;
+    }
+    switch (code) {
+    case 23:    // select, start, delete and write sd card files
+    case 28:
+    case 30:
+    case 32:
+    case 117:   // messages
+    case 118:
+    case 928:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Read the digits at \p p as an integer, moving \p p after them
+ * @return -1 if there is no digit at \p p
+ */
+qint64 parseInteger(const char *&p, const char *end)
+{
+    if (p == end || !isDigit(*p)) {
+        return -1;
+    }
+    qint64 number = 0;
+    for (; p < end && isDigit(*p); p++) {
+        number = number * 10 + (*p - '0');
+    }
+    return number;
+}
+}
+
+GCodeLine::GCodeLine()
+{
+    clear();
+}
+
+void GCodeLine::clear()
+{
+    _command.letter = 0;
+    _command.hasValue = false;
+    _command.decimals = 0;
+    _command.begin = 0;
+    _command.end = 0;
+    _command.value = 0;
+    _code = 0;
+    _subcode = -1;
+    _lineNumber = -1;
+    _checksum = -1;
+    _textBegin = -1;
+    _textEnd = -1;
+    _count = 0;
+    _valid = false;
+    _repeated = false;
+    for (signed char &index : _index) {
+        index = -1;
+    }
+}
+
+bool GCodeLine::parseNumber(const char *&p, const char *end, double &value, int *decimals)
+{
+    const char *q = p;
+    bool negative = false;
+    if (q < end && (*q == '-' || *q == '+')) {
+        negative = *q == '-';
+        q++;
+    }
+    // all digits go to one integer, scaled once at the end
+    quint64 mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    int fraction = 0;
+    bool any = false;
+    for (; q < end && isDigit(*q); q++) {
+        any = true;
+        if (digits < _maxDigits) {
+            mantissa = mantissa * 10 + quint64(*q - '0');
+            digits += mantissa != 0;
+        } else {
+            exponent++;
+        }
+    }
+    if (q < end && *q == '.') {
+        for (q++; q < end && isDigit(*q); q++) {
+            any = true;
+            fraction++;
+            if (digits < _maxDigits) {
+                mantissa = mantissa * 10 + quint64(*q - '0');
+                digits += mantissa != 0;
+                exponent--;
+            }
+        }
+    }
+    if (!any) {
+        return false;
+    }
+    // both operands are exact up to 2^53, the division rounds once
+    double number = double(mantissa);
+    if (exponent < 0) {
+        number /= -exponent <= _maxPower ? _powers[-exponent] : std::pow(10.0, -exponent);
+    } else if (exponent > 0) {
+        number *= exponent <= _maxPower ? _powers[exponent] : std::pow(10.0, exponent);
+    }
+    value = negative ? -number : number;
+    if (decimals) {
+        *decimals = fraction;
+    }
+    p = q;
+    return true;
+}
+
+bool GCodeLine::parse(const QByteArray &line)
+{
+    return parse(line.constData(), line.constData() + line.size());
+}
+
+bool GCodeLine::parse(const char *begin, const char *end)
+{
+    clear();
+    const char *p = begin;
+    while (p < end && isBlank(*p)) {
+        p++;
+    }
+    if (p + 1 < end && letterOf(*p) == 'N' && isDigit(p[1])) {
+        p++;
+        _lineNumber = parseInteger(p, end);
+        while (p < end && isBlank(*p)) {
+            p++;
+        }
+    }
+
+    // the command word
+    const char letter = p < end ? letterOf(*p) : 0;
+    if (!letter) {
+        return false;
+    }
+    _command.letter = letter;
+    _command.begin = int(++p - begin);
+    int decimals = 0;
+    if (!parseNumber(p, end, _command.value, &decimals)) {
+        return false;
+    }
+    _command.hasValue = true;
+    _command.decimals = short(decimals);
+    _command.end = int(p - begin);
+    _code = int(_command.value);
+    if (decimals) {
+        const char *dot = begin + _command.end - decimals;
+        _subcode = int(parseInteger(dot, p));
+    }
+
+    if (takesText(letter, _code)) {
+        if (p < end && *p == ' ') {
+            p++;
+        }
+        // a checksum is the only thing after the text
+        const char *textEnd = end;
+        for (const char *q = end - 1; q >= p; q--) {
+            if (*q == '*') {
+                const char *digits = q + 1;
+                const qint64 checksum = parseInteger(digits, end);
+                if (checksum >= 0 && digits == end) {
+                    _checksum = int(checksum);
+                    textEnd = q;
+                }
+                break;
+            }
+            if (!isDigit(*q)) {
+                break;
+            }
+        }
+        _textBegin = int(p - begin);
+        _textEnd = int(textEnd - begin);
+        _valid = true;
+        return true;
+    }
+
+    while (p < end) {
+        if (isBlank(*p)) {
+            p++;
+            continue;
+        }
+        if (*p == ';') {
+            break;
+        }
+        if (*p == '(') {
+            while (p < end && *p != ')') {
+                p++;
+            }
+            p += p < end;
+            continue;
+        }
+        if (*p == '*') {
+            p++;
+            const qint64 checksum = parseInteger(p, end);
+            while (p < end && isBlank(*p)) {
+                p++;
+            }
+            if (checksum < 0 || (p < end && *p != ';')) {
+                return false;
+            }
+            _checksum = int(checksum);
+            break;
+        }
+        const char wordLetter = letterOf(*p);
+        if (!wordLetter || _count == MaxWords) {
+            return false;
+        }
+        Word &word = _words[_count];
+        word.letter = wordLetter;
+        word.begin = int(++p - begin);
+        word.hasValue = p < end && (isDigit(*p) || *p == '-' || *p == '+' || *p == '.');
+        word.value = 0;
+        decimals = 0;
+        if (word.hasValue && !parseNumber(p, end, word.value, &decimals)) {
+            return false;
+        }
+        word.decimals = short(decimals);
+        word.end = int(p - begin);
+        signed char &index = _index[wordLetter - 'A'];
+        _repeated = _repeated || index >= 0;
+        index = static_cast<signed char>(_count++);
+    }
+    _valid = true;
+    return true;
+}
@@ -0,0 +1,233 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QByteArray>
+
+#include "atcore_export.h"
+
+/**
+ * @brief The GCodeLine class
+ * A line of G-code parsed into its command and words, without allocating.
+ *
+ * A line is an optional N line number, a command word like "G1" or "M104",
+ * its words, each a letter with an optional number, and an optional "*"
+ * checksum. Comments after ';' and between '(' and ')' are skipped. Commands
+ * taking text, like M117, keep it as text() instead of words.
+ *
+ * Numbers are read with a single correctly rounded division for up to 19
+ * digits, what a job holds. The words are kept in a fixed array, a GCodeLine
+ * can be reused for every line of a job.
+ */
+class ATCORE_EXPORT GCodeLine
+{
+public:
+    /**
+     * @brief Most words after the command word, lines with more don't parse
+     */
+    enum { MaxWords = 16 };
+
+    /**
+     * @brief A word of the line
+     */
+    struct Word {
+        char letter;            //!< @param letter: upper case letter
+        bool hasValue;          //!< @param hasValue: a number follows the letter, value is 0 otherwise
+        short decimals;         //!< @param decimals: digits after the decimal point
+        int begin;              //!< @param begin: offset of its number in the line, with the sign
+        int end;                //!< @param end: offset after its number
+        double value;           //!< @param value: its number
+    };
+
+    GCodeLine();
+
+    /**
+     * @brief Parse a line
+     * @param begin: first character of the line
+     * @param end: character after the line, without the new line
+     * @return False if the line is empty, a comment or not well formed, see isValid()
+     */
+    bool parse(const char *begin, const char *end);
+
+    /**
+     * @brief Parse a line
+     * @param line: the line, without the new line
+     * @return False if the line is empty, a comment or not well formed, see isValid()
+     */
+    bool parse(const QByteArray &line);
+
+    /**
+     * @brief Read a number at \p p, moving \p p after it
+     * @param p: start of the number, a sign or a digit
+     * @param end: end of the text
+     * @param value: the number
+     * @param decimals: if not nullptr, set to the digits after the decimal point
+     * @return False if there is no digit at \p p
+     */
+    static bool parseNumber(const char *&p, const char *end, double &value, int *decimals = nullptr);
+
+    /**
+     * @brief True if the last parse() found a command and all words were well formed
+     */
+    bool isValid() const
+    {
+        return _valid;
+    }
+
+    /**
+     * @brief Letter of the command, 'G', 'M', 'T' and the like, 0 if there is none
+     */
+    char letter() const
+    {
+        return _command.letter;
+    }
+
+    /**
+     * @brief Number of the command, 1 for "G1"
+     */
+    int code() const
+    {
+        return _code;
+    }
+
+    /**
+     * @brief Subcode of the command, 1 for "G29.1", -1 if there is none
+     */
+    int subcode() const
+    {
+        return _subcode;
+    }
+
+    /**
+     * @brief The command word itself
+     */
+    const Word &command() const
+    {
+        return _command;
+    }
+
+    /**
+     * @brief Line number of an N word before the command, -1 if there is none
+     */
+    qint64 lineNumber() const
+    {
+        return _lineNumber;
+    }
+
+    /**
+     * @brief Checksum after '*', -1 if there is none
+     */
+    int checksum() const
+    {
+        return _checksum;
+    }
+
+    /**
+     * @brief Number of words after the command word
+     */
+    int wordCount() const
+    {
+        return _count;
+    }
+
+    /**
+     * @brief Word \p i after the command word, in line order
+     */
+    const Word &word(int i) const
+    {
+        return _words[i];
+    }
+
+    /**
+     * @brief Word with \p letter, the last one if it is given twice
+     * @param letter: upper case letter
+     * @return nullptr if there is no such word
+     */
+    const Word *find(char letter) const
+    {
+        const int i = letter - 'A';
+        return i >= 0 && i < 26 && _index[i] >= 0 ? &_words[int(_index[i])] : nullptr;
+    }
+
+    /**
+     * @brief True if there is a word with \p letter
+     */
+    bool has(char letter) const
+    {
+        return find(letter);
+    }
+
+    /**
+     * @brief Number of the word with \p letter
+     * @param fallback: returned if there is no such word
+     */
+    double value(char letter, double fallback = 0) const
+    {
+        const Word *w = find(letter);
+        return w ? w->value : fallback;
+    }
+
+    /**
+     * @brief True if a letter was given twice
+     */
+    bool hasRepeatedWords() const
+    {
+        return _repeated;
+    }
+
+    /**
+     * @brief Offset of the text argument of commands like M117, -1 for other commands
+     */
+    int textBegin() const
+    {
+        return _textBegin;
+    }
+
+    /**
+     * @brief Offset after the text argument
+     */
+    int textEnd() const
+    {
+        return _textEnd;
+    }
+
+private:
+    /**
+     * @brief Forget the line parsed before
+     */
+    void clear();
+
+    Word _command;              //!< @param _command: the command word
+    int _code;                  //!< @param _code: integer part of the command number
+    int _subcode;               //!< @param _subcode: decimal part of the command number, -1 if none
+    qint64 _lineNumber;         //!< @param _lineNumber: N word, -1 if none
+    int _checksum;              //!< @param _checksum: number after '*', -1 if none
+    int _textBegin;             //!< @param _textBegin: offset of the text argument, -1 if none
+    int _textEnd;               //!< @param _textEnd: offset after the text argument
+    int _count;                 //!< @param _count: words after the command word
+    bool _valid;                //!< @param _valid: the line parsed
+    bool _repeated;             //!< @param _repeated: a letter was given twice
+    signed char _index[26];     //!< @param _index: word of each letter, -1 if none
+    Word _words[MaxWords];      //!< @param _words: words after the command word
+};
@@ -0,0 +1,324 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+#include "gcodeline.h"
+#include "gcodeminifier.h"
+
+namespace
+{
+enum { X = 0, Y, Z, E, AXES };
+
+/**
+ * @brief Axis of a word letter, -1 if it is not an axis
+ */
+int axis(char letter)
+{
+    switch (letter) {
+    case 'X':
+        return X;
+    case 'Y':
+        return Y;
+    case 'Z':
+        return Z;
+    case 'E':
+        return E;
+    default:
+        return -1;
+    }
+}
+
+/**
+ * @brief Copy the number in \p data from \p begin to \p end to \p out in as few characters as possible
+ *
+ * \p out may overlap the number as long as it doesn't start after it.
+ * @param leadingZero: keep the zero of "0.5"
+ * @return characters written
+ */
+int writeNumber(char *out, const char *begin, const char *end, bool leadingZero)
+{
+    bool negative = false;
+    if (*begin == '-' || *begin == '+') {
+        negative = *begin == '-';
+        begin++;
+    }
+    while (end - begin > 1 && *begin == '0' && begin[1] != '.') {
+        begin++;
+    }
+    const char *dot = static_cast<const char *>(std::memchr(begin, '.', size_t(end - begin)));
+    if (dot) {
+        while (end > dot + 1 && end[-1] == '0') {
+            end--;
+        }
+        if (end == dot + 1) {
+            end = dot;
+        }
+    }
+    if (!leadingZero && end - begin > 2 && begin[0] == '0' && begin[1] == '.') {
+        begin++;
+    }
+    bool zero = true;
+    for (const char *p = begin; p < end && zero; p++) {
+        zero = *p == '0' || *p == '.';
+    }
+    int length = 0;
+    if (zero) {
+        out[length++] = '0';
+        return length;
+    }
+    if (negative) {
+        out[length++] = '-';
+    }
+    // front to back, out never passes begin
+    for (const char *p = begin; p < end; p++) {
+        out[length++] = *p;
+    }
+    return length;
+}
+
+/**
+ * @brief True if M \p code can't move the head or the extruder
+ */
+bool keepsPosition(int code)
+{
+    switch (code) {
+    case 73:    // progress
+    case 82:
+    case 83:
+    case 104:   // temperatures
+    case 105:
+    case 109:
+    case 140:
+    case 190:
+    case 106:   // fan
+    case 107:
+    case 117:   // message
+    case 201:   // limits
+    case 203:
+    case 204:
+    case 205:
+    case 220:   // speed and flow factors
+    case 221:
+    case 400:
+        return true;
+    default:
+        return false;
+    }
+}
+}
+
+/**
+ * @brief The GCodeMinifierPrivate class
+ */
+class GCodeMinifierPrivate
+{
+public:
+    bool compactWords = false;  //!< @param compactWords: drop the spaces between words
+    qint64 bytesIn = 0;         //!< @param bytesIn: bytes passed in
+    qint64 bytesOut = 0;        //!< @param bytesOut: bytes returned
+
+    double position[AXES] = {}; //!< @param position: position of each axis
+    bool known[AXES] = {};      //!< @param known: the position of the axis is known
+    double feedrate = 0;        //!< @param feedrate: last F
+    bool knownFeedrate = false; //!< @param knownFeedrate: feedrate is known
+    bool relative = false;      //!< @param relative: G91 is active
+    bool relativeE = false;     //!< @param relativeE: M83 is active
+
+    /**
+     * @brief Forget the position of all axes
+     */
+    void lose(bool extruder)
+    {
+        known[X] = known[Y] = known[Z] = false;
+        known[E] = known[E] && !extruder;
+    }
+
+    /**
+     * @brief Apply a command that is not rewritten to the modal state
+     */
+    void track(const GCodeLine &line)
+    {
+        if (line.letter() == 'G') {
+            switch (line.code()) {
+            case 4:
+                break;
+            case 90:
+                relative = false;
+                break;
+            case 91:
+                relative = true;
+                break;
+            case 92:
+                for (int i = 0; i < line.wordCount(); i++) {
+                    const int a = axis(line.word(i).letter);
+                    if (a != -1) {
+                        position[a] = line.word(i).value;
+                        known[a] = true;
+                    }
+                }
+                if (!line.wordCount()) {
+                    lose(true);
+                }
+                break;
+            default:
+                // homing, probing, units and the like
+                lose(false);
+                knownFeedrate = false;
+                break;
+            }
+        } else if (line.letter() == 'M') {
+            if (line.code() == 82) {
+                relativeE = false;
+            } else if (line.code() == 83) {
+                relativeE = true;
+            } else if (!keepsPosition(line.code())) {
+                lose(true);
+            }
+        } else {
+            // tool changes move to the tool offset
+            lose(false);
+        }
+    }
+};
+
+GCodeMinifier::GCodeMinifier() :
+    d(new GCodeMinifierPrivate)
+{
+}
+
+GCodeMinifier::~GCodeMinifier()
+{
+    delete d;
+}
+
+QString GCodeMinifier::name() const
+{
+    return QStringLiteral("minify");
+}
+
+void GCodeMinifier::process(QVector<Line> &lines)
+{
+    // kept lines move down over the dropped ones
+    int kept = 0;
+    for (int i = 0; i < lines.size(); i++) {
+        if (!minify(lines[i].command)) {
+            continue;
+        }
+        if (kept != i) {
+            lines[kept] = std::move(lines[i]);
+        }
+        kept++;
+    }
+    lines.resize(kept);
+}
+
+void GCodeMinifier::setCompactWords(bool enabled)
+{
+    d->compactWords = enabled;
+}
+
+bool GCodeMinifier::compactWords() const
+{
+    return d->compactWords;
+}
+
+bool GCodeMinifier::minify(QByteArray &command)
+{
+    d->bytesIn += command.size();
+    GCodeLine line;
+    const bool parsed = line.parse(command);
+    bool rewrite = parsed && line.letter() == 'G' && line.code() >= 0 && line.code() <= 3 && line.subcode() == -1
+                   && line.lineNumber() == -1 && line.checksum() == -1 && !line.hasRepeatedWords();
+    // words are written back over the command, so every word needs what separated it
+    int previous = line.command().end;
+    for (int i = 0; rewrite && i < line.wordCount(); i++) {
+        const GCodeLine::Word &word = line.word(i);
+        rewrite = word.hasValue && (d->compactWords || word.begin - 1 > previous);
+        previous = word.end;
+    }
+    if (!rewrite) {
+        if (parsed) {
+            d->track(line);
+        } else if (!command.isEmpty()) {
+            // nothing is known about what it does
+            d->lose(true);
+            d->knownFeedrate = false;
+        }
+        d->bytesOut += command.size();
+        return !command.isEmpty();
+    }
+
+    const bool linear = line.code() <= 1;
+    char *data = command.data();
+    int length = 0;
+    data[length++] = line.letter();
+    length += writeNumber(data + length, data + line.command().begin, data + line.command().end, true);
+    int kept = 0;
+    for (int i = 0; i < line.wordCount(); i++) {
+        const GCodeLine::Word &word = line.word(i);
+        const int a = axis(word.letter);
+        bool drop = false;
+        if (word.letter == 'F') {
+            drop = linear && d->knownFeedrate && d->feedrate == word.value;
+            d->feedrate = word.value;
+            d->knownFeedrate = true;
+        } else if (a != -1) {
+            const bool relative = d->relative || (a == E && d->relativeE);
+            if (linear) {
+                drop = relative ? word.value == 0 : d->known[a] && std::abs(d->position[a] - word.value) < 1e-9;
+            }
+            d->position[a] = relative ? d->position[a] + word.value : word.value;
+            d->known[a] = d->known[a] || !relative;
+        }
+        if (drop) {
+            continue;
+        }
+        if (!d->compactWords) {
+            data[length++] = ' ';
+        }
+        data[length++] = word.letter;
+        length += writeNumber(data + length, data + word.begin, data + word.end, !d->compactWords);
+        kept++;
+    }
+    if (linear && !kept) {
+        // a move to where the head is
+        command.resize(0);
+        return false;
+    }
+    command.resize(length);
+    d->bytesOut += length;
+    return true;
+}
+
+qint64 GCodeMinifier::bytesIn() const
+{
+    return d->bytesIn;
+}
+
+qint64 GCodeMinifier::bytesOut() const
+{
+    return d->bytesOut;
+}
@@ -0,0 +1,93 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "gcodepipeline.h"
+
+class GCodeMinifierPrivate;
+/**
+ * @brief The GCodeMinifier class
+ * Rewrites streamed commands with as few bytes as the firmware needs.
+ *
+ * Modal state is tracked over the job: an F word repeating the feedrate and
+ * an absolute axis word repeating the position are dropped from G0 and G1,
+ * a move left without words is dropped altogether. Numbers lose their '+',
+ * leading and trailing zeros. Only G0 to G3 are rewritten, other commands pass
+ * through unchanged, their text may not be numbers.
+ *
+ * With setCompactWords() the spaces between words and the zero of "0.5" go
+ * too, for firmwares that read "G1X10Y.5".
+ *
+ * In a streamed print it runs as the last GCodePipeline stage.
+ */
+class ATCORE_EXPORT GCodeMinifier : public GCodeFilter
+{
+public:
+    GCodeMinifier();
+    ~GCodeMinifier() override;
+
+    /**
+     * @brief Name of the stage in a GCodePipeline
+     */
+    QString name() const override;
+
+    /**
+     * @brief Minify a batch of lines, as a GCodePipeline stage
+     * @param lines: next lines of the job, dropped commands are removed
+     */
+    void process(QVector<Line> &lines) override;
+
+    /**
+     * @brief Drop the spaces between words
+     * @param enabled: True if the firmware reads commands without spaces
+     */
+    void setCompactWords(bool enabled);
+
+    /**
+     * @brief True if the spaces between words are dropped
+     */
+    bool compactWords() const;
+
+    /**
+     * @brief Minify the next command of the job
+     * @param command: command without comment, words separated by one space, set to the minified command
+     * @return False if the command was dropped, \p command is empty then
+     */
+    bool minify(QByteArray &command);
+
+    /**
+     * @brief Bytes of the commands passed to minify()
+     */
+    qint64 bytesIn() const;
+
+    /**
+     * @brief Bytes of the commands minify() returned
+     */
+    qint64 bytesOut() const;
+
+private:
+    GCodeMinifier(const GCodeMinifier &) = delete;
+    GCodeMinifier &operator=(const GCodeMinifier &) = delete;
+    GCodeMinifierPrivate *d;
+};
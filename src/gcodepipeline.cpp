@@ -0,0 +1,114 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QElapsedTimer>
+
+#include "gcodepipeline.h"
+
+GCodeFilter::~GCodeFilter()
+{
+}
+
+void GCodeFilter::flush(QVector<Line> &lines)
+{
+    Q_UNUSED(lines);
+}
+
+/**
+ * @brief The GCodePipelinePrivate class
+ */
+class GCodePipelinePrivate
+{
+public:
+    QVector<GCodeFilter *> filters;                 //!< @param filters: stages in order
+    QVector<GCodePipeline::StageStats> stats;       //!< @param stats: counters of each stage
+    QElapsedTimer timer;                            //!< @param timer: times the stages
+
+    /**
+     * @brief Run \p lines through stage \p i, counting it
+     * @param held: flush the stage after processing
+     */
+    void run(int i, QVector<GCodeFilter::Line> &lines, bool held)
+    {
+        GCodePipeline::StageStats &stage = stats[i];
+        stage.linesIn += lines.size();
+        timer.start();
+        if (!lines.isEmpty()) {
+            filters[i]->process(lines);
+        }
+        if (held) {
+            filters[i]->flush(lines);
+        }
+        stage.nsecs += timer.nsecsElapsed();
+        stage.linesOut += lines.size();
+    }
+};
+
+GCodePipeline::GCodePipeline() :
+    d(new GCodePipelinePrivate)
+{
+}
+
+GCodePipeline::~GCodePipeline()
+{
+    qDeleteAll(d->filters);
+    delete d;
+}
+
+void GCodePipeline::addFilter(GCodeFilter *filter)
+{
+    if (!filter) {
+        return;
+    }
+    d->filters.append(filter);
+    StageStats stage;
+    stage.name = filter->name();
+    d->stats.append(stage);
+}
+
+bool GCodePipeline::isEmpty() const
+{
+    return d->filters.isEmpty();
+}
+
+void GCodePipeline::process(QVector<GCodeFilter::Line> &lines)
+{
+    for (int i = 0; i < d->filters.size(); i++) {
+        d->run(i, lines, false);
+    }
+}
+
+void GCodePipeline::flush(QVector<GCodeFilter::Line> &lines)
+{
+    // what a stage held goes through the stages after it
+    QVector<GCodeFilter::Line> held;
+    for (int i = 0; i < d->filters.size(); i++) {
+        d->run(i, held, true);
+    }
+    lines += held;
+}
+
+QVector<GCodePipeline::StageStats> GCodePipeline::stats() const
+{
+    return d->stats;
+}
@@ -0,0 +1,137 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QByteArray>
+#include <QMetaType>
+#include <QString>
+#include <QVector>
+
+#include "atcore_export.h"
+
+/**
+ * @brief The GCodeFilter class
+ * A stage of a GCodePipeline, transforming the lines of a streamed job.
+ *
+ * Lines come in batches, in job order, on the thread reading the job. A stage
+ * may change, drop or insert lines, or hold some back and return them with a
+ * later batch, as long as it keeps them in job order. Inserted lines take the
+ * offsets of the line they come from.
+ */
+class ATCORE_EXPORT GCodeFilter
+{
+public:
+    /**
+     * @brief A line of the job
+     */
+    struct Line {
+        QByteArray command;     //!< @param command: command without comment, words separated by one space
+        qint64 offset;          //!< @param offset: byte offset after the line in the job
+        qint64 fileOffset;      //!< @param fileOffset: offset after the line in the file on disk
+    };
+
+    virtual ~GCodeFilter();
+
+    /**
+     * @brief Name of the stage, for its counters
+     */
+    virtual QString name() const = 0;
+
+    /**
+     * @brief Transform the next batch of lines
+     * @param lines: lines of the batch, replaced by the lines done with
+     */
+    virtual void process(QVector<Line> &lines) = 0;
+
+    /**
+     * @brief Append the lines held back, at the end of the job
+     * @param lines: lines are appended to it
+     */
+    virtual void flush(QVector<Line> &lines);
+};
+
+class GCodePipelinePrivate;
+/**
+ * @brief The GCodePipeline class
+ * Runs batches of lines through GCodeFilter stages, in the order they were added.
+ *
+ * Every stage has counters of the lines it took and gave and of the time it
+ * spent, to see which one costs throughput. An empty pipeline does nothing,
+ * callers check isEmpty() to not batch lines at all.
+ */
+class ATCORE_EXPORT GCodePipeline
+{
+public:
+    /**
+     * @brief Counters of a stage
+     */
+    struct StageStats {
+        QString name;           //!< @param name: GCodeFilter::name() of the stage
+        qint64 nsecs = 0;       //!< @param nsecs: time spent in the stage in ns
+        qint64 linesIn = 0;     //!< @param linesIn: lines passed to the stage
+        qint64 linesOut = 0;    //!< @param linesOut: lines the stage returned
+    };
+
+    GCodePipeline();
+
+    /**
+     * @brief Delete the stages
+     */
+    ~GCodePipeline();
+
+    /**
+     * @brief Add a stage after the others
+     * @param filter: the stage, the pipeline takes ownership of it
+     */
+    void addFilter(GCodeFilter *filter);
+
+    /**
+     * @brief True if no stage was added
+     */
+    bool isEmpty() const;
+
+    /**
+     * @brief Run a batch through all stages
+     * @param lines: lines read from the job, replaced by the lines to send
+     */
+    void process(QVector<GCodeFilter::Line> &lines);
+
+    /**
+     * @brief Run the lines every stage held back through the stages after it, at the end of the job
+     * @param lines: lines to send are appended to it
+     */
+    void flush(QVector<GCodeFilter::Line> &lines);
+
+    /**
+     * @brief Counters of each stage, in order
+     */
+    QVector<StageStats> stats() const;
+
+private:
+    GCodePipeline(const GCodePipeline &) = delete;
+    GCodePipeline &operator=(const GCodePipeline &) = delete;
+    GCodePipelinePrivate *d;
+};
+
+Q_DECLARE_METATYPE(GCodePipeline::StageStats)
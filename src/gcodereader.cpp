@@ -0,0 +1,314 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QFile>
+#include <QLoggingCategory>
+#include <cstring>
+
+#if defined(Q_OS_UNIX)
+#include <sys/mman.h>
+#endif
+
+#include "gcodereader.h"
+#include "gcodedecompressor.h"
+
+Q_LOGGING_CATEGORY(GCODE_READER, "org.kde.atelier.core.gcodeReader")
+
+/**
+ * @brief The GCodeReaderPrivate class
+ */
+class GCodeReaderPrivate
+{
+public:
+    QFile file;                 //!< @param file: the G-code file
+    const char *data = nullptr; //!< @param data: start of the mapped file
+    qint64 size = 0;            //!< @param size: size of the file
+    qint64 position = 0;        //!< @param position: offset of the next line
+    bool open = false;          //!< @param open: True once the file is mapped or read
+    QByteArray fallback;        //!< @param fallback: file content if it can't be mapped
+    GCodeDecompressor *decompressor = nullptr; //!< @param decompressor: worker of a compressed file
+    QByteArray buffer;          //!< @param buffer: decompressed block being read, after the rest of the one before
+    qint64 bufferStart = 0;     //!< @param bufferStart: offset of buffer in the decompressed file
+    int bufferPosition = 0;     //!< @param bufferPosition: next line in buffer
+    qint64 compressedBegin = 0; //!< @param compressedBegin: compressed bytes consumed before buffer
+    qint64 compressedEnd = 0;   //!< @param compressedEnd: compressed bytes consumed up to the end of buffer
+    bool decompressed = false;  //!< @param decompressed: the decompressor handed out its last block
+
+    /**
+     * @brief Start decompressing the file from the beginning
+     */
+    bool startDecompressor()
+    {
+        delete decompressor;
+        decompressor = new GCodeDecompressor(file.fileName());
+        buffer.clear();
+        bufferStart = 0;
+        bufferPosition = 0;
+        compressedBegin = 0;
+        compressedEnd = 0;
+        decompressed = false;
+        position = 0;
+        return decompressor->open();
+    }
+
+    /**
+     * @brief Append the next decompressed block to the unread part of buffer
+     * @return False after the last block
+     */
+    bool nextBlock()
+    {
+        QByteArray block;
+        qint64 compressedOffset = 0;
+        if (decompressed || !decompressor->read(block, compressedOffset)) {
+            if (!decompressed && decompressor->hasError()) {
+                qCDebug(GCODE_READER) << "Stopped reading" << file.fileName() << "at a decompression error";
+            }
+            decompressed = true;
+            return false;
+        }
+        bufferStart += bufferPosition;
+        if (bufferPosition == buffer.size()) {
+            // no line crosses the blocks, take the block as it is
+            buffer = block;
+        } else {
+            buffer = buffer.mid(bufferPosition) + block;
+        }
+        bufferPosition = 0;
+        compressedBegin = compressedEnd;
+        compressedEnd = compressedOffset;
+        return true;
+    }
+};
+
+GCodeReader::GCodeReader(const QString &fileName) :
+    d(new GCodeReaderPrivate)
+{
+    d->file.setFileName(fileName);
+}
+
+GCodeReader::~GCodeReader()
+{
+    delete d->decompressor;
+    delete d;
+}
+
+bool GCodeReader::open()
+{
+    if (d->open) {
+        return true;
+    }
+    if (!d->file.open(QIODevice::ReadOnly)) {
+        qCDebug(GCODE_READER) << "Can't open" << d->file.fileName() << d->file.errorString();
+        return false;
+    }
+
+    d->size = d->file.size();
+    d->position = 0;
+    if (GCodeDecompressor::format(d->file.fileName()) != GCodeDecompressor::NONE) {
+        d->file.close();
+        if (!d->startDecompressor()) {
+            return false;
+        }
+        d->size = -1;
+        d->open = true;
+        return true;
+    }
+    d->open = true;
+    if (d->size == 0) {
+        return true;
+    }
+
+    uchar *map = d->file.map(0, d->size);
+    if (map) {
+#if defined(Q_OS_UNIX)
+        posix_madvise(map, size_t(d->size), POSIX_MADV_SEQUENTIAL);
+#endif
+        d->data = reinterpret_cast<const char *>(map);
+    } else {
+        qCDebug(GCODE_READER) << "Can't map" << d->file.fileName() << ", reading it instead";
+        d->fallback = d->file.readAll();
+        d->data = d->fallback.constData();
+        d->size = d->fallback.size();
+    }
+    return true;
+}
+
+bool GCodeReader::isOpen() const
+{
+    return d->open;
+}
+
+qint64 GCodeReader::size() const
+{
+    return d->size;
+}
+
+const char *GCodeReader::data() const
+{
+    return d->data;
+}
+
+bool GCodeReader::isCompressed() const
+{
+    return d->decompressor != nullptr;
+}
+
+qint64 GCodeReader::fileSize() const
+{
+    return d->decompressor ? d->decompressor->compressedSize() : d->size;
+}
+
+qint64 GCodeReader::filePosition() const
+{
+    if (!d->decompressor) {
+        return d->position;
+    }
+    if (d->buffer.isEmpty()) {
+        return d->compressedEnd;
+    }
+    return d->compressedBegin + (d->compressedEnd - d->compressedBegin) * d->bufferPosition / d->buffer.size();
+}
+
+qint64 GCodeReader::position() const
+{
+    return d->position;
+}
+
+bool GCodeReader::seek(qint64 offset)
+{
+    if (!d->open || offset < 0) {
+        return false;
+    }
+    if (d->decompressor) {
+        // decompress up to offset, from the start when going back
+        if (offset < d->position && !d->startDecompressor()) {
+            return false;
+        }
+        const char *data = nullptr;
+        int size = 0;
+        while (d->position < offset && readLine(data, size)) {
+        }
+        return d->position == offset;
+    }
+    if (offset > d->size) {
+        return false;
+    }
+    d->position = offset;
+    return true;
+}
+
+bool GCodeReader::atEnd() const
+{
+    if (d->decompressor) {
+        while (d->bufferPosition == d->buffer.size()) {
+            if (!d->nextBlock()) {
+                return true;
+            }
+        }
+        return false;
+    }
+    return d->position >= d->size;
+}
+
+bool GCodeReader::readLine(const char *&data, int &size)
+{
+    if (atEnd()) {
+        return false;
+    }
+    if (d->decompressor) {
+        for (;;) {
+            data = d->buffer.constData() + d->bufferPosition;
+            const int left = d->buffer.size() - d->bufferPosition;
+            const char *end = static_cast<const char *>(std::memchr(data, '\n', size_t(left)));
+            if (end) {
+                size = int(end - data);
+                d->bufferPosition += size + 1;
+                break;
+            }
+            if (!d->nextBlock()) {
+                // the last line has no terminator
+                size = left;
+                d->bufferPosition = d->buffer.size();
+                break;
+            }
+        }
+        d->position = d->bufferStart + d->bufferPosition;
+        if (size > 0 && data[size - 1] == '\r') {
+            size--;
+        }
+        return true;
+    }
+    data = d->data + d->position;
+    const qint64 left = d->size - d->position;
+    const char *end = static_cast<const char *>(std::memchr(data, '\n', size_t(left)));
+    if (end) {
+        size = int(end - data);
+        d->position += size + 1;
+    } else {
+        size = int(left);
+        d->position = d->size;
+    }
+    if (size > 0 && data[size - 1] == '\r') {
+        size--;
+    }
+    return true;
+}
+
+bool GCodeReader::readCommand(QByteArray &command)
+{
+    const char *data = nullptr;
+    int size = 0;
+    if (!readLine(data, size)) {
+        command.resize(0);
+        return false;
+    }
+    simplifyCommand(data, size, command);
+    return true;
+}
+
+void GCodeReader::simplifyCommand(const char *data, int size, QByteArray &command)
+{
+    const char *comment = static_cast<const char *>(std::memchr(data, ';', size_t(size)));
+    if (comment) {
+        size = int(comment - data);
+    }
+
+    // resize() keeps the capacity, command is only allocated for longer lines
+    command.resize(size);
+    char *out = command.data();
+    int length = 0;
+    bool space = false;
+    for (int i = 0; i < size; i++) {
+        const char c = data[i];
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f') {
+            space = length > 0;
+            continue;
+        }
+        if (space) {
+            out[length++] = ' ';
+            space = false;
+        }
+        out[length++] = c;
+    }
+    command.resize(length);
+}
@@ -0,0 +1,142 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+#include "atcore_export.h"
+
+class GCodeReaderPrivate;
+/**
+ * @brief The GCodeReader class
+ * Reads a G-code file line by line from a memory map.
+ *
+ * The file is mapped once and the kernel is told it will be read sequentially.
+ * Lines are handed out as spans into the map, nothing is decoded or allocated
+ * per line, and position() is an exact byte offset for progress.
+ * Files that can't be mapped are read into memory instead.
+ *
+ * Compressed files, see GCodeDecompressor, are decompressed on a worker as
+ * they are read. Their lines are only valid until the next read, data() is not
+ * available and seeking backwards decompresses again from the start.
+ */
+class ATCORE_EXPORT GCodeReader
+{
+public:
+    /**
+     * @brief Create a new GCodeReader, call open() before reading
+     * @param fileName: G-code file
+     */
+    explicit GCodeReader(const QString &fileName);
+    ~GCodeReader();
+
+    /**
+     * @brief Map the file
+     * @return False if the file can't be read
+     */
+    bool open();
+
+    /**
+     * @brief True if open() succeeded
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Size of the G-code in bytes
+     * @return -1 for a compressed file, its size is known once it was read
+     */
+    qint64 size() const;
+
+    /**
+     * @brief The whole file, valid until the reader is destroyed
+     * @return first byte of the file, nullptr before open(), for an empty file or a compressed one
+     */
+    const char *data() const;
+
+    /**
+     * @brief True if the file is decompressed as it is read
+     */
+    bool isCompressed() const;
+
+    /**
+     * @brief Size of the file on disk in bytes, compressed or not
+     */
+    qint64 fileSize() const;
+
+    /**
+     * @brief Bytes of the file on disk read up to position(), for progress
+     *
+     * position() for plain files. For compressed files it's interpolated within
+     * the decompressed block being read.
+     */
+    qint64 filePosition() const;
+
+    /**
+     * @brief Byte offset of the next line
+     */
+    qint64 position() const;
+
+    /**
+     * @brief Continue reading at \p offset
+     * @param offset: byte offset of the start of a line, in decompressed bytes for compressed files
+     * @return False if \p offset is outside the file
+     */
+    bool seek(qint64 offset);
+
+    /**
+     * @brief True if every line was read
+     */
+    bool atEnd() const;
+
+    /**
+     * @brief Next line without its terminator
+     * @param data: set to the first byte of the line, valid until the reader is destroyed or, for compressed files, until the next read
+     * @param size: set to the size of the line
+     * @return False at the end of the file
+     */
+    bool readLine(const char *&data, int &size);
+
+    /**
+     * @brief Next line as a command, without comment and with whitespace simplified
+     *
+     * \p command is reused, it only allocates when a line is longer than any before.
+     * @param command: set to the command, empty for blank and comment lines
+     * @return False at the end of the file
+     */
+    bool readCommand(QByteArray &command);
+
+    /**
+     * @brief Copy the command in \p data to \p command, dropping a ';' comment and simplifying whitespace
+     * @param data: line
+     * @param size: size of the line
+     * @param command: set to the command
+     */
+    static void simplifyCommand(const char *data, int size, QByteArray &command);
+
+private:
+    GCodeReader(const GCodeReader &) = delete;
+    GCodeReader &operator=(const GCodeReader &) = delete;
+    GCodeReaderPrivate *d;
+};
@@ -46,7 +46,7 @@ IFirmware::IFirmware()
 void IFirmware::init(AtCore *parent)
 {
     d->parent = parent;
-    connect(d->parent, &AtCore::receivedMessage, this, &IFirmware::checkCommand);
+    connect(d->parent, &AtCore::receivedMessage, this, &IFirmware::checkCommand, Qt::UniqueConnection);
 }
 
 AtCore *IFirmware::core() const
@@ -65,12 +65,51 @@ void IFirmware::checkCommand(const QByteArray &lastMessage)
 
 void IFirmware::validateCommand(const QString &lastMessage)
 {
-    if (lastMessage.contains(d->_ok)) {
+    if (isAcknowledge(lastMessage)) {
         emit readyForCommand();
     }
 }
 
 QByteArray IFirmware::translate(const QString &command)
 {
-    return command.toLocal8Bit();
+    return translate(command.toLocal8Bit());
+}
+
+QByteArray IFirmware::translate(const QByteArray &command)
+{
+    return command;
+}
+
+int IFirmware::bufferSize() const
+{
+    return 0;
+}
+
+bool IFirmware::isBinary(const QByteArray &command) const
+{
+    Q_UNUSED(command);
+    return false;
+}
+
+bool IFirmware::supportsArcs() const
+{
+    return false;
+}
+
+bool IFirmware::supportsCompactWords() const
+{
+    return false;
+}
+
+bool IFirmware::isAcknowledge(const QString &message)
+{
+    int i = 0;
+    while (i < message.size() && message.at(i).isSpace()) {
+        i++;
+    }
+    if (!message.midRef(i).startsWith(IFirmwarePrivate::_ok)) {
+        return false;
+    }
+    i += IFirmwarePrivate::_ok.size();
+    return i == message.size() || !message.at(i).isLetterOrNumber();
 }
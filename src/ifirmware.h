@@ -61,14 +61,70 @@ public:
     virtual void validateCommand(const QString &lastMessage);
 
     /**
-     * @brief Virtual translate to be reimplemnted by Firmwareplugin
+     * @brief Virtual translate of a command given as text
      *
-     * Translate common commands to firmware specific command.
+     * The default converts \p command with toLocal8Bit() and calls translate(const QByteArray &).
      * @param command: Command command to translate
      * @return firmware specific translated command
      */
     virtual QByteArray translate(const QString &command);
 
+    /**
+     * @brief Virtual translate to be reimplemnted by Firmwareplugin
+     *
+     * Translate common commands to firmware specific command. AtCore queues
+     * commands as bytes and only calls this overload, plugins reimplement it.
+     * The default returns \p command unchanged.
+     * @param command: Command command to translate
+     * @return firmware specific translated command
+     */
+    virtual QByteArray translate(const QByteArray &command);
+
+    /**
+     * @brief Virtual bufferSize to be reimplemented by Firmware plugin
+     *
+     * Size of the firmware's serial receive buffer. AtCore uses it to keep
+     * more than one command in flight when streaming.
+     * @return buffer size in bytes, 0 if the firmware takes one command at a time
+     */
+    virtual int bufferSize() const;
+
+    /**
+     * @brief Virtual isBinary to be reimplemented by Firmware plugins sending binary frames
+     *
+     * Binary frames returned by translate() are written without a line terminator.
+     * @param command: command returned by translate()
+     * @return True if \p command is a binary frame
+     */
+    virtual bool isBinary(const QByteArray &command) const;
+
+    /**
+     * @brief Virtual supportsArcs to be reimplemented by Firmware plugins with G2 and G3
+     *
+     * AtCore only fits arcs to streamed jobs for firmwares that support them.
+     * @return True if the firmware moves along G2 and G3 arcs
+     */
+    virtual bool supportsArcs() const;
+
+    /**
+     * @brief Virtual supportsCompactWords to be reimplemented by Firmware plugins reading "G1X10Y.5"
+     *
+     * Minified commands are sent without spaces between words, and without the zero of "0.5", if true.
+     * @return True if the firmware reads words without spaces between them
+     */
+    virtual bool supportsCompactWords() const;
+
+    /**
+     * @brief Check if \p message acknowledges a command
+     *
+     * Acknowledges start with "ok", like "ok", "ok 12", "ok N12 P15 B3" or
+     * "ok T:210.0 /210.0". Unsolicited messages that only contain it, like
+     * "echo:SD card ok" or temperatures reported by the firmware, are not.
+     * @param message: message from the printer
+     * @return True if \p message is an acknowledge
+     */
+    static bool isAcknowledge(const QString &message);
+
     /**
      * @brief AtCore Parent of the firmware plugin
      * @return
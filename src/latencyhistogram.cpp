@@ -0,0 +1,163 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <atomic>
+#include <cmath>
+
+#include "latencyhistogram.h"
+
+namespace
+{
+// 2^_subBucketBits linear buckets per power of two
+const int _subBucketBits = 4;
+const int _subBuckets = 1 << _subBucketBits;
+// largest power of two tracked, 2^36 µs is about 19 hours
+const int _maxExponent = 35;
+const int _bucketCount = (_maxExponent - _subBucketBits + 2) * _subBuckets;
+}
+
+/**
+ * @brief The LatencyHistogramPrivate class
+ */
+class LatencyHistogramPrivate
+{
+public:
+    std::atomic<quint64> buckets[_bucketCount];  //!< @param buckets: values per bucket
+    std::atomic<quint64> count{0};              //!< @param count: values recorded
+    std::atomic<quint64> sum{0};                //!< @param sum: sum of the values recorded
+    std::atomic<quint64> min{~quint64(0)};      //!< @param min: smallest value recorded
+    std::atomic<quint64> max{0};                //!< @param max: largest value recorded
+};
+
+LatencyHistogram::LatencyHistogram() :
+    d(new LatencyHistogramPrivate)
+{
+    reset();
+}
+
+LatencyHistogram::~LatencyHistogram()
+{
+    delete d;
+}
+
+int LatencyHistogram::bucketCount()
+{
+    return _bucketCount;
+}
+
+int LatencyHistogram::bucketIndex(quint64 usec)
+{
+    if (usec < quint64(_subBuckets)) {
+        return int(usec);
+    }
+    int exponent = 63;
+    while (!(usec >> exponent)) {
+        exponent--;
+    }
+    if (exponent > _maxExponent) {
+        return _bucketCount - 1;
+    }
+    const int sub = int(usec >> (exponent - _subBucketBits)) - _subBuckets;
+    return (exponent - _subBucketBits + 1) * _subBuckets + sub;
+}
+
+quint64 LatencyHistogram::bucketUpperBound(int index)
+{
+    if (index < _subBuckets) {
+        return quint64(index);
+    }
+    const int shift = index / _subBuckets - 1;
+    const quint64 lower = quint64(_subBuckets + index % _subBuckets) << shift;
+    return lower + (quint64(1) << shift) - 1;
+}
+
+quint64 LatencyHistogram::bucketValues(int index) const
+{
+    if (index < 0 || index >= _bucketCount) {
+        return 0;
+    }
+    return d->buckets[index].load(std::memory_order_relaxed);
+}
+
+void LatencyHistogram::record(quint64 usec)
+{
+    d->buckets[bucketIndex(usec)].fetch_add(1, std::memory_order_relaxed);
+    d->count.fetch_add(1, std::memory_order_relaxed);
+    d->sum.fetch_add(usec, std::memory_order_relaxed);
+
+    quint64 current = d->min.load(std::memory_order_relaxed);
+    while (usec < current && !d->min.compare_exchange_weak(current, usec, std::memory_order_relaxed)) {
+    }
+    current = d->max.load(std::memory_order_relaxed);
+    while (usec > current && !d->max.compare_exchange_weak(current, usec, std::memory_order_relaxed)) {
+    }
+}
+
+quint64 LatencyHistogram::count() const
+{
+    return d->count.load(std::memory_order_relaxed);
+}
+
+quint64 LatencyHistogram::min() const
+{
+    return count() ? d->min.load(std::memory_order_relaxed) : 0;
+}
+
+quint64 LatencyHistogram::max() const
+{
+    return d->max.load(std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const
+{
+    const quint64 values = count();
+    return values ? double(d->sum.load(std::memory_order_relaxed)) / double(values) : 0;
+}
+
+quint64 LatencyHistogram::percentile(double percent) const
+{
+    const quint64 values = count();
+    if (!values) {
+        return 0;
+    }
+    const quint64 target = qMax(quint64(1), quint64(std::ceil(qBound(0.0, percent, 100.0) / 100.0 * double(values))));
+    quint64 seen = 0;
+    for (int i = 0; i < _bucketCount; i++) {
+        seen += bucketValues(i);
+        if (seen >= target) {
+            return qMin(bucketUpperBound(i), max());
+        }
+    }
+    return max();
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto &bucket : d->buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    d->count.store(0, std::memory_order_relaxed);
+    d->sum.store(0, std::memory_order_relaxed);
+    d->min.store(~quint64(0), std::memory_order_relaxed);
+    d->max.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,108 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QtGlobal>
+
+#include "atcore_export.h"
+
+class LatencyHistogramPrivate;
+/**
+ * @brief The LatencyHistogram class
+ * Lock-free log-linear histogram of latencies in microseconds.
+ *
+ * Values below 16 µs are exact, larger ones fall in one of 16 buckets per
+ * power of two, so every value is known within about 6%. Values above
+ * 2^36 µs (about 19 hours) are clamped. record() is a few relaxed atomic
+ * operations and may run on any thread while others read.
+ */
+class ATCORE_EXPORT LatencyHistogram
+{
+public:
+    LatencyHistogram();
+    ~LatencyHistogram();
+
+    /**
+     * @brief Add one latency
+     * @param usec: latency in microseconds
+     */
+    void record(quint64 usec);
+
+    /**
+     * @brief Number of latencies recorded
+     */
+    quint64 count() const;
+
+    /**
+     * @brief Smallest latency recorded in microseconds, 0 if none
+     */
+    quint64 min() const;
+
+    /**
+     * @brief Largest latency recorded in microseconds, 0 if none
+     */
+    quint64 max() const;
+
+    /**
+     * @brief Mean latency in microseconds, 0 if none
+     */
+    double mean() const;
+
+    /**
+     * @brief Latency below which \p percent of the values fall
+     * @param percent: percentile between 0 and 100
+     * @return upper bound of the bucket holding the percentile in microseconds, 0 if none
+     */
+    quint64 percentile(double percent) const;
+
+    /**
+     * @brief Forget all recorded latencies
+     */
+    void reset();
+
+    /**
+     * @brief Number of buckets
+     */
+    static int bucketCount();
+
+    /**
+     * @brief Bucket holding \p usec
+     */
+    static int bucketIndex(quint64 usec);
+
+    /**
+     * @brief Highest value counted in bucket \p index
+     */
+    static quint64 bucketUpperBound(int index);
+
+    /**
+     * @brief Values recorded in bucket \p index
+     */
+    quint64 bucketValues(int index) const;
+
+private:
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+    LatencyHistogramPrivate *d;
+};
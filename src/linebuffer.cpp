@@ -0,0 +1,145 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <algorithm>
+#include <cstring>
+
+#include "linebuffer.h"
+
+/**
+ * @brief The LineBufferPrivate class
+ */
+class LineBufferPrivate
+{
+public:
+    QByteArray data;    //!< @param data: ring storage, allocated once
+    int head = 0;       //!< @param head: index of the first buffered byte
+    int size = 0;       //!< @param size: bytes buffered
+    int scanned = 0;    //!< @param scanned: bytes after head already known to hold no line end
+};
+
+LineBuffer::LineBuffer(int capacity) :
+    d(new LineBufferPrivate)
+{
+    d->data.resize(qMax(capacity, 1));
+}
+
+LineBuffer::~LineBuffer()
+{
+    delete d;
+}
+
+int LineBuffer::capacity() const
+{
+    return d->data.size();
+}
+
+int LineBuffer::size() const
+{
+    return d->size;
+}
+
+char *LineBuffer::reserve(int &space)
+{
+    const int tail = (d->head + d->size) % capacity();
+    if (d->size == capacity()) {
+        space = 0;
+    } else if (tail >= d->head) {
+        space = capacity() - tail;
+    } else {
+        space = d->head - tail;
+    }
+    return d->data.data() + tail;
+}
+
+void LineBuffer::commit(int size)
+{
+    d->size = qMin(d->size + size, capacity());
+}
+
+int LineBuffer::append(const char *data, int size)
+{
+    int copied = 0;
+    while (copied < size) {
+        int space = 0;
+        char *dest = reserve(space);
+        if (space == 0) {
+            break;
+        }
+        space = qMin(space, size - copied);
+        memcpy(dest, data + copied, size_t(space));
+        commit(space);
+        copied += space;
+    }
+    return copied;
+}
+
+bool LineBuffer::readLine(QByteArray &line)
+{
+    const char *ring = d->data.constData();
+    int length = -1;
+
+    //Look for '\n' in at most two contiguous runs, skipping what was scanned before
+    while (d->scanned < d->size) {
+        const int start = (d->head + d->scanned) % capacity();
+        const int run = qMin(d->size - d->scanned, capacity() - start);
+        const char *found = static_cast<const char *>(memchr(ring + start, '\n', size_t(run)));
+        if (found) {
+            length = d->scanned + int(found - (ring + start));
+            break;
+        }
+        d->scanned += run;
+    }
+
+    int consumed = length + 1;
+    if (length == -1) {
+        if (d->size < capacity()) {
+            return false;
+        }
+        //Full without a line end, hand it out rather than stall
+        length = d->size;
+        consumed = d->size;
+    }
+
+    line.resize(length);
+    const int firstRun = qMin(length, capacity() - d->head);
+    memcpy(line.data(), ring + d->head, size_t(firstRun));
+    memcpy(line.data() + firstRun, ring, size_t(length - firstRun));
+
+    //Both \n\r and \n are used at the end of lines
+    if (memchr(line.constData(), '\r', size_t(length))) {
+        line.resize(int(std::remove(line.begin(), line.end(), '\r') - line.begin()));
+    }
+
+    d->head = (d->head + consumed) % capacity();
+    d->size -= consumed;
+    d->scanned = 0;
+    return true;
+}
+
+void LineBuffer::clear()
+{
+    d->head = 0;
+    d->size = 0;
+    d->scanned = 0;
+}
@@ -0,0 +1,101 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QByteArray>
+
+#include "atcore_export.h"
+
+class LineBufferPrivate;
+/**
+ * @brief The LineBuffer class
+ * Fixed capacity ring buffer that splits serial data into lines.
+ *
+ * Data is written with reserve() and commit() (or append()) and finished
+ * lines are taken with readLine(). Each byte is scanned once and each line
+ * is copied once, '\\r' characters are dropped.
+ */
+class ATCORE_EXPORT LineBuffer
+{
+public:
+    /**
+     * @brief Create a new LineBuffer
+     * @param capacity: size of the ring in bytes
+     */
+    explicit LineBuffer(int capacity = 4096);
+    ~LineBuffer();
+
+    /**
+     * @brief Size of the ring in bytes
+     */
+    int capacity() const;
+
+    /**
+     * @brief Bytes waiting in the ring
+     */
+    int size() const;
+
+    /**
+     * @brief Contiguous free space at the write position
+     *
+     * Fill up to \p space bytes of the returned pointer then call commit()
+     * @param space: set to the number of bytes that can be written
+     * @return write position
+     */
+    char *reserve(int &space);
+
+    /**
+     * @brief Mark \p size bytes written after reserve() as data
+     * @param size: number of bytes written
+     */
+    void commit(int size);
+
+    /**
+     * @brief Copy \p size bytes of \p data into the ring
+     * @param data: data to copy
+     * @param size: size of data
+     * @return number of bytes copied, less than \p size if the ring is full
+     */
+    int append(const char *data, int size);
+
+    /**
+     * @brief Take the next finished line
+     *
+     * A full ring without a line end is returned as one line, so a long
+     * line can never stall the buffer.
+     * @param line: set to the line without its terminator
+     * @return True if a line was taken
+     */
+    bool readLine(QByteArray &line);
+
+    /**
+     * @brief Drop all buffered data
+     */
+    void clear();
+
+private:
+    LineBuffer(const LineBuffer &) = delete;
+    LineBuffer &operator=(const LineBuffer &) = delete;
+    LineBufferPrivate *d;
+};
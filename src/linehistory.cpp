@@ -0,0 +1,158 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QFile>
+#include <QVector>
+
+#include "linehistory.h"
+
+/**
+ * @brief The LineHistoryPrivate class
+ */
+class LineHistoryPrivate
+{
+public:
+    QVector<QByteArray> lines;  //!< @param lines: ring storage
+    int head = 0;               //!< @param head: index of the oldest line
+    int size = 0;               //!< @param size: lines in the ring
+    qint64 total = 0;           //!< @param total: lines appended since the last clear
+    QFile spill;                //!< @param spill: file receiving lines pushed out of the ring
+
+    /**
+     * @brief Write \p line to the spill file if there is one
+     */
+    void spillLine(const QByteArray &line)
+    {
+        if (spill.isOpen()) {
+            spill.write(line);
+            spill.write("\n", 1);
+        }
+    }
+};
+
+LineHistory::LineHistory(int depth) :
+    d(new LineHistoryPrivate)
+{
+    d->lines.resize(qMax(depth, 1));
+}
+
+LineHistory::~LineHistory()
+{
+    delete d;
+}
+
+int LineHistory::depth() const
+{
+    return d->lines.size();
+}
+
+void LineHistory::setDepth(int depth)
+{
+    depth = qMax(depth, 1);
+    if (depth == this->depth()) {
+        return;
+    }
+    const int drop = qMax(0, d->size - depth);
+    for (int i = 0; i < drop; i++) {
+        d->spillLine(d->lines.at((d->head + i) % this->depth()));
+    }
+    QVector<QByteArray> lines(depth);
+    for (int i = drop; i < d->size; i++) {
+        lines[i - drop] = d->lines.at((d->head + i) % this->depth());
+    }
+    d->lines.swap(lines);
+    d->head = 0;
+    d->size -= drop;
+}
+
+int LineHistory::size() const
+{
+    return d->size;
+}
+
+bool LineHistory::isEmpty() const
+{
+    return d->size == 0;
+}
+
+qint64 LineHistory::total() const
+{
+    return d->total;
+}
+
+void LineHistory::append(const QByteArray &line)
+{
+    d->total++;
+    if (d->size < depth()) {
+        d->lines[(d->head + d->size) % depth()] = line;
+        d->size++;
+        return;
+    }
+    QByteArray &oldest = d->lines[d->head];
+    d->spillLine(oldest);
+    oldest = line;
+    d->head = (d->head + 1) % depth();
+}
+
+QList<QByteArray> LineHistory::recent(int count) const
+{
+    if (count < 0 || count > d->size) {
+        count = d->size;
+    }
+    QList<QByteArray> lines;
+    lines.reserve(count);
+    for (int i = d->size - count; i < d->size; i++) {
+        lines.append(d->lines.at((d->head + i) % depth()));
+    }
+    return lines;
+}
+
+bool LineHistory::setSpillFile(const QString &fileName)
+{
+    if (d->spill.isOpen()) {
+        d->spill.close();
+    }
+    d->spill.setFileName(fileName);
+    if (fileName.isEmpty()) {
+        return true;
+    }
+    return d->spill.open(QIODevice::WriteOnly | QIODevice::Append);
+}
+
+QString LineHistory::spillFile() const
+{
+    return d->spill.isOpen() ? d->spill.fileName() : QString();
+}
+
+void LineHistory::clear()
+{
+    for (int i = 0; i < d->size; i++) {
+        QByteArray &line = d->lines[(d->head + i) % depth()];
+        d->spillLine(line);
+        line = QByteArray();
+    }
+    d->head = 0;
+    d->size = 0;
+    d->total = 0;
+    d->spill.flush();
+}
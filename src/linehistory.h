@@ -0,0 +1,112 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+#include "atcore_export.h"
+
+class LineHistoryPrivate;
+/**
+ * @brief The LineHistory class
+ * Keeps the last lines received from the printer in a fixed size ring.
+ *
+ * Memory use depends only on the depth, not on how many lines were appended.
+ * Lines pushed out of the ring can be spilled to a file to keep a full log.
+ */
+class ATCORE_EXPORT LineHistory
+{
+public:
+    /**
+     * @brief Create a new LineHistory
+     * @param depth: number of lines kept in memory
+     */
+    explicit LineHistory(int depth = 1000);
+    ~LineHistory();
+
+    /**
+     * @brief Number of lines kept in memory
+     */
+    int depth() const;
+
+    /**
+     * @brief Change the number of lines kept in memory
+     *
+     * The newest lines are kept, older ones are spilled if a spill file is set.
+     * @param depth: number of lines to keep, at least 1
+     */
+    void setDepth(int depth);
+
+    /**
+     * @brief Number of lines in memory
+     */
+    int size() const;
+
+    /**
+     * @brief True if no line is in memory
+     */
+    bool isEmpty() const;
+
+    /**
+     * @brief Lines appended since the history was created or cleared
+     */
+    qint64 total() const;
+
+    /**
+     * @brief Append \p line, pushing out the oldest line if the ring is full
+     * @param line: line to keep
+     */
+    void append(const QByteArray &line);
+
+    /**
+     * @brief The newest lines
+     * @param count: maximum number of lines, -1 for every line in memory
+     * @return lines from the oldest to the newest
+     */
+    QList<QByteArray> recent(int count = -1) const;
+
+    /**
+     * @brief Append lines pushed out of the ring to \p fileName
+     * @param fileName: file to append to, empty to stop spilling
+     * @return False if the file can't be opened
+     */
+    bool setSpillFile(const QString &fileName);
+
+    /**
+     * @brief File lines are spilled to, empty if spilling is off
+     */
+    QString spillFile() const;
+
+    /**
+     * @brief Drop the lines in memory, spilling them first if a spill file is set
+     */
+    void clear();
+
+private:
+    LineHistory(const LineHistory &) = delete;
+    LineHistory &operator=(const LineHistory &) = delete;
+    LineHistoryPrivate *d;
+};
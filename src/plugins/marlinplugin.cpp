@@ -78,8 +78,24 @@ void MarlinPlugin::validateCommand(const QString &lastMessage)
                 core()->setState(AtCore::IDLE);
             }
         }
-        if (lastMessage.contains(QStringLiteral("ok"))) {
+        if (isAcknowledge(lastMessage)) {
             emit readyForCommand();
         }
     }
 }
+
+int MarlinPlugin::bufferSize() const
+{
+    // Marlin RX_BUFFER_SIZE is 128, keep one byte free
+    return 127;
+}
+
+bool MarlinPlugin::supportsArcs() const
+{
+    return true;
+}
+
+bool MarlinPlugin::supportsCompactWords() const
+{
+    return true;
+}
@@ -54,4 +54,22 @@ public:
      * @param lastMessage: last Message from printer
      */
     void validateCommand(const QString &lastMessage) override;
+
+    /**
+     * @brief Size of the firmware serial receive buffer
+     * @return 127
+     */
+    int bufferSize() const override;
+
+    /**
+     * @brief Marlin moves along G2 and G3 arcs
+     * @return true
+     */
+    bool supportsArcs() const override;
+
+    /**
+     * @brief Marlin reads words without spaces between them
+     * @return true
+     */
+    bool supportsCompactWords() const override;
 };
@@ -24,12 +24,123 @@
 */
 #include <QLoggingCategory>
 #include <QString>
+#include <QtEndian>
+#include <cstring>
 
 #include "repetierplugin.h"
 #include "atcore.h"
 
 Q_LOGGING_CATEGORY(REPETIER_PLUGIN, "org.kde.atelier.core.firmware.repetier")
 
+namespace
+{
+/**
+ * @brief Bits of the binary "params" and "params2" words, see Repetier's gcode.cpp
+ */
+enum BinaryParam : quint16 {
+    // params
+    HasN = 1,
+    HasM = 2,
+    HasG = 4,
+    HasX = 8,
+    HasY = 16,
+    HasZ = 32,
+    HasE = 64,
+    Binary = 128,       // always set, tells the firmware the frame is binary
+    HasF = 256,
+    HasT = 512,
+    HasS = 1024,
+    HasP = 2048,
+    Version2 = 4096,
+    HasString = 32768,
+    // params2
+    HasI = 1,
+    HasJ = 2,
+    HasR = 4,
+    HasD = 8,
+    HasC = 16,
+    HasH = 32,
+    HasA = 64,
+    HasB = 128,
+    HasK = 256,
+    HasL = 512,
+    HasO = 1024
+};
+
+// float parameters, in frame order
+const char _paramsLetters[] = "XYZEF";
+const char _params2Letters[] = "IJRDCHABKLO";
+
+/**
+ * @brief Bit of a float parameter kept in params
+ */
+quint16 paramsBit(char letter)
+{
+    switch (letter) {
+    case 'X': return HasX;
+    case 'Y': return HasY;
+    case 'Z': return HasZ;
+    case 'E': return HasE;
+    case 'F': return HasF;
+    default: return 0;
+    }
+}
+
+/**
+ * @brief Bit of a float parameter kept in params2
+ */
+quint16 params2Bit(char letter)
+{
+    switch (letter) {
+    case 'I': return HasI;
+    case 'J': return HasJ;
+    case 'R': return HasR;
+    case 'D': return HasD;
+    case 'C': return HasC;
+    case 'H': return HasH;
+    case 'A': return HasA;
+    case 'B': return HasB;
+    case 'K': return HasK;
+    case 'L': return HasL;
+    case 'O': return HasO;
+    default: return 0;
+    }
+}
+
+/**
+ * @brief M codes whose argument is a string (file names and messages)
+ */
+bool isStringCommand(int m)
+{
+    switch (m) {
+    case 23:
+    case 28:
+    case 29:
+    case 30:
+    case 32:
+    case 36:
+    case 117:
+        return true;
+    default:
+        return false;
+    }
+}
+
+template <typename T>
+void appendLittleEndian(QByteArray &frame, T value)
+{
+    value = qToLittleEndian(value);
+    frame.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+void appendFloat(QByteArray &frame, float value)
+{
+    quint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    appendLittleEndian(frame, bits);
+}
+}
+
 QString RepetierPlugin::name() const
 {
     return QStringLiteral("Repetier");
@@ -42,6 +153,28 @@ RepetierPlugin::RepetierPlugin()
 
 void RepetierPlugin::validateCommand(const QString &lastMessage)
 {
+    const int protocol = lastMessage.indexOf(QStringLiteral("REPETIER_PROTOCOL:"));
+    if (protocol != -1) {
+        // 1: binary version 1, 2 and later: binary version 2
+        int end = protocol + 18;
+        while (end < lastMessage.size() && lastMessage.at(end).isDigit()) {
+            end++;
+        }
+        bool ok = false;
+        const int version = lastMessage.mid(protocol + 18, end - protocol - 18).toInt(&ok);
+        if (!ok) {
+            qCDebug(REPETIER_PLUGIN) << "Unexpected protocol version, staying in ASCII:" << lastMessage;
+            binaryVersion = 0;
+            return;
+        }
+        if (version > 2) {
+            qCDebug(REPETIER_PLUGIN) << "Unknown binary protocol version" << version << "using version 2";
+        }
+        binaryVersion = qMin(version, 2);
+        qCDebug(REPETIER_PLUGIN) << "Binary protocol version" << binaryVersion;
+        return;
+    }
+
     if (lastMessage.contains(QStringLiteral("End file list"))) {
         core()->setReadingSdCardList(false);
     } else if (core()->isReadingSdCardList()) {
@@ -80,8 +213,191 @@ void RepetierPlugin::validateCommand(const QString &lastMessage)
                 core()->setState(AtCore::IDLE);
             }
         }
-        if (lastMessage.contains(QStringLiteral("ok"))) {
+        if (isAcknowledge(lastMessage)) {
             emit readyForCommand();
         }
     }
 }
+
+QByteArray RepetierPlugin::translate(const QByteArray &command)
+{
+    if (binaryVersion == 0 || core()->lineNumbering()) {
+        return command;
+    }
+    QByteArray frame = encodeBinary(command, binaryVersion);
+    if (frame.isEmpty()) {
+        return command;
+    }
+    return frame;
+}
+
+bool RepetierPlugin::isBinary(const QByteArray &command) const
+{
+    // ASCII commands never have the high bit set
+    return !command.isEmpty() && (uchar(command.at(0)) & Binary);
+}
+
+QByteArray RepetierPlugin::encodeBinary(const QByteArray &command, int version)
+{
+    quint16 params = Binary;
+    quint16 params2 = 0;
+    quint16 n = 0;
+    int m = -1;
+    int g = -1;
+    float values[26] = {};
+    qint32 s = 0;
+    qint32 p = 0;
+    int t = 0;
+    QByteArray text;
+
+    const QByteArray trimmed = command.trimmed();
+    int i = 0;
+    while (i < trimmed.size()) {
+        if (trimmed.at(i) == ' ') {
+            i++;
+            continue;
+        }
+        const char letter = char(trimmed.at(i) & ~0x20);
+        int end = trimmed.indexOf(' ', i);
+        if (end == -1) {
+            end = trimmed.size();
+        }
+        const QByteArray value = trimmed.mid(i + 1, end - i - 1);
+
+        if (m != -1 && isStringCommand(m)) {
+            // everything after the M code is the string
+            text = trimmed.mid(i);
+            break;
+        }
+
+        bool ok = true;
+        bool isFloat = false;
+        quint16 param = 0;
+        quint16 param2 = 0;
+        switch (letter) {
+        case 'N': param = HasN; n = value.toUShort(&ok); break;
+        case 'M': param = HasM; m = value.toUShort(&ok); break;
+        case 'G': param = HasG; g = value.toUShort(&ok); break;
+        case 'T': param = HasT; t = value.toUShort(&ok); ok = ok && t <= 255; break;
+        case 'S': param = HasS; s = value.toInt(&ok); break;
+        case 'P': param = HasP; p = value.toInt(&ok); break;
+        case 'X':
+        case 'Y':
+        case 'Z':
+        case 'E':
+        case 'F':
+            param = paramsBit(letter);
+            isFloat = true;
+            break;
+        default:
+            // only version 2 has params2
+            param2 = version < 2 ? 0 : params2Bit(letter);
+            if (!param2) {
+                return QByteArray();
+            }
+            isFloat = true;
+            break;
+        }
+
+        if (isFloat) {
+            // words may have no value, "G28 X" homes X
+            values[letter - 'A'] = value.isEmpty() ? 0 : value.toFloat(&ok);
+        }
+        if (!ok || (params & param) || (params2 & param2)) {
+            return QByteArray();
+        }
+        params |= param;
+        params2 |= param2;
+        i = end;
+    }
+
+    if (!(params & (HasM | HasG)) || (params & HasM && params & HasG)) {
+        return QByteArray();
+    }
+    if (version < 2 && (m > 255 || g > 255)) {
+        return QByteArray();
+    }
+    if (!text.isEmpty() || (m != -1 && isStringCommand(m))) {
+        if (text.size() > (version < 2 ? 16 : 255)) {
+            return QByteArray();
+        }
+        params |= HasString;
+    }
+
+    QByteArray frame;
+    frame.reserve(64);
+    if (version >= 2) {
+        appendLittleEndian(frame, quint16(params | Version2));
+        appendLittleEndian(frame, params2);
+        if (params & HasString) {
+            frame.append(char(text.size()));
+        }
+    } else {
+        appendLittleEndian(frame, params);
+    }
+    if (params & HasN) {
+        appendLittleEndian(frame, n);
+    }
+    if (params & HasM) {
+        if (version >= 2) {
+            appendLittleEndian(frame, quint16(m));
+        } else {
+            frame.append(char(m));
+        }
+    }
+    if (params & HasG) {
+        if (version >= 2) {
+            appendLittleEndian(frame, quint16(g));
+        } else {
+            frame.append(char(g));
+        }
+    }
+    for (const char *letter = _paramsLetters; *letter; ++letter) {
+        if (params & paramsBit(*letter)) {
+            appendFloat(frame, values[*letter - 'A']);
+        }
+    }
+    if (params & HasT) {
+        frame.append(char(t));
+    }
+    if (params & HasS) {
+        appendLittleEndian(frame, s);
+    }
+    if (params & HasP) {
+        appendLittleEndian(frame, p);
+    }
+    for (const char *letter = _params2Letters; *letter; ++letter) {
+        if (params2 & params2Bit(*letter)) {
+            appendFloat(frame, values[*letter - 'A']);
+        }
+    }
+    if (params & HasString) {
+        frame.append(text);
+        if (version < 2) {
+            // version 1 strings have a fixed size
+            frame.append(QByteArray(16 - text.size(), '\0'));
+        }
+    }
+
+    // Fletcher-16
+    quint16 sum1 = 0;
+    quint16 sum2 = 0;
+    for (const char c : frame) {
+        sum1 = (sum1 + uchar(c)) % 255;
+        sum2 = (sum2 + sum1) % 255;
+    }
+    frame.append(char(sum1));
+    frame.append(char(sum2));
+    return frame;
+}
+
+int RepetierPlugin::bufferSize() const
+{
+    // Repetier keeps a 64 byte input cache on 8-bit boards
+    return 63;
+}
+
+bool RepetierPlugin::supportsArcs() const
+{
+    return true;
+}
@@ -54,4 +54,44 @@ public:
      * @param lastMessage: last Message from printer
      */
     void validateCommand(const QString &lastMessage) override;
+
+    /**
+     * @brief Size of the firmware serial receive buffer
+     * @return 63
+     */
+    int bufferSize() const override;
+
+    /**
+     * @brief Repetier moves along G2 and G3 arcs
+     * @return true
+     */
+    bool supportsArcs() const override;
+
+    /**
+     * @brief Translate \p command to a binary frame once the firmware reported support for it
+     *
+     * Commands that can't be represented, and all commands while AtCore::lineNumbering()
+     * is enabled, are sent as ASCII.
+     * @param command: command to translate
+     * @return binary frame or the ASCII command
+     */
+    QByteArray translate(const QByteArray &command) override;
+    using IFirmware::translate;
+
+    /**
+     * @brief Check if \p command is a binary frame
+     * @param command: command returned by translate()
+     */
+    bool isBinary(const QByteArray &command) const override;
+
+    /**
+     * @brief Encode \p command with Repetier's binary protocol
+     * @param command: ASCII command
+     * @param version: binary protocol version, 1 or 2
+     * @return the binary frame, empty if \p command can't be represented
+     */
+    static QByteArray encodeBinary(const QByteArray &command, int version);
+
+private:
+    int binaryVersion = 0;  //!< @param binaryVersion: binary protocol version to send, 0 for ASCII
 };
@@ -39,3 +39,8 @@ SmoothiePlugin::SmoothiePlugin()
 {
     qCDebug(SMOOTHIE_PLUGIN) << name() << " plugin loaded!";
 }
+
+bool SmoothiePlugin::supportsArcs() const
+{
+    return true;
+}
@@ -48,4 +48,10 @@ public:
      * @return Smoothie
      */
     QString name() const override;
+
+    /**
+     * @brief Smoothie moves along G2 and G3 arcs
+     * @return true
+     */
+    bool supportsArcs() const override;
 };
@@ -39,3 +39,8 @@ SprinterPlugin::SprinterPlugin()
 {
     qCDebug(SPRINTER_PLUGIN) << name() << " plugin loaded!";
 }
+
+bool SprinterPlugin::supportsArcs() const
+{
+    return true;
+}
@@ -48,4 +48,10 @@ public:
      * @return Sprinter
      */
     QString name() const override;
+
+    /**
+     * @brief Sprinter moves along G2 and G3 arcs
+     * @return true
+     */
+    bool supportsArcs() const override;
 };
@@ -40,15 +40,15 @@ TeacupPlugin::TeacupPlugin()
     qCDebug(TEACUP_PLUGIN) << name() << " plugin loaded!";
 }
 
-QByteArray TeacupPlugin::translate(const QString &command)
+QByteArray TeacupPlugin::translate(const QByteArray &command)
 {
-    QString temp = command;
-    if (command.contains(QStringLiteral("M109"))) {
-        temp.replace(QStringLiteral("M109"), QStringLiteral("M104"));
-        temp.append(QStringLiteral("\r\nM116"));
-    } else if (command.contains(QStringLiteral("M190"))) {
-        temp.replace(QStringLiteral("M190"), QStringLiteral("M140"));
-        temp.append(QStringLiteral("\r\nM116"));
+    QByteArray temp = command;
+    if (command.contains("M109")) {
+        temp.replace("M109", "M104");
+        temp.append("\r\nM116");
+    } else if (command.contains("M190")) {
+        temp.replace("M190", "M140");
+        temp.append("\r\nM116");
     }
-    return temp.toLocal8Bit();
+    return temp;
 }
@@ -54,5 +54,6 @@ public:
      * @param command: command to translate
      * @return firmware specific translated command
      */
-    QByteArray translate(const QString &command) override;
+    QByteArray translate(const QByteArray &command) override;
+    using IFirmware::translate;
 };
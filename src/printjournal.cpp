@@ -0,0 +1,422 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+
+#if defined(Q_OS_UNIX)
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <io.h>
+#endif
+
+#include "gcodeline.h"
+#include "printjournal.h"
+
+Q_LOGGING_CATEGORY(PRINT_JOURNAL, "org.kde.atelier.core.printJournal")
+
+namespace
+{
+const quint32 _magic = 0x41544a4c; // "ATJL"
+const quint16 _version = 1;
+const int _headerSize = 32;
+const int _slotSize = 64;
+
+/**
+ * @brief Apply \p command to the modal \p state
+ */
+void track(PrintJournal::State &state, const QByteArray &command)
+{
+    GCodeLine line;
+    if (!line.parse(command)) {
+        return;
+    }
+    const char letter = line.letter();
+    const int code = line.code();
+
+    if (letter == 'G') {
+        switch (code) {
+        case 0:
+        case 1:
+        case 2:
+        case 3:
+            if (line.has('X')) {
+                state.x = float(state.relative ? state.x + line.value('X') : line.value('X'));
+            }
+            if (line.has('Y')) {
+                state.y = float(state.relative ? state.y + line.value('Y') : line.value('Y'));
+            }
+            if (line.has('Z')) {
+                state.z = float(state.relative ? state.z + line.value('Z') : line.value('Z'));
+            }
+            if (line.has('E')) {
+                state.e = float(state.relative || state.relativeE ? state.e + line.value('E') : line.value('E'));
+            }
+            if (line.has('F')) {
+                state.feedrate = float(line.value('F'));
+            }
+            break;
+        case 28: {
+            const bool all = !line.has('X') && !line.has('Y') && !line.has('Z');
+            state.x = all || line.has('X') ? 0 : state.x;
+            state.y = all || line.has('Y') ? 0 : state.y;
+            state.z = all || line.has('Z') ? 0 : state.z;
+            break;
+        }
+        case 90:
+            state.relative = false;
+            break;
+        case 91:
+            state.relative = true;
+            break;
+        case 92:
+            state.x = line.has('X') ? float(line.value('X')) : state.x;
+            state.y = line.has('Y') ? float(line.value('Y')) : state.y;
+            state.z = line.has('Z') ? float(line.value('Z')) : state.z;
+            state.e = line.has('E') ? float(line.value('E')) : state.e;
+            break;
+        default:
+            break;
+        }
+    } else if (letter == 'M') {
+        switch (code) {
+        case 82:
+            state.relativeE = false;
+            break;
+        case 83:
+            state.relativeE = true;
+            break;
+        case 104:
+        case 109:
+            if (line.has('S') && (!line.has('T') || int(line.value('T')) == state.tool)) {
+                state.extruderTemp = float(line.value('S'));
+            }
+            break;
+        case 140:
+        case 190:
+            if (line.has('S')) {
+                state.bedTemp = float(line.value('S'));
+            }
+            break;
+        case 106:
+            state.fanSpeed = line.has('S') ? int(line.value('S')) : 255;
+            break;
+        case 107:
+            state.fanSpeed = 0;
+            break;
+        default:
+            break;
+        }
+    } else if (letter == 'T') {
+        state.tool = code;
+    }
+}
+
+/**
+ * @brief Flush \p file down to the disk
+ */
+bool syncFile(QFile &file)
+{
+    if (!file.flush()) {
+        return false;
+    }
+#if defined(Q_OS_LINUX)
+    return ::fdatasync(file.handle()) == 0;
+#elif defined(Q_OS_UNIX)
+    return ::fsync(file.handle()) == 0;
+#elif defined(Q_OS_WIN)
+    return ::_commit(file.handle()) == 0;
+#else
+    return true;
+#endif
+}
+
+/**
+ * @brief A record as stored in a slot
+ */
+QByteArray encodeRecord(quint32 sequence, const PrintJournal::State &state)
+{
+    QByteArray record;
+    record.reserve(_slotSize);
+    QDataStream out(&record, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_4);
+    out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    out << sequence << state.offset << state.x << state.y << state.z << state.e << state.feedrate
+        << state.extruderTemp << state.bedTemp << qint32(state.fanSpeed) << qint32(state.tool)
+        << quint8(state.relative) << quint8(state.relativeE);
+    out << qChecksum(record.constData(), uint(record.size()));
+    record.resize(_slotSize);
+    return record;
+}
+
+/**
+ * @brief Read a slot written by encodeRecord()
+ * @return False if the slot is empty or torn
+ */
+bool decodeRecord(const QByteArray &record, quint32 &sequence, PrintJournal::State &state)
+{
+    QDataStream in(record);
+    in.setVersion(QDataStream::Qt_5_4);
+    in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    qint32 fanSpeed = 0;
+    qint32 tool = 0;
+    quint8 relative = 0;
+    quint8 relativeE = 0;
+    in >> sequence >> state.offset >> state.x >> state.y >> state.z >> state.e >> state.feedrate
+       >> state.extruderTemp >> state.bedTemp >> fanSpeed >> tool >> relative >> relativeE;
+    const int size = int(in.device()->pos());
+    quint16 checksum = 0;
+    in >> checksum;
+    if (in.status() != QDataStream::Ok || sequence == 0 || checksum != qChecksum(record.constData(), uint(size))) {
+        return false;
+    }
+    state.fanSpeed = fanSpeed;
+    state.tool = tool;
+    state.relative = relative;
+    state.relativeE = relativeE;
+    return true;
+}
+
+/**
+ * @brief Size and modification time of a job, the journal is only valid for them
+ */
+QByteArray encodeHeader(const QString &jobFile)
+{
+    const QFileInfo info(jobFile);
+    QByteArray header;
+    QDataStream out(&header, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_4);
+    out << _magic << _version << info.size() << info.lastModified().toMSecsSinceEpoch();
+    header.resize(_headerSize);
+    return header;
+}
+}
+
+class JournalWriter;
+/**
+ * @brief The PrintJournalPrivate class
+ */
+class PrintJournalPrivate
+{
+public:
+    QString jobFile;                    //!< @param jobFile: the gcode file being printed
+    QFile file;                         //!< @param file: the journal file
+    PrintJournal::State state;          //!< @param state: state after the last acknowledged command
+    JournalWriter *writer = nullptr;    //!< @param writer: thread committing the records
+    quint32 sequence = 0;               //!< @param sequence: number of the last record written
+    QAtomicInt commits;                 //!< @param commits: records written
+
+    QMutex mutex;                       //!< @param mutex: guards the members below
+    QWaitCondition wake;                //!< @param wake: wakes the writer
+    PrintJournal::State pending;        //!< @param pending: state to commit next
+    bool dirty = false;                 //!< @param dirty: pending was not committed yet
+    bool stopping = false;              //!< @param stopping: the writer commits what is pending and quits
+    int commitInterval = 250;           //!< @param commitInterval: longest wait before a commit in ms
+
+    /**
+     * @brief Write \p state to the next slot and sync it
+     */
+    void commit(const PrintJournal::State &state)
+    {
+        sequence++;
+        file.seek(_headerSize + (sequence % 2) * _slotSize);
+        if (file.write(encodeRecord(sequence, state)) != _slotSize || !syncFile(file)) {
+            qCDebug(PRINT_JOURNAL) << "Can't write the journal" << file.fileName();
+            return;
+        }
+        commits.ref();
+    }
+};
+
+/**
+ * @brief Commits the records of a PrintJournal
+ */
+class JournalWriter : public QThread
+{
+public:
+    explicit JournalWriter(PrintJournalPrivate *journal) : d(journal)
+    {
+    }
+
+protected:
+    void run() override
+    {
+        QMutexLocker lock(&d->mutex);
+        for (;;) {
+            while (!d->dirty && !d->stopping) {
+                d->wake.wait(&d->mutex);
+            }
+            if (!d->dirty) {
+                break;
+            }
+            if (!d->stopping) {
+                // let the acknowledges of the next moments join this commit
+                d->wake.wait(&d->mutex, ulong(d->commitInterval));
+            }
+            const PrintJournal::State state = d->pending;
+            d->dirty = false;
+            lock.unlock();
+            d->commit(state);
+            lock.relock();
+        }
+    }
+
+private:
+    PrintJournalPrivate *d;
+};
+
+PrintJournal::PrintJournal(const QString &jobFile) :
+    d(new PrintJournalPrivate)
+{
+    d->jobFile = jobFile;
+    d->file.setFileName(journalFileName(jobFile));
+}
+
+PrintJournal::~PrintJournal()
+{
+    if (d->writer) {
+        {
+            QMutexLocker lock(&d->mutex);
+            d->stopping = true;
+            d->wake.wakeOne();
+        }
+        d->writer->wait();
+        delete d->writer;
+    }
+    delete d;
+}
+
+QString PrintJournal::journalFileName(const QString &jobFile)
+{
+    return jobFile + QStringLiteral(".atjournal");
+}
+
+bool PrintJournal::read(const QString &jobFile, PrintJournal::State &state)
+{
+    QFile file(journalFileName(jobFile));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    if (file.read(_headerSize) != encodeHeader(jobFile)) {
+        qCDebug(PRINT_JOURNAL) << "Journal" << file.fileName() << "is for another version of the job";
+        return false;
+    }
+
+    quint32 last = 0;
+    for (int slot = 0; slot < 2; slot++) {
+        quint32 sequence = 0;
+        PrintJournal::State record;
+        if (decodeRecord(file.read(_slotSize), sequence, record) && sequence > last) {
+            last = sequence;
+            state = record;
+        }
+    }
+    return last != 0;
+}
+
+bool PrintJournal::start(const PrintJournal::State &state)
+{
+    if (d->writer) {
+        return true;
+    }
+    if (!d->file.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        qCDebug(PRINT_JOURNAL) << "Can't create the journal" << d->file.fileName();
+        return false;
+    }
+    d->state = state;
+    d->sequence = 0;
+    d->stopping = false;
+    d->dirty = false;
+    d->file.write(encodeHeader(d->jobFile));
+    d->file.write(QByteArray(2 * _slotSize, '\0'));
+    d->commit(state);
+
+    d->writer = new JournalWriter(d);
+    d->writer->start(QThread::LowPriority);
+    return true;
+}
+
+bool PrintJournal::isActive() const
+{
+    return d->writer != nullptr;
+}
+
+void PrintJournal::acknowledged(const QByteArray &command, qint64 offset)
+{
+    track(d->state, command);
+    d->state.offset = offset;
+    if (!d->writer) {
+        return;
+    }
+    QMutexLocker lock(&d->mutex);
+    d->pending = d->state;
+    if (!d->dirty) {
+        d->dirty = true;
+        d->wake.wakeOne();
+    }
+}
+
+void PrintJournal::finish()
+{
+    if (!d->writer) {
+        return;
+    }
+    {
+        QMutexLocker lock(&d->mutex);
+        d->stopping = true;
+        d->dirty = false;
+        d->wake.wakeOne();
+    }
+    d->writer->wait();
+    delete d->writer;
+    d->writer = nullptr;
+    d->file.close();
+    d->file.remove();
+}
+
+const PrintJournal::State &PrintJournal::state() const
+{
+    return d->state;
+}
+
+int PrintJournal::commitInterval() const
+{
+    return d->commitInterval;
+}
+
+void PrintJournal::setCommitInterval(int msecs)
+{
+    QMutexLocker lock(&d->mutex);
+    d->commitInterval = qMax(0, msecs);
+}
+
+int PrintJournal::commits() const
+{
+    return d->commits.load();
+}
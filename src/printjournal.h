@@ -0,0 +1,140 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+#include "atcore_export.h"
+
+class PrintJournalPrivate;
+/**
+ * @brief The PrintJournal class
+ * Records how far a host-streamed print got, so it can be resumed after the
+ * host or the printer went down.
+ *
+ * Each command acknowledged by the firmware is passed to acknowledged(), which
+ * keeps the byte offset after it and the modal state the job set up to that
+ * point: position, E, feedrate, modes, temperatures and fan.
+ *
+ * Records are written by a thread of their own. It commits at most once per
+ * commitInterval() with a single fsync, folding all the acknowledges received
+ * meanwhile into it, so streaming never waits on the disk. Records go to two
+ * slots in turn, a write torn by a power loss leaves the other one intact.
+ */
+class ATCORE_EXPORT PrintJournal
+{
+public:
+    /**
+     * @brief Modal state of the job after an acknowledged command
+     */
+    struct State {
+        qint64 offset = 0;          //!< @param offset: byte offset after the last acknowledged command
+        float x = 0;                //!< @param x: X position
+        float y = 0;                //!< @param y: Y position
+        float z = 0;                //!< @param z: Z position
+        float e = 0;                //!< @param e: E position
+        float feedrate = 0;         //!< @param feedrate: last F word, 0 if none
+        float extruderTemp = 0;     //!< @param extruderTemp: extruder target temperature
+        float bedTemp = 0;          //!< @param bedTemp: bed target temperature
+        int fanSpeed = 0;           //!< @param fanSpeed: fan speed, 0-255
+        int tool = 0;               //!< @param tool: active extruder
+        bool relative = false;      //!< @param relative: G91 is active
+        bool relativeE = false;     //!< @param relativeE: M83 is active
+    };
+
+    /**
+     * @brief Create a journal for a job
+     * @param jobFile: the gcode file being printed
+     */
+    explicit PrintJournal(const QString &jobFile);
+
+    /**
+     * @brief Commit the last record and stop the writer
+     */
+    ~PrintJournal();
+
+    /**
+     * @brief Journal file used for \p jobFile
+     */
+    static QString journalFileName(const QString &jobFile);
+
+    /**
+     * @brief Read the last record of the journal of \p jobFile
+     * @param jobFile: the gcode file that was printed
+     * @param state: filled with the last committed state
+     * @return False if there is no journal or it belongs to another version of the file
+     */
+    static bool read(const QString &jobFile, State &state);
+
+    /**
+     * @brief Create the journal file and start the writer
+     * @param state: state the job starts from, the default one for a new print
+     * @return False if the journal file can't be written
+     */
+    bool start(const State &state = State());
+
+    /**
+     * @brief True between start() and finish()
+     */
+    bool isActive() const;
+
+    /**
+     * @brief Track a command the firmware acknowledged
+     * @param command: the command as sent, without line number
+     * @param offset: byte offset after the command in the job file
+     */
+    void acknowledged(const QByteArray &command, qint64 offset);
+
+    /**
+     * @brief The job finished or was stopped, delete the journal file
+     */
+    void finish();
+
+    /**
+     * @brief Modal state after the last acknowledged command
+     */
+    const State &state() const;
+
+    /**
+     * @brief Longest time between an acknowledge and its commit, in ms
+     */
+    int commitInterval() const;
+
+    /**
+     * @brief Set the longest time between an acknowledge and its commit
+     * @param msecs: time in ms, more folds more acknowledges into one fsync
+     */
+    void setCommitInterval(int msecs);
+
+    /**
+     * @brief Records written so far
+     */
+    int commits() const;
+
+private:
+    PrintJournal(const PrintJournal &) = delete;
+    PrintJournal &operator=(const PrintJournal &) = delete;
+    PrintJournalPrivate *d;
+};
@@ -20,12 +20,27 @@
     You should have received a copy of the GNU Lesser General Public
     License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 */
+#include <QElapsedTimer>
 #include <QTime>
 #include <QLoggingCategory>
+#include <QTimer>
 
 #include "printthread.h"
+#include "arcfitter.h"
+#include "gcodeminifier.h"
+#include "gcodepipeline.h"
+#include "gcodeindex.h"
+#include "gcodereader.h"
+#include "printtimeestimator.h"
 
 Q_LOGGING_CATEGORY(PRINT_THREAD, "org.kde.atelier.core.printThread")
+
+namespace
+{
+// lines read at once when the job goes through a pipeline
+const int _batchSize = 64;
+}
+
 /**
  * @brief The PrintThreadPrivate class
  */
@@ -33,56 +48,159 @@ class PrintThreadPrivate
 {
 public:
     AtCore *core = nullptr;             //!<@param core: Pointer to AtCore
-    QTextStream *gcodestream = nullptr; //!<@param gcodestream: Steam the job is read from
+    GCodeReader *reader = nullptr;      //!<@param reader: memory mapped or decompressed job file
+    GCodeIndex index;                   //!<@param index: line offsets and layers of the job
+    QString fileName;                   //!<@param fileName: job file
+    qint64 startOffset = 0;             //!<@param startOffset: byte offset the job continues from
+    qint64 startLine = -1;              //!<@param startLine: line the job continues from, -1 if not set
+    int startLayer = -1;                //!<@param startLayer: layer the job continues from, -1 if not set
+    int layer = -1;                     //!<@param layer: layer being printed
+    PrintTimeEstimator *estimator = nullptr; //!<@param estimator: print time of the job, estimated in the background
+    int remaining = -1;                 //!<@param remaining: last time left reported in s
     float printProgress = 0;            //!<@param printProgress: Progress of the print job
-    qint64 totalSize = 0;               //!<@param totalSize: total file size
-    qint64 stillSize = 0;               //!<@param stillSize: remaining file
-    QString cline;                      //!<@param cline: current line
+    float reportedProgress = -1;        //!<@param reportedProgress: last progress published
+    float startProgress = 0;            //!<@param startProgress: progress of a resumed job where it continued
+    QElapsedTimer progressTimer;        //!<@param progressTimer: time since progress was last published
+    QTimer *progressTick = nullptr;     //!<@param progressTick: publishes progress while no lines are read
+    int progressInterval = 250;         //!<@param progressInterval: longest time between two progress updates in ms
+    float progressStep = 0.1f;          //!<@param progressStep: progress change published right away
+    QByteArray command;                 //!<@param command: current command, reused for every line
     AtCore::STATES state = AtCore::IDLE;//!<@param state: printer state
-    QFile *file = nullptr;              //!<@param file: gcode File to stream from
+    QSharedPointer<PrintJob> job;       //!<@param job: lookahead queue shared with AtCore
+    bool ended = false;                 //!<@param ended: endPrint() was called
+    GCodePipeline pipeline;             //!<@param pipeline: stages lines go through before they are queued
+    QVector<GCodeFilter::Line> batch;   //!<@param batch: lines out of the pipeline not queued yet
+    int batchQueued = 0;                //!<@param batchQueued: lines of batch already queued
+    bool flushed = false;               //!<@param flushed: the pipeline returned the lines it held back
+    ArcFitter *arcFitter = nullptr;     //!<@param arcFitter: pipeline stage replacing G1 runs by arcs, nullptr if disabled
+    GCodeMinifier *minifier = nullptr;  //!<@param minifier: pipeline stage shortening commands, nullptr if disabled
 };
 
 PrintThread::PrintThread(AtCore *parent, QString fileName) : d(new PrintThreadPrivate)
 {
     d->core = parent;
     d->state = d->core->state();
-    d->file = new QFile(fileName);
-    d->file->open(QFile::ReadOnly);
-    d->totalSize = d->file->bytesAvailable();
-    d->stillSize = d->totalSize;
-    d->gcodestream = new QTextStream(d->file);
+    d->fileName = fileName;
+    d->reader = new GCodeReader(fileName);
+    if (!d->reader->open()) {
+        qCDebug(PRINT_THREAD) << "Can't read" << fileName;
+    }
+    d->command.reserve(256);
+    d->estimator = new PrintTimeEstimator(this);
+    d->estimator->setLimits(d->core->printTimeEstimator().limits());
+    d->job = QSharedPointer<PrintJob>::create();
+}
+
+PrintThread::~PrintThread()
+{
+    delete d->reader;
+    delete d;
+}
+
+void PrintThread::seekToLine(qint64 line)
+{
+    d->startOffset = 0;
+    d->startLine = line;
+    d->startLayer = -1;
+}
+
+void PrintThread::seekToLayer(int layer)
+{
+    d->startOffset = 0;
+    d->startLine = -1;
+    d->startLayer = layer;
+}
+
+void PrintThread::seek(qint64 offset)
+{
+    d->startOffset = qMax(offset, qint64(0));
+    d->startLine = -1;
+    d->startLayer = -1;
+}
+
+QSharedPointer<PrintJob> PrintThread::job() const
+{
+    return d->job;
+}
+
+void PrintThread::setProgressRate(int msecs, float step)
+{
+    d->progressInterval = qMax(0, msecs);
+    d->progressStep = qMax(0.0f, step);
+}
+
+void PrintThread::addFilter(GCodeFilter *filter)
+{
+    d->pipeline.addFilter(filter);
+}
+
+void PrintThread::setArcFitting(double tolerance)
+{
+    if (!d->arcFitter) {
+        d->arcFitter = new ArcFitter;
+        d->pipeline.addFilter(d->arcFitter);
+    }
+    d->arcFitter->setTolerance(tolerance);
+}
+
+void PrintThread::setMinifying(bool compactWords)
+{
+    if (!d->minifier) {
+        d->minifier = new GCodeMinifier;
+        d->pipeline.addFilter(d->minifier);
+    }
+    d->minifier->setCompactWords(compactWords);
 }
 
 void PrintThread::start()
 {
-    // we only want to do this when printing
-    connect(d->core->firmwarePlugin(), &IFirmware::readyForCommand, this, &PrintThread::processJob, Qt::QueuedConnection);
-    connect(this, &PrintThread::nextCommand, d->core, &AtCore::pushCommand, Qt::QueuedConnection);
+    // a big job is indexed here, away from the gui thread
+    if (!d->index.isValid() && !d->index.open(d->fileName)) {
+        qCDebug(PRINT_THREAD) << "Can't index" << d->fileName;
+    }
+    bool found = true;
+    if (d->startLine != -1) {
+        found = d->index.seekToLine(*d->reader, d->startLine);
+    } else if (d->startLayer != -1) {
+        found = d->index.seekToLayer(*d->reader, d->startLayer);
+    } else if (d->startOffset > 0) {
+        found = d->reader->seek(d->startOffset);
+    }
+    if (!found) {
+        qCDebug(PRINT_THREAD) << "Can't continue" << d->fileName << "at line" << d->startLine << "layer" << d->startLayer << "byte" << d->startOffset;
+        d->reader->seek(0);
+    }
+    d->startOffset = d->reader->position();
+    if (d->startOffset > 0) {
+        d->job->sentOffset = d->startOffset;
+        d->job->sentFileOffset = d->reader->filePosition();
+        const qint64 fileSize = d->reader->fileSize();
+        d->startProgress = fileSize ? float(d->job->sentFileOffset) * 100.0f / float(fileSize) : 0;
+    }
+    // the sidecar index is reused, only what is left of a resumed job is estimated
+    d->estimator->start(d->fileName, d->startOffset);
     connect(this, &PrintThread::stateChanged, d->core, &AtCore::setState, Qt::QueuedConnection);
     connect(d->core, &AtCore::stateChanged, this, &PrintThread::setState, Qt::QueuedConnection);
     connect(this, &PrintThread::finished, this, &PrintThread::deleteLater);
-    // force a command if the printer doesn't send "wait" when idle
+    d->progressTick = new QTimer(this);
+    d->progressTick->setInterval(qMax(10, d->progressInterval));
+    connect(d->progressTick, &QTimer::timeout, this, &PrintThread::publishProgress);
+    d->progressTick->start();
     processJob();
 }
 
 void PrintThread::processJob()
 {
-    if (d->gcodestream->atEnd()) {
-        endPrint();
-    }
-
+    d->job->wakePending = false;
     switch (d->state) {
     case AtCore::STARTPRINT:
     case AtCore::IDLE:
     case AtCore::BUSY:
         setState(AtCore::BUSY);
-        nextLine();
-        while (d->cline.isEmpty() && !d->gcodestream->atEnd()) {
-            nextLine();
-        }
-        if (!d->cline.isEmpty()) {
-            qCDebug(PRINT_THREAD) << "cline:" << d->cline;
-            emit nextCommand(d->cline);
+        fillQueue();
+        if (allQueued() && d->job->commands.isEmpty()) {
+            //AtCore sent every command
+            endPrint();
         }
         break;
 
@@ -104,12 +222,93 @@ void PrintThread::processJob()
     }
 }
 
+void PrintThread::fillQueue()
+{
+    const bool wasEmpty = d->job->commands.isEmpty();
+    bool queued = false;
+    auto &commands = d->job->commands;
+    // a line at a time, the queue is never full after a failed read
+    while (commands.size() < commands.capacity()) {
+        if (d->pipeline.isEmpty()) {
+            //no stages, lines go from the file to the queue one by one
+            if (d->reader->atEnd()) {
+                break;
+            }
+            nextLine();
+            queued = queueCommand(d->command, d->reader->position(), d->reader->filePosition()) || queued;
+            continue;
+        }
+        if (d->batchQueued < d->batch.size()) {
+            const GCodeFilter::Line &line = d->batch.at(d->batchQueued++);
+            queued = queueCommand(line.command, line.offset, line.fileOffset) || queued;
+            continue;
+        }
+        if (!readBatch()) {
+            break;
+        }
+    }
+    if (queued && wasEmpty) {
+        //AtCore may be waiting for the job, acknowledges drive it otherwise
+        emit commandsQueued();
+    }
+    publishProgress();
+}
+
+bool PrintThread::readBatch()
+{
+    d->batch.resize(0);
+    d->batchQueued = 0;
+    if (d->reader->atEnd()) {
+        if (d->flushed) {
+            return false;
+        }
+        d->flushed = true;
+        d->pipeline.flush(d->batch);
+        return true;
+    }
+    while (d->batch.size() < _batchSize && !d->reader->atEnd()) {
+        nextLine();
+        if (!d->command.isEmpty()) {
+            d->batch.append({d->command, d->reader->position(), d->reader->filePosition()});
+        }
+    }
+    d->pipeline.process(d->batch);
+    return true;
+}
+
+bool PrintThread::allQueued() const
+{
+    if (d->pipeline.isEmpty()) {
+        return d->reader->atEnd();
+    }
+    return d->flushed && d->batchQueued == d->batch.size();
+}
+
 void PrintThread::endPrint()
 {
+    if (d->ended) {
+        return;
+    }
+    d->ended = true;
+    if (d->progressTick) {
+        d->progressTick->stop();
+    }
     emit(printProgressChanged(100));
     qCDebug(PRINT_THREAD) << "atEnd";
-    disconnect(d->core->firmwarePlugin(), &IFirmware::readyForCommand, this, &PrintThread::processJob);
-    disconnect(this, &PrintThread::nextCommand, d->core, &AtCore::pushCommand);
+    if (d->arcFitter) {
+        qCDebug(PRINT_THREAD) << d->arcFitter->replacedMoves() << "moves sent as" << d->arcFitter->arcs() << "arcs";
+    }
+    if (d->minifier) {
+        qCDebug(PRINT_THREAD) << "Minified" << d->minifier->bytesIn() << "bytes to" << d->minifier->bytesOut();
+        emit(printMinified(d->minifier->bytesIn() - d->minifier->bytesOut(), d->minifier->bytesIn()));
+    }
+    if (!d->pipeline.isEmpty()) {
+        const QVector<GCodePipeline::StageStats> stages = d->pipeline.stats();
+        for (const GCodePipeline::StageStats &stage : stages) {
+            qCDebug(PRINT_THREAD) << "Stage" << stage.name << stage.linesIn << "lines in" << stage.linesOut << "out in" << stage.nsecs / 1000000 << "ms";
+        }
+        emit(printPipelineStats(stages));
+    }
     disconnect(d->core, &AtCore::stateChanged, this, &PrintThread::setState);
     emit(stateChanged(AtCore::FINISHEDPRINT));
     emit(stateChanged(AtCore::IDLE));
@@ -119,16 +318,55 @@ void PrintThread::endPrint()
 }
 void PrintThread::nextLine()
 {
-    d->cline = d->gcodestream->readLine();
-    qCDebug(PRINT_THREAD) << "Nextline:" << d->cline;
-    d->stillSize -= d->cline.size() + 1; //remove read chars
-    d->printProgress = float(d->totalSize - d->stillSize) * 100.0 / float(d->totalSize);
-    qCDebug(PRINT_THREAD) << "progress:" << QString::number(d->printProgress);
-    emit(printProgressChanged(d->printProgress));
-    if (d->cline.contains(QChar::fromLatin1(';'))) {
-        d->cline.resize(d->cline.indexOf(QChar::fromLatin1(';')));
+    d->reader->readCommand(d->command);
+}
+
+bool PrintThread::queueCommand(const QByteArray &command, qint64 offset, qint64 fileOffset)
+{
+    if (command.isEmpty()) {
+        return false;
+    }
+    qCDebug(PRINT_THREAD) << "Nextline:" << command;
+    d->job->commands.push({command, offset, fileOffset});
+    return true;
+}
+
+void PrintThread::publishProgress()
+{
+    if (d->ended) {
+        return;
+    }
+    const qint64 offset = d->job->sentOffset;
+    const auto &layers = d->index.layers();
+    const int layer = d->index.layerAt(offset);
+    if (layer != d->layer && !layers.isEmpty()) {
+        d->layer = layer;
+        emit(printLayerChanged(d->layer, layers.size()));
+    }
+    if (d->estimator->isReady() && d->estimator->totalTime() > 0) {
+        //time based once the estimate is there, over what was left of a resumed job
+        const double total = d->estimator->totalTime();
+        const double done = d->estimator->timeAt(offset);
+        d->printProgress = d->startProgress + float(done / total) * (100 - d->startProgress);
+        const int remaining = qRound(total - done);
+        if (remaining != d->remaining) {
+            d->remaining = remaining;
+            emit(printTimeRemainingChanged(remaining));
+        }
+    } else {
+        //bytes of the file on disk, the progress reaches 100 on the last line
+        const qint64 fileSize = d->reader->fileSize();
+        d->printProgress = fileSize ? float(d->job->sentFileOffset) * 100.0 / float(fileSize) : 100;
+    }
+    //bytes and time disagree when the estimate gets ready, progress never goes back
+    d->printProgress = qMax(d->printProgress, d->reportedProgress);
+    if (d->printProgress - d->reportedProgress >= d->progressStep
+            || (d->printProgress != d->reportedProgress && (!d->progressTimer.isValid() || d->progressTimer.elapsed() >= d->progressInterval))) {
+        qCDebug(PRINT_THREAD) << "progress:" << QString::number(d->printProgress);
+        d->reportedProgress = d->printProgress;
+        d->progressTimer.start();
+        emit(printProgressChanged(d->printProgress));
     }
-    d->cline = d->cline.simplified();
 }
 
 void PrintThread::setState(const AtCore::STATES &newState)
@@ -148,5 +386,9 @@ void PrintThread::setState(const AtCore::STATES &newState)
         d->state = newState;
         emit(stateChanged(d->state));
         connect(d->core, &AtCore::stateChanged, this, &PrintThread::setState, Qt::QueuedConnection);
+        if (d->state == AtCore::STOP) {
+            //AtCore doesn't ask for more commands once stopped
+            endPrint();
+        }
     }
 }
@@ -22,10 +22,35 @@
 */
 #pragma once
 
-#include <QTextStream>
-#include <QFile>
+#include <QSharedPointer>
+#include <atomic>
 
 #include "atcore.h"
+#include "gcodepipeline.h"
+#include "spscqueue.h"
+
+/**
+ * @brief A command of a print job, read ahead by a PrintThread
+ */
+struct PrintJobCommand {
+    QByteArray command;                 //!< @param command: the command
+    qint64 offset;                      //!< @param offset: byte offset after it in the job file
+    qint64 fileOffset;                  //!< @param fileOffset: offset in the file on disk, compressed or not, for progress
+};
+
+/**
+ * @brief Commands read ahead by a PrintThread and sent by AtCore
+ *
+ * The PrintThread fills the queue and AtCore::processQueue() drains it. AtCore
+ * wakes the PrintThread only once the queue falls below lowWater.
+ */
+struct PrintJob {
+    SpscQueue<PrintJobCommand> commands{256};   //!< @param commands: commands read ahead
+    int lowWater = 64;                          //!< @param lowWater: AtCore asks for more below this many commands
+    std::atomic<bool> wakePending{false};       //!< @param wakePending: AtCore asked for more, the PrintThread didn't read on yet
+    std::atomic<qint64> sentOffset{0};          //!< @param sentOffset: byte offset after the last command AtCore sent
+    std::atomic<qint64> sentFileOffset{0};      //!< @param sentFileOffset: fileOffset of the last command AtCore sent
+};
 
 class PrintThreadPrivate;
 /**
@@ -45,6 +70,66 @@ public:
      * @param fileName: gcode File to print
      */
     PrintThread(AtCore *parent, QString fileName);
+    ~PrintThread() override;
+
+    /**
+     * @brief Continue the job from a line instead of the start
+     * Call it before start(). start() indexes the job on the print thread, which makes
+     * the seek a jump rather than a scan. A line the job doesn't have prints it from the start.
+     * @param line: line number, from 0
+     */
+    void seekToLine(qint64 line);
+
+    /**
+     * @brief Continue the job from the start of a layer
+     * Call it before start(), the seek happens in start() like for seekToLine().
+     * @param layer: layer number, from 0
+     */
+    void seekToLayer(int layer);
+
+    /**
+     * @brief Continue the job from a byte offset, as kept by a PrintJournal
+     * Call it before start(), the seek itself happens in start() as compressed jobs
+     * are decompressed up to \p offset.
+     * @param offset: offset of a line start in the job file
+     */
+    void seek(qint64 offset);
+
+    /**
+     * @brief Limit how often printProgressChanged() is emitted
+     *
+     * Progress is published when \p msecs have passed or it moved by \p step, whichever comes first.
+     * The final 100 is always published.
+     * @param msecs: longest time between two updates, in ms
+     * @param step: progress change published right away, in percent
+     */
+    void setProgressRate(int msecs, float step);
+
+    /**
+     * @brief Run the job through a stage before it is sent, see GCodePipeline
+     * Call before start(), stages run in the order they were added.
+     * @param filter: the stage, the print thread takes ownership of it
+     */
+    void addFilter(GCodeFilter *filter);
+
+    /**
+     * @brief Replace runs of G1 moves along an arc by G2 and G3, see ArcFitter
+     * Call before start(), after addFilter().
+     * @param tolerance: largest distance of a move from its arc in mm
+     */
+    void setArcFitting(double tolerance);
+
+    /**
+     * @brief Send commands as short as possible, see GCodeMinifier
+     * Call before start(), after the other stages were added.
+     * @param compactWords: drop the spaces between words too
+     */
+    void setMinifying(bool compactWords);
+
+    /**
+     * @brief The lookahead queue of the job, for AtCore
+     */
+    QSharedPointer<PrintJob> job() const;
 signals:
     /**
     * @brief Print job has finished
@@ -63,10 +148,36 @@ signals:
     void printProgressChanged(float);
 
     /**
-     * @brief the next command of the job
-     * @param comm: Command to be sent next
+     * @brief The job reached a new layer
+     * @param layer: layer being printed, from 0
+     * @param layerCount: number of layers in the job
+     */
+    void printLayerChanged(int layer, int layerCount);
+
+    /**
+     * @brief The estimated time left changed
+     * @param seconds: time left to print the job
+     */
+    void printTimeRemainingChanged(int seconds);
+
+    /**
+     * @brief Bytes the minifier saved, at the end of the job
+     * @param savedBytes: bytes not sent
+     * @param jobBytes: bytes of the commands before minifying
      */
-    void nextCommand(const QString &comm);
+    void printMinified(qint64 savedBytes, qint64 jobBytes);
+
+    /**
+     * @brief Counters of the pipeline stages, at the end of the job
+     * Not emitted if the job went through no stage.
+     * @param stages: counters of each stage, in order
+     */
+    void printPipelineStats(const QVector<GCodePipeline::StageStats> &stages);
+
+    /**
+     * @brief Commands were added to an empty job() queue
+     */
+    void commandsQueued();
 
     /**
      * @brief Printer state was changed
@@ -79,11 +190,17 @@ public slots:
      * @brief start the print thread
      */
     void start();
-private slots:
+
     /**
-     * @brief process the current job
+     * @brief Read ahead into the job() queue until it is full
+     * Connect to AtCore asking for more commands.
      */
     void processJob();
+private slots:
+    /**
+     * @brief Publish progress, layer and time left as far as AtCore sent the job
+     */
+    void publishProgress();
 
     /**
      * @brief Set printer state
@@ -97,6 +214,32 @@ private:
      */
     void nextLine();
 
+    /**
+     * @brief Push a command to the job() queue
+     * @param command: the command
+     * @param offset: byte offset after it in the job file
+     * @param fileOffset: offset after it in the file on disk
+     * @return False if the command was empty
+     */
+    bool queueCommand(const QByteArray &command, qint64 offset, qint64 fileOffset);
+
+    /**
+     * @brief Read the next batch of lines and run it through the pipeline
+     * Once the file ended, the batch is what the stages held back.
+     * @return False if there is nothing left to read
+     */
+    bool readBatch();
+
+    /**
+     * @brief Read lines into the job() queue until it is full or the file ends
+     */
+    void fillQueue();
+
+    /**
+     * @brief True once every line of the file is in the job() queue
+     */
+    bool allQueued() const;
+
     /**
      * @brief end the print
      */
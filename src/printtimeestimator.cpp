@@ -0,0 +1,687 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QLoggingCategory>
+#include <QThread>
+#include <QVector>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#include "gcodereader.h"
+#include "gcodedecompressor.h"
+#include "gcodechunkparser.h"
+#include "printtimeestimator.h"
+
+Q_LOGGING_CATEGORY(PRINT_TIME_ESTIMATOR, "org.kde.atelier.core.printTimeEstimator")
+
+namespace
+{
+// Lowest speed through a junction, as Marlin's MINIMUM_PLANNER_SPEED
+const double _minimumPlannerSpeed = 0.05;
+const double _pi = 3.14159265358979323846;
+
+typedef GCodeChunkParser::Record Record;
+typedef GCodeChunkParser::Word Word;
+const Word WordX = GCodeChunkParser::WordX;
+const Word WordY = GCodeChunkParser::WordY;
+const Word WordZ = GCodeChunkParser::WordZ;
+const Word WordE = GCodeChunkParser::WordE;
+const Word WordF = GCodeChunkParser::WordF;
+const Word WordI = GCodeChunkParser::WordI;
+const Word WordJ = GCodeChunkParser::WordJ;
+const Word WordP = GCodeChunkParser::WordP;
+const Word WordR = GCodeChunkParser::WordR;
+const Word WordS = GCodeChunkParser::WordS;
+const Word WordT = GCodeChunkParser::WordT;
+
+/**
+ * @brief True for the commands the estimate follows
+ */
+bool isTimed(char letter, int code)
+{
+    if (letter == 'G') {
+        return (code >= 0 && code <= 4) || code == 20 || code == 21 || code == 28 || (code >= 90 && code <= 92);
+    }
+    if (letter != 'M') {
+        return false;
+    }
+    switch (code) {
+    case 82:
+    case 83:
+    case 109:
+    case 190:
+    case 201:
+    case 203:
+    case 204:
+    case 205:
+    case 400:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief A planned move
+ */
+struct Block {
+    qint64 line;                //!< @param line: line of the move
+    double distance;            //!< @param distance: length in mm
+    double nominalSpeed;        //!< @param nominalSpeed: cruise speed in mm/s
+    double acceleration;        //!< @param acceleration: mm/s²
+    double maxEntrySpeed;       //!< @param maxEntrySpeed: fastest speed through the junction before it
+    double entrySpeed;          //!< @param entrySpeed: planned speed at the start
+};
+
+/**
+ * @brief Time to run a trapezoid
+ * @param distance: length in mm
+ * @param entry: speed at the start
+ * @param exit: speed at the end
+ * @param nominal: cruise speed
+ * @param acceleration: acceleration and deceleration
+ */
+double trapezoidTime(double distance, double entry, double exit, double nominal, double acceleration)
+{
+    if (acceleration <= 0) {
+        return distance / qMax(nominal, _minimumPlannerSpeed);
+    }
+    const double accelerate = (nominal * nominal - entry * entry) / (2 * acceleration);
+    const double decelerate = (nominal * nominal - exit * exit) / (2 * acceleration);
+    if (accelerate + decelerate <= distance) {
+        return (nominal - entry) / acceleration + (nominal - exit) / acceleration + (distance - accelerate - decelerate) / nominal;
+    }
+    // no cruise, a triangle
+    const double peak = std::sqrt(qMax(0.0, acceleration * distance + (entry * entry + exit * exit) / 2));
+    return qMax(0.0, peak - entry) / acceleration + qMax(0.0, peak - exit) / acceleration;
+}
+
+/**
+ * @brief Runs the parsed commands through a model of the firmware planner
+ */
+class Simulator
+{
+public:
+    Simulator(const PrintTimeEstimator::Limits &limits, int stride, QVector<double> &times) :
+        _limits(limits), _stride(stride), _times(times)
+    {
+        _blocks.reserve(qMax(1, limits.lookahead) + 1);
+    }
+
+    void process(const Record &record, qint64 line)
+    {
+        if (record.letter == 'G') {
+            processG(record, line);
+        } else {
+            processM(record, line);
+        }
+    }
+
+    /**
+     * @brief Run what is left and time the lines after the last move
+     * @param lineCount: lines in the file
+     */
+    void finish(qint64 lineCount)
+    {
+        flush();
+        markLine(lineCount);
+    }
+
+    double time() const
+    {
+        return _time;
+    }
+
+private:
+    void processG(const Record &record, qint64 line)
+    {
+        switch (record.code) {
+        case 0:
+        case 1:
+        case 2:
+        case 3:
+            move(record, line);
+            break;
+        case 4: {
+            const double seconds = record.has(WordS) ? record.value[WordS] : record.has(WordP) ? record.value[WordP] / 1000 : 0;
+            flush();
+            markLine(line);
+            _time += qMax(0.0, seconds);
+            break;
+        }
+        case 20:
+            _scale = 25.4;
+            break;
+        case 21:
+            _scale = 1;
+            break;
+        case 28: {
+            flush();
+            const bool all = !record.has(WordX) && !record.has(WordY) && !record.has(WordZ);
+            for (int axis = 0; axis < 3; axis++) {
+                if (all || record.has(Word(axis))) {
+                    _position[axis] = 0;
+                }
+            }
+            break;
+        }
+        case 90:
+            _relative = false;
+            break;
+        case 91:
+            _relative = true;
+            break;
+        case 92:
+            for (int axis = 0; axis < 4; axis++) {
+                if (record.has(Word(axis))) {
+                    _position[axis] = record.value[axis] * _scale;
+                }
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    void processM(const Record &record, qint64 line)
+    {
+        Q_UNUSED(line);
+        switch (record.code) {
+        case 82:
+            _relativeE = false;
+            break;
+        case 83:
+            _relativeE = true;
+            break;
+        case 109:
+        case 190:
+        case 400:
+            // the firmware finishes every move first
+            flush();
+            break;
+        case 201:
+            setAxes(record, _limits.maxAcceleration);
+            break;
+        case 203:
+            setAxes(record, _limits.maxFeedrate);
+            break;
+        case 204:
+            if (record.has(WordS)) {
+                _limits.acceleration = _limits.travelAcceleration = record.value[WordS];
+            }
+            if (record.has(WordP)) {
+                _limits.acceleration = record.value[WordP];
+            }
+            if (record.has(WordR)) {
+                _limits.retractAcceleration = record.value[WordR];
+            }
+            if (record.has(WordT)) {
+                _limits.travelAcceleration = record.value[WordT];
+            }
+            break;
+        case 205:
+            setAxes(record, _limits.jerk);
+            if (record.has(WordJ)) {
+                _limits.junctionDeviation = record.value[WordJ];
+            }
+            if (record.has(WordS)) {
+                _limits.minimumFeedrate = record.value[WordS];
+            }
+            if (record.has(WordT)) {
+                _limits.minimumTravelFeedrate = record.value[WordT];
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    void setAxes(const Record &record, double *values)
+    {
+        for (int axis = 0; axis < 4; axis++) {
+            if (record.has(Word(axis))) {
+                values[axis] = record.value[axis];
+            }
+        }
+    }
+
+    void move(const Record &record, qint64 line)
+    {
+        if (record.has(WordF) && record.value[WordF] > 0) {
+            _feedrate = record.value[WordF] * _scale / 60;
+        }
+
+        double target[4];
+        for (int axis = 0; axis < 4; axis++) {
+            const bool relative = _relative || (axis == WordE && _relativeE);
+            target[axis] = _position[axis];
+            if (record.has(Word(axis))) {
+                target[axis] = relative ? _position[axis] + record.value[axis] * _scale : record.value[axis] * _scale;
+            }
+        }
+
+        double delta[4];
+        for (int axis = 0; axis < 4; axis++) {
+            delta[axis] = target[axis] - _position[axis];
+            _position[axis] = target[axis];
+        }
+
+        double distance = std::sqrt(delta[0] * delta[0] + delta[1] * delta[1] + delta[2] * delta[2]);
+        if (record.code == 2 || record.code == 3) {
+            distance = arcLength(record, delta, distance);
+        }
+        const bool extruderOnly = distance < 1e-6;
+        if (extruderOnly) {
+            distance = std::fabs(delta[3]);
+        }
+        if (distance < 1e-6) {
+            return;
+        }
+
+        // speed of each axis per unit of speed, the direction for junction deviation leaves E out unless it moves alone
+        double unit[4];
+        double ratio[4];
+        double direction[4];
+        for (int axis = 0; axis < 4; axis++) {
+            unit[axis] = delta[axis] / distance;
+            ratio[axis] = std::fabs(unit[axis]);
+            direction[axis] = extruderOnly == (axis == 3) ? unit[axis] : 0;
+        }
+
+        const bool extruding = delta[3] > 0 && !extruderOnly;
+        double speed = qMax(_feedrate, extruding || extruderOnly ? _limits.minimumFeedrate : _limits.minimumTravelFeedrate);
+        double acceleration = extruderOnly ? _limits.retractAcceleration : extruding ? _limits.acceleration : _limits.travelAcceleration;
+        for (int axis = 0; axis < 4; axis++) {
+            if (ratio[axis] * speed > _limits.maxFeedrate[axis] && _limits.maxFeedrate[axis] > 0) {
+                speed = _limits.maxFeedrate[axis] / ratio[axis];
+            }
+            if (ratio[axis] * acceleration > _limits.maxAcceleration[axis] && _limits.maxAcceleration[axis] > 0) {
+                acceleration = _limits.maxAcceleration[axis] / ratio[axis];
+            }
+        }
+
+        Block block;
+        block.line = line;
+        block.distance = distance;
+        block.nominalSpeed = speed;
+        block.acceleration = acceleration;
+        block.maxEntrySpeed = junctionSpeed(direction, unit, speed, acceleration);
+        block.entrySpeed = block.maxEntrySpeed;
+
+        std::copy(direction, direction + 4, _direction);
+        std::copy(unit, unit + 4, _unit);
+        _nominalSpeed = speed;
+        _hasPrevious = true;
+
+        _blocks.append(block);
+        if (_blocks.size() > qMax(1, _limits.lookahead)) {
+            plan();
+            execute();
+        }
+    }
+
+    /**
+     * @brief Length of an arc, from I J or R
+     */
+    double arcLength(const Record &record, const double *delta, double chord) const
+    {
+        double sweep = 0;
+        double radius = 0;
+        if (record.has(WordI) || record.has(WordJ)) {
+            const double i = record.has(WordI) ? record.value[WordI] * _scale : 0;
+            const double j = record.has(WordJ) ? record.value[WordJ] * _scale : 0;
+            radius = std::sqrt(i * i + j * j);
+            const double start = std::atan2(-j, -i);
+            const double end = std::atan2(delta[1] - j, delta[0] - i);
+            sweep = record.code == 2 ? start - end : end - start;
+            while (sweep <= 1e-9) {
+                sweep += 2 * _pi;
+            }
+        } else if (record.has(WordR)) {
+            radius = std::fabs(record.value[WordR] * _scale);
+            const double planar = std::sqrt(delta[0] * delta[0] + delta[1] * delta[1]);
+            sweep = radius > 0 ? 2 * std::asin(qMin(1.0, planar / (2 * radius))) : 0;
+            if (record.value[WordR] < 0) {
+                sweep = 2 * _pi - sweep;
+            }
+        } else {
+            return chord;
+        }
+        const double planar = radius * sweep;
+        return std::sqrt(planar * planar + delta[2] * delta[2]);
+    }
+
+    /**
+     * @brief Fastest speed through the junction with the previous move
+     */
+    double junctionSpeed(const double *direction, const double *unit, double speed, double acceleration) const
+    {
+        if (_limits.junctionDeviation > 0) {
+            if (!_hasPrevious) {
+                return _minimumPlannerSpeed;
+            }
+            double cosTheta = 0;
+            for (int axis = 0; axis < 4; axis++) {
+                cosTheta -= _direction[axis] * direction[axis];
+            }
+            if (cosTheta > 0.999999) {
+                // going back the way it came
+                return _minimumPlannerSpeed;
+            }
+            cosTheta = qMax(cosTheta, -0.999999);
+            const double sinHalfTheta = std::sqrt(0.5 * (1 - cosTheta));
+            const double junction = std::sqrt(acceleration * _limits.junctionDeviation * sinHalfTheta / (1 - sinHalfTheta));
+            return qMin(junction, qMin(speed, _nominalSpeed));
+        }
+
+        if (!_hasPrevious) {
+            // from standstill each axis may jump to its jerk
+            double safe = speed;
+            for (int axis = 0; axis < 4; axis++) {
+                if (std::fabs(unit[axis]) * safe > _limits.jerk[axis]) {
+                    safe = _limits.jerk[axis] / std::fabs(unit[axis]);
+                }
+            }
+            return qMax(safe, _minimumPlannerSpeed);
+        }
+
+        const double junction = qMin(speed, _nominalSpeed);
+        double factor = 1;
+        for (int axis = 0; axis < 4; axis++) {
+            const double exit = _unit[axis] * junction;
+            const double entry = unit[axis] * junction;
+            const double jerk = (exit < 0) == (entry < 0) ? std::fabs(exit - entry) : qMax(std::fabs(exit), std::fabs(entry));
+            if (jerk > _limits.jerk[axis] && jerk > 0) {
+                factor = qMin(factor, _limits.jerk[axis] / jerk);
+            }
+        }
+        return qMax(junction * factor, _minimumPlannerSpeed);
+    }
+
+    /**
+     * @brief Recompute the entry speeds of the moves waiting, the first one is running already
+     */
+    void plan()
+    {
+        double exit = 0;
+        for (int i = _blocks.size() - 1; i >= 1; i--) {
+            Block &block = _blocks[i];
+            block.entrySpeed = qMin(block.maxEntrySpeed, std::sqrt(exit * exit + 2 * block.acceleration * block.distance));
+            exit = block.entrySpeed;
+        }
+        for (int i = 0; i + 1 < _blocks.size(); i++) {
+            const Block &block = _blocks.at(i);
+            const double reach = std::sqrt(block.entrySpeed * block.entrySpeed + 2 * block.acceleration * block.distance);
+            if (_blocks.at(i + 1).entrySpeed > reach) {
+                _blocks[i + 1].entrySpeed = reach;
+            }
+        }
+    }
+
+    /**
+     * @brief Run the first move
+     */
+    void execute()
+    {
+        const Block block = _blocks.takeFirst();
+        const double exit = _blocks.isEmpty() ? 0 : _blocks.first().entrySpeed;
+        markLine(block.line);
+        _time += trapezoidTime(block.distance, block.entrySpeed, exit, qMax(block.nominalSpeed, qMax(block.entrySpeed, exit)), block.acceleration);
+    }
+
+    /**
+     * @brief Run every move waiting, ending at a stop
+     */
+    void flush()
+    {
+        plan();
+        while (!_blocks.isEmpty()) {
+            execute();
+        }
+        _hasPrevious = false;
+    }
+
+    /**
+     * @brief Keep the time of the stride lines up to \p line
+     */
+    void markLine(qint64 line)
+    {
+        while (_nextStride <= line) {
+            _times.append(_time);
+            _nextStride += _stride;
+        }
+    }
+
+    PrintTimeEstimator::Limits _limits;
+    int _stride;
+    QVector<double> &_times;
+    qint64 _nextStride = 0;
+    double _time = 0;
+    double _position[4] = {0, 0, 0, 0};
+    double _scale = 1;
+    double _feedrate = 25;
+    bool _relative = false;
+    bool _relativeE = false;
+    QList<Block> _blocks;
+    bool _hasPrevious = false;
+    double _direction[4] = {0, 0, 0, 0};
+    double _unit[4] = {0, 0, 0, 0};
+    double _nominalSpeed = 0;
+};
+}
+
+class EstimatorThread;
+/**
+ * @brief The PrintTimeEstimatorPrivate class
+ */
+class PrintTimeEstimatorPrivate
+{
+public:
+    PrintTimeEstimator::Limits limits;  //!< @param limits: limits at the start of a file
+    int stride = 256;                   //!< @param stride: lines between two kept times
+    QAtomicInt ready;                   //!< @param ready: the results below are complete
+    qint64 fileSize = 0;                //!< @param fileSize: size of the estimated file
+    qint64 lineCount = 0;               //!< @param lineCount: lines in the estimated file
+    double totalTime = 0;               //!< @param totalTime: time for the whole file in s
+    QVector<qint64> offsets;            //!< @param offsets: offset of every stride line
+    QVector<double> times;              //!< @param times: time before every stride line in s
+    EstimatorThread *thread = nullptr;  //!< @param thread: thread running start()
+    std::atomic<bool> cancel{false};    //!< @param cancel: stops the estimate running in thread
+};
+
+/**
+ * @brief Runs PrintTimeEstimator::estimate() for start()
+ */
+class EstimatorThread : public QThread
+{
+public:
+    EstimatorThread(PrintTimeEstimator *estimator, const QString &fileName, qint64 offset) :
+        _estimator(estimator), _fileName(fileName), _offset(offset)
+    {
+    }
+
+    bool ok = false;
+
+protected:
+    void run() override
+    {
+        ok = _estimator->estimate(_fileName, _offset);
+    }
+
+private:
+    PrintTimeEstimator *_estimator;
+    QString _fileName;
+    qint64 _offset;
+};
+
+PrintTimeEstimator::PrintTimeEstimator(QObject *parent) :
+    QObject(parent),
+    d(new PrintTimeEstimatorPrivate)
+{
+}
+
+PrintTimeEstimator::~PrintTimeEstimator()
+{
+    if (d->thread) {
+        d->cancel = true;
+        d->thread->wait();
+        delete d->thread;
+    }
+    delete d;
+}
+
+const PrintTimeEstimator::Limits &PrintTimeEstimator::limits() const
+{
+    return d->limits;
+}
+
+void PrintTimeEstimator::setLimits(const PrintTimeEstimator::Limits &limits)
+{
+    d->limits = limits;
+}
+
+int PrintTimeEstimator::stride() const
+{
+    return d->stride;
+}
+
+void PrintTimeEstimator::setStride(int stride)
+{
+    d->stride = qMax(1, stride);
+}
+
+bool PrintTimeEstimator::estimate(const QString &fileName, qint64 offset)
+{
+    d->ready.storeRelease(0);
+    if (GCodeDecompressor::format(fileName) != GCodeDecompressor::NONE) {
+        // chunks are parsed from the memory map
+        qCDebug(PRINT_TIME_ESTIMATOR) << "Can't estimate compressed" << fileName;
+        return false;
+    }
+    GCodeReader reader(fileName);
+    if (!reader.open()) {
+        return false;
+    }
+    const char *data = reader.data();
+    const qint64 size = reader.size();
+    const qint64 from = qBound(qint64(0), offset, size);
+
+    GCodeChunkParser parser(data + from, size - from, isTimed);
+    QVector<qint64> offsets;
+    QVector<double> times;
+    Simulator simulator(d->limits, d->stride, times);
+    qint64 line = 0;
+    const bool done = parser.run([&](const GCodeChunkParser::Chunk &chunk) {
+        for (int j = int((d->stride - line % d->stride) % d->stride); j < chunk.lines.size(); j += d->stride) {
+            offsets.append(from + chunk.begin + chunk.lines.at(j));
+        }
+        for (const auto &record : chunk.records) {
+            simulator.process(record, line + record.line);
+        }
+        line += chunk.lines.size();
+    }, &d->cancel);
+    if (!done) {
+        qCDebug(PRINT_TIME_ESTIMATOR) << "Estimate of" << fileName << "cancelled";
+        return false;
+    }
+    simulator.finish(line);
+    times.resize(offsets.size());
+
+    d->fileSize = size;
+    d->lineCount = line;
+    d->totalTime = simulator.time();
+    d->offsets = offsets;
+    d->times = times;
+    d->ready.storeRelease(1);
+    qCDebug(PRINT_TIME_ESTIMATOR) << fileName << "takes" << d->totalTime << "s," << parser.chunkCount() << "chunks";
+    return true;
+}
+
+void PrintTimeEstimator::start(const QString &fileName, qint64 offset)
+{
+    if (d->thread) {
+        d->cancel = true;
+        d->thread->wait();
+        delete d->thread;
+        d->cancel = false;
+    }
+    d->ready.storeRelease(0);
+    EstimatorThread *thread = new EstimatorThread(this, fileName, offset);
+    d->thread = thread;
+    // deleting a cancelled thread drops its queued finished(), it isn't mixed up with the next estimate
+    connect(thread, &QThread::finished, thread, [this, thread] {
+        emit finished(thread->ok);
+    });
+    thread->start(QThread::LowPriority);
+}
+
+bool PrintTimeEstimator::isReady() const
+{
+    return d->ready.loadAcquire();
+}
+
+double PrintTimeEstimator::totalTime() const
+{
+    return isReady() ? d->totalTime : 0;
+}
+
+qint64 PrintTimeEstimator::lineCount() const
+{
+    return isReady() ? d->lineCount : 0;
+}
+
+double PrintTimeEstimator::timeBeforeLine(qint64 line) const
+{
+    if (!isReady() || d->times.isEmpty() || line <= 0) {
+        return 0;
+    }
+    if (line >= d->lineCount) {
+        return d->totalTime;
+    }
+    const int index = int(line / d->stride);
+    const double from = d->times.at(index);
+    const double to = index + 1 < d->times.size() ? d->times.at(index + 1) : d->totalTime;
+    const qint64 next = qMin(qint64(index + 1) * d->stride, d->lineCount);
+    return from + (to - from) * double(line - qint64(index) * d->stride) / double(next - qint64(index) * d->stride);
+}
+
+double PrintTimeEstimator::timeAt(qint64 offset) const
+{
+    if (!isReady() || d->offsets.isEmpty() || offset <= d->offsets.first()) {
+        return 0;
+    }
+    if (offset >= d->fileSize) {
+        return d->totalTime;
+    }
+    const int index = int(std::upper_bound(d->offsets.constBegin(), d->offsets.constEnd(), offset) - d->offsets.constBegin()) - 1;
+    const double from = d->times.at(index);
+    const double to = index + 1 < d->times.size() ? d->times.at(index + 1) : d->totalTime;
+    const qint64 next = index + 1 < d->offsets.size() ? d->offsets.at(index + 1) : d->fileSize;
+    return from + (to - from) * double(offset - d->offsets.at(index)) / double(next - d->offsets.at(index));
+}
+
+double PrintTimeEstimator::remainingTime(qint64 offset) const
+{
+    return isReady() ? qMax(0.0, d->totalTime - timeAt(offset)) : 0;
+}
@@ -0,0 +1,164 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QObject>
+#include <QString>
+
+#include "atcore_export.h"
+
+class PrintTimeEstimatorPrivate;
+/**
+ * @brief The PrintTimeEstimator class
+ * Estimates how long a G-code file takes to print.
+ *
+ * Moves are planned the way the firmware does: each one accelerates and
+ * decelerates along a trapezoid, the speed through a corner is limited by the
+ * junction deviation or, when it is 0, by the jerk, and a limited lookahead
+ * decides how early to slow down. M201, M203, M204 and M205 in the file
+ * override the Limits it starts with.
+ *
+ * The file is parsed in chunks on all cores while one thread plans the
+ * parsed moves in order. The time at every stride() line is kept, so the
+ * time left from any point of the file is a lookup.
+ */
+class ATCORE_EXPORT PrintTimeEstimator : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Motion limits of the printer, axes are X, Y, Z and E
+     */
+    struct Limits {
+        double maxFeedrate[4] = {300, 300, 5, 25};              //!< @param maxFeedrate: M203, mm/s
+        double maxAcceleration[4] = {3000, 3000, 100, 10000};   //!< @param maxAcceleration: M201, mm/s²
+        double acceleration = 3000;                             //!< @param acceleration: M204 P, printing moves in mm/s²
+        double retractAcceleration = 3000;                      //!< @param retractAcceleration: M204 R, E only moves in mm/s²
+        double travelAcceleration = 3000;                       //!< @param travelAcceleration: M204 T, moves without extrusion in mm/s²
+        double jerk[4] = {10, 10, 0.3, 5};                      //!< @param jerk: M205 X Y Z E, mm/s
+        double junctionDeviation = 0;                           //!< @param junctionDeviation: M205 J in mm, 0 to use jerk
+        double minimumFeedrate = 0;                             //!< @param minimumFeedrate: M205 S, mm/s
+        double minimumTravelFeedrate = 0;                       //!< @param minimumTravelFeedrate: M205 T, mm/s
+        int lookahead = 16;                                     //!< @param lookahead: moves the firmware plans ahead
+    };
+
+    /**
+     * @brief Create an estimator
+     * @param parent: parent of the estimator
+     */
+    explicit PrintTimeEstimator(QObject *parent = nullptr);
+
+    /**
+     * @brief Cancels a running start() and waits for it
+     */
+    ~PrintTimeEstimator() override;
+
+    /**
+     * @brief Limits used at the start of a file
+     */
+    const Limits &limits() const;
+
+    /**
+     * @brief Set the limits used at the start of a file
+     * @param limits: limits of the printer
+     */
+    void setLimits(const Limits &limits);
+
+    /**
+     * @brief Distance in lines between two kept times
+     */
+    int stride() const;
+
+    /**
+     * @brief Set the distance in lines between two kept times
+     * @param stride: lines, used by the next estimate()
+     */
+    void setStride(int stride);
+
+    /**
+     * @brief Estimate \p fileName, blocking until done
+     *
+     * A job continued from \p offset is estimated from there only, times and
+     * lines count from \p offset and the moves start from the default state.
+     * @param fileName: G-code file
+     * @param offset: byte offset of the line to start at
+     * @return False if the file can't be read
+     */
+    bool estimate(const QString &fileName, qint64 offset = 0);
+
+    /**
+     * @brief Estimate \p fileName in a background thread
+     * finished() is emitted when done, the results can be read once isReady().
+     * An estimate still running is cancelled.
+     * @param fileName: G-code file
+     * @param offset: byte offset of the line to start at, see estimate()
+     */
+    void start(const QString &fileName, qint64 offset = 0);
+
+    /**
+     * @brief True once an estimate is done, may be called from any thread
+     */
+    bool isReady() const;
+
+    /**
+     * @brief Time to print the whole file in seconds
+     */
+    double totalTime() const;
+
+    /**
+     * @brief Number of lines estimated, from the start offset to the end of the file
+     */
+    qint64 lineCount() const;
+
+    /**
+     * @brief Time printing takes to reach \p line
+     * @param line: line number, from 0 at the start offset
+     * @return seconds from the start offset
+     */
+    double timeBeforeLine(qint64 line) const;
+
+    /**
+     * @brief Time printing takes to reach byte \p offset
+     * @param offset: byte offset in the file
+     * @return seconds from the start offset, 0 before it
+     */
+    double timeAt(qint64 offset) const;
+
+    /**
+     * @brief Time left once byte \p offset is printed
+     * @param offset: byte offset in the file
+     * @return seconds to the end of the file
+     */
+    double remainingTime(qint64 offset) const;
+
+signals:
+    /**
+     * @brief A start() is done
+     * @param ok: False if the file couldn't be read
+     */
+    void finished(bool ok);
+
+private:
+    PrintTimeEstimatorPrivate *d;
+};
@@ -0,0 +1,110 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QVector>
+
+#include "retransmitbuffer.h"
+
+/**
+ * @brief The RetransmitBufferPrivate class
+ */
+class RetransmitBufferPrivate
+{
+public:
+    QVector<QByteArray> lines;  //!< @param lines: ring of framed lines, indexed by line number
+    int next = 1;               //!< @param next: line number of the next framed command
+    int first = 1;              //!< @param first: oldest line number still kept
+};
+
+RetransmitBuffer::RetransmitBuffer(int capacity) :
+    d(new RetransmitBufferPrivate)
+{
+    d->lines.resize(qMax(capacity, 1));
+}
+
+RetransmitBuffer::~RetransmitBuffer()
+{
+    delete d;
+}
+
+int RetransmitBuffer::capacity() const
+{
+    return d->lines.size();
+}
+
+int RetransmitBuffer::nextLineNumber() const
+{
+    return d->next;
+}
+
+quint8 RetransmitBuffer::checksum(const QByteArray &data)
+{
+    quint8 sum = 0;
+    for (const char c : data) {
+        sum ^= quint8(c);
+    }
+    return sum;
+}
+
+QByteArray RetransmitBuffer::frame(const QByteArray &command)
+{
+    QByteArray line;
+    line.reserve(command.size() + 16);
+    line.append('N');
+    line.append(QByteArray::number(d->next));
+    line.append(' ');
+    line.append(command);
+    const quint8 sum = checksum(line);
+    line.append('*');
+    line.append(QByteArray::number(sum));
+
+    d->lines[d->next % capacity()] = line;
+    d->next++;
+    if (d->next - d->first > capacity()) {
+        d->first = d->next - capacity();
+    }
+    return line;
+}
+
+QByteArray RetransmitBuffer::reset(int line)
+{
+    // "N<line> M110 N<line>": the firmware expects line + 1 afterwards
+    line = qMax(line, 0);
+    d->next = line;
+    d->first = line + 1;
+    const QByteArray command = frame(QByteArray("M110 N") + QByteArray::number(line));
+    d->first = d->next;
+    return command;
+}
+
+bool RetransmitBuffer::resend(int line, QList<QByteArray> &lines) const
+{
+    lines.clear();
+    if (line < d->first || line >= d->next) {
+        return false;
+    }
+    for (int i = line; i < d->next; i++) {
+        lines.append(d->lines.at(i % capacity()));
+    }
+    return true;
+}
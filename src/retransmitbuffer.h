@@ -0,0 +1,92 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+
+#include "atcore_export.h"
+
+class RetransmitBufferPrivate;
+/**
+ * @brief The RetransmitBuffer class
+ * Adds line numbers and checksums to commands and keeps the last lines sent.
+ *
+ * Each command is framed as "N<line> <command>*<checksum>", the checksum being the
+ * XOR of every byte before '*'. The last capacity() framed lines are kept so a
+ * "Resend: <line>" request from the firmware can be answered.
+ */
+class ATCORE_EXPORT RetransmitBuffer
+{
+public:
+    /**
+     * @brief Create a new RetransmitBuffer
+     * @param capacity: number of sent lines kept for resends
+     */
+    explicit RetransmitBuffer(int capacity = 64);
+    ~RetransmitBuffer();
+
+    /**
+     * @brief Number of sent lines kept for resends
+     */
+    int capacity() const;
+
+    /**
+     * @brief Line number that the next framed command will use
+     */
+    int nextLineNumber() const;
+
+    /**
+     * @brief Frame \p command with the next line number and keep it
+     * @param command: command without line number, checksum or terminator
+     * @return "N<line> <command>*<checksum>"
+     */
+    QByteArray frame(const QByteArray &command);
+
+    /**
+     * @brief Restart numbering at \p line and forget the kept lines
+     * @param line: line number the firmware is told to continue from, negative values are clamped to 0
+     * @return framed M110 telling the firmware about the new numbering
+     */
+    QByteArray reset(int line = 0);
+
+    /**
+     * @brief Framed lines from \p line up to the last one sent
+     * @param line: first line requested by the firmware
+     * @param lines: set to the framed lines to send again
+     * @return False if \p line was never sent or is no longer kept
+     */
+    bool resend(int line, QList<QByteArray> &lines) const;
+
+    /**
+     * @brief XOR checksum used by Marlin, Repetier and most RepRap firmwares
+     * @param data: bytes before '*'
+     */
+    static quint8 checksum(const QByteArray &data);
+
+private:
+    RetransmitBuffer(const RetransmitBuffer &) = delete;
+    RetransmitBuffer &operator=(const RetransmitBuffer &) = delete;
+    RetransmitBufferPrivate *d;
+};
@@ -23,16 +23,23 @@
     License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <QCoreApplication>
+#include <QEvent>
 #include <QLoggingCategory>
+#include <QMetaMethod>
+#include <QThread>
+#include <QTimer>
+#include <atomic>
 
 #include "seriallayer.h"
+#include "linebuffer.h"
+#include "linehistory.h"
+#include "spscqueue.h"
 
 Q_LOGGING_CATEGORY(SERIAL_LAYER, "org.kde.atelier.core.serialLayer")
 
 namespace
 {
-QByteArray _return = QByteArray("\r");
-QByteArray _newLine = QByteArray("\n");
 QByteArray _newLineReturn = QByteArray("\n\r");
 QStringList _validBaudRates = {
     QStringLiteral("9600"),
@@ -48,8 +55,44 @@ QStringList _validBaudRates = {
     QStringLiteral("500000"),
     QStringLiteral("1000000")
 };
+// Full speed USB CDC bulk packet size, whole packets avoid short transfers
+const int _usbPacketSize = 64;
+// Longest time a partial packet waits for more commands, in milliseconds
+const int _flushDeadline = 2;
+const QEvent::Type _flushEvent = QEvent::Type(QEvent::registerEventType());
+const QEvent::Type _receivedEvent = QEvent::Type(QEvent::registerEventType());
+const QEvent::Type _readEvent = QEvent::Type(QEvent::registerEventType());
+const QEvent::Type _drainedEvent = QEvent::Type(QEvent::registerEventType());
+const QEvent::Type _closeEvent = QEvent::Type(QEvent::registerEventType());
 }
 
+/**
+ * @brief The SerialDispatcher class
+ * Stays on the thread that started the I/O thread, which wakes it up to take received lines
+ * and to push commands again.
+ */
+class SerialDispatcher : public QObject
+{
+public:
+    explicit SerialDispatcher(SerialLayer *layer) : _layer(layer) {}
+
+    bool event(QEvent *event) override
+    {
+        if (event->type() == _receivedEvent) {
+            _layer->dispatchReceived();
+            return true;
+        }
+        if (event->type() == _drainedEvent) {
+            emit(_layer->commandQueueDrained());
+            return true;
+        }
+        return QObject::event(event);
+    }
+
+private:
+    SerialLayer *_layer;
+};
+
 /**
  * @brief The SerialLayerPrivate class
  */
@@ -57,9 +100,22 @@ class SerialLayerPrivate
 {
 public:
     bool _serialOpened;                 //!< @param _serialOpened: is serial port opened
-    QByteArray _rawData;                //!< @param _rawData: the raw serial data
-    QVector<QByteArray> _rByteCommands; //!< @param _rByteCommand: received Messages
+    LineBuffer _rawData;                //!< @param _rawData: the raw serial data, split in lines
+    QByteArray _line;                   //!< @param _line: last line taken from _rawData
+    LineHistory _rByteCommands;         //!< @param _rByteCommand: last received Messages
     QVector<QByteArray> _sByteCommands; //!< @param _sByteCommand: sent Messages
+    QThread *_ioThread = nullptr;       //!< @param _ioThread: thread doing reads and writes, nullptr if none
+    SerialDispatcher *_dispatcher = nullptr; //!< @param _dispatcher: takes received lines on the owner thread
+    SpscQueue<QByteArray> _rxQueue;     //!< @param _rxQueue: lines from the I/O thread
+    SpscQueue<QByteArray> _txQueue;     //!< @param _txQueue: commands for the I/O thread
+    std::atomic<bool> _rxWakePending{false}; //!< @param _rxWakePending: owner thread already woken for _rxQueue
+    std::atomic<bool> _txWakePending{false}; //!< @param _txWakePending: I/O thread already woken for _txQueue
+    std::atomic<bool> _rxStalled{false}; //!< @param _rxStalled: I/O thread stopped reading, _rxQueue was full
+    std::atomic<bool> _txStalled{false}; //!< @param _txStalled: a command was refused, _txQueue was full
+    bool _lineHeld = false;             //!< @param _lineHeld: _line is still for _rxQueue
+    QByteArray _outBuffer;              //!< @param _outBuffer: commands waiting to be written
+    QTimer *_flushTimer = nullptr;      //!< @param _flushTimer: writes a partial packet after _flushDeadline
+    std::atomic<bool> _coalescing{false}; //!< @param _coalescing: True to write whole packets only
 };
 
 SerialLayer::SerialLayer(const QString &port, uint baud, QObject *parent) :
@@ -67,6 +123,11 @@ SerialLayer::SerialLayer(const QString &port, uint baud, QObject *parent) :
 {
     setPortName(port);
     setBaudRate(baud);
+    d->_outBuffer.reserve(4096);
+    d->_flushTimer = new QTimer(this);
+    d->_flushTimer->setSingleShot(true);
+    d->_flushTimer->setInterval(_flushDeadline);
+    connect(d->_flushTimer, &QTimer::timeout, this, &SerialLayer::flushOutput);
     if (open(QIODevice::ReadWrite)) {
         d->_serialOpened = true;
         connect(this, &QSerialPort::readyRead, this, &SerialLayer::readAllData);
@@ -75,45 +136,260 @@ SerialLayer::SerialLayer(const QString &port, uint baud, QObject *parent) :
 
 void SerialLayer::readAllData()
 {
-    d->_rawData.append(readAll());
+    bool queued = false;
+    bool stalled = false;
+    if (d->_lineHeld) {
+        stalled = !queueReceived(d->_line);
+        d->_lineHeld = stalled;
+        queued = !stalled;
+    }
+
+    // Hand out every finished line once, then read straight into the ring
+    while (!stalled) {
+        while (d->_rawData.readLine(d->_line)) {
+            if (!d->_ioThread) {
+                emitReceived(d->_line);
+            } else if (queueReceived(d->_line)) {
+                queued = true;
+            } else {
+                // the rest waits in the ring and the port until the owner thread took the queue
+                d->_lineHeld = stalled = true;
+                break;
+            }
+        }
+        if (stalled || bytesAvailable() <= 0) {
+            break;
+        }
+        int space = 0;
+        char *data = d->_rawData.reserve(space);
+        const qint64 count = read(data, space);
+        if (count <= 0) {
+            break;
+        }
+        d->_rawData.commit(int(count));
+    }
+
+    if ((queued || stalled) && !d->_rxWakePending.exchange(true)) {
+        QCoreApplication::postEvent(d->_dispatcher, new QEvent(_receivedEvent));
+    }
+}
+
+bool SerialLayer::queueReceived(const QByteArray &line)
+{
+    if (d->_rxQueue.push(line)) {
+        return true;
+    }
+    // dispatchReceived() makes the I/O thread read again
+    d->_rxStalled = true;
+    return false;
+}
 
-    /*
-     * Check if \r exist and remove
-     * Both \n\r and \n are used in string's end and some protocols
-     */
-    if (d->_rawData.contains(_return)) {
-        d->_rawData = d->_rawData.replace(_return, QByteArray());
+void SerialLayer::dispatchReceived()
+{
+    d->_rxWakePending = false;
+    QByteArray line;
+    while (d->_rxQueue.pop(line)) {
+        emitReceived(line);
     }
+    if (d->_rxStalled.exchange(false)) {
+        QCoreApplication::postEvent(this, new QEvent(_readEvent));
+    }
+}
 
-    QByteArray tempArray;
-    QList<QByteArray> tempList = d->_rawData.split(_newLine.at(0));
-    for (auto i = tempList.begin(); i != tempList.end(); ++i) {
-        // Get finished line to _byteCommands
-        if (i < tempList.end() - 1) {
-            d->_rByteCommands.append(*i);
-            emit(receivedCommand(*i));
-        } else {
-            d->_rawData.clear();
-            d->_rawData.append(*i);
+void SerialLayer::emitReceived(const QByteArray &line)
+{
+    d->_rByteCommands.append(line);
+    emit(receivedCommand(line));
+}
+
+bool SerialLayer::queueForIoThread() const
+{
+    return d->_ioThread && QThread::currentThread() != d->_ioThread;
+}
+
+bool SerialLayer::queueCommand(const QByteArray &command)
+{
+    const bool queued = d->_txQueue.push(command);
+    if (!queued) {
+        qCDebug(SERIAL_LAYER) << "I/O thread queue is full, command not sent:" << command;
+        d->_txStalled = true;
+    }
+    wakeIoThread();
+    return queued;
+}
+
+void SerialLayer::wakeIoThread()
+{
+    if (!d->_txWakePending.exchange(true)) {
+        QCoreApplication::postEvent(this, new QEvent(_flushEvent));
+    }
+}
+
+void SerialLayer::appendCommand(const QByteArray &comm, const QByteArray &term)
+{
+    d->_outBuffer.append(comm);
+    d->_outBuffer.append(term);
+    // only build the whole command if someone listens
+    static const QMetaMethod pushedSignal = QMetaMethod::fromSignal(&SerialLayer::pushedCommand);
+    if (isSignalConnected(pushedSignal)) {
+        emit(pushedCommand(comm + term));
+    }
+}
+
+void SerialLayer::writeOutput(bool all)
+{
+    int size = d->_outBuffer.size();
+    if (!all) {
+        size -= size % _usbPacketSize;
+    }
+    if (size > 0) {
+        write(d->_outBuffer.constData(), size);
+        d->_outBuffer.remove(0, size);
+    }
+
+    if (d->_outBuffer.isEmpty()) {
+        d->_flushTimer->stop();
+    } else if (!d->_flushTimer->isActive()) {
+        d->_flushTimer->start();
+    }
+}
+
+void SerialLayer::flushOutput()
+{
+    writeOutput(true);
+}
+
+bool SerialLayer::writeCommand(const QByteArray &comm, const QByteArray &term)
+{
+    if (queueForIoThread()) {
+        return queueCommand(comm + term);
+    }
+    appendCommand(comm, term);
+    writeOutput(!d->_coalescing);
+    return true;
+}
+
+bool SerialLayer::event(QEvent *event)
+{
+    if (event->type() == _flushEvent) {
+        d->_txWakePending = false;
+        QByteArray command;
+        while (d->_txQueue.pop(command)) {
+            appendCommand(command, QByteArray());
+        }
+        writeOutput(!d->_coalescing);
+        if (d->_txStalled.exchange(false)) {
+            QCoreApplication::postEvent(d->_dispatcher, new QEvent(_drainedEvent));
+        }
+        return true;
+    }
+
+    if (event->type() == _readEvent) {
+        readAllData();
+        return true;
+    }
+
+    if (event->type() == _closeEvent) {
+        writeOutput(true);
+        // QSerialPort::close() drops what it didn't write yet
+        flush();
+        QSerialPort::close();
+        moveToThread(d->_dispatcher->thread());
+        QThread::currentThread()->quit();
+        return true;
+    }
+
+    return QSerialPort::event(event);
+}
+
+void SerialLayer::startIoThread()
+{
+    if (d->_ioThread || !isOpen()) {
+        return;
+    }
+    if (parent()) {
+        qCDebug(SERIAL_LAYER) << "Can't move a SerialLayer with a parent to the I/O thread";
+        return;
+    }
+    d->_dispatcher = new SerialDispatcher(this);
+    d->_ioThread = new QThread();
+    moveToThread(d->_ioThread);
+    d->_ioThread->start();
+}
+
+bool SerialLayer::ioThreadRunning() const
+{
+    return d->_ioThread;
+}
+
+void SerialLayer::close()
+{
+    if (d->_ioThread && QThread::currentThread() != d->_ioThread) {
+        QCoreApplication::postEvent(this, new QEvent(_closeEvent));
+        d->_ioThread->wait();
+        delete d->_ioThread;
+        d->_ioThread = nullptr;
+        // lines read before closing, including those a full queue held back
+        d->_rxStalled = false;
+        dispatchReceived();
+        if (d->_lineHeld) {
+            d->_lineHeld = false;
+            emitReceived(d->_line);
+        }
+        while (d->_rawData.readLine(d->_line)) {
+            emitReceived(d->_line);
         }
+        delete d->_dispatcher;
+        d->_dispatcher = nullptr;
+        d->_txStalled = false;
+        return;
+    }
+    writeOutput(true);
+    flush();
+    QSerialPort::close();
+}
+
+void SerialLayer::setWriteCoalescing(bool enabled)
+{
+    d->_coalescing = enabled;
+    if (enabled) {
+        return;
+    }
+    if (queueForIoThread()) {
+        wakeIoThread();
+    } else {
+        writeOutput(true);
     }
 }
 
-void SerialLayer::pushCommand(const QByteArray &comm, const QByteArray &term)
+bool SerialLayer::writeCoalescing() const
+{
+    return d->_coalescing;
+}
+
+bool SerialLayer::pushCommand(const QByteArray &comm, const QByteArray &term)
 {
     if (!isOpen()) {
         qCDebug(SERIAL_LAYER) << "Serial not connected !";
-        return;
+        return false;
     }
-    QByteArray tmp = comm + term;
-    write(tmp);
-    emit(pushedCommand(tmp));
+    return writeCommand(comm, term);
+}
 
+bool SerialLayer::pushCommand(const QByteArray &comm)
+{
+    return pushCommand(comm, _newLineReturn);
 }
 
-void SerialLayer::pushCommand(const QByteArray &comm)
+bool SerialLayer::canPushCommand(int count)
 {
-    pushCommand(comm, _newLineReturn);
+    if (!queueForIoThread() || d->_txQueue.capacity() - d->_txQueue.size() >= count) {
+        return true;
+    }
+    // commandQueueDrained() follows once the I/O thread took the queue
+    d->_txStalled = true;
+    wakeIoThread();
+    return false;
 }
 
 void SerialLayer::add(const QByteArray &comm, const QByteArray &term)
@@ -127,17 +403,30 @@ void SerialLayer::add(const QByteArray &comm)
     add(comm, _newLineReturn);
 }
 
-void SerialLayer::push()
+bool SerialLayer::push()
 {
     if (!isOpen()) {
         qCDebug(SERIAL_LAYER) << "Serial not connected !";
-        return;
+        return false;
     }
+    // one write for the whole batch
+    const bool queue = queueForIoThread();
+    int pushed = 0;
     foreach (const auto &comm, d->_sByteCommands) {
-        write(comm);
-        emit(pushedCommand(comm));
+        if (queue) {
+            if (!queueCommand(comm)) {
+                break;
+            }
+        } else {
+            appendCommand(comm, QByteArray());
+        }
+        pushed++;
+    }
+    if (!queue) {
+        writeOutput(!d->_coalescing);
     }
-    d->_sByteCommands.clear();
+    d->_sByteCommands.remove(0, pushed);
+    return d->_sByteCommands.isEmpty();
 }
 
 bool SerialLayer::commandAvailable() const
@@ -145,6 +434,36 @@ bool SerialLayer::commandAvailable() const
     return !d->_rByteCommands.isEmpty();
 }
 
+int SerialLayer::historyDepth() const
+{
+    return d->_rByteCommands.depth();
+}
+
+void SerialLayer::setHistoryDepth(int depth)
+{
+    d->_rByteCommands.setDepth(depth);
+}
+
+bool SerialLayer::setHistorySpillFile(const QString &fileName)
+{
+    return d->_rByteCommands.setSpillFile(fileName);
+}
+
+QString SerialLayer::historySpillFile() const
+{
+    return d->_rByteCommands.spillFile();
+}
+
+QList<QByteArray> SerialLayer::recentCommands(int count) const
+{
+    return d->_rByteCommands.recent(count);
+}
+
+qint64 SerialLayer::receivedCount() const
+{
+    return d->_rByteCommands.total();
+}
+
 QStringList SerialLayer::validBaudRates() const
 {
     return _validBaudRates;
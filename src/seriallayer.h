@@ -30,6 +30,7 @@
 #include "atcore_export.h"
 
 class SerialLayerPrivate;
+class SerialDispatcher;
 /**
  * @brief The SerialLayer class.
  * Provide the low level serial operations
@@ -37,6 +38,7 @@ class SerialLayerPrivate;
 class ATCORE_EXPORT SerialLayer : public QSerialPort
 {
     Q_OBJECT
+    friend class SerialDispatcher;
 
 private:
     SerialLayerPrivate *d;
@@ -46,6 +48,83 @@ private:
      *
      */
     void readAllData();
+
+    /**
+     * @brief Hand a received line to the owner thread, used by the I/O thread
+     *
+     * @param line : Received line
+     * @return False if the queue is full, the I/O thread stops reading until the owner thread took it
+     */
+    bool queueReceived(const QByteArray &line);
+
+    /**
+     * @brief Emit receivedCommand for the lines queued by the I/O thread
+     *
+     */
+    void dispatchReceived();
+
+    /**
+     * @brief Keep \p line in the history and emit receivedCommand
+     *
+     * @param line : Received line
+     */
+    void emitReceived(const QByteArray &line);
+
+    /**
+     * @brief Write \p comm and \p term or queue them for the I/O thread
+     *
+     * @param comm : Command
+     * @param term : Terminator
+     * @return False if the I/O thread's queue is full
+     */
+    bool writeCommand(const QByteArray &comm, const QByteArray &term);
+
+    /**
+     * @brief True when called from another thread than the running I/O thread
+     */
+    bool queueForIoThread() const;
+
+    /**
+     * @brief Hand a command to the I/O thread
+     *
+     * @param command : Command with its terminator
+     * @return False if the queue is full, the command is not sent
+     */
+    bool queueCommand(const QByteArray &command);
+
+    /**
+     * @brief Make the I/O thread write its queued commands
+     *
+     */
+    void wakeIoThread();
+
+    /**
+     * @brief Append a command to the output buffer
+     *
+     * @param comm : Command
+     * @param term : Terminator
+     */
+    void appendCommand(const QByteArray &comm, const QByteArray &term);
+
+    /**
+     * @brief Write the output buffer
+     *
+     * @param all : True to write everything, false to write whole USB packets only
+     */
+    void writeOutput(bool all);
+
+    /**
+     * @brief Write the whole output buffer, the deadline of a partial packet passed
+     *
+     */
+    void flushOutput();
+
+protected:
+    /**
+     * @brief Handle the I/O thread wake up and close requests
+     */
+    bool event(QEvent *event) override;
+
 signals:
 
     /**
@@ -61,6 +140,12 @@ signals:
      * @param comm : Command
      */
     void receivedCommand(const QByteArray &comm);
+
+    /**
+     * @brief Emit signal when the I/O thread took its queue after canPushCommand() or pushCommand() failed
+     *
+     */
+    void commandQueueDrained();
 public:
 
     /**
@@ -92,21 +177,77 @@ public:
      *
      * @param comm : Command
      * @param term : Terminator
+     * @return False if the command was not sent, the port is closed or the I/O thread's queue is full
      */
-    void pushCommand(const QByteArray &comm, const QByteArray &term);
+    bool pushCommand(const QByteArray &comm, const QByteArray &term);
 
     /**
      * @brief Push command directly
      *
      * @param comm : Command, default terminator will be used
+     * @return False if the command was not sent, the port is closed or the I/O thread's queue is full
      */
-    void pushCommand(const QByteArray &comm);
+    bool pushCommand(const QByteArray &comm);
+
+    /**
+     * @brief Check if the I/O thread's queue has room for \p count more commands
+     *
+     * Always true without the I/O thread. When false, commandQueueDrained is emitted
+     * once the I/O thread took the queued commands.
+     * @param count : Number of commands
+     * @return bool
+     */
+    bool canPushCommand(int count = 1);
 
     /**
      * @brief Push all commands used in add to serial write
      *
+     * @return False if commands are left for the next push(), the I/O thread's queue is full
+     */
+    bool push();
+
+    /**
+     * @brief Run reads, line framing and writes on a dedicated thread
+     *
+     * Received lines and pushed commands go through lock-free single producer,
+     * single consumer queues. receivedCommand is still emitted on the calling thread,
+     * a slow event loop there no longer delays the serial port.
+     * Call from the thread that created the SerialLayer, which must have no parent.
+     * Afterwards push commands from that thread only. Neither side waits for the other:
+     * a full queue of commands refuses more, see canPushCommand(), and a full queue of
+     * received lines leaves the rest unread until receivedCommand was emitted for them.
+     */
+    void startIoThread();
+
+    /**
+     * @brief Check if the I/O thread is running
+     *
+     * @return bool
      */
-    void push();
+    bool ioThreadRunning() const;
+
+    /**
+     * @brief Close the port, stopping the I/O thread if it is running
+     *
+     */
+    void close() override;
+
+    /**
+     * @brief Coalesce commands into as few writes as possible
+     *
+     * Commands are written in whole 64 byte USB CDC packets. The rest is written
+     * at most 2 ms after it was pushed, so single commands barely wait.
+     * Disabling writes whatever is pending at once.
+     * @param enabled : True to coalesce writes
+     */
+    void setWriteCoalescing(bool enabled);
+
+    /**
+     * @brief Check if writes are coalesced
+     *
+     * @return bool
+     */
+    bool writeCoalescing() const;
 
     /**
      * @brief Check if is a command available
@@ -115,6 +256,52 @@ public:
      */
     bool commandAvailable() const;
 
+    /**
+     * @brief Number of received lines kept in memory
+     *
+     * @return int
+     */
+    int historyDepth() const;
+
+    /**
+     * @brief Change the number of received lines kept in memory, 1000 by default
+     *
+     * Memory use stays the same however long the connection lasts.
+     * @param depth : number of lines to keep
+     */
+    void setHistoryDepth(int depth);
+
+    /**
+     * @brief Append received lines pushed out of the history to \p fileName
+     *
+     * @param fileName : file to append to, empty to stop spilling
+     * @return False if the file can't be opened
+     */
+    bool setHistorySpillFile(const QString &fileName);
+
+    /**
+     * @brief File received lines are spilled to, empty if spilling is off
+     *
+     * @return QString
+     */
+    QString historySpillFile() const;
+
+    /**
+     * @brief The last received lines
+     *
+     * Call from the thread that created the SerialLayer.
+     * @param count : maximum number of lines, -1 for the whole history
+     * @return lines from the oldest to the newest
+     */
+    QList<QByteArray> recentCommands(int count = -1) const;
+
+    /**
+     * @brief Number of lines received since the port was opened
+     *
+     * @return qint64
+     */
+    qint64 receivedCount() const;
+
     /**
      * @brief Return a QStringList of valids serial baud rates
      *
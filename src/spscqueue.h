@@ -0,0 +1,134 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QVector>
+#include <atomic>
+
+/**
+ * @brief The SpscQueue class
+ * Bounded lock-free queue for exactly one producer thread and one consumer thread.
+ *
+ * push() may only be called from the producer, front() and pop() from the consumer.
+ * The capacity is rounded up to a power of two.
+ */
+template <typename T>
+class SpscQueue
+{
+public:
+    /**
+     * @brief Create a new SpscQueue
+     * @param capacity: maximum number of items in the queue
+     */
+    explicit SpscQueue(uint capacity = 1024)
+    {
+        uint size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        _items.resize(int(size));
+        _data = _items.data();
+        _mask = size - 1;
+    }
+
+    /**
+     * @brief Append \p item, producer only
+     * @return False if the queue is full
+     */
+    bool push(const T &item)
+    {
+        const uint tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _head.load(std::memory_order_acquire) > _mask) {
+            return false;
+        }
+        _data[tail & _mask] = item;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief The oldest item, consumer only
+     * @return nullptr if the queue is empty, valid until the next pop()
+     */
+    const T *front() const
+    {
+        const uint head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &_data[head & _mask];
+    }
+
+    /**
+     * @brief Take the oldest item, consumer only
+     * @param item: set to the oldest item
+     * @return False if the queue is empty
+     */
+    bool pop(T &item)
+    {
+        const uint head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        T &slot = _data[head & _mask];
+        item = slot;
+        slot = T();
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Number of items in the queue, exact only from the producer or the consumer
+     */
+    int size() const
+    {
+        return int(_tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire));
+    }
+
+    /**
+     * @brief True if the queue holds no items
+     */
+    bool isEmpty() const
+    {
+        return size() == 0;
+    }
+
+    /**
+     * @brief Maximum number of items in the queue
+     */
+    int capacity() const
+    {
+        return int(_mask + 1);
+    }
+
+private:
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    QVector<T> _items;
+    T *_data;
+    uint _mask;
+    alignas(64) std::atomic<uint> _head{0};
+    alignas(64) std::atomic<uint> _tail{0};
+};
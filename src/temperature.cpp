@@ -22,116 +22,269 @@
     You should have received a copy of the GNU Lesser General Public
     License along with this library.  If not, see <http://www.gnu.org/licenses/>.
 */
-#include <QRegularExpressionMatch>
-#include <cmath>
+#include <QVector>
 
 #include "temperature.h"
+#include "temperaturereport.h"
 /**
  * @brief The TemperaturePrivate class
  *
- * Private Data of Temperature
+ * Private Data of Temperature, the sensor table as one array per field
  */
 class TemperaturePrivate
 {
 public:
-    float extruderTemp;         //!< @param extruderTemp: Extruder current temperature
-    float extruderTargetTemp;   //!< @param extruderTargetTemp: Extruder target temperature
-    float bedTemp;              //!< @param bedTemp: Bed current temperature
-    float bedTargetTemp;        //!< @param bedTargetTemp: Bed target temperature
+    /**
+     * @brief Row of a sensor, added if it is new
+     * @param type: kind of sensor
+     * @param index: tool or label number
+     */
+    int sensor(Temperature::SensorType type, int index);
+
+    int extruders = 0;                          //!< @param extruders: extruder rows, at the start of the table
+    QVector<Temperature::SensorType> types;     //!< @param types: kind of each sensor
+    QVector<int> indexes;                       //!< @param indexes: tool or label number of each sensor
+    QVector<float> temperatures;                //!< @param temperatures: current temperature of each sensor
+    QVector<float> targets;                     //!< @param targets: target temperature of each sensor
 };
 
+int TemperaturePrivate::sensor(Temperature::SensorType type, int index)
+{
+    const int first = type == Temperature::Extruder ? 0 : extruders;
+    const int last = type == Temperature::Extruder ? extruders : types.size();
+    for (int i = first; i < last; i++) {
+        if (types.at(i) == type && indexes.at(i) == index) {
+            return i;
+        }
+    }
+    // extruders stay in tool order ahead of the other sensors
+    int row = types.size();
+    if (type == Temperature::Extruder) {
+        row = extruders;
+        while (row > 0 && indexes.at(row - 1) > index) {
+            row--;
+        }
+        extruders++;
+    }
+    types.insert(row, type);
+    indexes.insert(row, index);
+    temperatures.insert(row, 0);
+    targets.insert(row, 0);
+    return row;
+}
+
+namespace
+{
+Temperature::SensorType letterType(char letter)
+{
+    switch (letter) {
+    case 'B':
+        return Temperature::Bed;
+    case 'C':
+        return Temperature::Chamber;
+    case 'P':
+        return Temperature::Probe;
+    case 'A':
+        return Temperature::Ambient;
+    case 'R':
+        return Temperature::Redundant;
+    default:
+        return Temperature::Extruder;
+    }
+}
+}
+
 Temperature::Temperature(QObject *parent)
     : QObject(parent)
     , d(new TemperaturePrivate)
 {
+    d->sensor(Extruder, 0);
+    d->sensor(Bed, 0);
+}
+
+Temperature::~Temperature()
+{
+    delete d;
 }
 
 float Temperature::bedTargetTemperature() const
 {
-    return d->bedTargetTemp;
+    const int bed = findSensor(Bed);
+    return bed == -1 ? 0 : d->targets.at(bed);
 }
 
 float Temperature::bedTemperature() const
 {
-    return d->bedTemp;
+    const int bed = findSensor(Bed);
+    return bed == -1 ? 0 : d->temperatures.at(bed);
 }
 
-float Temperature::extruderTargetTemperature() const
+float Temperature::extruderTargetTemperature(int extruder) const
 {
-    return d->extruderTargetTemp;
+    const int row = findSensor(Extruder, extruder);
+    return row == -1 ? 0 : d->targets.at(row);
 }
 
-float Temperature::extruderTemperature() const
+float Temperature::extruderTemperature(int extruder) const
 {
-    return d->extruderTemp;
+    const int row = findSensor(Extruder, extruder);
+    return row == -1 ? 0 : d->temperatures.at(row);
 }
 
-void Temperature::setBedTargetTemperature(float temp)
+int Temperature::extruderCount() const
 {
-    d->bedTargetTemp = temp;
-    emit bedTargetTemperatureChanged(temp);
+    return d->extruders;
 }
 
-void Temperature::setBedTemperature(float temp)
+int Temperature::sensorCount() const
 {
-    d->bedTemp = temp;
-    emit bedTemperatureChanged(temp);
+    return d->types.size();
 }
 
-void Temperature::setExtruderTargetTemperature(float temp)
+int Temperature::findSensor(SensorType type, int index) const
 {
-    d->extruderTargetTemp = temp;
-    emit extruderTargetTemperatureChanged(temp);
+    for (int i = 0; i < d->types.size(); i++) {
+        if (d->types.at(i) == type && d->indexes.at(i) == index) {
+            return i;
+        }
+    }
+    return -1;
 }
 
-void Temperature::setExtruderTemperature(float temp)
+Temperature::SensorType Temperature::sensorType(int sensor) const
 {
-    d->extruderTemp = temp;
-    emit extruderTemperatureChanged(temp);
+    return d->types.at(sensor);
 }
 
-void Temperature::decodeTemp(const QByteArray &msg)
+int Temperature::sensorIndex(int sensor) const
+{
+    return d->indexes.at(sensor);
+}
+
+float Temperature::temperature(int sensor) const
+{
+    return d->temperatures.at(sensor);
+}
+
+float Temperature::targetTemperature(int sensor) const
+{
+    return d->targets.at(sensor);
+}
+
+void Temperature::setBedTargetTemperature(float temp)
 {
-    int bloc = msg.indexOf(QStringLiteral("B:"));
+    const int row = d->sensor(Bed, 0);
+    const float old = d->targets.at(row);
+    d->targets[row] = temp;
+    if (temp != old) {
+        emit bedTargetTemperatureChanged(temp);
+    }
+    emit temperaturesChanged();
+}
 
-    float firstTargetTemperature = 0;
-    float secondTargetTemperature = 0;
+void Temperature::setBedTemperature(float temp)
+{
+    const int row = d->sensor(Bed, 0);
+    const float old = d->temperatures.at(row);
+    d->temperatures[row] = temp;
+    if (temp != old) {
+        emit bedTemperatureChanged(temp);
+    }
+    emit temperaturesChanged();
+}
 
-    QRegularExpression tempRegEx(QStringLiteral("(T:(?<extruder>\\d+\\.?\\d*))"));
-    QRegularExpression targetTempRegEx(QStringLiteral("(\\/)(?<extruderTarget>\\d*)(.+)"));
-    QRegularExpressionMatch tempCheck = tempRegEx.match(QString::fromLatin1(msg));
-    QRegularExpressionMatch targetTempCheck = targetTempRegEx.match(QString::fromLatin1(msg));
+void Temperature::setExtruderTargetTemperature(float temp, int extruder)
+{
+    const int row = d->sensor(Extruder, extruder);
+    const float old = d->targets.at(row);
+    d->targets[row] = temp;
+    if (extruder == 0 && temp != old) {
+        emit extruderTargetTemperatureChanged(temp);
+    }
+    emit temperaturesChanged();
+}
 
-    if (tempCheck.hasMatch()) {
-        setExtruderTemperature(tempCheck.captured(QStringLiteral("extruder")).toFloat());
+void Temperature::setExtruderTemperature(float temp, int extruder)
+{
+    const int row = d->sensor(Extruder, extruder);
+    const float old = d->temperatures.at(row);
+    d->temperatures[row] = temp;
+    if (extruder == 0 && temp != old) {
+        emit extruderTemperatureChanged(temp);
     }
+    emit temperaturesChanged();
+}
 
-    if (targetTempCheck.hasMatch()) {
-        firstTargetTemperature = targetTempCheck.captured(QStringLiteral("extruderTarget")).toFloat();
+void Temperature::setExtruderCount(int count)
+{
+    count = qMax(count, 1);
+    if (count == d->extruders) {
+        return;
     }
+    // extruders are sorted by tool, the ones past count are at the end of the block
+    int keep = 0;
+    while (keep < d->extruders && d->indexes.at(keep) < count) {
+        keep++;
+    }
+    const int removed = d->extruders - keep;
+    d->types.remove(keep, removed);
+    d->indexes.remove(keep, removed);
+    d->temperatures.remove(keep, removed);
+    d->targets.remove(keep, removed);
+    d->extruders = keep;
+    for (int i = 0; i < count; i++) {
+        d->sensor(Extruder, i);
+    }
+    emit temperaturesChanged();
+}
 
-    if (bloc != -1) {
-        QRegularExpression bedRegEx(QStringLiteral("(B:(?<bed>\\d+\\.?\\d*))"));
-        QRegularExpressionMatch bedCheck = bedRegEx.match(QString::fromLatin1(msg));
-        QRegularExpression targetBedRegEx(QStringLiteral("B:(.+)(\\/)(?<bedTarget>\\d+)"));
-        QRegularExpressionMatch targetBedCheck = targetBedRegEx.match(QString::fromLatin1(msg));
+void Temperature::decodeTemp(const QByteArray &msg)
+{
+    TemperatureReport report;
+    if (!report.parse(msg)) {
+        return;
+    }
 
-        if (bedCheck.hasMatch()) {
-            setBedTemperature(bedCheck.captured(QStringLiteral("bed")).toFloat());
+    //Firmwares with several extruders report each as T0, T1.. and the active one again as T
+    bool numberedExtruders = false;
+    for (int i = 0; i < report.sensorCount(); i++) {
+        if (report.sensor(i).letter == 'T' && report.sensor(i).index >= 0) {
+            numberedExtruders = true;
+            break;
         }
+    }
 
-        if (targetBedCheck.hasMatch()) {
-            secondTargetTemperature = targetBedCheck.captured(QStringLiteral("bedTarget")).toFloat();
+    const float bed = bedTemperature();
+    const float bedTarget = bedTargetTemperature();
+    const float extruder = extruderTemperature();
+    const float extruderTarget = extruderTargetTemperature();
+    for (int i = 0; i < report.sensorCount(); i++) {
+        const TemperatureReport::Sensor &sensor = report.sensor(i);
+        if (sensor.letter == 'T' && sensor.index < 0 && numberedExtruders) {
+            continue;
         }
+        const int row = d->sensor(letterType(sensor.letter), qMax(int(sensor.index), 0));
+        d->temperatures[row] = sensor.temperature;
+        if (sensor.hasTarget) {
+            d->targets[row] = sensor.target;
+        }
+    }
+    emitFieldChanges(bed, bedTarget, extruder, extruderTarget);
+    emit temperaturesChanged();
+}
+
+void Temperature::emitFieldChanges(float bed, float bedTarget, float extruder, float extruderTarget)
+{
+    if (bedTemperature() != bed) {
+        emit bedTemperatureChanged(bedTemperature());
+    }
+    if (bedTargetTemperature() != bedTarget) {
+        emit bedTargetTemperatureChanged(bedTargetTemperature());
+    }
+    if (extruderTemperature() != extruder) {
+        emit extruderTemperatureChanged(extruderTemperature());
     }
-    //Currently the first value after / is stored in firstTargetTemperature and the second / in secondTargetTemperature
-    //Because of this we need to check what came first in the return and place the values
-    //The regex for temperature needs to look at the whole T: or B: block to correctly decode targets
-    if (bloc < msg.indexOf(QStringLiteral("T:")) && bloc != -1) {
-        setExtruderTargetTemperature(secondTargetTemperature);
-        setBedTargetTemperature(firstTargetTemperature);
-    } else {
-        setExtruderTargetTemperature(firstTargetTemperature);
-        setBedTargetTemperature(secondTargetTemperature);
+    if (extruderTargetTemperature() != extruderTarget) {
+        emit extruderTargetTemperatureChanged(extruderTargetTemperature());
     }
 }
@@ -32,6 +32,13 @@ class TemperaturePrivate;
  * @brief The Temperature class
  *
  * Read and hold the Temperature info for the printer
+ *
+ * Every heater and sensor the firmware reports is a row of a sensor table:
+ * the extruders first, one per tool, then the bed and any chamber, probe,
+ * ambient or redundant sensor in the order they were first reported. Rows are
+ * addressed by index, see findSensor(). Each report updates the table and
+ * emits temperaturesChanged() once, after the signals of the bed and first
+ * extruder fields that changed.
  */
 class ATCORE_EXPORT Temperature : public QObject
 {
@@ -40,14 +47,31 @@ class ATCORE_EXPORT Temperature : public QObject
     Q_PROPERTY(float bedTargetTemperature READ bedTargetTemperature WRITE setBedTargetTemperature NOTIFY bedTargetTemperatureChanged)
     Q_PROPERTY(float extruderTemperature READ extruderTemperature WRITE setExtruderTemperature NOTIFY extruderTemperatureChanged)
     Q_PROPERTY(float extruderTargetTemperature READ extruderTargetTemperature WRITE setExtruderTargetTemperature NOTIFY extruderTargetTemperatureChanged)
+    Q_PROPERTY(int extruderCount READ extruderCount WRITE setExtruderCount NOTIFY temperaturesChanged)
+    Q_PROPERTY(int sensorCount READ sensorCount NOTIFY temperaturesChanged)
 
 public:
+    /**
+     * @brief Kinds of sensors a firmware reports
+     */
+    enum SensorType {
+        Extruder,   //!< T, T0, T1...
+        Bed,        //!< B
+        Chamber,    //!< C
+        Probe,      //!< P
+        Ambient,    //!< A
+        Redundant   //!< R
+    };
+    Q_ENUM(SensorType)
+
     /**
      * @brief Create a new Temperature object
      * @param parent
      */
     explicit Temperature(QObject *parent = nullptr);
 
+    ~Temperature();
+
     /**
      * @brief Get bed current temperature
      */
@@ -60,13 +84,54 @@ public:
 
     /**
      * @brief Get extruder temperature
+     * @param extruder: tool number
      */
-    float extruderTemperature() const;
+    float extruderTemperature(int extruder = 0) const;
 
     /**
      * @brief Get extruder target temperature
+     * @param extruder: tool number
+     */
+    float extruderTargetTemperature(int extruder = 0) const;
+
+    /**
+     * @brief Number of extruders in the sensor table
+     * @sa setExtruderCount()
+     */
+    int extruderCount() const;
+
+    /**
+     * @brief Number of rows in the sensor table
+     */
+    int sensorCount() const;
+
+    /**
+     * @brief Row of a sensor
+     * @param type: kind of sensor
+     * @param index: tool number for extruders, the number after the label otherwise
+     * @return -1 if the sensor was never reported
      */
-    float extruderTargetTemperature() const;
+    int findSensor(SensorType type, int index = 0) const;
+
+    /**
+     * @brief Kind of the sensor in row \p sensor
+     */
+    SensorType sensorType(int sensor) const;
+
+    /**
+     * @brief Tool number or label number of the sensor in row \p sensor
+     */
+    int sensorIndex(int sensor) const;
+
+    /**
+     * @brief Current temperature of the sensor in row \p sensor
+     */
+    float temperature(int sensor) const;
+
+    /**
+     * @brief Target temperature of the sensor in row \p sensor, 0 for sensors without a heater
+     */
+    float targetTemperature(int sensor) const;
 
     /**
      * @brief decode Temp values from string \p msg
@@ -90,14 +155,22 @@ public slots:
     /**
      * @brief Set exturder temperature
      * @param temp: bed temperature
+     * @param extruder: tool number
      */
-    void setExtruderTemperature(float temp);
+    void setExtruderTemperature(float temp, int extruder = 0);
 
     /**
     * @brief Set extruder target temperature
     * @param temp: extruder target temperature
+    * @param extruder: tool number
     */
-    void setExtruderTargetTemperature(float temp);
+    void setExtruderTargetTemperature(float temp, int extruder = 0);
+
+    /**
+     * @brief Size the table for the extruders of the printer
+     * @param count: extruders the firmware has, from EXTRUDER_COUNT of M115
+     */
+    void setExtruderCount(int count);
 
 signals:
     /**
@@ -113,17 +186,27 @@ signals:
     void bedTargetTemperatureChanged(float temp);
 
     /**
-     * @brief extruder temperature has changed
+     * @brief extruder temperature has changed, for tool 0 only
      * @param temp : new extruder temperature
      */
     void extruderTemperatureChanged(float temp);
 
     /**
-     * @brief extruder target temperature has changed
+     * @brief extruder target temperature has changed, for tool 0 only
      * @param temp : new extruder target temperature
      */
     void extruderTargetTemperatureChanged(float temp);
 
+    /**
+     * @brief Temperatures or the sensor table have changed, once per report
+     */
+    void temperaturesChanged();
+
 private:
+    /**
+     * @brief Emit the signals of the bed and first extruder fields that differ from the given values
+     */
+    void emitFieldChanges(float bed, float bedTarget, float extruder, float extruderTarget);
+
     TemperaturePrivate *d;
 };
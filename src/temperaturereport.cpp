@@ -0,0 +1,134 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "gcodeline.h"
+#include "temperaturereport.h"
+
+namespace
+{
+bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+bool isSensorLetter(char c)
+{
+    switch (c) {
+    case 'T':
+    case 'B':
+    case 'C':
+    case 'P':
+    case 'A':
+    case 'R':
+        return true;
+    default:
+        return false;
+    }
+}
+
+const char *skipBlanks(const char *p, const char *end)
+{
+    while (p < end && isBlank(*p)) {
+        p++;
+    }
+    return p;
+}
+}
+
+TemperatureReport::TemperatureReport() :
+    _count(0)
+{
+}
+
+bool TemperatureReport::parse(const char *begin, const char *end)
+{
+    _count = 0;
+    const char *p = begin;
+    while (p < end && _count < MaxSensors) {
+        p = skipBlanks(p, end);
+        if (p == end) {
+            break;
+        }
+
+        // a label starts a word: a letter, an optional index and ':'
+        const char *q = p;
+        if (isSensorLetter(*q)) {
+            q++;
+            int index = -1;
+            if (q < end && isDigit(*q)) {
+                index = *q++ - '0';
+                if (q < end && isDigit(*q)) {
+                    index = index * 10 + (*q++ - '0');
+                }
+            }
+            double temperature = 0;
+            if (q < end && *q == ':' && GCodeLine::parseNumber(++q, end, temperature)) {
+                Sensor &sensor = _sensors[_count++];
+                sensor.letter = *p;
+                sensor.index = (signed char)index;
+                sensor.temperature = float(temperature);
+                sensor.hasTarget = false;
+                sensor.target = 0;
+
+                // " /210", "/210" or " / 210"
+                const char *r = skipBlanks(q, end);
+                double target = 0;
+                if (r < end && *r == '/') {
+                    r = skipBlanks(r + 1, end);
+                    if (GCodeLine::parseNumber(r, end, target)) {
+                        sensor.hasTarget = true;
+                        sensor.target = float(target);
+                        q = r;
+                    }
+                }
+            }
+        }
+
+        // on to the next word
+        while (q < end && !isBlank(*q)) {
+            q++;
+        }
+        p = q;
+    }
+    return _count > 0;
+}
+
+bool TemperatureReport::parse(const QByteArray &message)
+{
+    return parse(message.constData(), message.constData() + message.size());
+}
+
+const TemperatureReport::Sensor *TemperatureReport::find(char letter, int index) const
+{
+    for (int i = 0; i < _count; i++) {
+        if (_sensors[i].letter == letter && _sensors[i].index == index) {
+            return &_sensors[i];
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,103 @@
+/* AtCore
+    Copyright (C) <2018>
+
+    Authors:
+        Patrick José Pereira <patrickelectric@gmail.com>
+        Chris Rizzitello <rizzitello@kde.org>
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QByteArray>
+
+#include "atcore_export.h"
+
+/**
+ * @brief The TemperatureReport class
+ * A temperature report of the firmware, scanned in a single pass without allocating.
+ *
+ * Reports are a list of sensors, each a label, its temperature and an optional
+ * target after '/', like "ok T:210.2 /210.0 B:60.1 /60.0 T0:210.2 /210.0 @:0 B@:0".
+ * Labels are T for extruders, B for the bed, C for the chamber, P for the probe,
+ * A for ambient and R for the redundant sensor, with an optional index like T1.
+ * Anything else, "ok", power words like "@:0" or "B@:0", is skipped.
+ */
+class ATCORE_EXPORT TemperatureReport
+{
+public:
+    /**
+     * @brief Most sensors kept, the ones after are skipped
+     */
+    enum { MaxSensors = 16 };
+
+    /**
+     * @brief A sensor of the report
+     */
+    struct Sensor {
+        char letter;            //!< @param letter: label letter, 'T', 'B', 'C', 'P', 'A' or 'R'
+        signed char index;      //!< @param index: number after the letter, -1 if none
+        bool hasTarget;         //!< @param hasTarget: a target follows the temperature
+        float temperature;      //!< @param temperature: current temperature
+        float target;           //!< @param target: target temperature, 0 if none
+    };
+
+    TemperatureReport();
+
+    /**
+     * @brief Scan a report
+     * @param begin: first character of the message
+     * @param end: character after the message
+     * @return False if there is no sensor in the message
+     */
+    bool parse(const char *begin, const char *end);
+
+    /**
+     * @brief Scan a report
+     * @param message: message from the printer
+     * @return False if there is no sensor in the message
+     */
+    bool parse(const QByteArray &message);
+
+    /**
+     * @brief Number of sensors found
+     */
+    int sensorCount() const
+    {
+        return _count;
+    }
+
+    /**
+     * @brief Sensor \p i, in the order of the report
+     */
+    const Sensor &sensor(int i) const
+    {
+        return _sensors[i];
+    }
+
+    /**
+     * @brief First sensor with \p letter and \p index
+     * @param letter: label letter
+     * @param index: number after the letter, -1 for none
+     * @return nullptr if the report has no such sensor
+     */
+    const Sensor *find(char letter, int index = -1) const;
+
+private:
+    int _count;                         //!< @param _count: sensors found
+    Sensor _sensors[MaxSensors];        //!< @param _sensors: sensors found, in order
+};
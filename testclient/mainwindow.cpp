@@ -111,26 +111,7 @@ MainWindow::MainWindow(QWidget *parent) :
         ui->sdFileListView->addItems(fileList);
     });
 
-    connect(&core->temperature(), &Temperature::bedTemperatureChanged, [ this ](float temp) {
-        checkTemperature(0x00, 0, temp);
-        ui->plotWidget->appendPoint(tr("Actual Bed"), temp);
-        ui->plotWidget->update();
-    });
-    connect(&core->temperature(), &Temperature::bedTargetTemperatureChanged, [ this ](float temp) {
-        checkTemperature(0x01, 0, temp);
-        ui->plotWidget->appendPoint(tr("Target Bed"), temp);
-        ui->plotWidget->update();
-    });
-    connect(&core->temperature(), &Temperature::extruderTemperatureChanged, [ this ](float temp) {
-        checkTemperature(0x02, 0, temp);
-        ui->plotWidget->appendPoint(tr("Actual Ext.1"), temp);
-        ui->plotWidget->update();
-    });
-    connect(&core->temperature(), &Temperature::extruderTargetTemperatureChanged, [ this ](float temp) {
-        checkTemperature(0x03, 0, temp);
-        ui->plotWidget->appendPoint(tr("Target Ext.1"), temp);
-        ui->plotWidget->update();
-    });
+    connect(&core->temperature(), &Temperature::temperaturesChanged, this, &MainWindow::temperaturesChanged);
 
     connect(ui->actionQuit, &QAction::triggered, this, &MainWindow::close);
     connect(ui->actionShowDockTitles, &QAction::toggled, this, &MainWindow::toggleDockTitles);
@@ -241,8 +222,45 @@ void MainWindow::checkPushedCommands(QByteArray bmsg)
     addSLog(msg);
 }
 
+void MainWindow::temperaturesChanged()
+{
+    const Temperature &temperature = core->temperature();
+    for (int sensor = 0; sensor < temperature.sensorCount(); sensor++) {
+        const int number = temperature.sensorIndex(sensor);
+        switch (temperature.sensorType(sensor)) {
+        case Temperature::Extruder:
+            checkTemperature(0x02, number, temperature.temperature(sensor));
+            checkTemperature(0x03, number, temperature.targetTemperature(sensor));
+            break;
+        case Temperature::Bed:
+            checkTemperature(0x00, number, temperature.temperature(sensor));
+            checkTemperature(0x01, number, temperature.targetTemperature(sensor));
+            break;
+        case Temperature::Chamber:
+            checkTemperature(0x04, number, temperature.temperature(sensor));
+            checkTemperature(0x05, number, temperature.targetTemperature(sensor));
+            break;
+        default:
+            break;
+        }
+    }
+
+    ui->plotWidget->appendPoint(tr("Actual Bed"), temperature.bedTemperature());
+    ui->plotWidget->appendPoint(tr("Target Bed"), temperature.bedTargetTemperature());
+    ui->plotWidget->appendPoint(tr("Actual Ext.1"), temperature.extruderTemperature());
+    ui->plotWidget->appendPoint(tr("Target Ext.1"), temperature.extruderTargetTemperature());
+    ui->plotWidget->update();
+}
+
 void MainWindow::checkTemperature(uint sensorType, uint number, uint temp)
 {
+    // reports come every second or so, only log what changed
+    const QPair<uint, uint> sensor(sensorType, number);
+    if (loggedTemperatures.contains(sensor) && loggedTemperatures.value(sensor) == temp) {
+        return;
+    }
+    loggedTemperatures.insert(sensor, temp);
+
     QString msg;
     switch (sensorType) {
     case 0x00: // bed
@@ -494,6 +512,7 @@ void MainWindow::printerStateChanged(AtCore::STATES state)
 
     case AtCore::DISCONNECTED:
         stateString = QStringLiteral("Not Connected");
+        loggedTemperatures.clear();
         ui->commandDock->setDisabled(true);
         ui->moveDock->setDisabled(true);
         ui->tempControlsDock->setDisabled(true);
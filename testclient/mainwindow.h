@@ -22,6 +22,7 @@
 */
 #pragma once
 
+#include <QHash>
 #include <QTemporaryFile>
 #include <QMainWindow>
 #include <QSerialPort>
@@ -54,7 +55,7 @@ public slots:
     void checkPushedCommands(QByteArray);
 
     /**
-     * @brief Check temperature
+     * @brief Check temperature, logged if it differs from the one last logged
      *
      * @param  sensorType : type of sensor
      * @param  number     : index of sensor
@@ -62,6 +63,11 @@ public slots:
      */
     void checkTemperature(uint sensorType, uint number, uint temp);
 
+    /**
+     * @brief Log and plot the sensors of a temperature report
+     */
+    void temperaturesChanged();
+
 private slots:
     //ButtonEvents
     /**
@@ -197,6 +203,8 @@ private:
     QTemporaryFile *logFile;
     QTime *printTime;
     QTimer *printTimer;
+    // Temperatures last logged by sensor type and index
+    QHash<QPair<uint, uint>, uint> loggedTemperatures;
     // Define max number of fans
     static int fanCount;
 
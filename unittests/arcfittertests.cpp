@@ -0,0 +1,160 @@
+/*
+    This file is part of the KDE project
+
+    Copyright (C) 2018 Patrick José Pereira <patrickelectric@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QtTest>
+#include <cmath>
+
+#include "arcfittertests.h"
+
+namespace
+{
+/**
+ * @brief G1 moves along the circle around \p x, \p y from \p from to \p to degrees
+ * @param e: E word of each move, -1 for none
+ */
+QList<QByteArray> circle(double x, double y, double radius, int from, int to, int steps, double e)
+{
+    QList<QByteArray> moves;
+    for (int i = 1; i <= steps; i++) {
+        const double angle = (from + (to - from) * double(i) / steps) * M_PI / 180;
+        QByteArray move = "G1 X" + QByteArray::number(x + radius * std::cos(angle), 'f', 3)
+                          + " Y" + QByteArray::number(y + radius * std::sin(angle), 'f', 3);
+        if (e >= 0) {
+            move += " E" + QByteArray::number(e, 'f', 5);
+        }
+        moves.append(move);
+    }
+    return moves;
+}
+}
+
+QVector<ArcFitter::Line> ArcFitterTests::fit(ArcFitter &fitter, const QList<QByteArray> &commands)
+{
+    QVector<ArcFitter::Line> output;
+    qint64 offset = 0;
+    for (const QByteArray &command : commands) {
+        offset += command.size() + 1;
+        fitter.addLine({command, offset, offset}, output);
+    }
+    fitter.flush(output);
+    return output;
+}
+
+void ArcFitterTests::testCounterClockwise()
+{
+    ArcFitter fitter;
+    QList<QByteArray> job = {"G90", "M83", "G1 X20 Y10 F1800"};
+    job += circle(10, 10, 10, 0, 180, 18, 0.05236);
+    const QVector<ArcFitter::Line> output = fit(fitter, job);
+
+    QVERIFY(output.size() == 4);
+    QVERIFY(output.at(3).command == QByteArray("G3 X0.000 Y10.000 I-10.000 J0.000 E0.94248"));
+    QVERIFY(fitter.arcs() == 1);
+    QVERIFY(fitter.replacedMoves() == 18);
+    QVERIFY(fitter.isEmpty());
+
+    // the arc ends where its last move did
+    qint64 size = 0;
+    for (const QByteArray &command : job) {
+        size += command.size() + 1;
+    }
+    QVERIFY(output.at(3).offset == size);
+}
+
+void ArcFitterTests::testClockwiseAbsoluteE()
+{
+    ArcFitter fitter;
+    QList<QByteArray> job = {"G90", "M82", "G92 E0", "G1 X0 Y40"};
+    for (const QByteArray &move : circle(0, 30, 10, 90, 0, 10, -1)) {
+        job.append(move + " E" + QByteArray::number(0.1 * (job.size() - 3), 'f', 5));
+    }
+    job.append("G1 Z0.4");
+    const QVector<ArcFitter::Line> output = fit(fitter, job);
+
+    QVERIFY(output.size() == 6);
+    // the E of the last move, not a sum
+    QVERIFY(output.at(4).command == QByteArray("G2 X10.000 Y30.000 I0.000 J-10.000 E1.00000"));
+    QVERIFY(output.at(5).command == QByteArray("G1 Z0.4"));
+}
+
+void ArcFitterTests::testStraightLines()
+{
+    ArcFitter fitter;
+    const QList<QByteArray> job = {"G90", "G1 X0 Y0", "G1 X10 Y0 E1", "G1 X20 Y0 E1", "G1 X30 Y0 E1", "G1 X30 Y10 E1", "G1 X30 Y20 E1"};
+    const QVector<ArcFitter::Line> output = fit(fitter, job);
+    QVERIFY(output.size() == job.size());
+    for (int i = 0; i < job.size(); i++) {
+        QVERIFY(output.at(i).command == job.at(i));
+    }
+    QVERIFY(fitter.arcs() == 0);
+}
+
+void ArcFitterTests::testTolerance()
+{
+    // a 0.1 mm bump in the middle of a quarter circle
+    QList<QByteArray> job = {"G90", "G1 X10 Y0"};
+    QList<QByteArray> moves = circle(0, 0, 10, 0, 90, 10, -1);
+    moves[4] = circle(0, 0, 10.1, 0, 90, 10, -1).at(4);
+    job += moves;
+
+    ArcFitter loose;
+    loose.setTolerance(0.2);
+    fit(loose, job);
+    QVERIFY(loose.arcs() == 1);
+
+    ArcFitter tight;
+    tight.setTolerance(0.05);
+    fit(tight, job);
+    QVERIFY(tight.replacedMoves() < 10);
+}
+
+void ArcFitterTests::testRunBreaks()
+{
+    // a Z move, a change of feedrate and travel after extrusion each end an arc
+    QList<QByteArray> job = {"G90", "M83", "G1 X10 Y0"};
+    job += circle(0, 0, 10, 0, 90, 18, 0.1);
+    job.append("G1 Z1");
+    job += circle(0, 0, 10, 90, 180, 18, 0.1);
+    QList<QByteArray> slower = circle(0, 0, 10, 180, 270, 18, 0.1);
+    slower[0] += " F600";
+    job += slower;
+    job += circle(0, 0, 10, 270, 360, 18, -1);
+
+    ArcFitter fitter;
+    const QVector<ArcFitter::Line> output = fit(fitter, job);
+    QVERIFY(fitter.arcs() == 4);
+    QVERIFY(output.at(4).command == QByteArray("G1 Z1"));
+    QVERIFY(output.at(6).command.startsWith("G3") && output.at(6).command.endsWith(" F600"));
+    QVERIFY(!output.last().command.contains(" E"));
+}
+
+void ArcFitterTests::testRelativeMoves()
+{
+    ArcFitter fitter;
+    QList<QByteArray> job = {"G91", "G1 X10 Y0"};
+    job += circle(0, 0, 10, 0, 90, 18, -1);
+    job.append("G90");
+    job += circle(0, 0, 10, 90, 180, 18, -1);
+    const QVector<ArcFitter::Line> output = fit(fitter, job);
+    // the position is lost in relative mode, it takes an absolute X and Y to find it again
+    QVERIFY(fitter.arcs() == 1);
+    QVERIFY(fitter.replacedMoves() == 17);
+    QVERIFY(output.at(2).command == job.at(2));
+}
+
+QTEST_MAIN(ArcFitterTests)
@@ -0,0 +1,35 @@
+/*
+    This file is part of the KDE project
+
+    Copyright (C) 2018 Patrick José Pereira <patrickelectric@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QObject>
+
+#include "../src/arcfitter.h"
+
+class ArcFitterTests: public QObject
+{
+    Q_OBJECT
+private slots:
+    void testCounterClockwise();
+    void testClockwiseAbsoluteE();
+    void testStraightLines();
+    void testTolerance();
+    void testRunBreaks();
+    void testRelativeMoves();
+private:
+    QVector<ArcFitter::Line> fit(ArcFitter &fitter, const QList<QByteArray> &commands);
+};
@@ -19,6 +19,10 @@
 #include <algorithm>
 
 #include "atcoretests.h"
+#include "testfile.h"
+#include "../src/printjournal.h"
+#include "../src/retransmitbuffer.h"
+#include "../src/seriallayer.h"
 
 void AtCoreTests::initTestCase()
 {
@@ -102,6 +106,12 @@ void AtCoreTests::testPluginMarlin_validate()
     core->firmwarePlugin()->validateCommand(QStringLiteral("ok"));
     core->firmwarePlugin()->validateCommand(QStringLiteral("other text"));
     QVERIFY(sSpy.count() == 1);
+    // temperatures reported after M155 are no acknowledge
+    core->firmwarePlugin()->validateCommand(QStringLiteral(" T:210.00 /210.00 B:60.00 /60.00 @:64 B@:0"));
+    core->firmwarePlugin()->validateCommand(QStringLiteral("echo:SD card ok"));
+    QVERIFY(sSpy.count() == 1);
+    core->firmwarePlugin()->validateCommand(QStringLiteral("ok T:210.00 /210.00 B:60.00 /60.00 @:64 B@:0"));
+    QVERIFY(sSpy.count() == 2);
 }
 
 void AtCoreTests::testPluginRepetier_load()
@@ -119,6 +129,77 @@ void AtCoreTests::testPluginRepetier_validate()
     QVERIFY(sSpy.count() == 1);
 }
 
+void AtCoreTests::testPluginRepetier_binary()
+{
+    // expected frames follow the layout GCode::parseBinary() of Repetier-Firmware reads
+    core->loadFirmwarePlugin(QStringLiteral("repetier"));
+    IFirmware *plugin = core->firmwarePlugin();
+    QVERIFY(plugin->translate(QStringLiteral("G1 X10")) == "G1 X10");
+    QVERIFY(!plugin->isBinary("G1 X10"));
+
+    // the Fletcher-16 check of GCode::parseBinary(), both sums modulo 255
+    const auto checksumValid = [](const QByteArray &frame) {
+        uint sum1 = 0;
+        uint sum2 = 0;
+        for (int i = 0; i < frame.size() - 2; i++) {
+            sum1 = (sum1 + uchar(frame.at(i))) % 255;
+            sum2 = (sum2 + sum1) % 255;
+        }
+        return frame.size() > 2 && uchar(frame.at(frame.size() - 2)) == sum1 && uchar(frame.at(frame.size() - 1)) == sum2;
+    };
+
+    // frames assembled field by field as the firmware reads them, little endian
+    plugin->validateCommand(QStringLiteral("REPETIER_PROTOCOL:1"));
+    QByteArray frame = plugin->translate(QStringLiteral("G1 X10 F3000"));
+    QVERIFY(checksumValid(frame));
+    QVERIFY(frame.left(frame.size() - 2) == QByteArray::fromHex("8c01"       // params: G, X, F and bit 7
+                                                                "01"         // G, 8 bit in version 1
+                                                                "00002041"   // X 10.0f
+                                                                "00803b45")); // F 3000.0f
+    plugin->validateCommand(QStringLiteral("REPETIER_PROTOCOL:2"));
+    frame = plugin->translate(QStringLiteral("M117 Hello"));
+    QVERIFY(checksumValid(frame));
+    QVERIFY(frame.left(frame.size() - 2) == QByteArray::fromHex("8290"         // params: M, bit 7, version 2 and string
+                                                                "0000"         // params2
+                                                                "05"           // string length
+                                                                "7500"         // M, 16 bit in version 2
+                                                                "48656c6c6f")); // "Hello"
+
+    // the whole number is the version, later versions speak version 2
+    plugin->validateCommand(QStringLiteral("REPETIER_PROTOCOL:10"));
+    QVERIFY(plugin->translate(QStringLiteral("M117 Hello")) == QByteArray::fromHex("8290000005750048656c6c6f833f"));
+    plugin->validateCommand(QStringLiteral("REPETIER_PROTOCOL:x"));
+    QVERIFY(plugin->translate(QStringLiteral("G1 X10")) == "G1 X10");
+
+    // version 1: 8 bit G and M, strings padded to 16 bytes
+    plugin->validateCommand(QStringLiteral("REPETIER_PROTOCOL:1"));
+    frame = plugin->translate(QStringLiteral("G1 X10 Y-2.5 F3000"));
+    QVERIFY(plugin->isBinary(frame));
+    QVERIFY(frame == QByteArray::fromHex("9c010100002041000020c000803b45e196"));
+    QVERIFY(plugin->translate(QStringLiteral("M117 Hello")) == QByteArray::fromHex("82807548656c6c6f00000000000000000000006ea3"));
+    QVERIFY(plugin->translate(QStringLiteral("N12 G28 X")) == QByteArray::fromHex("8d000c001c00000000b5da"));
+    QVERIFY(plugin->translate(QStringLiteral("M109 S200 T1")) == QByteArray::fromHex("82066d01c8000000bff6"));
+    // no params2 and no strings over 16 bytes, those stay ASCII
+    QVERIFY(plugin->translate(QStringLiteral("G2 X1 Y1 I0.5 J-0.5")) == "G2 X1 Y1 I0.5 J-0.5");
+    QVERIFY(plugin->translate(QStringLiteral("M117 This message is too long")) == "M117 This message is too long");
+
+    // version 2: params2, 16 bit G and M, strings sized by their length byte
+    plugin->validateCommand(QStringLiteral("REPETIER_PROTOCOL:2"));
+    QVERIFY(plugin->translate(QStringLiteral("G1 X10 Y-2.5 F3000")) == QByteArray::fromHex("9c110000010000002041000020c000803b45f181"));
+    QVERIFY(plugin->translate(QStringLiteral("M117 Hello")) == QByteArray::fromHex("8290000005750048656c6c6f833f"));
+    QVERIFY(plugin->translate(QStringLiteral("N12 G28 X")) == QByteArray::fromHex("8d1000000c001c0000000000c55c"));
+    QVERIFY(plugin->translate(QStringLiteral("G2 X1 Y1 I0.5 J-0.5")) == QByteArray::fromHex("9c10030002000000803f0000803f0000003f000000bf309e"));
+
+    // numbered lines carry an ASCII checksum, they are never encoded
+    QVERIFY(plugin->translate(QStringLiteral("N12 G1 X1*45")) == "N12 G1 X1*45");
+    core->setLineNumbering(true);
+    QVERIFY(plugin->translate(QStringLiteral("G1 X10")) == "G1 X10");
+    core->setLineNumbering(false);
+
+    plugin->validateCommand(QStringLiteral("REPETIER_PROTOCOL:0"));
+    QVERIFY(plugin->translate(QStringLiteral("G1 X10")) == "G1 X10");
+}
+
 void AtCoreTests::testPluginSmoothie_load()
 {
     core->loadFirmwarePlugin(QStringLiteral("smoothie"));
@@ -171,4 +252,299 @@ void AtCoreTests::testPluginTeacup_translate()
     QVERIFY(core->firmwarePlugin()->translate(QStringLiteral("M190 S50")) == "M140 S50\r\nM116");
 }
 
+void AtCoreTests::testStreamingWindow()
+{
+    QVERIFY(core->streamingWindow() == false);
+    QVERIFY(core->commandWindow() == 1);
+
+    core->setStreamingWindow(true);
+    QVERIFY(core->commandWindow() == 1);
+
+    core->loadFirmwarePlugin(QStringLiteral("marlin"));
+    QVERIFY(core->firmwarePlugin()->bufferSize() == 127);
+    QVERIFY(core->commandWindow() > 1);
+
+    core->setStreamingWindow(false);
+    QVERIFY(core->commandWindow() == 1);
+}
+
+void AtCoreTests::testStreamingBytes()
+{
+    TestPort port;
+    if (!port.isOpen()) {
+        QSKIP("Needs a pseudo terminal");
+    }
+    // 18 characters, 20 bytes on the wire with "\n\r"
+    QList<QByteArray> sent;
+    for (int i = 0; i < 10; i++) {
+        sent.append(QStringLiteral("G1 X1%1.000 Y10.000").arg(i).toLatin1());
+    }
+
+    AtCore atcore;
+    QVERIFY(atcore.initSerial(port.portName(), 115200));
+    atcore.loadFirmwarePlugin(QStringLiteral("marlin"));
+    QVERIFY(atcore.firmwarePlugin()->bufferSize() == 127);
+    atcore.setStreamingWindow(true);
+    for (const QByteArray &command : sent) {
+        atcore.pushCommand(QString::fromLatin1(command));
+    }
+
+    // 6 * 20 bytes fit in 127, the 7th waits for an "ok"
+    QVERIFY(port.readCommands(6) == sent.mid(0, 6));
+    QVERIFY(port.readCommands(1, 200).isEmpty());
+    QVERIFY(port.write("ok
+"));
+    QVERIFY(port.readCommands(1) == sent.mid(6, 1));
+    QVERIFY(port.readCommands(1, 200).isEmpty());
+
+    // ADVANCED_OK reports 2 free slots, 5 commands are still in flight
+    QVERIFY(port.write("ok N0 P15 B2
+"));
+    QVERIFY(port.readCommands(1, 200).isEmpty());
+    QVERIFY(port.write("ok
+ok
+ok
+"));
+    QVERIFY(port.readCommands(1, 200).isEmpty());
+    QVERIFY(port.write("ok
+"));
+    QVERIFY(port.readCommands(1) == sent.mid(7, 1));
+    QVERIFY(port.readCommands(1, 200).isEmpty());
+    QVERIFY(port.write("ok
+"));
+    QVERIFY(port.readCommands(1) == sent.mid(8, 1));
+    QVERIFY(port.readCommands(1, 200).isEmpty());
+    atcore.closeConnection();
+
+    TestPort repetierPort;
+    AtCore repetier;
+    QVERIFY(repetier.initSerial(repetierPort.portName(), 115200));
+    repetier.loadFirmwarePlugin(QStringLiteral("repetier"));
+    QVERIFY(repetier.firmwarePlugin()->bufferSize() == 63);
+    repetier.setStreamingWindow(true);
+    for (const QByteArray &command : sent) {
+        repetier.pushCommand(QString::fromLatin1(command));
+    }
+
+    // 3 * 20 bytes fit in 63
+    QVERIFY(repetierPort.readCommands(3) == sent.mid(0, 3));
+    QVERIFY(repetierPort.readCommands(1, 200).isEmpty());
+    for (int i = 3; i < 6; i++) {
+        QVERIFY(repetierPort.write("ok
+"));
+        QVERIFY(repetierPort.readCommands(1) == sent.mid(i, 1));
+        QVERIFY(repetierPort.readCommands(1, 200).isEmpty());
+    }
+    repetier.closeConnection();
+}
+
+void AtCoreTests::testProgressRate()
+{
+    QVERIFY(core->progressInterval() == 250);
+    QVERIFY(qFuzzyCompare(core->progressStep(), 0.1f));
+
+    core->setProgressInterval(1000);
+    core->setProgressStep(1);
+    QVERIFY(core->progressInterval() == 1000);
+    QVERIFY(qFuzzyCompare(core->progressStep(), 1.0f));
+
+    core->setProgressInterval(-5);
+    QVERIFY(core->progressInterval() == 0);
+}
+
+void AtCoreTests::testAcknowledge()
+{
+    QVERIFY(IFirmware::isAcknowledge(QStringLiteral("ok")));
+    QVERIFY(IFirmware::isAcknowledge(QStringLiteral("ok 12")));
+    QVERIFY(IFirmware::isAcknowledge(QStringLiteral("ok N12 P15 B3")));
+    QVERIFY(IFirmware::isAcknowledge(QStringLiteral("ok T:154 @:0 B:150")));
+    QVERIFY(IFirmware::isAcknowledge(QStringLiteral("  ok\r")));
+
+    QVERIFY(!IFirmware::isAcknowledge(QString()));
+    QVERIFY(!IFirmware::isAcknowledge(QStringLiteral(" T:25.47 /230 B:69.42 /80 B@:255 @:0")));
+    QVERIFY(!IFirmware::isAcknowledge(QStringLiteral("echo:SD card ok")));
+    QVERIFY(!IFirmware::isAcknowledge(QStringLiteral("okay")));
+    QVERIFY(!IFirmware::isAcknowledge(QStringLiteral("o")));
+
+    QVERIFY(core->temperatureAutoReport() == false);
+}
+
+bool AtCoreTests::connectNumbered(AtCore &atcore, TestPort &port)
+{
+    if (!atcore.initSerial(port.portName(), 115200)) {
+        return false;
+    }
+    atcore.setLineNumbering(true);
+    atcore.loadFirmwarePlugin(QStringLiteral("marlin"));
+    RetransmitBuffer expected;
+    return port.readCommands(1) == QList<QByteArray>{expected.reset(0)} && port.write("ok\n");
+}
+
+void AtCoreTests::testResend()
+{
+    TestPort port;
+    if (!port.isOpen()) {
+        QSKIP("Needs a pseudo terminal");
+    }
+    AtCore atcore;
+    QVERIFY(connectNumbered(atcore, port));
+    atcore.setStreamingWindow(true);
+    // only prints coalesce writes
+    QVERIFY(!atcore.serial()->writeCoalescing());
+
+    RetransmitBuffer expected;
+    expected.reset(0);
+    const QList<QByteArray> sent = {expected.frame("G1 X1"), expected.frame("G1 X2"), expected.frame("G1 X3")};
+    atcore.pushCommand(QStringLiteral("G1 X1"));
+    atcore.pushCommand(QStringLiteral("G1 X2"));
+    atcore.pushCommand(QStringLiteral("G1 X3"));
+    QVERIFY(port.readCommands(3) == sent);
+
+    // N2 is corrupted, Marlin drops N3 too and asks again for N2
+    QVERIFY(port.write("ok\n"
+                       "Error:checksum mismatch, Last Line: 1\nResend: 2\nok\n"
+                       "Error:Line Number is not Last Line Number+1, Last Line: 1\nResend: 2\nok\n"));
+    QVERIFY(port.readCommands(2) == sent.mid(1));
+    QVERIFY(port.readCommands(1, 200).isEmpty());
+    QVERIFY(atcore.lineErrors() == 2);
+    QVERIFY(atcore.retransmits() == 2);
+    QVERIFY(port.write("ok\nok\n"));
+
+    // older Repetier firmwares ask with "rs"
+    const QByteArray fourth = expected.frame("G1 X4");
+    atcore.pushCommand(QStringLiteral("G1 X4"));
+    QVERIFY(port.readCommands(1) == QList<QByteArray>{fourth});
+    QVERIFY(port.write("rs N4\nok\n"));
+    QVERIFY(port.readCommands(1) == QList<QByteArray>{fourth});
+    QVERIFY(atcore.retransmits() == 3);
+    QVERIFY(port.write("ok\n"));
+
+    // lines never sent can't be resent
+    QVERIFY(port.write("Resend: 9999\n"));
+    QVERIFY(port.readCommands(1, 200).isEmpty());
+    QVERIFY(atcore.retransmits() == 3);
+    QVERIFY(atcore.lineErrors() == 2);
+
+    atcore.closeConnection();
+}
+
+void AtCoreTests::testResendJournal()
+{
+    TestPort port;
+    if (!port.isOpen()) {
+        QSKIP("Needs a pseudo terminal");
+    }
+    QTemporaryFile job;
+    QVERIFY(writeFile(job, QByteArray("G1 X1\nG1 X2\nG1 X3\n")));
+    AtCore atcore;
+    QVERIFY(connectNumbered(atcore, port));
+    atcore.setStreamingWindow(true);
+    atcore.print(job.fileName());
+
+    RetransmitBuffer expected;
+    expected.reset(0);
+    const QList<QByteArray> sent = {expected.frame("G1 X1"), expected.frame("G1 X2"), expected.frame("G1 X3")};
+    QVERIFY(port.readCommands(3) == sent);
+
+    // the "ok"s Marlin sends for the dropped N2 and N3 don't acknowledge them
+    QVERIFY(port.write("ok\n"
+                       "Error:checksum mismatch, Last Line: 1\nResend: 2\nok\n"
+                       "Error:Line Number is not Last Line Number+1, Last Line: 1\nResend: 2\nok\n"));
+    QVERIFY(port.readCommands(2) == sent.mid(1));
+    QVERIFY(port.readCommands(1, 200).isEmpty());
+    PrintJournal::State state;
+    QTRY_VERIFY(PrintJournal::read(job.fileName(), state) && state.offset == 6);
+    QTest::qWait(500);
+    QVERIFY(PrintJournal::read(job.fileName(), state));
+    QVERIFY(state.offset == 6 && state.x == 1);
+
+    // the "ok" of the line sent again does
+    QVERIFY(port.write("ok\n"));
+    QTRY_VERIFY(PrintJournal::read(job.fileName(), state) && state.offset == 12);
+    QVERIFY(state.x == 2);
+
+    atcore.closeConnection();
+}
+
+void AtCoreTests::testLineNumberReset()
+{
+    TestPort port;
+    if (!port.isOpen()) {
+        QSKIP("Needs a pseudo terminal");
+    }
+    AtCore atcore;
+    QVERIFY(connectNumbered(atcore, port));
+
+    RetransmitBuffer expected;
+    const QByteArray reset = expected.reset(0);
+    const QByteArray first = expected.frame("G1 X1");
+    atcore.pushCommand(QStringLiteral("G1 X1"));
+    QVERIFY(port.readCommands(1) == QList<QByteArray>{first});
+    QVERIFY(port.write("ok\n"));
+
+    atcore.setLineNumbering(false);
+    atcore.pushCommand(QStringLiteral("G1 X2"));
+    QVERIFY(port.readCommands(1) == QList<QByteArray>{"G1 X2"});
+    QVERIFY(port.write("ok\n"));
+
+    // numbering starts over at N1 after the M110
+    atcore.setLineNumbering(true);
+    QVERIFY(port.readCommands(1) == QList<QByteArray>{reset});
+    QVERIFY(port.write("ok\n"));
+    atcore.pushCommand(QStringLiteral("G1 X1"));
+    QVERIFY(port.readCommands(1) == QList<QByteArray>{first});
+
+    // and again once the plugin is loaded anew, commands in flight are forgotten
+    atcore.loadFirmwarePlugin(QStringLiteral("marlin"));
+    QVERIFY(port.readCommands(1) == QList<QByteArray>{reset});
+    QVERIFY(port.write("ok\n"));
+    atcore.pushCommand(QStringLiteral("G1 X1"));
+    QVERIFY(port.readCommands(1) == QList<QByteArray>{first});
+    QVERIFY(atcore.lineErrors() == 0);
+    QVERIFY(atcore.retransmits() == 0);
+
+    // a single "ok" still frees a single command
+    atcore.pushCommand(QStringLiteral("G1 X2"));
+    atcore.pushCommand(QStringLiteral("G1 X3"));
+    QVERIFY(port.write("ok\n"));
+    QVERIFY(port.readCommands(2, 200) == QList<QByteArray>{expected.frame("G1 X2")});
+
+    atcore.closeConnection();
+}
+
+void AtCoreTests::testTemperatureAutoReport()
+{
+    TestPort port;
+    if (!port.isOpen()) {
+        QSKIP("Needs a pseudo terminal");
+    }
+    AtCore atcore;
+    QVERIFY(atcore.initSerial(port.portName(), 115200));
+    atcore.loadFirmwarePlugin(QStringLiteral("marlin"));
+    QVERIFY(!atcore.temperatureAutoReport());
+    QVERIFY(QMetaObject::invokeMethod(&atcore, "checkTemperature"));
+    QVERIFY(port.readCommands(1) == QList<QByteArray>{"M105"});
+    QVERIFY(port.write("ok T:20.0 /0.0 B:20.0 /0.0\n"));
+
+    // M155 asks for a report at the polling interval, once
+    QVERIFY(port.write("Cap:AUTOREPORT_TEMP:1\nCap:AUTOREPORT_TEMP:1\n"));
+    QVERIFY(port.readCommands(1) == QList<QByteArray>{"M155 S5"});
+    QVERIFY(atcore.temperatureAutoReport());
+    QVERIFY(port.write("ok\n"));
+    QVERIFY(port.readCommands(1, 200).isEmpty());
+
+    // reports come unsolicited, no more M105
+    QVERIFY(port.write("T:25.5 /0.0 B:21.0 /0.0 @:0 B@:0\n"));
+    QTRY_VERIFY(qFuzzyCompare(atcore.temperature().extruderTemperature(), 25.5f));
+    QVERIFY(QMetaObject::invokeMethod(&atcore, "checkTemperature"));
+    QVERIFY(port.readCommands(1, 200).isEmpty());
+
+    // another firmware may not report, the timer polls again
+    atcore.loadFirmwarePlugin(QStringLiteral("marlin"));
+    QVERIFY(!atcore.temperatureAutoReport());
+    QVERIFY(port.readCommands(1, 6000) == QList<QByteArray>{"M105"});
+
+    atcore.closeConnection();
+}
+
 QTEST_MAIN(AtCoreTests)
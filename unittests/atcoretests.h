@@ -20,6 +20,7 @@
 #include <QObject>
 
 #include "../src/atcore.h"
+#include "testport.h"
 
 class AtCoreTests: public QObject
 {
@@ -38,6 +39,7 @@ private slots:
     void testPluginMarlin_validate();
     void testPluginRepetier_load();
     void testPluginRepetier_validate();
+    void testPluginRepetier_binary();
     void testPluginSmoothie_load();
     void testPluginSmoothie_validate();
     void testPluginSprinter_load();
@@ -45,6 +47,19 @@ private slots:
     void testPluginTeacup_load();
     void testPluginTeacup_validate();
     void testPluginTeacup_translate();
+    void testStreamingWindow();
+    void testStreamingBytes();
+    void testProgressRate();
+    void testAcknowledge();
+    void testResend();
+    void testResendJournal();
+    void testLineNumberReset();
+    void testTemperatureAutoReport();
 private:
+    /**
+     * @brief Connect \p atcore to \p port as a Marlin printer numbering its lines
+     * @return False if the port can't be opened or the M110 reset wasn't sent
+     */
+    bool connectNumbered(AtCore &atcore, TestPort &port);
     AtCore *core = nullptr;
 };
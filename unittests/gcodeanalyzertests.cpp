@@ -0,0 +1,186 @@
+/*
+    This file is part of the KDE project
+
+    Copyright (C) 2018 Patrick José Pereira <patrickelectric@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QtTest>
+
+#include "gcodeanalyzertests.h"
+#include "testfile.h"
+#include "../src/gcodechunkparser.h"
+
+namespace
+{
+/**
+ * @brief A job of \p layers layers, \p moves extruding moves each
+ */
+QByteArray makeJob(int layers, int moves)
+{
+    QByteArray job;
+    for (int layer = 0; layer < layers; layer++) {
+        job.append("G1 Z" + QByteArray::number(0.2 * (layer + 1), 'f', 2) + " F300\n");
+        for (int i = 0; i < moves; i++) {
+            job.append("G1 X" + QByteArray::number(i % 200) + ".123 Y" + QByteArray::number(layer % 50)
+                       + ".5 E" + QByteArray::number(layer * moves + i + 1) + "\n");
+        }
+    }
+    return job;
+}
+}
+
+GCodeAnalyzer::Analysis GCodeAnalyzerTests::analyze(const QByteArray &gcode)
+{
+    QTemporaryFile file;
+    GCodeAnalyzer::Analysis analysis;
+    if (!writeFile(file, gcode) || !GCodeAnalyzer::analyze(file.fileName(), analysis)) {
+        analysis.lineCount = -1;
+    }
+    return analysis;
+}
+
+void GCodeAnalyzerTests::testJob()
+{
+    const GCodeAnalyzer::Analysis analysis = analyze("M140 S60\nM104 S200\nM190 S60\nM109 S210\nG28\n"
+                                             "G1 Z0.2 F300\nG1 X10 Y10 F6000\nG1 X20 Y10 E1 F1200\nG1 X20 Y20 E2\n"
+                                             "G1 Z0.4\nG1 X10 Y20 E3\nG0 X100 Y-5 Z10\nM104 S0\n");
+    QCOMPARE(analysis.lineCount, qint64(13));
+
+    // every move, from the home position
+    QCOMPARE(analysis.minimum[0], 0.0);
+    QCOMPARE(analysis.maximum[0], 100.0);
+    QCOMPARE(analysis.minimum[1], -5.0);
+    QCOMPARE(analysis.maximum[1], 20.0);
+    QCOMPARE(analysis.maximum[2], 10.0);
+
+    // the extruding ones
+    QCOMPARE(analysis.printMinimum[0], 10.0);
+    QCOMPARE(analysis.printMaximum[0], 20.0);
+    QCOMPARE(analysis.printMinimum[1], 10.0);
+    QCOMPARE(analysis.printMaximum[1], 20.0);
+    QCOMPARE(analysis.printMinimum[2], 0.2);
+    QCOMPARE(analysis.printMaximum[2], 0.4);
+
+    QCOMPARE(analysis.filament, QVector<double>({3}));
+    QCOMPARE(analysis.tools, QVector<int>({0}));
+    QCOMPARE(analysis.layerCount(), 2);
+    QCOMPARE(analysis.layerHeights, QVector<double>({0.2, 0.4}));
+    QCOMPARE(analysis.minimumFeedrate, 300.0);
+    QCOMPARE(analysis.maximumFeedrate, 6000.0);
+
+    // turning a heater off isn't a temperature
+    QCOMPARE(analysis.extruderTemperatures, QVector<double>({200, 210}));
+    QCOMPARE(analysis.bedTemperatures, QVector<double>({60}));
+
+    const double volumeMinimum[3] = {0, -10, 0};
+    const double volumeMaximum[3] = {200, 200, 200};
+    const double smallVolume[3] = {50, 50, 50};
+    QVERIFY(analysis.fitsIn(volumeMinimum, volumeMaximum));
+    QVERIFY(!analysis.fitsIn(volumeMinimum, smallVolume));
+}
+
+void GCodeAnalyzerTests::testTools()
+{
+    // relative E with a retraction on T1, absolute E after G92 on T0
+    const GCodeAnalyzer::Analysis analysis = analyze("G28\nG1 Z0.3\nT1\nM83\nG1 X5 E2\nG1 E-1\nG1 E1\nG1 X6 E0.5\n"
+                                             "T0\nM82\nG92 E0\nG1 X7 E4\n");
+    QCOMPARE(analysis.filament, QVector<double>({4, 2.5}));
+    QCOMPARE(analysis.tools, QVector<int>({0, 1}));
+}
+
+void GCodeAnalyzerTests::testRelativeMoves()
+{
+    // X was never positioned, Y was
+    GCodeAnalyzer::Analysis analysis = analyze("G91\nG1 X10\nG90\nG1 Y5\n");
+    QCOMPARE(analysis.minimum[0], 0.0);
+    QCOMPARE(analysis.maximum[0], 0.0);
+    QCOMPARE(analysis.minimum[1], 5.0);
+    QCOMPARE(analysis.maximum[1], 5.0);
+
+    analysis = analyze("G28\nG91\nG1 X10\nG1 X10 Y-5\n");
+    QCOMPARE(analysis.maximum[0], 20.0);
+    QCOMPARE(analysis.minimum[1], -5.0);
+}
+
+void GCodeAnalyzerTests::testInches()
+{
+    const GCodeAnalyzer::Analysis analysis = analyze("G20\nG1 X1 Y1 F10\n");
+    QCOMPARE(analysis.maximum[0], 25.4);
+    QCOMPARE(analysis.maximumFeedrate, 254.0);
+}
+
+void GCodeAnalyzerTests::testArcs()
+{
+    // half circles around X10 Y0 reach 10 mm away from the chord
+    GCodeAnalyzer::Analysis analysis = analyze("G1 X0 Y0\nG3 X20 Y0 I10 J0 E1\n");
+    QVERIFY(qAbs(analysis.minimum[1] + 10) < 1e-9);
+    QVERIFY(qAbs(analysis.maximum[1]) < 1e-9);
+    QVERIFY(qAbs(analysis.printMinimum[1] + 10) < 1e-9);
+
+    analysis = analyze("G1 X0 Y0\nG2 X20 Y0 I10 J0 E1\n");
+    QVERIFY(qAbs(analysis.maximum[1] - 10) < 1e-9);
+    QVERIFY(qAbs(analysis.minimum[1]) < 1e-9);
+}
+
+void GCodeAnalyzerTests::testZHop()
+{
+    // lifting to travel and coming back down is not a layer
+    const GCodeAnalyzer::Analysis analysis = analyze("G1 Z0.2\nG1 X1 E1\nG1 Z0.6\nG1 X5\nG1 Z0.2\nG1 X6 E2\nG1 Z0.4\nG1 X7 E3\n");
+    QCOMPARE(analysis.layerHeights, QVector<double>({0.2, 0.4}));
+}
+
+void GCodeAnalyzerTests::testChunks()
+{
+    // several MB, the state goes across the chunks
+    const GCodeAnalyzer::Analysis analysis = analyze(makeJob(300, 2000));
+    QCOMPARE(analysis.lineCount, qint64(300 * 2001));
+    QCOMPARE(analysis.layerCount(), 300);
+    QCOMPARE(analysis.maximum[0], 199.123);
+    QCOMPARE(analysis.filament, QVector<double>({600000}));
+}
+
+void GCodeAnalyzerTests::testChunkSplit()
+{
+    const QByteArray data("G1 X1\nG1 X2\nG1 X3\nG1 X4");
+    // a part ends at the first line end past chunkSize bytes
+    auto parts = GCodeChunkParser::split(data.constData(), data.size(), 8);
+    QCOMPARE(parts.size(), 2);
+    QVERIFY(parts.at(0) == qMakePair(qint64(0), qint64(12)));
+    QVERIFY(parts.at(1) == qMakePair(qint64(12), qint64(data.size())));
+
+    parts = GCodeChunkParser::split(data.constData(), data.size(), 1 << 20);
+    QCOMPARE(parts.size(), 1);
+    QVERIFY(parts.at(0) == qMakePair(qint64(0), qint64(data.size())));
+    QVERIFY(GCodeChunkParser::split(data.constData(), 0, 8).isEmpty());
+}
+
+void GCodeAnalyzerTests::testMissingFile()
+{
+    GCodeAnalyzer::Analysis analysis;
+    QVERIFY(!GCodeAnalyzer::analyze(QStringLiteral("/nonexistent/job.gcode"), analysis));
+}
+
+void GCodeAnalyzerTests::benchmarkAnalyze()
+{
+    QTemporaryFile file;
+    QVERIFY(writeFile(file, makeJob(500, 5000)));
+    GCodeAnalyzer::Analysis analysis;
+    QBENCHMARK {
+        QVERIFY(GCodeAnalyzer::analyze(file.fileName(), analysis));
+    }
+    QCOMPARE(analysis.layerCount(), 500);
+}
+
+QTEST_MAIN(GCodeAnalyzerTests)
@@ -0,0 +1,145 @@
+/*
+    This file is part of the KDE project
+
+    Copyright (C) 2018 Patrick José Pereira <patrickelectric@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QtTest>
+#include <QMetaEnum>
+
+#include "gcodebuildertests.h"
+
+namespace
+{
+QByteArray formatted(double value, int decimals)
+{
+    char out[32];
+    return QByteArray(out, GCodeBuilder::formatNumber(out, value, decimals));
+}
+}
+
+void GCodeBuilderTests::testEveryCode()
+{
+    GCodeBuilder builder;
+    const QMetaEnum gcodes = QMetaEnum::fromType<GCode::GCommands>();
+    for (int i = 0; i < gcodes.keyCount(); i++) {
+        QCOMPARE(builder.begin(GCode::GCommands(gcodes.value(i))).command(), QByteArray(gcodes.key(i)));
+    }
+    const QMetaEnum mcodes = QMetaEnum::fromType<GCode::MCommands>();
+    for (int i = 0; i < mcodes.keyCount(); i++) {
+        QCOMPARE(builder.begin(GCode::MCommands(mcodes.value(i))).command(), QByteArray(mcodes.key(i)));
+    }
+}
+
+void GCodeBuilderTests::testWords()
+{
+    GCodeBuilder builder;
+    QCOMPARE(builder.begin(GCode::M104).word('P', 0u).word('S', 200u).command(), QByteArray("M104 P0 S200"));
+    QCOMPARE(builder.begin(GCode::G28).word('X').word('Y').command(), QByteArray("G28 X Y"));
+    QCOMPARE(builder.begin(GCode::G1).word('X', -12).word('E', qint64(1) << 40).command(), QByteArray("G1 X-12 E1099511627776"));
+    QCOMPARE(builder.begin(GCode::G1).word('X', 10.5).word('Y', 2.0).word('F', 1800).command(), QByteArray("G1 X10.5 Y2 F1800"));
+    QCOMPARE(builder.begin('T', 1).command(), QByteArray("T1"));
+
+    // same command as toCommand() wrote
+    QCOMPARE(builder.begin(GCode::M106).word('P', 1).word('S', 255).command(), GCode::toCommand(GCode::M106, QStringLiteral("1"), QStringLiteral("255")).toLatin1());
+    QCOMPARE(builder.begin(GCode::M140).word('S', 60).command(), GCode::toCommand(GCode::M140, QStringLiteral("60")).toLatin1());
+}
+
+void GCodeBuilderTests::testNumbers()
+{
+    QCOMPARE(formatted(0, 3), QByteArray("0"));
+    QCOMPARE(formatted(200, 3), QByteArray("200"));
+    QCOMPARE(formatted(1.5, 3), QByteArray("1.5"));
+    QCOMPARE(formatted(-0.25, 3), QByteArray("-0.25"));
+    QCOMPARE(formatted(0.1 + 0.2, 3), QByteArray("0.3"));
+    QCOMPARE(formatted(12.3456, 2), QByteArray("12.35"));
+    QCOMPARE(formatted(99.9996, 3), QByteArray("100"));
+    QCOMPARE(formatted(1.23456789, 5), QByteArray("1.23457"));
+    QCOMPARE(formatted(1234.5, 0), QByteArray("1235"));
+    QCOMPARE(formatted(0.000001, 9), QByteArray("0.000001"));
+
+    // rounding to zero drops the sign
+    QCOMPARE(formatted(-0.0004, 3), QByteArray("0"));
+
+    // decimals are capped
+    QCOMPARE(formatted(0.5, 20), QByteArray("0.5"));
+    QCOMPARE(formatted(0.5, -1), QByteArray("1"));
+
+    // out of the fixed point range
+    QCOMPARE(formatted(1e300, 3), QByteArray("1e+300"));
+}
+
+void GCodeBuilderTests::testText()
+{
+    GCodeBuilder builder;
+    QCOMPARE(builder.begin(GCode::M117).text("Hello World").command(), QByteArray("M117 Hello World"));
+    QCOMPARE(builder.begin(GCode::M23).text("part.gco").command(), GCode::toCommand(GCode::M23, QStringLiteral("part.gco")).toLatin1());
+}
+
+void GCodeBuilderTests::testReuse()
+{
+    GCodeBuilder builder;
+    const QByteArray first = builder.begin(GCode::G1).word('X', 10).command();
+    const char *buffer = builder.begin(GCode::G1).word('Y', 20).command().constData();
+
+    // a copy of a command is not changed by the next one
+    QCOMPARE(first, QByteArray("G1 X10"));
+    QCOMPARE(builder.command(), QByteArray("G1 Y20"));
+
+    // the buffer is kept once no copy shares it
+    QVERIFY(builder.begin(GCode::G1).word('Z', 0.2).command().constData() == buffer);
+    QCOMPARE(builder.command(), QByteArray("G1 Z0.2"));
+}
+
+void GCodeBuilderTests::testConstants()
+{
+    QCOMPARE(GCodeBuilder::G28, GCode::toCommand(GCode::G28).toLatin1());
+    QCOMPARE(GCodeBuilder::G90, GCode::toCommand(GCode::G90).toLatin1());
+    QCOMPARE(GCodeBuilder::G91, GCode::toCommand(GCode::G91).toLatin1());
+    QCOMPARE(GCodeBuilder::M24, GCode::toCommand(GCode::M24).toLatin1());
+    QCOMPARE(GCodeBuilder::M25, GCode::toCommand(GCode::M25).toLatin1());
+    QCOMPARE(GCodeBuilder::M27, GCode::toCommand(GCode::M27).toLatin1());
+    QCOMPARE(GCodeBuilder::M105, GCode::toCommand(GCode::M105).toLatin1());
+    QCOMPARE(GCodeBuilder::M112, GCode::toCommand(GCode::M112).toLatin1());
+    QCOMPARE(GCodeBuilder::M114, GCode::toCommand(GCode::M114).toLatin1());
+    QCOMPARE(GCodeBuilder::M115, GCode::toCommand(GCode::M115).toLatin1());
+}
+
+void GCodeBuilderTests::benchmarkToCommand()
+{
+    int size = 0;
+    QBENCHMARK {
+        for (uint i = 0; i < 1000; i++) {
+            size += GCode::toCommand(GCode::M104, QString::number(i % 2), QString::number(180 + i % 40)).toLocal8Bit().size();
+            size += GCode::toCommand(GCode::G1, QStringLiteral("X%1 Y%2").arg(i * 0.125, 0, 'f', 3).arg(i * 0.5, 0, 'f', 3)).toLocal8Bit().size();
+        }
+    }
+    QVERIFY(size > 0);
+}
+
+void GCodeBuilderTests::benchmarkBuilder()
+{
+    GCodeBuilder builder;
+    int size = 0;
+    QBENCHMARK {
+        for (uint i = 0; i < 1000; i++) {
+            size += builder.begin(GCode::M104).word('P', i % 2).word('S', 180 + i % 40).command().size();
+            size += builder.begin(GCode::G1).word('X', i * 0.125).word('Y', i * 0.5).command().size();
+        }
+    }
+    QVERIFY(size > 0);
+}
+
+QTEST_MAIN(GCodeBuilderTests)
@@ -0,0 +1,222 @@
+/*
+    This file is part of the KDE project
+
+    Copyright (C) 2018 Patrick José Pereira <patrickelectric@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QtTest>
+
+#include "gcodeindextests.h"
+#include "testfile.h"
+#include "../src/gcodereader.h"
+
+void GCodeIndexTests::initTestCase()
+{
+    // several MB so build() splits it in chunks, with relative Z hops and M83 sections crossing them
+    QByteArray content;
+    content.append("G21\nG90\nM82\nG28\nG92 E0\n");
+    jobLines = 5;
+    double e = 0;
+    for (int layer = 0; layer < 100; layer++) {
+        content.append("G1 Z" + QByteArray::number(0.2 * (layer + 1), 'f', 2) + " F300\n");
+        jobLines++;
+        for (int i = 0; i < 1000; i++) {
+            e += 0.05;
+            content.append("G1 X" + QByteArray::number(i % 200) + " Y" + QByteArray::number(layer) + " E" + QByteArray::number(e, 'f', 5) + "\n");
+            jobLines++;
+        }
+        // travel with a z hop, must not start a layer
+        content.append("G91\nG1 Z1\nG90\nG1 X0 Y0\nG91\nG1 Z-1\nG90\n");
+        jobLines += 7;
+    }
+    jobLayers = 100;
+    QVERIFY(writeFile(job, content));
+}
+
+void GCodeIndexTests::cleanupTestCase()
+{
+    QFile::remove(GCodeIndex::sidecarFileName(job.fileName()));
+}
+
+void GCodeIndexTests::testLayersFromZ()
+{
+    QTemporaryFile file;
+    QVERIFY(writeFile(file, QByteArray("G28\nG92 E0\nG1 Z0.2\nG1 X10 E1\nG1 X20 E2\nG1 Z0.4\nG1 X10 E3\nG1 Z5\nG1 X0\nG1 Z0.6 E3.5\n")));
+    GCodeIndex index;
+    QVERIFY(index.build(file.fileName()));
+    QVERIFY(index.isValid());
+    QVERIFY(index.lineCount() == 10);
+    QVERIFY(index.layers().size() == 3);
+    QVERIFY(index.layers().at(0).line == 3);
+    QVERIFY(qFuzzyCompare(index.layers().at(0).z, 0.2f));
+    QVERIFY(index.layers().at(1).line == 6);
+    QVERIFY(qFuzzyCompare(index.layers().at(1).extruded, 2.0));
+    // the travel to Z5 doesn't extrude
+    QVERIFY(index.layers().at(2).line == 9);
+    QVERIFY(qFuzzyCompare(index.layers().at(2).z, 0.6f));
+    QVERIFY(qFuzzyCompare(index.totalExtruded(), 3.5));
+}
+
+void GCodeIndexTests::testLayerComments()
+{
+    QTemporaryFile file;
+    QVERIFY(writeFile(file, QByteArray("G1 Z0.3\n;LAYER:0\nG1 X1 E1\nG1 Z0.6\n;LAYER:1\nG1 X2 E2\n")));
+    GCodeIndex index;
+    QVERIFY(index.build(file.fileName()));
+    QVERIFY(index.layers().size() == 2);
+    QVERIFY(index.layers().at(0).line == 1);
+    QVERIFY(index.layers().at(1).line == 4);
+    QVERIFY(qFuzzyCompare(index.layers().at(1).extruded, 1.0));
+    QVERIFY(index.layerAt(0) == -1);
+    QVERIFY(index.layerAt(index.layers().at(1).offset) == 1);
+}
+
+void GCodeIndexTests::testRelativeMoves()
+{
+    QTemporaryFile file;
+    QVERIFY(writeFile(file, QByteArray("M83\nG1 Z0.2\nG1 X1 E1\nG1 E-0.5\nG91\nG1 Z0.2\nG1 X1 E0.5\nG90\nM82\nG92 E10\nG1 X2 E11\n")));
+    GCodeIndex index;
+    QVERIFY(index.build(file.fileName()));
+    QVERIFY(index.layers().size() == 2);
+    QVERIFY(qFuzzyCompare(index.layers().at(1).z, 0.4f));
+    QVERIFY(qFuzzyCompare(index.layers().at(1).extruded, 0.5));
+    QVERIFY(qFuzzyCompare(index.totalExtruded(), 2.0));
+}
+
+void GCodeIndexTests::testChunks()
+{
+    GCodeIndex index;
+    QVERIFY(index.build(job.fileName(), 100));
+    QVERIFY(index.lineCount() == jobLines);
+    QVERIFY(index.layers().size() == jobLayers);
+    for (int i = 0; i < jobLayers; i++) {
+        QVERIFY(qFuzzyCompare(index.layers().at(i).z, float(0.2 * (i + 1))));
+        QVERIFY(qAbs(index.layers().at(i).extruded - i * 50.0) < 0.01);
+    }
+    QVERIFY(qAbs(index.totalExtruded() - jobLayers * 50.0) < 0.01);
+}
+
+void GCodeIndexTests::testSeekToLine()
+{
+    GCodeIndex index;
+    QVERIFY(index.build(job.fileName(), 100));
+    GCodeReader reader(job.fileName());
+    QVERIFY(reader.open());
+
+    // the 5 setup lines, the layer's Z line and 1000 moves
+    QVERIFY(index.seekToLine(reader, 5 + 1 + 250));
+    QByteArray command;
+    QVERIFY(reader.readCommand(command));
+    QVERIFY(command == QByteArray("G1 X50 Y0 E12.55000"));
+    QVERIFY(!index.seekToLine(reader, jobLines));
+    QVERIFY(!index.seekToLine(reader, -1));
+}
+
+void GCodeIndexTests::testSeekToLayer()
+{
+    GCodeIndex index;
+    QVERIFY(index.build(job.fileName()));
+    GCodeReader reader(job.fileName());
+    QVERIFY(reader.open());
+
+    QVERIFY(index.seekToLayer(reader, 3));
+    QByteArray command;
+    QVERIFY(reader.readCommand(command));
+    QVERIFY(command == QByteArray("G1 X0 Y3 E150.05000"));
+    QVERIFY(index.layerAt(reader.position()) == 3);
+    QVERIFY(!index.seekToLayer(reader, jobLayers));
+}
+
+void GCodeIndexTests::testSidecar()
+{
+    QTemporaryFile file;
+    QVERIFY(writeFile(file, QByteArray("G1 Z0.2\nG1 X1 E1\nG1 Z0.4\nG1 X2 E2\n")));
+    const QString sidecar = GCodeIndex::sidecarFileName(file.fileName());
+    QFile::remove(sidecar);
+
+    GCodeIndex built;
+    QVERIFY(!built.load(file.fileName()));
+    QVERIFY(built.open(file.fileName(), 2));
+    QVERIFY(QFile::exists(sidecar));
+
+    GCodeIndex loaded;
+    QVERIFY(loaded.load(file.fileName()));
+    QVERIFY(loaded.stride() == 2);
+    QVERIFY(loaded.lineCount() == built.lineCount());
+    QVERIFY(loaded.layers().size() == 2);
+    QVERIFY(loaded.layers().at(1).offset == built.layers().at(1).offset);
+    QVERIFY(qFuzzyCompare(loaded.extrudedBefore(2), 1.0));
+
+    // a changed job invalidates its sidecar
+    file.write("G1 Z0.6\nG1 X3 E3\n");
+    file.flush();
+    QVERIFY(!loaded.load(file.fileName()));
+    QVERIFY(loaded.open(file.fileName(), 2));
+    QVERIFY(loaded.layers().size() == 3);
+    QFile::remove(sidecar);
+}
+
+void GCodeIndexTests::testDamagedSidecar()
+{
+    QTemporaryFile file;
+    QVERIFY(writeFile(file, QByteArray("G1 Z0.2\nG1 X1 E1\nG1 Z0.4\nG1 X2 E2\n")));
+    const QString sidecar = GCodeIndex::sidecarFileName(file.fileName());
+    GCodeIndex built;
+    QVERIFY(built.open(file.fileName(), 2));
+    QFile saved(sidecar);
+    QVERIFY(saved.open(QIODevice::ReadOnly));
+    const QByteArray data = saved.readAll();
+    saved.close();
+
+    // counts are big endian, the layer count is followed by two layers of 32 bytes
+    // and preceded by two vectors of two 8 byte items
+    const int layerCount = data.size() - 4 - 2 * 32;
+    const int strideCount = layerCount - 2 * (4 + 2 * 8);
+    const auto damage = [&](int at, quint32 count) {
+        QByteArray damaged = data;
+        qToBigEndian(count, reinterpret_cast<uchar *>(damaged.data() + at));
+        QFile out(sidecar);
+        return out.open(QIODevice::WriteOnly) && out.write(damaged) == damaged.size();
+    };
+    GCodeIndex loaded;
+    QVERIFY(damage(layerCount, 2));
+    QVERIFY(loaded.load(file.fileName()));
+    QVERIFY(damage(layerCount, 0x7fffffff));
+    QVERIFY(!loaded.load(file.fileName()));
+    QVERIFY(damage(layerCount, 3));
+    QVERIFY(!loaded.load(file.fileName()));
+    QVERIFY(damage(strideCount, 0xffffffff));
+    QVERIFY(!loaded.load(file.fileName()));
+    QVERIFY(!loaded.isValid());
+    QFile::remove(sidecar);
+}
+
+void GCodeIndexTests::testMissingFile()
+{
+    GCodeIndex index;
+    QVERIFY(!index.open(QStringLiteral("/nonexistent/job.gcode")));
+    QVERIFY(!index.isValid());
+    QVERIFY(index.layerAt(0) == -1);
+}
+
+void GCodeIndexTests::benchmarkBuild()
+{
+    GCodeIndex index;
+    QBENCHMARK {
+        index.build(job.fileName());
+    }
+}
+
+QTEST_MAIN(GCodeIndexTests)
@@ -0,0 +1,237 @@
+/*
+    This file is part of the KDE project
+
+    Copyright (C) 2018 Patrick José Pereira <patrickelectric@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QtTest>
+
+#include "gcodelinetests.h"
+
+void GCodeLineTests::initTestCase()
+{
+    // what a slicer writes, mostly extruding moves
+    for (int i = 0; i < 20000; i++) {
+        job.append("G1 X" + QByteArray::number(100 + (i % 50) * 0.731, 'f', 3)
+                   + " Y" + QByteArray::number(80 + (i % 70) * 0.419, 'f', 3)
+                   + " E" + QByteArray::number(i * 0.02917, 'f', 5));
+        if (i % 10 == 0) {
+            job.append("G0 F7200 X" + QByteArray::number(i % 200, 'f', 3) + " Y50.000");
+        }
+    }
+}
+
+void GCodeLineTests::testCommand()
+{
+    GCodeLine line;
+    const QByteArray command("G1 X10.5 Y-3 E.25 F1800");
+    QVERIFY(line.parse(command));
+    QVERIFY(line.isValid());
+    QVERIFY(line.letter() == 'G');
+    QVERIFY(line.code() == 1);
+    QVERIFY(line.subcode() == -1);
+    QVERIFY(line.lineNumber() == -1);
+    QVERIFY(line.checksum() == -1);
+    QVERIFY(line.textBegin() == -1);
+    QVERIFY(line.wordCount() == 4);
+    QVERIFY(!line.hasRepeatedWords());
+
+    QVERIFY(line.word(0).letter == 'X');
+    QVERIFY(line.word(0).value == 10.5);
+    QVERIFY(line.word(0).decimals == 1);
+    QVERIFY(command.mid(line.word(0).begin, line.word(0).end - line.word(0).begin) == QByteArray("10.5"));
+    QVERIFY(command.mid(line.word(1).begin, line.word(1).end - line.word(1).begin) == QByteArray("-3"));
+    QVERIFY(line.value('Y') == -3);
+    QVERIFY(line.value('E') == 0.25);
+    QVERIFY(line.value('F') == 1800);
+    QVERIFY(!line.has('Z'));
+    QVERIFY(line.value('Z', 7) == 7);
+    QVERIFY(!line.find('S'));
+
+    // reused for the next line, nothing of the last one is left
+    QVERIFY(line.parse(QByteArray("m104 s210 t1")));
+    QVERIFY(line.letter() == 'M');
+    QVERIFY(line.code() == 104);
+    QVERIFY(line.value('S') == 210);
+    QVERIFY(line.value('T') == 1);
+    QVERIFY(!line.has('X'));
+}
+
+void GCodeLineTests::testNumbers()
+{
+    const QList<QByteArray> numbers = {"0", "1", "0.1", "-0.1", "+2.5", "123.456", "0.000001", "-12345.6789",
+                                       "3.14159265358979", ".5", "5.", "0012.3400", "1234567890.123456"
+                                      };
+    for (const QByteArray &number : numbers) {
+        const char *p = number.constData();
+        const char *end = p + number.size();
+        double value = 0;
+        QVERIFY(GCodeLine::parseNumber(p, end, value));
+        QVERIFY(p == end);
+        // correctly rounded, as the compiler reads literals
+        QVERIFY(value == number.toDouble());
+    }
+
+    int decimals = 0;
+    const QByteArray number("-1.250X");
+    const char *p = number.constData();
+    double value = 0;
+    QVERIFY(GCodeLine::parseNumber(p, p + number.size(), value, &decimals));
+    QVERIFY(value == -1.25);
+    QVERIFY(decimals == 3);
+    QVERIFY(*p == 'X');
+
+    for (const char *text : {"", "-", ".", "+.", "X1"}) {
+        const char *q = text;
+        QVERIFY(!GCodeLine::parseNumber(q, q + qstrlen(text), value));
+        QVERIFY(q == text);
+    }
+}
+
+void GCodeLineTests::testLineNumberAndChecksum()
+{
+    GCodeLine line;
+    QVERIFY(line.parse(QByteArray("N123 G1 X1 Y2*85")));
+    QVERIFY(line.lineNumber() == 123);
+    QVERIFY(line.checksum() == 85);
+    QVERIFY(line.letter() == 'G');
+    QVERIFY(line.code() == 1);
+    QVERIFY(line.wordCount() == 2);
+    QVERIFY(line.value('Y') == 2);
+
+    QVERIFY(line.parse(QByteArray("N7 M105*36")));
+    QVERIFY(line.lineNumber() == 7);
+    QVERIFY(line.checksum() == 36);
+    QVERIFY(line.wordCount() == 0);
+
+    QVERIFY(!line.parse(QByteArray("G1 X1*")));
+    QVERIFY(!line.parse(QByteArray("G1 X1*12 Y2")));
+}
+
+void GCodeLineTests::testSubcode()
+{
+    GCodeLine line;
+    QVERIFY(line.parse(QByteArray("G29.1 Z0.2")));
+    QVERIFY(line.code() == 29);
+    QVERIFY(line.subcode() == 1);
+    QVERIFY(line.value('Z') == 0.2);
+    QVERIFY(line.parse(QByteArray("G1")));
+    QVERIFY(line.subcode() == -1);
+}
+
+void GCodeLineTests::testFlagWords()
+{
+    GCodeLine line;
+    QVERIFY(line.parse(QByteArray("G28 X Y0")));
+    QVERIFY(line.wordCount() == 2);
+    QVERIFY(line.has('X'));
+    QVERIFY(!line.word(0).hasValue);
+    QVERIFY(line.value('X', 5) == 0);
+    QVERIFY(line.word(1).hasValue);
+
+    QVERIFY(line.parse(QByteArray("G1 X1 X2")));
+    QVERIFY(line.hasRepeatedWords());
+    QVERIFY(line.value('X') == 2);
+}
+
+void GCodeLineTests::testComments()
+{
+    GCodeLine line;
+    QVERIFY(line.parse(QByteArray("  G1 X1 (first) Y2 ; and a comment")));
+    QVERIFY(line.wordCount() == 2);
+    QVERIFY(line.value('X') == 1);
+    QVERIFY(line.value('Y') == 2);
+    QVERIFY(line.parse(QByteArray("G1 X1 (not closed")));
+    QVERIFY(line.wordCount() == 1);
+}
+
+void GCodeLineTests::testCompactWords()
+{
+    GCodeLine line;
+    QVERIFY(line.parse(QByteArray("G1X10Y.5E-.2F3000")));
+    QVERIFY(line.code() == 1);
+    QVERIFY(line.wordCount() == 4);
+    QVERIFY(line.value('X') == 10);
+    QVERIFY(line.value('Y') == 0.5);
+    QVERIFY(line.value('E') == -0.2);
+    QVERIFY(line.value('F') == 3000);
+}
+
+void GCodeLineTests::testText()
+{
+    GCodeLine line;
+    const QByteArray message("M117 Layer 2 of 10*34");
+    QVERIFY(line.parse(message));
+    QVERIFY(line.wordCount() == 0);
+    QVERIFY(line.checksum() == 34);
+    QVERIFY(message.mid(line.textBegin(), line.textEnd() - line.textBegin()) == QByteArray("Layer 2 of 10"));
+
+    const QByteArray file("M23 /jobs/cube.gco");
+    QVERIFY(line.parse(file));
+    QVERIFY(line.checksum() == -1);
+    QVERIFY(file.mid(line.textBegin(), line.textEnd() - line.textBegin()) == QByteArray("/jobs/cube.gco"));
+}
+
+void GCodeLineTests::testInvalid()
+{
+    GCodeLine line;
+    for (const char *text : {"", "   ", "; comment", "G", "GX1", "1 X1", "G1 X1.2.3", "G1 X-", "G1 #1"}) {
+        QVERIFY(!line.parse(QByteArray(text)));
+        QVERIFY(!line.isValid());
+    }
+
+    // words past MaxWords
+    QByteArray command("G1");
+    for (int i = 0; i <= GCodeLine::MaxWords; i++) {
+        command += " A1";
+    }
+    QVERIFY(!line.parse(command));
+}
+
+void GCodeLineTests::benchmarkSplit()
+{
+    // What string based handling costs
+    const QList<QByteArray> &commands = job;
+    double sum = 0;
+    QBENCHMARK {
+        sum = 0;
+        for (const QByteArray &command : commands) {
+            const QStringList words = QString::fromLatin1(command).split(QChar::fromLatin1(' '));
+            for (int i = 1; i < words.size(); i++) {
+                sum += words.at(i).midRef(1).toDouble();
+            }
+        }
+    }
+    QVERIFY(sum != 0);
+}
+
+void GCodeLineTests::benchmarkParse()
+{
+    const QList<QByteArray> &commands = job;
+    double sum = 0;
+    GCodeLine line;
+    QBENCHMARK {
+        sum = 0;
+        for (const QByteArray &command : commands) {
+            line.parse(command);
+            for (int i = 0; i < line.wordCount(); i++) {
+                sum += line.word(i).value;
+            }
+        }
+    }
+    QVERIFY(sum != 0);
+}
+
+QTEST_MAIN(GCodeLineTests)
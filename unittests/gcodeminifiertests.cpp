@@ -0,0 +1,117 @@
+/*
+    This file is part of the KDE project
+
+    Copyright (C) 2018 Patrick José Pereira <patrickelectric@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QtTest>
+
+#include "gcodeminifiertests.h"
+
+namespace
+{
+/**
+ * @brief Minify \p command with \p minifier
+ */
+QByteArray minified(GCodeMinifier &minifier, const char *command)
+{
+    QByteArray result(command);
+    minifier.minify(result);
+    return result;
+}
+}
+
+void GCodeMinifierTests::testNumbers()
+{
+    GCodeMinifier minifier;
+    QVERIFY(minified(minifier, "G01 X10.500 Y+020.000 Z0.200") == QByteArray("G1 X10.5 Y20 Z0.2"));
+    QVERIFY(minified(minifier, "G1 X-0.0 Y-05.50") == QByteArray("G1 X0 Y-5.5"));
+    QVERIFY(minified(minifier, "G2 X1 Y2 I0.500 J-0.000") == QByteArray("G2 X1 Y2 I0.5 J0"));
+}
+
+void GCodeMinifierTests::testModalWords()
+{
+    GCodeMinifier minifier;
+    QVERIFY(minified(minifier, "G28") == QByteArray("G28"));
+    QVERIFY(minified(minifier, "G1 Z0.2 F3000") == QByteArray("G1 Z0.2 F3000"));
+    // the position is only known after an absolute move
+    QVERIFY(minified(minifier, "G1 X10 Y20 Z0.2 F3000") == QByteArray("G1 X10 Y20"));
+    QVERIFY(minified(minifier, "G1 X10 Y25 E0.04 F1800") == QByteArray("G1 Y25 E0.04 F1800"));
+    QVERIFY(minified(minifier, "G0 X10 Y25 F1800") == QByteArray());
+
+    // arcs keep their end point, it's not a move to where the head is
+    QVERIFY(minified(minifier, "G2 X10 Y25 I5 J0 F1800") == QByteArray("G2 X10 Y25 I5 J0 F1800"));
+
+    // homing forgets the position and feedrate
+    QVERIFY(minified(minifier, "G28 X0") == QByteArray("G28 X0"));
+    QVERIFY(minified(minifier, "G1 X10 Y25 F1800") == QByteArray("G1 X10 Y25 F1800"));
+}
+
+void GCodeMinifierTests::testRelativeMoves()
+{
+    GCodeMinifier minifier;
+    QVERIFY(minified(minifier, "G1 X10 Y10 E5") == QByteArray("G1 X10 Y10 E5"));
+    minified(minifier, "M83");
+    QVERIFY(minified(minifier, "G1 X10 Y20 E0.000") == QByteArray("G1 Y20"));
+    QVERIFY(minified(minifier, "G1 X20 E5") == QByteArray("G1 X20 E5"));
+    QVERIFY(minified(minifier, "G1 X20 E5") == QByteArray("G1 E5"));
+
+    minified(minifier, "G91");
+    QVERIFY(minified(minifier, "G1 X0 Y10") == QByteArray("G1 Y10"));
+    QVERIFY(minified(minifier, "G1 X0 Y10") == QByteArray("G1 Y10"));
+    minified(minifier, "G90");
+    QVERIFY(minified(minifier, "G1 X20 Y40") == QByteArray());
+}
+
+void GCodeMinifierTests::testPassThrough()
+{
+    GCodeMinifier minifier;
+    QVERIFY(minified(minifier, "M117 Layer 0.50") == QByteArray("M117 Layer 0.50"));
+    QVERIFY(minified(minifier, "M104 S210.0") == QByteArray("M104 S210.0"));
+    QVERIFY(minified(minifier, "G92 E0.000") == QByteArray("G92 E0.000"));
+    QVERIFY(minified(minifier, "G1 X1.50*12") == QByteArray("G1 X1.50*12"));
+
+    QByteArray empty;
+    QVERIFY(!minifier.minify(empty));
+
+    // a tool change moves the head
+    QVERIFY(minified(minifier, "G1 X10 Y10") == QByteArray("G1 X10 Y10"));
+    QVERIFY(minified(minifier, "T1") == QByteArray("T1"));
+    QVERIFY(minified(minifier, "G1 X10 Y10") == QByteArray("G1 X10 Y10"));
+}
+
+void GCodeMinifierTests::testCompactWords()
+{
+    GCodeMinifier minifier;
+    minifier.setCompactWords(true);
+    QVERIFY(minified(minifier, "G1 Z0.200 F3000.0") == QByteArray("G1Z.2F3000"));
+    QVERIFY(minified(minifier, "G1 X-0.50 Y25 E0.04000") == QByteArray("G1X-.5Y25E.04"));
+    QVERIFY(minified(minifier, "M117 Hello there") == QByteArray("M117 Hello there"));
+}
+
+void GCodeMinifierTests::testBytesSaved()
+{
+    GCodeMinifier minifier;
+    const QList<QByteArray> job = {"G1 X10.000 Y10.000 F1800.000", "G1 X10.000 Y20.000 F1800.000", "G1 X10.000 Y20.000"};
+    qint64 size = 0;
+    for (QByteArray command : job) {
+        size += command.size();
+        minifier.minify(command);
+    }
+    QVERIFY(minifier.bytesIn() == size);
+    QVERIFY(minifier.bytesOut() == QByteArray("G1 X10 Y10 F1800").size() + QByteArray("G1 Y20").size());
+}
+
+QTEST_MAIN(GCodeMinifierTests)
@@ -0,0 +1,173 @@
+/*
+    This file is part of the KDE project
+
+    Copyright (C) 2018 Patrick José Pereira <patrickelectric@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QtTest>
+
+#include "gcodepipelinetests.h"
+#include "../src/gcodeminifier.h"
+#include "../src/gcodepipeline.h"
+
+namespace
+{
+/**
+ * @brief Appends a word to every command
+ */
+class AppendFilter : public GCodeFilter
+{
+public:
+    explicit AppendFilter(const QByteArray &word) : _word(word) {}
+    QString name() const override
+    {
+        return QString::fromLatin1(_word);
+    }
+    void process(QVector<Line> &lines) override
+    {
+        for (Line &line : lines) {
+            line.command += ' ' + _word;
+        }
+    }
+private:
+    QByteArray _word;
+};
+
+/**
+ * @brief Holds every line back until the end of the job
+ */
+class HoldFilter : public GCodeFilter
+{
+public:
+    QString name() const override
+    {
+        return QStringLiteral("hold");
+    }
+    void process(QVector<Line> &lines) override
+    {
+        _held += lines;
+        lines.clear();
+    }
+    void flush(QVector<Line> &lines) override
+    {
+        lines += _held;
+        _held.clear();
+    }
+private:
+    QVector<Line> _held;
+};
+
+/**
+ * @brief Lines with \p commands, each one byte after the other
+ */
+QVector<GCodeFilter::Line> batch(const QList<QByteArray> &commands)
+{
+    QVector<GCodeFilter::Line> lines;
+    for (const QByteArray &command : commands) {
+        lines.append({command, lines.size() + 1, lines.size() + 1});
+    }
+    return lines;
+}
+}
+
+void GCodePipelineTests::testEmpty()
+{
+    GCodePipeline pipeline;
+    QVERIFY(pipeline.isEmpty());
+    QVERIFY(pipeline.stats().isEmpty());
+
+    QVector<GCodeFilter::Line> lines = batch({"G28", "G1 X10"});
+    pipeline.process(lines);
+    QVERIFY(lines.size() == 2);
+    QVERIFY(lines.at(1).command == QByteArray("G1 X10"));
+
+    QVector<GCodeFilter::Line> held;
+    pipeline.flush(held);
+    QVERIFY(held.isEmpty());
+}
+
+void GCodePipelineTests::testOrder()
+{
+    GCodePipeline pipeline;
+    pipeline.addFilter(new AppendFilter("A1"));
+    pipeline.addFilter(new AppendFilter("B2"));
+    QVERIFY(!pipeline.isEmpty());
+
+    QVector<GCodeFilter::Line> lines = batch({"G1 X10", "G1 X20"});
+    pipeline.process(lines);
+    QVERIFY(lines.size() == 2);
+    QVERIFY(lines.at(0).command == QByteArray("G1 X10 A1 B2"));
+    QVERIFY(lines.at(1).command == QByteArray("G1 X20 A1 B2"));
+    QVERIFY(lines.at(1).offset == 2);
+}
+
+void GCodePipelineTests::testHeldLines()
+{
+    GCodePipeline pipeline;
+    pipeline.addFilter(new AppendFilter("A1"));
+    pipeline.addFilter(new HoldFilter);
+    pipeline.addFilter(new AppendFilter("B2"));
+
+    QVector<GCodeFilter::Line> lines = batch({"G1 X10"});
+    pipeline.process(lines);
+    QVERIFY(lines.isEmpty());
+    lines = batch({"G1 X20"});
+    pipeline.process(lines);
+    QVERIFY(lines.isEmpty());
+
+    // held lines go through the stages after the one holding them, in job order
+    pipeline.flush(lines);
+    QVERIFY(lines.size() == 2);
+    QVERIFY(lines.at(0).command == QByteArray("G1 X10 A1 B2"));
+    QVERIFY(lines.at(1).command == QByteArray("G1 X20 A1 B2"));
+}
+
+void GCodePipelineTests::testStats()
+{
+    GCodePipeline pipeline;
+    pipeline.addFilter(new HoldFilter);
+    pipeline.addFilter(new AppendFilter("A1"));
+
+    QVector<GCodeFilter::Line> lines = batch({"G1 X10", "G1 X20", "G1 X30"});
+    pipeline.process(lines);
+    pipeline.flush(lines);
+
+    const QVector<GCodePipeline::StageStats> stats = pipeline.stats();
+    QVERIFY(stats.size() == 2);
+    QVERIFY(stats.at(0).name == QStringLiteral("hold"));
+    QVERIFY(stats.at(0).linesIn == 3);
+    QVERIFY(stats.at(0).linesOut == 3);
+    QVERIFY(stats.at(1).name == QStringLiteral("A1"));
+    QVERIFY(stats.at(1).linesIn == 3);
+    QVERIFY(stats.at(1).linesOut == 3);
+    QVERIFY(stats.at(0).nsecs >= 0);
+}
+
+void GCodePipelineTests::testMinifierStage()
+{
+    GCodePipeline pipeline;
+    pipeline.addFilter(new GCodeMinifier);
+
+    QVector<GCodeFilter::Line> lines = batch({"G1 X10.000 Y10.000", "G1 X10 Y10", "M117 Done", "G1 X10.000 Y20.000"});
+    pipeline.process(lines);
+    QVERIFY(lines.size() == 3);
+    QVERIFY(lines.at(0).command == QByteArray("G1 X10 Y10"));
+    QVERIFY(lines.at(1).command == QByteArray("M117 Done"));
+    QVERIFY(lines.at(1).offset == 3);
+    QVERIFY(lines.at(2).command == QByteArray("G1 X10 Y20"));
+    QVERIFY(pipeline.stats().at(0).linesOut == 3);
+}
+
+QTEST_MAIN(GCodePipelineTests)
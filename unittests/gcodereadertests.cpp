@@ -0,0 +1,222 @@
+/*
+    This file is part of the KDE project
+
+    Copyright (C) 2018 Patrick José Pereira <patrickelectric@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QtTest>
+#include <QTextStream>
+
+#include "gcodereadertests.h"
+#include "testfile.h"
+#include "../src/gcodedecompressor.h"
+
+void GCodeReaderTests::initTestCase()
+{
+    QByteArray content;
+    for (int i = 0; i < 200000; i++) {
+        content.append("G1 X" + QByteArray::number(i % 200) + " Y" + QByteArray::number(i % 150) + " E0.0412 ; move\n");
+        jobLines++;
+    }
+    QVERIFY(writeFile(job, content));
+}
+
+void GCodeReaderTests::testReadLine()
+{
+    QTemporaryFile file;
+    QVERIFY(writeFile(file, QByteArray("G28\r\nG1 X10\n\nM105")));
+    GCodeReader reader(file.fileName());
+    QVERIFY(reader.open());
+
+    const char *data = nullptr;
+    int size = 0;
+    QVERIFY(reader.readLine(data, size));
+    QVERIFY(QByteArray(data, size) == QByteArray("G28"));
+    QVERIFY(reader.readLine(data, size));
+    QVERIFY(QByteArray(data, size) == QByteArray("G1 X10"));
+    QVERIFY(reader.readLine(data, size));
+    QVERIFY(size == 0);
+    QVERIFY(reader.readLine(data, size));
+    QVERIFY(QByteArray(data, size) == QByteArray("M105"));
+    QVERIFY(reader.atEnd());
+    QVERIFY(!reader.readLine(data, size));
+}
+
+void GCodeReaderTests::testReadCommand()
+{
+    QTemporaryFile file;
+    QVERIFY(writeFile(file, QByteArray("  G1   X10\tY2 ; a comment\n;LAYER:1\nM117 Hi there  \n")));
+    GCodeReader reader(file.fileName());
+    QVERIFY(reader.open());
+
+    QByteArray command;
+    QVERIFY(reader.readCommand(command));
+    QVERIFY(command == QByteArray("G1 X10 Y2"));
+    QVERIFY(reader.readCommand(command));
+    QVERIFY(command.isEmpty());
+    QVERIFY(reader.readCommand(command));
+    QVERIFY(command == QByteArray("M117 Hi there"));
+    QVERIFY(!reader.readCommand(command));
+}
+
+void GCodeReaderTests::testPosition()
+{
+    QTemporaryFile file;
+    QVERIFY(writeFile(file, QByteArray("G28\nG1 X10\n")));
+    GCodeReader reader(file.fileName());
+    QVERIFY(reader.open());
+    QVERIFY(reader.size() == 11);
+
+    QByteArray command;
+    QVERIFY(reader.position() == 0);
+    reader.readCommand(command);
+    QVERIFY(reader.position() == 4);
+    reader.readCommand(command);
+    QVERIFY(reader.position() == reader.size());
+    QVERIFY(reader.atEnd());
+}
+
+void GCodeReaderTests::testSeek()
+{
+    QTemporaryFile file;
+    QVERIFY(writeFile(file, QByteArray("G28\nG1 X10\nG1 X20\n")));
+    GCodeReader reader(file.fileName());
+    QVERIFY(reader.open());
+
+    QByteArray command;
+    QVERIFY(reader.seek(11));
+    reader.readCommand(command);
+    QVERIFY(command == QByteArray("G1 X20"));
+    QVERIFY(reader.seek(0));
+    reader.readCommand(command);
+    QVERIFY(command == QByteArray("G28"));
+    QVERIFY(!reader.seek(-1));
+    QVERIFY(!reader.seek(reader.size() + 1));
+}
+
+void GCodeReaderTests::testEmptyFile()
+{
+    QTemporaryFile file;
+    QVERIFY(writeFile(file, QByteArray()));
+    GCodeReader reader(file.fileName());
+    QVERIFY(reader.open());
+    QVERIFY(reader.atEnd());
+    QByteArray command;
+    QVERIFY(!reader.readCommand(command));
+}
+
+void GCodeReaderTests::testMissingFile()
+{
+    GCodeReader reader(QStringLiteral("/nonexistent/job.gcode"));
+    QVERIFY(!reader.open());
+    QVERIFY(!reader.isOpen());
+}
+
+void GCodeReaderTests::testCompressed()
+{
+    // 50000 lines alternating "G1 X0 E0.05" and "G1 X1 E0.05", over a few decompressed blocks
+    const QByteArray gzipMember = QByteArray::fromBase64(
+                                      "H4sIAAAAAAACA+3IMQ0AIAwAsB8VU0DGgQQyC/hXAicKuPo1rRE7Y2XP2ep6PPbee++9995777333nvvvffee++9995777333nvvf/0BTY++HOAuAAA=");
+    const QList<QPair<GCodeDecompressor::FORMAT, QByteArray>> files = {
+        // 50 concatenated members of 1000 lines
+        {GCodeDecompressor::GZIP, gzipMember.repeated(50)},
+        {
+            GCodeDecompressor::BZIP2, QByteArray::fromBase64(
+                "QlpoOTFBWSZTWYHw6cAEAWPeAAAQQAFiAAKAAEAwALgIMmIIMmIClSMm1OBJQXBJQXBJQWgkoLQSUFgkoLoSUF0JKC8ElBYE"
+                "lBbCSgsCSgsCSgtBJQX4u5IpwoSED4dOAA==")
+        },
+        {
+            GCodeDecompressor::ZSTD, QByteArray::fromBase64(
+                "KLUv/QRo5AAAiEcxIFgwIEUwLjA1CkcxIFgxAgDl/zszeLcsAVQAAAABAP3/+/+5BgJEAAAAAQD9/zkAAkQAAAABAP3/OQAC"
+                "RQAAAAEAvSc5AAIHZFgc")
+        },
+    };
+
+    int tested = 0;
+    for (const auto &compressed : files) {
+        QTemporaryFile file;
+        QVERIFY(writeFile(file, compressed.second));
+        QVERIFY(GCodeDecompressor::format(file.fileName()) == compressed.first);
+        if (!GCodeDecompressor::isSupported(compressed.first)) {
+            continue;
+        }
+        tested++;
+
+        GCodeReader reader(file.fileName());
+        QVERIFY(reader.open());
+        QVERIFY(reader.isCompressed());
+        QVERIFY(reader.fileSize() == compressed.second.size());
+        QByteArray command;
+        int lines = 0;
+        while (reader.readCommand(command)) {
+            QVERIFY(command == (lines % 2 ? QByteArray("G1 X1 E0.05") : QByteArray("G1 X0 E0.05")));
+            lines++;
+        }
+        QVERIFY(lines == 50000);
+        QVERIFY(reader.position() == 600000);
+        QVERIFY(reader.filePosition() == reader.fileSize());
+
+        // backwards decompresses again
+        QVERIFY(reader.seek(12 * 3));
+        reader.readCommand(command);
+        QVERIFY(command == QByteArray("G1 X1 E0.05"));
+        QVERIFY(reader.seek(12 * 30000));
+        reader.readCommand(command);
+        QVERIFY(command == QByteArray("G1 X0 E0.05"));
+        QVERIFY(!reader.seek(600001));
+    }
+    if (!tested) {
+        QSKIP("AtCore was built without decompression libraries");
+    }
+}
+
+void GCodeReaderTests::benchmarkTextStream()
+{
+    // What PrintThread did before GCodeReader
+    int lines = 0;
+    QBENCHMARK {
+        QFile file(job.fileName());
+        QVERIFY(file.open(QFile::ReadOnly));
+        QTextStream stream(&file);
+        lines = 0;
+        while (!stream.atEnd()) {
+            QString line = stream.readLine();
+            if (line.contains(QChar::fromLatin1(';'))) {
+                line.resize(line.indexOf(QChar::fromLatin1(';')));
+            }
+            line = line.simplified();
+            lines++;
+        }
+    }
+    QVERIFY(lines == jobLines);
+}
+
+void GCodeReaderTests::benchmarkReader()
+{
+    int lines = 0;
+    QBENCHMARK {
+        GCodeReader reader(job.fileName());
+        QVERIFY(reader.open());
+        QByteArray command;
+        command.reserve(256);
+        lines = 0;
+        while (reader.readCommand(command)) {
+            lines++;
+        }
+    }
+    QVERIFY(lines == jobLines);
+}
+
+QTEST_MAIN(GCodeReaderTests)
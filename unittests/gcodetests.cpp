@@ -58,6 +58,12 @@ void GCodeTests::command_G91()
     QVERIFY(GCode::toCommand(GCode::G91) == QStringLiteral("G91"));
 }
 
+void GCodeTests::command_G20_G21()
+{
+    QVERIFY(GCode::toCommand(GCode::G20) == QStringLiteral("G20"));
+    QVERIFY(GCode::toCommand(GCode::G21) == QStringLiteral("G21"));
+}
+
 void GCodeTests::command_unsupportedG()
 {
     QVERIFY(GCode::toCommand(GCode::G2) == GCode::commandNotSupported);
@@ -228,4 +234,43 @@ void GCodeTests::command_unsupportedM()
     QVERIFY(GCode::toCommand(GCode::M999) == GCode::commandNotSupported);
 }
 
+void GCodeTests::description()
+{
+    QVERIFY(GCode::description(GCode::G28) == QStringLiteral("G28: Move to Origin Home"));
+    QVERIFY(GCode::description(GCode::M105) == QStringLiteral("M105: Get Extruder Temperature"));
+    QVERIFY(GCode::description(GCode::M999) == QStringLiteral("M999: Restart after being stopped by error"));
+    // in the enum, without a description
+    QVERIFY(GCode::description(GCode::G22) == GCode::commandNotSupported);
+}
+
+void GCodeTests::firmwares()
+{
+    QVERIFY(GCode::firmwares(GCode::G0) & GCode::MakerBot);
+    QVERIFY(!(GCode::firmwares(GCode::G1) & GCode::MakerBot));
+    QVERIFY(GCode::firmwares(GCode::G33) == GCode::Repetier);
+    QVERIFY(GCode::firmwares(GCode::M18) == (GCode::Teacup | GCode::Marlin | GCode::Smoothie | GCode::RepRapFirmware));
+    QVERIFY(GCode::firmwares(GCode::G22) == GCode::Firmwares());
+}
+
+void GCodeTests::fromCommand()
+{
+    GCode::GCommands gcode = GCode::G0;
+    QVERIFY(GCode::fromCommand(QStringLiteral("G28 X Y"), gcode));
+    QVERIFY(gcode == GCode::G28);
+    QVERIFY(GCode::fromCommand(QStringLiteral("g1"), gcode));
+    QVERIFY(gcode == GCode::G1);
+    QVERIFY(!GCode::fromCommand(QStringLiteral("G29.1"), gcode));
+    QVERIFY(!GCode::fromCommand(QStringLiteral("G5 X1"), gcode));
+    QVERIFY(!GCode::fromCommand(QStringLiteral("M105"), gcode));
+
+    GCode::MCommands mcode = GCode::M0;
+    QVERIFY(GCode::fromCommand(QStringLiteral("  M104 S200"), mcode));
+    QVERIFY(mcode == GCode::M104);
+    QVERIFY(GCode::fromCommand(QStringLiteral("M999"), mcode));
+    QVERIFY(mcode == GCode::M999);
+    QVERIFY(!GCode::fromCommand(QStringLiteral("M"), mcode));
+    QVERIFY(!GCode::fromCommand(QStringLiteral("M1000"), mcode));
+    QVERIFY(!GCode::fromCommand(QString(), mcode));
+}
+
 QTEST_MAIN(GCodeTests)
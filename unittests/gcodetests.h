@@ -32,6 +32,7 @@ private slots:
     void command_G32();
     void command_G90();
     void command_G91();
+    void command_G20_G21();
     void command_unsupportedG();
 
     bool testMCodeNeedsArg(GCode::MCommands code);
@@ -63,4 +64,8 @@ private slots:
     void command_M220();
     void command_M221();
     void command_unsupportedM();
+
+    void description();
+    void firmwares();
+    void fromCommand();
 };
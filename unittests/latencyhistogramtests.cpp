@@ -0,0 +1,86 @@
+/*
+    This file is part of the KDE project
+
+    Copyright (C) 2018 Patrick José Pereira <patrickelectric@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QtTest>
+
+#include "latencyhistogramtests.h"
+
+void LatencyHistogramTests::testEmpty()
+{
+    LatencyHistogram histogram;
+    QVERIFY(histogram.count() == 0);
+    QVERIFY(histogram.min() == 0);
+    QVERIFY(histogram.max() == 0);
+    QVERIFY(histogram.mean() == 0);
+    QVERIFY(histogram.percentile(50) == 0);
+}
+
+void LatencyHistogramTests::testBuckets()
+{
+    // small values are exact
+    for (quint64 value = 0; value < 32; value++) {
+        QVERIFY(LatencyHistogram::bucketUpperBound(LatencyHistogram::bucketIndex(value)) == value);
+    }
+
+    // buckets are contiguous and every value is known within 1/16
+    for (int i = 1; i < LatencyHistogram::bucketCount(); i++) {
+        const quint64 lower = LatencyHistogram::bucketUpperBound(i - 1) + 1;
+        const quint64 upper = LatencyHistogram::bucketUpperBound(i);
+        QVERIFY(LatencyHistogram::bucketIndex(lower) == i);
+        QVERIFY(LatencyHistogram::bucketIndex(upper) == i);
+        QVERIFY((upper - lower) * 16 <= lower);
+    }
+
+    // huge values are clamped into the last bucket
+    QVERIFY(LatencyHistogram::bucketIndex(quint64(1) << 60) == LatencyHistogram::bucketCount() - 1);
+}
+
+void LatencyHistogramTests::testStatistics()
+{
+    LatencyHistogram histogram;
+    for (quint64 value = 1; value <= 1000; value++) {
+        histogram.record(value);
+    }
+    QVERIFY(histogram.count() == 1000);
+    QVERIFY(histogram.min() == 1);
+    QVERIFY(histogram.max() == 1000);
+    QCOMPARE(histogram.mean(), 500.5);
+    QVERIFY(histogram.percentile(50) >= 500 && histogram.percentile(50) <= 532);
+    QVERIFY(histogram.percentile(99) >= 990 && histogram.percentile(99) <= 1000);
+    QVERIFY(histogram.percentile(100) == 1000);
+}
+
+void LatencyHistogramTests::testReset()
+{
+    LatencyHistogram histogram;
+    histogram.record(42);
+    histogram.reset();
+    QVERIFY(histogram.count() == 0);
+    QVERIFY(histogram.bucketValues(LatencyHistogram::bucketIndex(42)) == 0);
+}
+
+void LatencyHistogramTests::benchmarkRecord()
+{
+    LatencyHistogram histogram;
+    quint64 value = 0;
+    QBENCHMARK {
+        histogram.record(value++ % 100000);
+    }
+}
+
+QTEST_MAIN(LatencyHistogramTests)
@@ -0,0 +1,253 @@
+/*
+    This file is part of the KDE project
+
+    Copyright (C) 2018 Patrick José Pereira <patrickelectric@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QtTest>
+#include <QElapsedTimer>
+#include <atomic>
+#include <cstdlib>
+
+#include "linebuffertests.h"
+
+namespace
+{
+std::atomic<qint64> allocations(0);
+
+// Size of the chunks handed out by readyRead in the benchmarks
+const int chunkSize = 64;
+
+/**
+ * @brief The framing SerialLayer::readAllData used before LineBuffer
+ */
+int splitLines(const QByteArray &data)
+{
+    int lines = 0;
+    QByteArray rawData;
+    for (int pos = 0; pos < data.size(); pos += chunkSize) {
+        rawData.append(data.mid(pos, chunkSize));
+        if (rawData.contains(QByteArray("\r"))) {
+            rawData = rawData.replace(QByteArray("\r"), QByteArray());
+        }
+        QList<QByteArray> tempList = rawData.split('\n');
+        for (auto i = tempList.begin(); i != tempList.end(); ++i) {
+            if (i < tempList.end() - 1) {
+                lines++;
+            } else {
+                rawData.clear();
+                rawData.append(*i);
+            }
+        }
+    }
+    return lines;
+}
+
+int ringLines(const QByteArray &data)
+{
+    int lines = 0;
+    LineBuffer buffer;
+    QByteArray line;
+    for (int pos = 0; pos < data.size(); pos += chunkSize) {
+        buffer.append(data.constData() + pos, qMin(chunkSize, data.size() - pos));
+        while (buffer.readLine(line)) {
+            lines++;
+        }
+    }
+    return lines;
+}
+}
+
+#if defined(__GLIBC__)
+// Count every heap allocation, QByteArray and QList go straight to malloc
+#define ATCORE_COUNT_ALLOCATIONS
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+}
+#endif
+
+void LineBufferTests::initTestCase()
+{
+    //A typical print: "ok" for each line and a temperature report now and then
+    for (int i = 0; i < 20000; i++) {
+        if (i % 50 == 0) {
+            stream.append("ok T:210.05 /210.00 B:60.02 /60.00 @:64 B@:0\n\r");
+        } else {
+            stream.append("ok\n\r");
+        }
+        streamLines++;
+    }
+}
+
+void LineBufferTests::testSingleLine()
+{
+    LineBuffer buffer;
+    QByteArray line;
+    QVERIFY(buffer.append("ok", 2) == 2);
+    QVERIFY(!buffer.readLine(line));
+    QVERIFY(buffer.append("\n", 1) == 1);
+    QVERIFY(buffer.readLine(line));
+    QVERIFY(line == "ok");
+    QVERIFY(buffer.size() == 0);
+}
+
+void LineBufferTests::testSplitLine()
+{
+    LineBuffer buffer;
+    QByteArray line;
+    buffer.append("ok\nT:2", 6);
+    QVERIFY(buffer.readLine(line));
+    QVERIFY(line == "ok");
+    QVERIFY(!buffer.readLine(line));
+    buffer.append("0 /0\n\n", 6);
+    QVERIFY(buffer.readLine(line));
+    QVERIFY(line == "T:20 /0");
+    QVERIFY(buffer.readLine(line));
+    QVERIFY(line.isEmpty());
+    QVERIFY(!buffer.readLine(line));
+}
+
+void LineBufferTests::testReturnRemoved()
+{
+    LineBuffer buffer;
+    QByteArray line;
+    buffer.append("ok\n\rwait\r\n", 10);
+    QVERIFY(buffer.readLine(line));
+    QVERIFY(line == "ok");
+    QVERIFY(buffer.readLine(line));
+    QVERIFY(line == "wait");
+}
+
+void LineBufferTests::testWrapAround()
+{
+    LineBuffer buffer(8);
+    QByteArray line;
+    buffer.append("abcde\n", 6);
+    QVERIFY(buffer.readLine(line));
+    int space = 0;
+    buffer.reserve(space);
+    QVERIFY(space == 2);
+    QVERIFY(buffer.append("fghij\n", 6) == 6);
+    QVERIFY(buffer.readLine(line));
+    QVERIFY(line == "fghij");
+}
+
+void LineBufferTests::testFullWithoutLineEnd()
+{
+    LineBuffer buffer(4);
+    QByteArray line;
+    QVERIFY(buffer.append("abcdef", 6) == 4);
+    QVERIFY(buffer.readLine(line));
+    QVERIFY(line == "abcd");
+    QVERIFY(buffer.size() == 0);
+}
+
+void LineBufferTests::testRandomChunks()
+{
+    qsrand(42);
+    QByteArray data;
+    QList<QByteArray> expected;
+    for (int i = 0; i < 2000; i++) {
+        QByteArray line;
+        for (int j = qrand() % 60; j > 0; j--) {
+            line.append(char('a' + qrand() % 26));
+        }
+        expected.append(line);
+        data.append(line);
+        data.append(qrand() % 2 ? "\n" : "\r\n");
+    }
+
+    LineBuffer buffer(128);
+    QList<QByteArray> received;
+    QByteArray line;
+    int pos = 0;
+    while (pos < data.size()) {
+        int space = 0;
+        char *dest = buffer.reserve(space);
+        const int count = qMin(qMin(space, qrand() % 100), data.size() - pos);
+        memcpy(dest, data.constData() + pos, size_t(count));
+        buffer.commit(count);
+        pos += count;
+        while (buffer.readLine(line)) {
+            received.append(line);
+        }
+    }
+    QVERIFY(received == expected);
+}
+
+void LineBufferTests::benchmarkSplit()
+{
+    int lines = 0;
+    QBENCHMARK {
+        lines = splitLines(stream);
+    }
+    QVERIFY(lines == streamLines);
+}
+
+void LineBufferTests::benchmarkLineBuffer()
+{
+    int lines = 0;
+    QBENCHMARK {
+        lines = ringLines(stream);
+    }
+    QVERIFY(lines == streamLines);
+}
+
+void LineBufferTests::compareAllocations()
+{
+#ifndef ATCORE_COUNT_ALLOCATIONS
+    QSKIP("Allocations are only counted with glibc");
+#endif
+    QElapsedTimer timer;
+
+    allocations = 0;
+    timer.start();
+    splitLines(stream);
+    const qint64 splitTime = qMax(timer.nsecsElapsed(), qint64(1));
+    const double splitAllocations = double(allocations) / streamLines;
+
+    allocations = 0;
+    timer.restart();
+    ringLines(stream);
+    const qint64 ringTime = qMax(timer.nsecsElapsed(), qint64(1));
+    const double ringAllocations = double(allocations) / streamLines;
+
+    qInfo("split/replace: %.0f lines/s, %.2f allocations/line", streamLines * 1e9 / splitTime, splitAllocations);
+    qInfo("LineBuffer:    %.0f lines/s, %.2f allocations/line", streamLines * 1e9 / ringTime, ringAllocations);
+    QVERIFY(ringAllocations <= 1);
+    QVERIFY(ringAllocations < splitAllocations);
+}
+
+QTEST_MAIN(LineBufferTests)
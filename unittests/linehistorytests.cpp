@@ -0,0 +1,95 @@
+/*
+    This file is part of the KDE project
+
+    Copyright (C) 2018 Patrick José Pereira <patrickelectric@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "linehistorytests.h"
+
+void LineHistoryTests::testAppend()
+{
+    LineHistory history(4);
+    QVERIFY(history.isEmpty());
+    history.append(QByteArray("ok"));
+    history.append(QByteArray("T:20.0 /0.0"));
+    QVERIFY(history.size() == 2);
+    QVERIFY(history.total() == 2);
+    QVERIFY(history.recent() == QList<QByteArray>({"ok", "T:20.0 /0.0"}));
+}
+
+void LineHistoryTests::testWrapAround()
+{
+    LineHistory history(3);
+    for (int i = 0; i < 10; i++) {
+        history.append(QByteArray::number(i));
+    }
+    QVERIFY(history.size() == 3);
+    QVERIFY(history.total() == 10);
+    QVERIFY(history.recent() == QList<QByteArray>({"7", "8", "9"}));
+}
+
+void LineHistoryTests::testRecent()
+{
+    LineHistory history(5);
+    for (int i = 0; i < 7; i++) {
+        history.append(QByteArray::number(i));
+    }
+    QVERIFY(history.recent(2) == QList<QByteArray>({"5", "6"}));
+    QVERIFY(history.recent(0).isEmpty());
+    QVERIFY(history.recent(100).size() == 5);
+    history.clear();
+    QVERIFY(history.isEmpty());
+    QVERIFY(history.recent().isEmpty());
+}
+
+void LineHistoryTests::testSetDepth()
+{
+    LineHistory history(4);
+    for (int i = 0; i < 6; i++) {
+        history.append(QByteArray::number(i));
+    }
+    history.setDepth(2);
+    QVERIFY(history.depth() == 2);
+    QVERIFY(history.recent() == QList<QByteArray>({"4", "5"}));
+    history.setDepth(3);
+    history.append(QByteArray("6"));
+    QVERIFY(history.recent() == QList<QByteArray>({"4", "5", "6"}));
+}
+
+void LineHistoryTests::testSpillFile()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.path() + QStringLiteral("/history.log");
+
+    LineHistory history(2);
+    QVERIFY(history.setSpillFile(fileName));
+    QVERIFY(history.spillFile() == fileName);
+    for (int i = 0; i < 5; i++) {
+        history.append(QByteArray::number(i));
+    }
+    QVERIFY(history.setSpillFile(QString()));
+    QVERIFY(history.spillFile().isEmpty());
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QVERIFY(file.readAll() == QByteArray("0\n1\n2\n"));
+    QVERIFY(history.recent() == QList<QByteArray>({"3", "4"}));
+}
+
+QTEST_MAIN(LineHistoryTests)
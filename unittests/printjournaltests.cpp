@@ -0,0 +1,172 @@
+/*
+    This file is part of the KDE project
+
+    Copyright (C) 2018 Patrick José Pereira <patrickelectric@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QtTest>
+
+#include "printjournaltests.h"
+
+void PrintJournalTests::init()
+{
+    job = new QTemporaryFile;
+    QVERIFY(job->open());
+    job->write("G28\nG1 Z0.2\nG1 X10 E1\n");
+    job->flush();
+}
+
+void PrintJournalTests::cleanup()
+{
+    QFile::remove(PrintJournal::journalFileName(job->fileName()));
+    delete job;
+}
+
+void PrintJournalTests::testModalState()
+{
+    PrintJournal journal(job->fileName());
+    journal.acknowledged(QByteArray("M140 S60"), 9);
+    journal.acknowledged(QByteArray("M104 S210"), 19);
+    journal.acknowledged(QByteArray("G28"), 23);
+    journal.acknowledged(QByteArray("G1 Z0.2 F300"), 36);
+    journal.acknowledged(QByteArray("G1 X10 Y-5 E1.5 F1200"), 58);
+    journal.acknowledged(QByteArray("M106 S127"), 68);
+
+    const PrintJournal::State &state = journal.state();
+    QVERIFY(state.offset == 68);
+    QVERIFY(qFuzzyCompare(state.bedTemp, 60.0f));
+    QVERIFY(qFuzzyCompare(state.extruderTemp, 210.0f));
+    QVERIFY(qFuzzyCompare(state.x, 10.0f));
+    QVERIFY(qFuzzyCompare(state.y, -5.0f));
+    QVERIFY(qFuzzyCompare(state.z, 0.2f));
+    QVERIFY(qFuzzyCompare(state.e, 1.5f));
+    QVERIFY(qFuzzyCompare(state.feedrate, 1200.0f));
+    QVERIFY(state.fanSpeed == 127);
+
+    journal.acknowledged(QByteArray("M107"), 73);
+    journal.acknowledged(QByteArray("T1"), 76);
+    journal.acknowledged(QByteArray("M104 T0 S0"), 87);
+    QVERIFY(journal.state().fanSpeed == 0);
+    QVERIFY(journal.state().tool == 1);
+    QVERIFY(qFuzzyCompare(journal.state().extruderTemp, 210.0f));
+}
+
+void PrintJournalTests::testRelativeModes()
+{
+    PrintJournal journal(job->fileName());
+    journal.acknowledged(QByteArray("G92 E10"), 8);
+    journal.acknowledged(QByteArray("M83"), 12);
+    journal.acknowledged(QByteArray("G1 X5 E2"), 21);
+    QVERIFY(qFuzzyCompare(journal.state().e, 12.0f));
+    QVERIFY(journal.state().relativeE);
+
+    journal.acknowledged(QByteArray("G91"), 25);
+    journal.acknowledged(QByteArray("G1 X5 Z1 E-1"), 38);
+    QVERIFY(qFuzzyCompare(journal.state().x, 10.0f));
+    QVERIFY(qFuzzyCompare(journal.state().z, 1.0f));
+    QVERIFY(qFuzzyCompare(journal.state().e, 11.0f));
+    journal.acknowledged(QByteArray("G90"), 42);
+    journal.acknowledged(QByteArray("M82"), 46);
+    QVERIFY(!journal.state().relative);
+    QVERIFY(!journal.state().relativeE);
+}
+
+void PrintJournalTests::testReadBack()
+{
+    PrintJournal::State state;
+    QVERIFY(!PrintJournal::read(job->fileName(), state));
+    {
+        PrintJournal journal(job->fileName());
+        QVERIFY(journal.start());
+        QVERIFY(journal.isActive());
+        journal.acknowledged(QByteArray("M104 S200"), 10);
+        journal.acknowledged(QByteArray("G1 X3 Y4 Z0.3 E2 F900"), 32);
+        // the journal is left behind as on a crash, the last record is committed on destruction
+    }
+    QVERIFY(PrintJournal::read(job->fileName(), state));
+    QVERIFY(state.offset == 32);
+    QVERIFY(qFuzzyCompare(state.extruderTemp, 200.0f));
+    QVERIFY(qFuzzyCompare(state.y, 4.0f));
+    QVERIFY(qFuzzyCompare(state.z, 0.3f));
+    QVERIFY(qFuzzyCompare(state.feedrate, 900.0f));
+}
+
+void PrintJournalTests::testTornRecord()
+{
+    {
+        PrintJournal journal(job->fileName());
+        journal.setCommitInterval(0);
+        QVERIFY(journal.start());
+        journal.acknowledged(QByteArray("G1 X1"), 10);
+        QTRY_VERIFY(journal.commits() == 2);
+        journal.acknowledged(QByteArray("G1 X2"), 20);
+    }
+
+    // tear the newest record, the one before it must be used
+    QFile file(PrintJournal::journalFileName(job->fileName()));
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QByteArray content = file.readAll();
+    PrintJournal::State state;
+    QVERIFY(PrintJournal::read(job->fileName(), state));
+    QVERIFY(state.offset == 20);
+    const int slot = content.indexOf(QByteArray::fromHex("0000000000000014"));
+    QVERIFY(slot > 0);
+    content[slot + 7] = 0x15;
+    file.seek(0);
+    file.write(content);
+    file.close();
+    QVERIFY(PrintJournal::read(job->fileName(), state));
+    QVERIFY(state.offset == 10);
+}
+
+void PrintJournalTests::testChangedJob()
+{
+    {
+        PrintJournal journal(job->fileName());
+        QVERIFY(journal.start());
+        journal.acknowledged(QByteArray("G1 X1"), 4);
+    }
+    job->write("G1 X20 E2\n");
+    job->flush();
+    PrintJournal::State state;
+    QVERIFY(!PrintJournal::read(job->fileName(), state));
+}
+
+void PrintJournalTests::testFinish()
+{
+    PrintJournal journal(job->fileName());
+    QVERIFY(journal.start());
+    QVERIFY(QFile::exists(PrintJournal::journalFileName(job->fileName())));
+    journal.acknowledged(QByteArray("G1 X1"), 4);
+    journal.finish();
+    QVERIFY(!journal.isActive());
+    QVERIFY(!QFile::exists(PrintJournal::journalFileName(job->fileName())));
+}
+
+void PrintJournalTests::testGroupCommit()
+{
+    PrintJournal journal(job->fileName());
+    journal.setCommitInterval(100);
+    QVERIFY(journal.start());
+    for (int i = 1; i <= 10000; i++) {
+        journal.acknowledged(QByteArray("G1 X1 E0.01"), i * 12);
+    }
+    // the start record and a few commits, not one fsync per acknowledge
+    QTRY_VERIFY(journal.commits() >= 2);
+    QVERIFY(journal.commits() < 100);
+    journal.finish();
+}
+
+QTEST_MAIN(PrintJournalTests)
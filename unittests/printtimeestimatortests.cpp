@@ -0,0 +1,210 @@
+/*
+    This file is part of the KDE project
+
+    Copyright (C) 2018 Patrick José Pereira <patrickelectric@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QtTest>
+
+#include "printtimeestimatortests.h"
+#include "testfile.h"
+
+double PrintTimeEstimatorTests::estimate(const QByteArray &gcode, const PrintTimeEstimator::Limits &limits)
+{
+    QTemporaryFile file;
+    PrintTimeEstimator estimator;
+    estimator.setLimits(limits);
+    if (!writeFile(file, gcode) || !estimator.estimate(file.fileName())) {
+        return -1;
+    }
+    return estimator.totalTime();
+}
+
+void PrintTimeEstimatorTests::testStraightMove()
+{
+    // starts at the X jerk, accelerates to 50 mm/s at 3000 mm/s², cruises and stops
+    const double expected = 40.0 / 3000 + 50.0 / 3000 + (100 - 2400.0 / 6000 - 2500.0 / 6000) / 50;
+    QVERIFY(qAbs(estimate("G1 X100 F3000\n") - expected) < 1e-6);
+    // the same line in two moves doesn't slow down in the middle
+    QVERIFY(qAbs(estimate("G1 X50 F3000\nG1 X100\n") - expected) < 1e-6);
+    // relative moves and inches
+    QVERIFY(qAbs(estimate("G91\nG1 X50 F3000\nG1 X50\n") - expected) < 1e-6);
+    QVERIFY(qAbs(estimate("G20\nG1 X3.937007874 F118.11023622\n") - expected) < 1e-4);
+}
+
+void PrintTimeEstimatorTests::testDwell()
+{
+    QVERIFY(qFuzzyCompare(estimate("G4 P500\nG4 S1\n"), 1.5));
+}
+
+void PrintTimeEstimatorTests::testLimitsFromFile()
+{
+    // too slow to reach 100 mm/s cruising more than 0.5 mm
+    QVERIFY(qAbs(estimate("M204 P100 T100\nG1 X100 F6000\n") - 1.905) < 1e-6);
+    PrintTimeEstimator::Limits limits;
+    limits.travelAcceleration = 100;
+    QVERIFY(qAbs(estimate("G1 X100 F6000\n", limits) - 1.905) < 1e-6);
+    // M203 caps the feedrate
+    QVERIFY(estimate("M203 X10\nG1 X100 F6000\n") > 10);
+}
+
+void PrintTimeEstimatorTests::testCorners()
+{
+    const double straight = estimate("G1 X50 F3000\nG1 X100\n");
+    const double corner = estimate("G1 X50 F3000\nG1 X50 Y50\n");
+    QVERIFY(corner > straight);
+    QVERIFY(estimate("G1 X50 F3000\nG1 X0\n") >= corner);
+
+    PrintTimeEstimator::Limits limits;
+    limits.junctionDeviation = 0.013;
+    const double junction = estimate("G1 X50 F3000\nG1 X50 Y50\n", limits);
+    QVERIFY(junction > straight);
+    QVERIFY(estimate("G1 X50 F3000\nG1 X0\n", limits) > junction);
+}
+
+void PrintTimeEstimatorTests::testArc()
+{
+    // a half circle of 10 mm radius at 10 mm/s, too slow for acceleration to show
+    QVERIFY(qAbs(estimate("G1 X10 F600\nG2 X-10 Y0 I-10 J0\n") - (1 + M_PI)) < 0.01);
+    QVERIFY(qAbs(estimate("G1 X10 F600\nG3 X-10 Y0 R10\n") - (1 + M_PI)) < 0.01);
+}
+
+void PrintTimeEstimatorTests::testTimeTable()
+{
+    QTemporaryFile file;
+    QVERIFY(writeFile(file, QByteArray("G1 X10 F600\nG1 X0\n; comment\n").repeated(100)));
+
+    PrintTimeEstimator estimator;
+    estimator.setStride(4);
+    QVERIFY(estimator.estimate(file.fileName()));
+    QVERIFY(estimator.isReady());
+    QVERIFY(estimator.lineCount() == 300);
+    QVERIFY(estimator.timeBeforeLine(0) == 0);
+    QVERIFY(qFuzzyCompare(estimator.timeBeforeLine(300), estimator.totalTime()));
+    QVERIFY(qFuzzyCompare(estimator.timeAt(file.size()), estimator.totalTime()));
+    QVERIFY(estimator.remainingTime(file.size()) == 0);
+    double last = 0;
+    for (qint64 line = 1; line <= 300; line++) {
+        QVERIFY(estimator.timeBeforeLine(line) >= last);
+        last = estimator.timeBeforeLine(line);
+    }
+    // every 3 lines take the same time, lookups between kept lines are off by less than a stride
+    QVERIFY(qAbs(estimator.timeBeforeLine(150) - estimator.totalTime() / 2) < 2);
+    QVERIFY(qAbs(estimator.timeAt(file.size() / 2) - estimator.totalTime() / 2) < 2);
+}
+
+void PrintTimeEstimatorTests::testChunks()
+{
+    // blocks ending with a dwell time the same wherever the chunks split the file
+    const QByteArray block("G1 X20 Y10 E1 F2400\nG1 X0 Y10 E2\nG1 X0 Y0 E3\nG92 E0\nG4 P0\n");
+    const double once = estimate(block);
+    QTemporaryFile file;
+    const int count = 100000;
+    QVERIFY(writeFile(file, block.repeated(count)));
+
+    PrintTimeEstimator estimator;
+    QVERIFY(estimator.estimate(file.fileName()));
+    QVERIFY(estimator.lineCount() == count * 5);
+    QVERIFY(qAbs(estimator.totalTime() - once * count) < 1e-6 * once * count);
+}
+
+void PrintTimeEstimatorTests::testOffset()
+{
+    // each block stops at the origin, a job continued after one starts as a new file does
+    const QByteArray block("G1 X20 Y10 E1 F2400\nG1 X0 Y10 E2\nG1 X0 Y0 E3\nG92 E0\nG4 P0\n");
+    QTemporaryFile file;
+    QVERIFY(writeFile(file, block.repeated(1000)));
+    // line 1280 has its time kept, no lookup in between
+    const qint64 offset = block.size() * 256;
+
+    PrintTimeEstimator full;
+    PrintTimeEstimator resumed;
+    QVERIFY(full.estimate(file.fileName()));
+    QVERIFY(resumed.estimate(file.fileName(), offset));
+    QVERIFY(resumed.lineCount() == 744 * 5);
+    QVERIFY(qAbs(resumed.totalTime() - full.remainingTime(offset)) < 1e-6 * full.totalTime());
+    QVERIFY(resumed.timeAt(0) == 0);
+    QVERIFY(resumed.timeAt(offset) == 0);
+    QVERIFY(resumed.timeAt(offset + block.size() * 100) > 0);
+    QVERIFY(qFuzzyCompare(resumed.timeAt(file.size()), resumed.totalTime()));
+
+    // past the end there is nothing left
+    QVERIFY(resumed.estimate(file.fileName(), file.size() + 10));
+    QVERIFY(resumed.totalTime() == 0);
+}
+
+void PrintTimeEstimatorTests::testStart()
+{
+    QTemporaryFile file;
+    QVERIFY(writeFile(file, QByteArray("G1 X100 F3000\n")));
+
+    PrintTimeEstimator estimator;
+    QSignalSpy spy(&estimator, &PrintTimeEstimator::finished);
+    estimator.start(file.fileName());
+    QVERIFY(spy.wait());
+    QVERIFY(spy.first().first().toBool());
+    QVERIFY(estimator.isReady());
+    QVERIFY(estimator.totalTime() > 2);
+}
+
+void PrintTimeEstimatorTests::testCancel()
+{
+    // a few chunks, a new start() or the destructor stop it early
+    QTemporaryFile big;
+    QVERIFY(writeFile(big, QByteArray("G1 X10 Y10 E1 F3000\nG1 X0 Y0 E2\n").repeated(500000)));
+    QTemporaryFile small;
+    QVERIFY(writeFile(small, QByteArray("G1 X100 F3000\n")));
+
+    {
+        PrintTimeEstimator estimator;
+        estimator.start(big.fileName());
+    }
+
+    PrintTimeEstimator estimator;
+    QSignalSpy spy(&estimator, &PrintTimeEstimator::finished);
+    estimator.start(big.fileName());
+    estimator.start(small.fileName());
+    QVERIFY(spy.wait());
+    QVERIFY(spy.first().first().toBool());
+    QVERIFY(estimator.lineCount() == 1);
+    // the cancelled estimate reports nothing
+    QVERIFY(!spy.wait(200));
+    QVERIFY(spy.count() == 1);
+}
+
+void PrintTimeEstimatorTests::testMissingFile()
+{
+    PrintTimeEstimator estimator;
+    QVERIFY(!estimator.estimate(QStringLiteral("/nonexistent/job.gcode")));
+    QVERIFY(!estimator.isReady());
+    QVERIFY(estimator.remainingTime(0) == 0);
+}
+
+void PrintTimeEstimatorTests::benchmarkEstimate()
+{
+    QByteArray job;
+    for (int i = 0; i < 200000; i++) {
+        job.append("G1 X" + QByteArray::number(i % 200) + " Y" + QByteArray::number(i % 150) + " E0.0412 F1800\n");
+    }
+    QTemporaryFile file;
+    QVERIFY(writeFile(file, job));
+
+    PrintTimeEstimator estimator;
+    QBENCHMARK {
+        estimator.estimate(file.fileName());
+    }
+}
+
+QTEST_MAIN(PrintTimeEstimatorTests)
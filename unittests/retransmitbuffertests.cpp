@@ -0,0 +1,84 @@
+/*
+    This file is part of the KDE project
+
+    Copyright (C) 2018 Patrick José Pereira <patrickelectric@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QtTest>
+
+#include "retransmitbuffertests.h"
+
+void RetransmitBufferTests::testChecksum()
+{
+    QVERIFY(RetransmitBuffer::checksum(QByteArray()) == 0);
+    QVERIFY(RetransmitBuffer::checksum(QByteArray("N0 M110 N0")) == 125);
+    QVERIFY(RetransmitBuffer::checksum(QByteArray("N1 G1 X1")) == 96);
+}
+
+void RetransmitBufferTests::testFrame()
+{
+    RetransmitBuffer buffer;
+    QVERIFY(buffer.nextLineNumber() == 1);
+    QVERIFY(buffer.frame(QByteArray("G1 X1")) == QByteArray("N1 G1 X1*96"));
+    QVERIFY(buffer.frame(QByteArray("G1 X1")) == QByteArray("N2 G1 X1*99"));
+    QVERIFY(buffer.nextLineNumber() == 3);
+}
+
+void RetransmitBufferTests::testReset()
+{
+    RetransmitBuffer buffer;
+    buffer.frame(QByteArray("G28"));
+    QVERIFY(buffer.reset() == QByteArray("N0 M110 N0*125"));
+    QVERIFY(buffer.nextLineNumber() == 1);
+
+    QList<QByteArray> lines;
+    QVERIFY(!buffer.resend(0, lines));
+    QVERIFY(!buffer.resend(1, lines));
+    QVERIFY(buffer.reset(-5).startsWith("N0 M110 N0"));
+}
+
+void RetransmitBufferTests::testResend()
+{
+    RetransmitBuffer buffer;
+    buffer.reset();
+    for (int i = 1; i <= 5; i++) {
+        buffer.frame(QByteArray("G1 X") + QByteArray::number(i));
+    }
+
+    QList<QByteArray> lines;
+    QVERIFY(buffer.resend(3, lines));
+    QVERIFY(lines.size() == 3);
+    QVERIFY(lines.first().startsWith("N3 G1 X3*"));
+    QVERIFY(lines.last().startsWith("N5 G1 X5*"));
+    QVERIFY(!buffer.resend(6, lines));
+    QVERIFY(lines.isEmpty());
+}
+
+void RetransmitBufferTests::testResendEvicted()
+{
+    RetransmitBuffer buffer(4);
+    buffer.reset();
+    for (int i = 1; i <= 10; i++) {
+        buffer.frame(QByteArray("G1 X") + QByteArray::number(i));
+    }
+
+    QList<QByteArray> lines;
+    QVERIFY(!buffer.resend(6, lines));
+    QVERIFY(buffer.resend(7, lines));
+    QVERIFY(lines.size() == 4);
+    QVERIFY(lines.first().startsWith("N7 G1 X7*"));
+}
+
+QTEST_MAIN(RetransmitBufferTests)
@@ -0,0 +1,212 @@
+/*
+    This file is part of the KDE project
+
+    Copyright (C) 2018 Patrick José Pereira <patrickelectric@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QtTest>
+
+#include "seriallayertests.h"
+
+void SerialLayerTests::init()
+{
+    port = new TestPort;
+    if (!port->isOpen()) {
+        QSKIP("Needs a pseudo terminal");
+    }
+}
+
+void SerialLayerTests::cleanup()
+{
+    delete port;
+    port = nullptr;
+}
+
+void SerialLayerTests::testSendReceive()
+{
+    SerialLayer layer(port->portName(), 115200);
+    QVERIFY(layer.isOpen());
+    QVERIFY(!layer.ioThreadRunning());
+    QSignalSpy received(&layer, &SerialLayer::receivedCommand);
+
+    layer.pushCommand("G28");
+    QCOMPARE(port->read(5), QByteArray("G28\n\r"));
+
+    // lines are only handed out once they are complete
+    QVERIFY(port->write("ok\r\nT:20"));
+    QVERIFY(received.wait());
+    QCOMPARE(received.count(), 1);
+    QCOMPARE(received.takeFirst().first().toByteArray(), QByteArray("ok"));
+    QVERIFY(port->write(".5\n"));
+    QVERIFY(received.wait());
+    QCOMPARE(received.takeFirst().first().toByteArray(), QByteArray("T:20.5"));
+
+    layer.close();
+    QVERIFY(!layer.isOpen());
+}
+
+void SerialLayerTests::testWriteCoalescing()
+{
+    SerialLayer layer(port->portName(), 115200);
+    QVERIFY(layer.isOpen());
+    QVERIFY(!layer.writeCoalescing());
+    layer.setWriteCoalescing(true);
+    QVERIFY(layer.writeCoalescing());
+
+    // whole 64 byte packets are written at once
+    const QByteArray move = "G1 X10.000 Y10.000 E0.12345";
+    layer.pushCommand(move);
+    layer.pushCommand(move);
+    QCOMPARE(layer.bytesToWrite(), qint64(0));
+    layer.pushCommand(move);
+    QCOMPARE(layer.bytesToWrite(), qint64(64));
+
+    // the partial packet follows after the flush deadline
+    const QByteArray moves = QByteArray(move + "\n\r").repeated(3);
+    QCOMPARE(port->read(moves.size()), moves);
+    QCOMPARE(layer.bytesToWrite(), qint64(0));
+
+    // disabling writes what is pending
+    layer.pushCommand("M105");
+    QCOMPARE(layer.bytesToWrite(), qint64(0));
+    layer.setWriteCoalescing(false);
+    QVERIFY(!layer.writeCoalescing());
+    QCOMPARE(layer.bytesToWrite(), qint64(6));
+    QCOMPARE(port->read(6), QByteArray("M105\n\r"));
+
+    layer.pushCommand("M114");
+    QCOMPARE(layer.bytesToWrite(), qint64(6));
+    QCOMPARE(port->read(6), QByteArray("M114\n\r"));
+
+    layer.close();
+}
+
+void SerialLayerTests::testIoThread()
+{
+    // a SerialLayer with a parent stays on its thread
+    QObject parent;
+    SerialLayer *child = new SerialLayer(port->portName(), 115200, &parent);
+    child->startIoThread();
+    QVERIFY(!child->ioThreadRunning());
+    child->close();
+    delete child;
+
+    SerialLayer *layer = new SerialLayer(port->portName(), 115200);
+    QVERIFY(layer->isOpen());
+    layer->startIoThread();
+    QVERIFY(layer->ioThreadRunning());
+    QVERIFY(layer->thread() != QThread::currentThread());
+
+    // commands pushed from here are written by the I/O thread in order
+    QByteArray expected;
+    for (int i = 0; i < 200; i++) {
+        const QByteArray command = "G1 X" + QByteArray::number(i);
+        layer->pushCommand(command);
+        expected.append(command + "\n\r");
+    }
+    QCOMPARE(port->read(expected.size()), expected);
+
+    // lines read by the I/O thread are emitted on this one
+    QSignalSpy received(layer, &SerialLayer::receivedCommand);
+    QList<QThread *> threads;
+    connect(layer, &SerialLayer::receivedCommand, this, [&threads]() {
+        threads.append(QThread::currentThread());
+    }, Qt::DirectConnection);
+    QByteArray replies;
+    for (int i = 0; i < 200; i++) {
+        replies.append("ok " + QByteArray::number(i) + "\n");
+    }
+    QVERIFY(port->write(replies));
+    QTRY_COMPARE_WITH_TIMEOUT(received.count(), 200, 5000);
+    for (int i = 0; i < received.count(); i++) {
+        QCOMPARE(received.at(i).first().toByteArray(), "ok " + QByteArray::number(i));
+    }
+    QVERIFY(threads.count(QThread::currentThread()) == 200);
+
+    layer->close();
+    QVERIFY(!layer->ioThreadRunning());
+    QVERIFY(!layer->isOpen());
+    QVERIFY(layer->thread() == QThread::currentThread());
+    delete layer;
+}
+
+void SerialLayerTests::testIoThreadClose()
+{
+    SerialLayer *layer = new SerialLayer(port->portName(), 115200);
+    layer->startIoThread();
+    QSignalSpy received(layer, &SerialLayer::receivedCommand);
+
+    // the I/O thread reads the line, this thread doesn't get to dispatch it before close()
+    QVERIFY(port->write("ok\n"));
+    QThread::msleep(200);
+    QVERIFY(received.isEmpty());
+    layer->pushCommand("M84");
+    layer->close();
+    QCOMPARE(received.count(), 1);
+    QCOMPARE(received.first().first().toByteArray(), QByteArray("ok"));
+
+    // commands queued before close() are written before the port closes
+    QCOMPARE(port->read(5), QByteArray("M84\n\r"));
+    delete layer;
+}
+
+void SerialLayerTests::testIoThreadFullQueues()
+{
+    SerialLayer *layer = new SerialLayer(port->portName(), 115200);
+    layer->startIoThread();
+    QSignalSpy received(layer, &SerialLayer::receivedCommand);
+
+    // this thread takes no lines meanwhile, the I/O thread fills its queue and stops reading
+    const int count = 3000;
+    QByteArray replies;
+    for (int i = 0; i < count; i++) {
+        replies.append("ok " + QByteArray::number(i) + "\n");
+    }
+    QVERIFY(port->write(replies));
+    QThread::msleep(200);
+    QTRY_COMPARE_WITH_TIMEOUT(received.count(), count, 10000);
+    for (int i = 0; i < count; i++) {
+        QCOMPARE(received.at(i).first().toByteArray(), "ok " + QByteArray::number(i));
+    }
+
+    // while the I/O thread is busy the command queue fills up and refuses more
+    QSemaphore busy;
+    QSemaphore resume;
+    QTimer::singleShot(0, layer, [&busy, &resume]() {
+        busy.release();
+        resume.acquire();
+    });
+    QVERIFY(busy.tryAcquire(1, 5000));
+    QSignalSpy drained(layer, &SerialLayer::commandQueueDrained);
+    QByteArray expected;
+    int queued = 0;
+    while (layer->canPushCommand()) {
+        const QByteArray command = "G1 X" + QByteArray::number(queued++);
+        QVERIFY(layer->pushCommand(command));
+        expected.append(command + "\n\r");
+    }
+    QVERIFY(queued == 1024);
+    QVERIFY(!layer->pushCommand("M84"));
+    resume.release();
+    QVERIFY(drained.wait());
+    QCOMPARE(port->read(expected.size()), expected);
+    QVERIFY(layer->pushCommand("M84"));
+    QCOMPARE(port->read(5), QByteArray("M84\n\r"));
+
+    layer->close();
+    delete layer;
+}
+
+QTEST_MAIN(SerialLayerTests)
@@ -0,0 +1,118 @@
+/*
+    This file is part of the KDE project
+
+    Copyright (C) 2018 Patrick José Pereira <patrickelectric@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QtTest>
+#include <thread>
+
+#include "spscqueuetests.h"
+
+void SpscQueueTests::testCapacity()
+{
+    QVERIFY(SpscQueue<int>(1).capacity() == 2);
+    QVERIFY(SpscQueue<int>(5).capacity() == 8);
+    QVERIFY(SpscQueue<int>(64).capacity() == 64);
+    QVERIFY(SpscQueue<int>().capacity() == 1024);
+}
+
+void SpscQueueTests::testFullEmpty()
+{
+    SpscQueue<int> queue(8);
+    int item = -1;
+    QVERIFY(queue.isEmpty());
+    QVERIFY(!queue.front());
+    QVERIFY(!queue.pop(item));
+    QVERIFY(item == -1);
+
+    for (int i = 0; i < 8; i++) {
+        QVERIFY(queue.push(i));
+    }
+    QVERIFY(queue.size() == 8);
+    QVERIFY(!queue.push(8));
+    QVERIFY(*queue.front() == 0);
+
+    // one free slot takes one more item
+    QVERIFY(queue.pop(item));
+    QVERIFY(item == 0);
+    QVERIFY(queue.push(8));
+    QVERIFY(!queue.push(9));
+
+    for (int i = 1; i <= 8; i++) {
+        QVERIFY(queue.pop(item));
+        QVERIFY(item == i);
+    }
+    QVERIFY(queue.isEmpty());
+    QVERIFY(!queue.pop(item));
+}
+
+void SpscQueueTests::testWrapAround()
+{
+    // fill levels that don't divide the capacity move the ends across the wrap at every offset
+    SpscQueue<int> queue(4);
+    int pushed = 0;
+    int popped = 0;
+    for (int round = 0; round < 1000; round++) {
+        const int fill = round % 4 + 1;
+        for (int i = 0; i < fill; i++) {
+            QVERIFY(queue.push(pushed++));
+        }
+        QVERIFY(queue.size() == fill);
+        QVERIFY(*queue.front() == popped);
+        int item;
+        while (queue.pop(item)) {
+            QVERIFY(item == popped++);
+        }
+    }
+    QVERIFY(popped == pushed);
+}
+
+void SpscQueueTests::testTwoThreads()
+{
+    // a small queue keeps both sides running into full and empty
+    SpscQueue<quint64> queue(16);
+    const quint64 count = 2000000;
+    std::thread producer([&queue, count]() {
+        for (quint64 i = 1; i <= count;) {
+            if (queue.push(i)) {
+                i++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    quint64 expected = 1;
+    quint64 sum = 0;
+    bool ordered = true;
+    while (expected <= count) {
+        quint64 item;
+        if (!queue.pop(item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        ordered = ordered && item == expected;
+        sum += item;
+        expected++;
+    }
+    producer.join();
+
+    QVERIFY(ordered);
+    QVERIFY(sum == count * (count + 1) / 2);
+    QVERIFY(queue.isEmpty());
+}
+
+QTEST_MAIN(SpscQueueTests)
@@ -16,10 +16,64 @@
     You should have received a copy of the GNU General Public License
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
+#include <QRegularExpression>
+#include <QSignalSpy>
 #include <algorithm>
+#include <random>
 
 #include "temperaturetests.h"
 
+namespace
+{
+// replies of the firmwares of the decode tests, %1 to %4 are the extruder, its target, the bed and its target
+const char *_formats[] = {
+    "ok B:%3 /%4 T:%1 /%2",
+    "ok T:%1 /%2 B:%3 /%4 @:0 B@:0",
+    "T:%1 /%2 B:%3 /%4 B@:255 @:0",
+    "ok T:%1 /%2 @0 B:%3 /%4 @",
+    "T:%1/%2 B:%3/%4",
+    "ok T:%1 /%2 B:%3 /%4 T0:%1 /%2 @:0 B@:0 @0:0",
+    "ok T0:%1 /%2 B:%3 /%4 @:0",
+};
+
+// what the printers see during a print
+const QList<QByteArray> _replies = {
+    "ok T:210.2 /210.0 B:60.1 /60.0 @:64 B@:127",
+    "ok B:49.06 /55 T:64.78 /215",
+    "T:25.47 /230 B:69.42 /80 B@:255 @:0",
+    "ok T:76.36 /220.0 @0 B:24.1 /60.0 @",
+    "T:15.50/210.0 B:46.80/82.0",
+    "ok T:201.3 /202.0 B:117.4 /0.0 T0:201.3 /202.0 T1:25.1 /0.0 @:0 B@:0 @0:0 @1:0",
+};
+
+/**
+ * @brief The sensors of \p message read with a regular expression, the grammar TemperatureReport scans
+ */
+QList<TemperatureReport::Sensor> referenceSensors(const QByteArray &message)
+{
+    static const QRegularExpression sensorRegEx(QStringLiteral(
+                "(?:^|[ \\t\\r])([TBCPAR])(\\d{0,2}):([+-]?(?:\\d+\\.?\\d*|\\.\\d+))(?:[ \\t\\r]*/[ \\t\\r]*([+-]?(?:\\d+\\.?\\d*|\\.\\d+)))?"));
+    QList<TemperatureReport::Sensor> sensors;
+    QRegularExpressionMatchIterator matches = sensorRegEx.globalMatch(QString::fromLatin1(message));
+    while (matches.hasNext() && sensors.size() < TemperatureReport::MaxSensors) {
+        const QRegularExpressionMatch match = matches.next();
+        TemperatureReport::Sensor sensor;
+        sensor.letter = match.captured(1).at(0).toLatin1();
+        sensor.index = match.captured(2).isEmpty() ? -1 : match.captured(2).toInt();
+        sensor.temperature = match.captured(3).toFloat();
+        sensor.hasTarget = !match.captured(4).isEmpty();
+        sensor.target = sensor.hasTarget ? match.captured(4).toFloat() : 0;
+        sensors.append(sensor);
+    }
+    return sensors;
+}
+
+bool sameFloat(float a, float b)
+{
+    return a == b || qAbs(a - b) <= 1e-6f * qMax(qAbs(a), qAbs(b));
+}
+}
+
 void TemperatureTests::initTestCase()
 {
     temperature = new Temperature(this);
@@ -31,6 +85,7 @@ void TemperatureTests::cleanup()
     temperature->setBedTargetTemperature(0);
     temperature->setExtruderTemperature(0);
     temperature->setExtruderTargetTemperature(0);
+    temperature->setExtruderCount(1);
 }
 
 void TemperatureTests::setExtruderTemperature()
@@ -120,4 +175,254 @@ void TemperatureTests::testDecodeTeacup()
     QVERIFY(temperature->bedTargetTemperature() == 82);
 }
 
+void TemperatureTests::testReportSensors()
+{
+    TemperatureReport report;
+    QVERIFY(report.parse(QByteArray("ok T:201.3 /202.0 B:117.4 /0.0 T0:201.3 /202.0 T1:25.1 /0.0 C:30.5 /0.0 @:0 B@:0 @0:0 @1:0")));
+    QCOMPARE(report.sensorCount(), 5);
+    QCOMPARE(report.sensor(0).letter, 'T');
+    QCOMPARE(int(report.sensor(0).index), -1);
+    QCOMPARE(report.sensor(0).temperature, 201.3f);
+    QCOMPARE(report.sensor(0).target, 202.0f);
+    QCOMPARE(report.sensor(1).letter, 'B');
+    QVERIFY(report.sensor(1).hasTarget);
+    QCOMPARE(report.find('T', 1)->temperature, 25.1f);
+    QCOMPARE(report.find('C')->temperature, 30.5f);
+    QVERIFY(!report.find('T', 2));
+
+    // Sprinter sends no targets, a sensor may be below 0
+    QVERIFY(report.parse(QByteArray("ok T:154 @:0 B:-12.5")));
+    QCOMPARE(report.sensorCount(), 2);
+    QVERIFY(!report.sensor(0).hasTarget);
+    QCOMPARE(report.sensor(0).target, 0.0f);
+    QCOMPARE(report.sensor(1).temperature, -12.5f);
+
+    // the targets of a multi extruder decode go to T, or T0 when there is no T
+    temperature->decodeTemp(QByteArray("ok T0:180.5 /185 T1:20 /0 B:55 /60"));
+    QCOMPARE(temperature->extruderTemperature(), 180.5f);
+    QCOMPARE(temperature->extruderTargetTemperature(), 185.0f);
+    QCOMPARE(temperature->bedTargetTemperature(), 60.0f);
+}
+
+void TemperatureTests::testReportInvalid()
+{
+    TemperatureReport report;
+    QVERIFY(!report.parse(QByteArray()));
+    QVERIFY(!report.parse(QByteArray("ok")));
+    QVERIFY(!report.parse(QByteArray("T:")));
+    QVERIFY(!report.parse(QByteArray("T: B:")));
+    QVERIFY(!report.parse(QByteArray("@:0 B@:127 W:?")));
+    QVERIFY(!report.parse(QByteArray("X:10 Y:20 E:0")));
+    QVERIFY(!report.parse(QByteArray("T123:20 TB:30 okT:40")));
+
+    // a broken target leaves the temperature
+    QVERIFY(report.parse(QByteArray("T:20 /abc")));
+    QCOMPARE(report.sensorCount(), 1);
+    QVERIFY(!report.sensor(0).hasTarget);
+
+    // a message full of sensors keeps the first ones
+    QByteArray many;
+    for (int i = 0; i < 40; i++) {
+        many.append("T" + QByteArray::number(i % 10) + ":" + QByteArray::number(i) + " ");
+    }
+    QVERIFY(report.parse(many));
+    QCOMPARE(report.sensorCount(), int(TemperatureReport::MaxSensors));
+    QCOMPARE(report.sensor(15).temperature, 15.0f);
+
+    // decoding a message without a sensor changes nothing
+    temperature->setExtruderTemperature(42);
+    temperature->decodeTemp(QByteArray("echo:busy: processing T:"));
+    QCOMPARE(temperature->extruderTemperature(), 42.0f);
+}
+
+void TemperatureTests::testSensorTable()
+{
+    QCOMPARE(temperature->extruderCount(), 1);
+    temperature->decodeTemp(QByteArray("ok T:180 /180 T0:200 /200 T1:180 /180 T2:25.5 /0 B:60 /60 C:40.5 /0 @:0 B@:0"));
+    QCOMPARE(temperature->extruderCount(), 3);
+    QCOMPARE(temperature->sensorCount(), 5);
+
+    // extruders first in tool order, T repeats the active one
+    for (int i = 0; i < 3; i++) {
+        QCOMPARE(temperature->sensorType(i), Temperature::Extruder);
+        QCOMPARE(temperature->sensorIndex(i), i);
+    }
+    QCOMPARE(temperature->extruderTemperature(), 200.0f);
+    QCOMPARE(temperature->extruderTemperature(1), 180.0f);
+    QCOMPARE(temperature->extruderTargetTemperature(2), 0.0f);
+    QCOMPARE(temperature->extruderTemperature(2), 25.5f);
+    QCOMPARE(temperature->bedTemperature(), 60.0f);
+
+    const int chamber = temperature->findSensor(Temperature::Chamber);
+    QCOMPARE(chamber, 4);
+    QCOMPARE(temperature->temperature(chamber), 40.5f);
+    QCOMPARE(temperature->findSensor(Temperature::Probe), -1);
+
+    // a report without a target leaves the one set
+    temperature->setExtruderTargetTemperature(215, 1);
+    temperature->decodeTemp(QByteArray("ok T0:201 T1:190"));
+    QCOMPARE(temperature->extruderTemperature(1), 190.0f);
+    QCOMPARE(temperature->extruderTargetTemperature(1), 215.0f);
+
+    temperature->setExtruderCount(1);
+    QCOMPARE(temperature->sensorCount(), 3);
+    QCOMPARE(temperature->findSensor(Temperature::Chamber), 2);
+}
+
+void TemperatureTests::testExtruderCount()
+{
+    temperature->setBedTemperature(55);
+    temperature->setExtruderTemperature(190);
+    temperature->setExtruderCount(12);
+    QCOMPARE(temperature->extruderCount(), 12);
+    QCOMPARE(temperature->findSensor(Temperature::Extruder, 11), 11);
+    QCOMPARE(temperature->sensorType(12), Temperature::Bed);
+    QCOMPARE(temperature->extruderTemperature(), 190.0f);
+    QCOMPARE(temperature->bedTemperature(), 55.0f);
+
+    temperature->decodeTemp(QByteArray("ok T10:220.5 /230 B:56 /60"));
+    QCOMPARE(temperature->extruderTemperature(10), 220.5f);
+    QCOMPARE(temperature->extruderTargetTemperature(10), 230.0f);
+
+    // targets set for tools past the count add them
+    temperature->setExtruderCount(2);
+    QCOMPARE(temperature->findSensor(Temperature::Extruder, 10), -1);
+    temperature->setExtruderTargetTemperature(200, 3);
+    QCOMPARE(temperature->extruderCount(), 3);
+    QCOMPARE(temperature->findSensor(Temperature::Extruder, 3), 2);
+    QCOMPARE(temperature->extruderTemperature(2), 0.0f);
+
+    temperature->setExtruderCount(0);
+    QCOMPARE(temperature->extruderCount(), 1);
+    QCOMPARE(temperature->bedTemperature(), 56.0f);
+}
+
+void TemperatureTests::testTemperaturesChanged()
+{
+    QSignalSpy spy(temperature, &Temperature::temperaturesChanged);
+    temperature->decodeTemp(QByteArray("ok T0:200 /200 T1:180 /0 B:60 /60 C:40 /0"));
+    QCOMPARE(spy.count(), 1);
+    temperature->decodeTemp(QByteArray("ok"));
+    QCOMPARE(spy.count(), 1);
+    temperature->setBedTargetTemperature(70);
+    QCOMPARE(spy.count(), 2);
+}
+
+void TemperatureTests::testFieldSignals()
+{
+    QSignalSpy bed(temperature, &Temperature::bedTemperatureChanged);
+    QSignalSpy bedTarget(temperature, &Temperature::bedTargetTemperatureChanged);
+    QSignalSpy extruder(temperature, &Temperature::extruderTemperatureChanged);
+    QSignalSpy extruderTarget(temperature, &Temperature::extruderTargetTemperatureChanged);
+
+    temperature->decodeTemp(QByteArray("ok T:200 /210 B:60 /65"));
+    QCOMPARE(bed.count(), 1);
+    QCOMPARE(bed.takeFirst().first().toFloat(), 60.0f);
+    QCOMPARE(bedTarget.takeFirst().first().toFloat(), 65.0f);
+    QCOMPARE(extruder.takeFirst().first().toFloat(), 200.0f);
+    QCOMPARE(extruderTarget.takeFirst().first().toFloat(), 210.0f);
+
+    // only fields that changed
+    temperature->decodeTemp(QByteArray("ok T:201 /210 B:60 /65"));
+    QCOMPARE(extruder.count(), 1);
+    QVERIFY(bed.isEmpty() && bedTarget.isEmpty() && extruderTarget.isEmpty());
+
+    // other tools have no field of their own
+    temperature->decodeTemp(QByteArray("ok T0:201 /210 T1:180 /190 B:60 /65"));
+    temperature->setExtruderTargetTemperature(200, 1);
+    QCOMPARE(extruder.count(), 1);
+    QVERIFY(extruderTarget.isEmpty());
+
+    temperature->setBedTargetTemperature(70);
+    temperature->setBedTargetTemperature(70);
+    QCOMPARE(bedTarget.count(), 1);
+}
+
+void TemperatureTests::fuzzFirmwareFormats()
+{
+    std::mt19937 random(105);
+    std::uniform_int_distribution<int> temperatures(-500, 40000);
+    std::uniform_int_distribution<int> decimals(0, 2);
+    std::uniform_int_distribution<int> formats(0, int(sizeof(_formats) / sizeof(*_formats)) - 1);
+    const auto number = [&](float &value) {
+        const QString text = QString::number(double(temperatures(random)) / 100, 'f', decimals(random));
+        value = text.toFloat();
+        return text;
+    };
+
+    for (int i = 0; i < 5000; i++) {
+        float extruder, extruderTarget, bed, bedTarget;
+        const QString extruderText = number(extruder);
+        const QString extruderTargetText = number(extruderTarget);
+        const QString bedText = number(bed);
+        const QString bedTargetText = number(bedTarget);
+        const QByteArray message = QString::fromLatin1(_formats[formats(random)]).arg(extruderText, extruderTargetText, bedText, bedTargetText).toLatin1();
+        temperature->decodeTemp(message);
+        QVERIFY2(temperature->extruderTemperature() == extruder, message.constData());
+        QVERIFY2(temperature->extruderTargetTemperature() == extruderTarget, message.constData());
+        QVERIFY2(temperature->bedTemperature() == bed, message.constData());
+        QVERIFY2(temperature->bedTargetTemperature() == bedTarget, message.constData());
+    }
+}
+
+void TemperatureTests::fuzzScanner()
+{
+    // words and pieces of words replies are made of
+    const char *pieces[] = {"T:", "B:", "T1:", " /", "T", "B", "C", "P", "A", "R", "X", "@", "ok", "0", "1", "7", "42", "210.5", "-3", ".5", "5.", "+", ".", ":", "/", " ", " ", "  ", "\t", "\r"};
+    std::mt19937 random(190);
+    std::uniform_int_distribution<int> piece(0, int(sizeof(pieces) / sizeof(*pieces)) - 1);
+    std::uniform_int_distribution<int> length(0, 40);
+
+    TemperatureReport report;
+    for (int i = 0; i < 20000; i++) {
+        QByteArray message;
+        for (int n = length(random); n > 0; n--) {
+            message.append(pieces[piece(random)]);
+        }
+        const QList<TemperatureReport::Sensor> expected = referenceSensors(message);
+        QCOMPARE(report.parse(message), !expected.isEmpty());
+        QVERIFY2(report.sensorCount() == expected.size(), message.constData());
+        for (int j = 0; j < expected.size(); j++) {
+            const TemperatureReport::Sensor &sensor = report.sensor(j);
+            QVERIFY2(sensor.letter == expected.at(j).letter && sensor.index == expected.at(j).index, message.constData());
+            QVERIFY2(sameFloat(sensor.temperature, expected.at(j).temperature), message.constData());
+            QVERIFY2(sensor.hasTarget == expected.at(j).hasTarget && sameFloat(sensor.target, expected.at(j).target), message.constData());
+        }
+    }
+}
+
+void TemperatureTests::benchmarkRegex()
+{
+    // what decodeTemp() used to do for each reply
+    float sum = 0;
+    QBENCHMARK {
+        for (const QByteArray &reply : _replies) {
+            QRegularExpression tempRegEx(QStringLiteral("(T:(?<extruder>\\d+\\.?\\d*))"));
+            QRegularExpression targetTempRegEx(QStringLiteral("(\\/)(?<extruderTarget>\\d*)(.+)"));
+            QRegularExpression bedRegEx(QStringLiteral("(B:(?<bed>\\d+\\.?\\d*))"));
+            QRegularExpression targetBedRegEx(QStringLiteral("B:(.+)(\\/)(?<bedTarget>\\d+)"));
+            sum += tempRegEx.match(QString::fromLatin1(reply)).captured(QStringLiteral("extruder")).toFloat();
+            sum += targetTempRegEx.match(QString::fromLatin1(reply)).captured(QStringLiteral("extruderTarget")).toFloat();
+            sum += bedRegEx.match(QString::fromLatin1(reply)).captured(QStringLiteral("bed")).toFloat();
+            sum += targetBedRegEx.match(QString::fromLatin1(reply)).captured(QStringLiteral("bedTarget")).toFloat();
+        }
+    }
+    QVERIFY(sum > 0);
+}
+
+void TemperatureTests::benchmarkScanner()
+{
+    TemperatureReport report;
+    float sum = 0;
+    QBENCHMARK {
+        for (const QByteArray &reply : _replies) {
+            report.parse(reply);
+            for (int i = 0; i < report.sensorCount(); i++) {
+                sum += report.sensor(i).temperature + report.sensor(i).target;
+            }
+        }
+    }
+    QVERIFY(sum > 0);
+}
+
 QTEST_MAIN(TemperatureTests)
@@ -20,6 +20,7 @@
 #include <QObject>
 
 #include "../src/temperature.h"
+#include "../src/temperaturereport.h"
 
 class TemperatureTests: public QObject
 {
@@ -37,6 +38,16 @@ private slots:
     void testDecodeSmoothie();
     void testDecodeSprinter();
     void testDecodeTeacup();
+    void testReportSensors();
+    void testReportInvalid();
+    void testSensorTable();
+    void testExtruderCount();
+    void testTemperaturesChanged();
+    void testFieldSignals();
+    void fuzzFirmwareFormats();
+    void fuzzScanner();
+    void benchmarkRegex();
+    void benchmarkScanner();
 private:
     Temperature *temperature;
 };
@@ -0,0 +1,154 @@
+/*
+    This file is part of the KDE project
+
+    Copyright (C) 2018 Patrick José Pereira <patrickelectric@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QList>
+#include <QString>
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief The TestPort class
+ * A pseudo terminal standing in for a printer. SerialLayer and AtCore open
+ * portName(), the test reads what they send and writes the printer's replies.
+ */
+class TestPort
+{
+public:
+    TestPort()
+    {
+#ifdef Q_OS_UNIX
+        _master = posix_openpt(O_RDWR | O_NOCTTY);
+        if (_master == -1 || grantpt(_master) != 0 || unlockpt(_master) != 0) {
+            return;
+        }
+        _portName = QString::fromLocal8Bit(ptsname(_master));
+        // held open so what was written stays readable after the port was closed
+        _slave = ::open(ptsname(_master), O_RDWR | O_NOCTTY);
+#endif
+    }
+
+    ~TestPort()
+    {
+#ifdef Q_OS_UNIX
+        if (_slave != -1) {
+            ::close(_slave);
+        }
+        if (_master != -1) {
+            ::close(_master);
+        }
+#endif
+    }
+
+    /**
+     * @brief False if there are no pseudo terminals
+     */
+    bool isOpen() const
+    {
+        return _slave != -1;
+    }
+
+    /**
+     * @brief Port to open
+     */
+    QString portName() const
+    {
+        return _portName;
+    }
+
+    /**
+     * @brief Read what was sent to the printer, processing events meanwhile
+     * @param size: bytes to wait for
+     * @param timeout: longest wait in ms
+     */
+    QByteArray read(int size, int timeout = 5000)
+    {
+        QByteArray data;
+#ifdef Q_OS_UNIX
+        QElapsedTimer timer;
+        timer.start();
+        while (data.size() < size && timer.elapsed() < timeout) {
+            QCoreApplication::processEvents();
+            pollfd fd = {_master, POLLIN, 0};
+            if (poll(&fd, 1, 10) > 0 && (fd.revents & POLLIN)) {
+                char buffer[256];
+                const ssize_t count = ::read(_master, buffer, sizeof(buffer));
+                if (count > 0) {
+                    data.append(buffer, int(count));
+                }
+            }
+        }
+#else
+        Q_UNUSED(size);
+        Q_UNUSED(timeout);
+#endif
+        return data;
+    }
+
+    /**
+     * @brief Read \p count commands sent to the printer
+     * @return the commands without their "\n\r" terminator, fewer on timeout
+     */
+    QList<QByteArray> readCommands(int count, int timeout = 5000)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        while (_pending.count("\n\r") < count && timer.elapsed() < timeout) {
+            _pending.append(read(1, 10));
+        }
+        QList<QByteArray> commands;
+        int end;
+        while (commands.size() < count && (end = _pending.indexOf("\n\r")) != -1) {
+            commands.append(_pending.left(end));
+            _pending.remove(0, end + 2);
+        }
+        return commands;
+    }
+
+    /**
+     * @brief Send \p data as the printer would
+     * @return False if it couldn't be written
+     */
+    bool write(const QByteArray &data)
+    {
+#ifdef Q_OS_UNIX
+        return ::write(_master, data.constData(), size_t(data.size())) == data.size();
+#else
+        Q_UNUSED(data);
+        return false;
+#endif
+    }
+
+private:
+    TestPort(const TestPort &) = delete;
+    TestPort &operator=(const TestPort &) = delete;
+
+    int _master = -1;       //!< @param _master: printer side of the pseudo terminal
+    int _slave = -1;        //!< @param _slave: host side, kept open for the whole test
+    QString _portName;      //!< @param _portName: path of the host side
+    QByteArray _pending;    //!< @param _pending: read by readCommands() and not returned yet
+};